@@ -150,6 +150,49 @@ describe("TNS Workers", () => {
         }
     });
 
+    it("Send objects that serialize like JSON.stringify and receive them back", (done) => {
+        var a = new Worker("./EvalWorker.js");
+
+        var value = {
+            "1": "integer keys first",
+            text: "quotes \" \\ \n\t\u0001 \u2028 ünïcödé \ud800",
+            numbers: [0, -0, 1.5, -2e-7, 1e21, 9007199254740993, NaN, Infinity],
+            skipped: undefined,
+            fn: function () { },
+            holes: [undefined, function () { }, , null],
+            date: new Date(0),
+            nested: { empty: {}, emptyArray: [], deep: [[[{ a: [1] }]]] },
+            nullPrototype: Object.assign(Object.create(null), { b: true })
+        };
+        var expected = JSON.parse(JSON.stringify(value));
+
+        a.postMessage({ value: value, eval: "postMessage(value);" });
+        a.onmessage = (msg) => {
+            expect(msg.data).toEqual(expected);
+            expect(Object.keys(msg.data)).toEqual(Object.keys(expected));
+            a.terminate();
+            done();
+        }
+    });
+
+    it("Send a 100KB object and receive back the same object", (done) => {
+        var a = new Worker("./EvalWorker.js");
+
+        var value = [];
+        for (var i = 0; i < 1000; i++) {
+            value.push({ id: i, name: "item " + i, tags: ["a", "b", "c"], ratio: i / 7, active: i % 2 === 0 });
+        }
+
+        var start = performance.now();
+        a.postMessage({ value: value, eval: "postMessage(value);" });
+        a.onmessage = (msg) => {
+            console.log("100KB worker round trip: " + (performance.now() - start).toFixed(2) + "ms");
+            expect(msg.data).toEqual(value);
+            a.terminate();
+            done();
+        }
+    });
+
     it("Send an object containing repeated references", (done) => {
         var a = new Worker("./EvalWorker.js");
 
@@ -28,4 +28,66 @@ describe("Test JSONObject conversions", () => {
             num: 123
         }]);
     });
+});
+
+describe("Console writer", () => {
+    const File = java.io.File;
+    const readLines = file => {
+        const text = new java.util.Scanner(file).useDelimiter("\\A").next();
+        return text.split("\n").filter(line => line.length > 0);
+    };
+    let file;
+
+    beforeEach(() => {
+        file = File.createTempFile("console", ".log");
+        __configureConsole({ sink: file.getAbsolutePath() });
+    });
+
+    afterEach(() => {
+        __configureConsole({ sink: "logcat", level: "log" });
+        file.delete();
+    });
+
+    it("writes formatted messages to the file sink", () => {
+        console.log("a", 1, true);
+        console.warn("b");
+        expect(__flushConsole()).toBe(true);
+
+        expect(readLines(file)).toEqual(["I CONSOLE LOG: a 1 true", "W CONSOLE WARN: b"]);
+    });
+
+    it("filters levels before formatting", () => {
+        let formatted = false;
+        __configureConsole({ level: "warn" });
+        console.log({ toString: () => { formatted = true; return "hidden"; } });
+        console.error("shown");
+        __flushConsole();
+
+        expect(formatted).toBe(false);
+        expect(readLines(file)).toEqual(["E CONSOLE ERROR: shown"]);
+    });
+
+    it("keeps the message intact when a toString logs too", () => {
+        console.log("outer", { toString: () => { console.log("inner"); return "value"; } });
+        __flushConsole();
+
+        expect(readLines(file)).toEqual(["I CONSOLE LOG: inner", "I CONSOLE LOG: outer value"]);
+    });
+
+    it("logs 100k messages without dropping", () => {
+        const before = __getConsoleStats();
+        const start = performance.now();
+        for (let i = 0; i < 100000; i++) {
+            console.log("message", i);
+        }
+        const elapsed = performance.now() - start;
+        expect(__flushConsole(10000)).toBe(true);
+        const after = __getConsoleStats();
+
+        expect(after.written - before.written).toBe(100000);
+        expect(after.dropped - before.dropped).toBe(0);
+        expect(readLines(file).length).toBe(100000);
+        __configureConsole({ sink: "logcat" });
+        console.log(`100k console.log calls took ${elapsed.toFixed(1)}ms`);
+    });
 });
\ No newline at end of file
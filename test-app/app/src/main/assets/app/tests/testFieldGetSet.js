@@ -36,4 +36,33 @@ describe("Tests final fields set", function () {
         expect(s).toBe(null);
         expect(isNull).toBe(true);
     });
+
+    it("__getJavaFields reads several fields in one call", function () {
+
+        var rect = new android.graphics.Rect(1, 2, 3, 4);
+        var fields = __getJavaFields(rect, ["left", "top", "right", "bottom"]);
+
+        expect(fields.left).toBe(1);
+        expect(fields.top).toBe(2);
+        expect(fields.right).toBe(3);
+        expect(fields.bottom).toBe(4);
+    });
+
+    it("__getJavaFields reads inherited fields and falls back to properties", function () {
+
+        var dc = new com.tns.tests.DummyClass.DummyDerivedClass();
+        dc.arbitraryString = "arbitrary";
+        var fields = __getJavaFields(dc, ["nameField", "arbitraryString", "arrIntField2", "dummyMethod"]);
+
+        expect(fields.nameField).toBe(dc.nameField);
+        expect(fields.arbitraryString).toBe("arbitrary");
+        expect(fields.arrIntField2).toBe(null);
+        expect(typeof fields.dummyMethod).toBe("function");
+    });
+
+    it("__getJavaFields throws for non Java objects", function () {
+
+        expect(function () { __getJavaFields({}, ["a"]); }).toThrow();
+        expect(function () { __getJavaFields(new android.graphics.Point(1, 2)); }).toThrow();
+    });
 });
\ No newline at end of file
@@ -267,6 +267,35 @@ describeFunc("Tests garbage collection", function () {
 		java.lang.System.gc();
 	});
 
+	it("should hand back Java objects whose wrappers were finalized together", function (done) {
+		var list = new java.util.ArrayList();
+		var before = __getObjectManagerStats();
+		(function () {
+			for (var i = 0; i < 1000; i++) {
+				list.add(new java.lang.StringBuilder("item" + i));
+			}
+		})();
+
+		gc();
+		java.lang.System.gc();
+
+		// the wrappers are finalized after the GC and their instances made weak in one batch
+		setTimeout(function () {
+			var stats = __getObjectManagerStats();
+			var flushes = stats.weakFlushes - before.weakFlushes;
+			var instances = stats.weakFlushedInstances - before.weakFlushedInstances;
+			// a call to Java per instance would make them equal
+			expect(instances >= 1000).toBe(true);
+			expect(flushes >= 1).toBe(true);
+			expect(flushes <= instances / 100).toBe(true);
+
+			for (var i = 0; i < 1000; i++) {
+				expect(list.get(i).toString()).toBe("item" + i);
+			}
+			done();
+		}, 100);
+	});
+
 	it("should keep array-enclosed objects alive after GC", function () {
         function createObjects(name) {
             var arr = new Array();
@@ -94,7 +94,17 @@ describe('native timer', () => {
             done();
         });
     });
-    xit('frees up resources after complete', (done) => {
+
+    it('passes the arguments to the callback', (done) => {
+        const arg = {};
+        setTimeout((first, second) => {
+            expect(first).toBe(arg);
+            expect(second).toBe('second');
+            done();
+        }, 10, arg, 'second');
+    });
+
+    it('frees up resources after complete', (done) => {
         let timeout = 0;
         let interval = 0;
         let weakRef;
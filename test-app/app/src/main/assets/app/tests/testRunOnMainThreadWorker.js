@@ -0,0 +1,23 @@
+self.onmessage = function(msg) {
+    // only the source reaches the main runtime, functions that aren't function expressions are rejected
+    var rejected = [];
+    var candidates = {
+        bound: function() {}.bind(null),
+        native: Math.max,
+        method: ({ run() {} }).run
+    };
+    for (var name in candidates) {
+        try {
+            __runOnMainThread(candidates[name]);
+        } catch (e) {
+            if (e instanceof TypeError) {
+                rejected.push(name);
+            }
+        }
+    }
+
+    __runOnMainThread(function(text, data) {
+        global.__runOnMainThreadFromWorker = text + " " + data.count;
+    }, "ran on the main thread", { count: 2 });
+    self.postMessage(rejected);
+}
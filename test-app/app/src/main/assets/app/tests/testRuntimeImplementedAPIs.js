@@ -28,4 +28,211 @@ describe("Runtime exposes", function () {
       }
     }
   });
+
+  it("__runOnMainThread runs the scheduled functions in order", function(done) {
+    var before = __getMainThreadQueueStats();
+    var calls = [];
+    for (var i = 0; i < 100; i++) {
+      (function(index) {
+        __runOnMainThread(function() {
+          calls.push(index);
+        });
+      })(i);
+    }
+    __runOnMainThread(function() {
+      var stats = __getMainThreadQueueStats();
+      expect(calls.length).toBe(100);
+      for (var i = 0; i < calls.length; i++) {
+        expect(calls[i]).toBe(i);
+      }
+      expect(stats.posted - before.posted).toBe(101);
+      expect(stats.maxDepth >= 101).toBe(true);
+      done();
+    });
+  });
+
+  it("__runOnMainThread passes the arguments to the function", function(done) {
+    var data = { count: 1 };
+    __runOnMainThread(function(text, value) {
+      expect(text).toBe("argument");
+      expect(value).toBe(data);
+      done();
+    }, "argument", data);
+  });
+
+  it("__runOnMainThread runs the functions posted by a worker on the main runtime", function(done) {
+    var worker = new Worker("./testRunOnMainThreadWorker");
+
+    worker.onmessage = function(msg) {
+      __runOnMainThread(function() {
+        expect(msg.data).toEqual(["bound", "native", "method"]);
+        expect(global.__runOnMainThreadFromWorker).toBe("ran on the main thread 2");
+        delete global.__runOnMainThreadFromWorker;
+        worker.terminate();
+        done();
+      });
+    };
+
+    worker.postMessage("post");
+  });
+
+  it("scheduler.postTask runs tasks by priority before idle callbacks", function(done) {
+    var order = [];
+    requestIdleCallback(function(deadline) {
+      order.push("idle");
+      expect(typeof deadline.timeRemaining()).toBe("number");
+      expect(deadline.didTimeout).toBe(false);
+    });
+    var background = scheduler.postTask(function() { order.push("background"); }, { priority: "background" });
+    var visible = scheduler.postTask(function() { order.push("visible"); return 42; });
+    var blocking = scheduler.postTask(function() { order.push("blocking"); }, { priority: "user-blocking" });
+    var cancelled = requestIdleCallback(function() { order.push("cancelled"); });
+    cancelIdleCallback(cancelled);
+
+    expect(function() { scheduler.postTask(function() {}, { priority: "urgent" }); }).toThrow();
+
+    Promise.all([background, visible, blocking]).then(function(results) {
+      expect(results[1]).toBe(42);
+      requestIdleCallback(function() {
+        expect(order).toEqual(["blocking", "visible", "background", "idle"]);
+        expect(__getSchedulerStats().frames > 0).toBe(true);
+        done();
+      }, { timeout: 1000 });
+    });
+  });
+
+  it("performance timeline records marks, measures and runtime entries", function(done) {
+    var a = performance.now();
+    var b = performance.now();
+    expect(b >= a).toBe(true);
+    expect(performance.timeOrigin > 0).toBe(true);
+
+    var observed = [];
+    var observer = new PerformanceObserver(function(list, obs) {
+      expect(obs).toBe(observer);
+      observed = observed.concat(list.getEntriesByType("measure"));
+      obs.disconnect();
+      expect(observed.length).toBe(1);
+      expect(observed[0].name).toBe("span");
+      done();
+    });
+    observer.observe({ type: "measure" });
+
+    performance.mark("start");
+    performance.mark("end");
+    var measure = performance.measure("span", "start", "end");
+    expect(measure.entryType).toBe("measure");
+    expect(measure.duration >= 0).toBe(true);
+    expect(performance.getEntriesByName("start", "mark").length).toBe(1);
+
+    performance.clearMarks("start");
+    expect(performance.getEntriesByName("start").length).toBe(0);
+    expect(function() { performance.measure("missing", "start"); }).toThrow();
+
+    var runtime = performance.getEntriesByType("runtime").map(function(e) { return e.name; });
+    expect(runtime.indexOf("init") >= 0).toBe(true);
+  });
+
+  it("__stopTracing writes a trace with Java calls and timers", function(done) {
+    __startTracing();
+    var file = new java.io.File(java.lang.System.getProperty("java.io.tmpdir"), "trace-test.json");
+    setTimeout(function() {
+      var path = __stopTracing(file.getAbsolutePath());
+      expect(path).toBe(file.getAbsolutePath());
+
+      var text = new java.util.Scanner(file).useDelimiter("\\A").next();
+      file.delete();
+      var events = JSON.parse(text).traceEvents;
+      var names = events.map(function(e) { return e.name; });
+      expect(names.indexOf("CallJavaMethod") >= 0).toBe(true);
+      expect(names.indexOf("SetTimer") >= 0).toBe(true);
+      expect(names.indexOf("Timer") >= 0).toBe(true);
+      var flows = events.filter(function(e) { return e.name === "Timer" && (e.ph === "s" || e.ph === "f"); });
+      expect(flows.length >= 2).toBe(true);
+      done();
+    }, 0);
+  });
+
+  it("__getCallStats reports per method counters of Java calls", function() {
+    __startCallStats();
+    for (var i = 0; i < 10; i++) {
+      java.lang.Integer.toHexString(i);
+    }
+    expect(function() { java.lang.Integer.parseInt("not a number"); }).toThrow();
+    __stopCallStats();
+    java.lang.Integer.toHexString(42);
+
+    var stats = __getCallStats(1000);
+    var hex = stats.filter(function(s) { return s.name.indexOf("java.lang.Integer.toHexString") === 0; })[0];
+    expect(hex.direction).toBe("js-to-java");
+    expect(hex.calls).toBe(10);
+    expect(hex.totalTime >= hex.maxTime).toBe(true);
+    expect(hex.exceptions).toBe(0);
+
+    var parse = stats.filter(function(s) { return s.name.indexOf("java.lang.Integer.parseInt") === 0; })[0];
+    expect(parse.exceptions).toBe(1);
+
+    for (var i = 1; i < stats.length; i++) {
+      expect(stats[i - 1].totalTime >= stats[i].totalTime).toBe(true);
+    }
+  });
+
+  it("requires a large JSON module", function() {
+    var items = [];
+    for (var i = 0; i < 50000; i++) {
+      items.push({ id: i, name: "item " + i, tags: ["json", "module"], ratio: i / 3, nested: { flag: i % 2 === 0 } });
+    }
+    var text = JSON.stringify({ items: items });
+    expect(text.length > 5000000).toBe(true);
+
+    var file = new java.io.File(java.lang.System.getProperty("java.io.tmpdir"), "large-module-" + Date.now() + ".json");
+    var writer = new java.io.FileWriter(file);
+    writer.write(text);
+    writer.close();
+
+    var start = performance.now();
+    var data = require(file.getAbsolutePath());
+    console.log("require of a " + text.length + " bytes JSON module: " + (performance.now() - start).toFixed(2) + "ms");
+    file.delete();
+
+    expect(data.items.length).toBe(items.length);
+    expect(data.items[items.length - 1]).toEqual(items[items.length - 1]);
+  });
+
+  it("__getArrayBufferAllocatorStats accounts for the ArrayBuffers", function() {
+    var before = __getArrayBufferAllocatorStats();
+    if (before === undefined) {
+      // the engine keeps ArrayBuffers in its own heap
+      return;
+    }
+
+    var buffers = [];
+    for (var i = 0; i < 100; i++) {
+      buffers.push(new ArrayBuffer(4096));
+    }
+    var stats = __getArrayBufferAllocatorStats();
+    expect(stats.allocations - before.allocations >= 100).toBe(true);
+    expect(stats.liveBytes - before.liveBytes >= 100 * 4096).toBe(true);
+    expect(stats.peakBytes >= stats.liveBytes).toBe(true);
+    expect(new Uint8Array(buffers[99])[4095]).toBe(0);
+  });
+
+  it("churns through short-lived ArrayBuffers", function() {
+    var sizes = [4096, 16384, 65536, 262144, 1048576];
+    var start = performance.now();
+    var checksum = 0;
+    for (var i = 0; i < 2000; i++) {
+      var bytes = new Uint8Array(sizes[i % sizes.length]);
+      expect(bytes[bytes.length - 1]).toBe(0);
+      bytes[bytes.length - 1] = i & 0xff;
+      checksum += bytes[bytes.length - 1];
+      if (i % 100 === 99 && typeof gc === "function") {
+        gc();
+      }
+    }
+    var stats = __getArrayBufferAllocatorStats();
+    console.log("2000 ArrayBuffers of 4KB to 1MB: " + (performance.now() - start).toFixed(2) + "ms" +
+      (stats ? ", " + stats.reused + " reused, peak " + stats.peakBytes + " bytes" : ""));
+    expect(checksum > 0).toBe(true);
+  });
 });
\ No newline at end of file
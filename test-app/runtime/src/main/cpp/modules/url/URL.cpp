@@ -1,11 +1,45 @@
 #include "URL.h"
 #include "URLSearchParams.h"
+#include <memory>
 #include <string>
 
 using namespace ada;
 using namespace tns;
 
 namespace {
+    /*
+     * The UTF-8 of a string argument, short strings don't allocate
+     */
+    class Utf8Arg {
+    public:
+        Utf8Arg(napi_env env, napi_value value)
+                : data_(stack_), length_(0), ok_(false) {
+            if (napi_get_value_string_utf8(env, value, nullptr, 0, &length_) != napi_ok) {
+                return;
+            }
+            if (length_ >= sizeof(stack_)) {
+                heap_.reset(new char[length_ + 1]);
+                data_ = heap_.get();
+            }
+            ok_ = napi_get_value_string_utf8(env, value, data_, length_ + 1, &length_) == napi_ok;
+        }
+
+        bool ok() const {
+            return ok_;
+        }
+
+        std::string_view view() const {
+            return {data_, length_};
+        }
+
+    private:
+        char stack_[256];
+        std::unique_ptr<char[]> heap_;
+        char *data_;
+        size_t length_;
+        bool ok_;
+    };
+
     URL *GetInstance(napi_env env, napi_callback_info info) {
         NAPI_PREAMBLE
         napi_value jsThis;
@@ -22,22 +56,12 @@ namespace {
         return instance;
     }
 
-    template<typename Getter>
-    napi_value GetUrlProperty(napi_env env, napi_callback_info info,
-                              Getter getter) {
-        NAPI_PREAMBLE
+    napi_value GetUrlProperty(napi_env env, napi_callback_info info, URL::Component component) {
         URL *instance = GetInstance(env, info);
         if (!instance)
             return nullptr;
 
-        auto value = (instance->GetURL()->*getter)();
-
-        napi_value result;
-        NAPI_GUARD(napi_create_string_utf8(env, value.data(), value.length(), &result)) {
-            return nullptr;
-        }
-
-        return result;
+        return instance->GetComponent(env, component);
     }
 
     template<typename Setter>
@@ -51,69 +75,135 @@ namespace {
         if (argc < 1)
             return nullptr;
 
-        size_t str_size;
-        NAPI_GUARD(napi_get_value_string_utf8(env, argv[0], nullptr, 0, &str_size)) {
+        Utf8Arg value(env, argv[0]);
+        if (!value.ok())
             return nullptr;
-        }
 
-        std::vector<char> buffer(str_size + 1);
-        NAPI_GUARD(napi_get_value_string_utf8(env, argv[0], buffer.data(), str_size + 1, nullptr)) {
-            return nullptr;
-        }
-
-        (instance->GetURL()->*setter)(buffer.data());
+        (instance->GetURL()->*setter)(value.view());
+        instance->Invalidate();
         return napi_util::get_true(env);
     }
 }
 
-URL::URL(url_aggregator url) : url_(url) {}
+URL::URL(url_aggregator url)
+        : url_(std::move(url)), env_(nullptr), cache_(nullptr), read_(0), cached_(0) {}
+
+URL::~URL() {
+    if (cache_ != nullptr) {
+        napi_delete_reference(env_, cache_);
+    }
+}
 
 url_aggregator *URL::GetURL() {
     return &url_;
 }
 
+void URL::Invalidate() {
+    read_ = 0;
+    cached_ = 0;
+}
+
+napi_value URL::CreateComponent(napi_env env, Component component) {
+    std::string origin;
+    std::string_view value;
+    switch (component) {
+        case Hash: value = url_.get_hash(); break;
+        case Host: value = url_.get_host(); break;
+        case HostName: value = url_.get_hostname(); break;
+        case Href: value = url_.get_href(); break;
+        case Origin: origin = url_.get_origin(); value = origin; break;
+        case Password: value = url_.get_password(); break;
+        case PathName: value = url_.get_pathname(); break;
+        case Port: value = url_.get_port(); break;
+        case Protocol: value = url_.get_protocol(); break;
+        case Search: value = url_.get_search(); break;
+        case UserName: value = url_.get_username(); break;
+        default: break;
+    }
+
+    napi_value result;
+    if (napi_create_string_utf8(env, value.data(), value.length(), &result) != napi_ok) {
+        return nullptr;
+    }
+    return result;
+}
+
+napi_value URL::GetComponent(napi_env env, Component component) {
+    uint32_t bit = 1u << component;
+    napi_value cache = nullptr;
+    if (cached_ & bit) {
+        napi_value result;
+        napi_get_reference_value(env, cache_, &cache);
+        napi_get_element(env, cache, component, &result);
+        return result;
+    }
+
+    auto result = CreateComponent(env, component);
+    if (result == nullptr) {
+        return nullptr;
+    }
+
+    // a url that is read once, like most of the parsed ones, doesn't pay for the cache
+    if ((read_ & bit) == 0) {
+        read_ |= bit;
+        return result;
+    }
+
+    if (cache_ == nullptr) {
+        napi_create_array_with_length(env, ComponentCount, &cache);
+        napi_create_reference(env, cache, 1, &cache_);
+        env_ = env;
+    } else {
+        napi_get_reference_value(env, cache_, &cache);
+    }
+    napi_set_element(env, cache, component, result);
+    cached_ |= bit;
+
+    return result;
+}
+
 napi_value URL::GetHash(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_hash);
+    return GetUrlProperty(env, info, Hash);
 }
 
 napi_value URL::GetHost(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_host);
+    return GetUrlProperty(env, info, Host);
 }
 
 napi_value URL::GetHostName(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_hostname);
+    return GetUrlProperty(env, info, HostName);
 }
 
 napi_value URL::GetHref(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_href);
+    return GetUrlProperty(env, info, Href);
 }
 
 napi_value URL::GetOrigin(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_origin);
+    return GetUrlProperty(env, info, Origin);
 }
 
 napi_value URL::GetPassword(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_password);
+    return GetUrlProperty(env, info, Password);
 }
 
 napi_value URL::GetPathName(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_pathname);
+    return GetUrlProperty(env, info, PathName);
 }
 
 napi_value URL::GetPort(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_port);
+    return GetUrlProperty(env, info, Port);
 }
 
 napi_value URL::GetProtocol(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_protocol);
+    return GetUrlProperty(env, info, Protocol);
 }
 
 napi_value URL::GetSearch(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_search);
+    return GetUrlProperty(env, info, Search);
 }
 
 napi_value URL::GetUserName(napi_env env, napi_callback_info info) {
-    return GetUrlProperty(env, info, &url_aggregator::get_username);
+    return GetUrlProperty(env, info, UserName);
 }
 
 napi_value URL::SetHash(napi_env env, napi_callback_info info) {
@@ -159,19 +249,13 @@ napi_value URL::SetUserName(napi_env env, napi_callback_info info) {
 
 // Add toString method
 napi_value URL::ToString(napi_env env, napi_callback_info info) {
-    NAPI_PREAMBLE
-    URL *instance = GetInstance(env, info);
-    if (!instance)
-        return nullptr;
-
-    auto value = instance->GetURL()->get_href();
-
-    napi_value result;
-    NAPI_GUARD(napi_create_string_utf8(env, value.data(), value.length(), &result)) {
-        return nullptr;
-    }
+    return GetUrlProperty(env, info, Href);
+}
 
-    return result;
+namespace {
+    // the url parseMany is constructing an instance for. Native code can create externals too, so
+    // the constructor only takes one that points to it, without reading the data of any other
+    thread_local url_aggregator *t_parsedUrl = nullptr;
 }
 
 // Constructor
@@ -183,57 +267,51 @@ napi_value URL::New(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
-    size_t str_size;
-    NAPI_GUARD(napi_get_value_string_utf8(env, argv[0], nullptr, 0, &str_size)) {
-        return nullptr;
-    }
-
-    std::vector<char> url_buffer(str_size + 1);
-    NAPI_GUARD(napi_get_value_string_utf8(env, argv[0], url_buffer.data(), str_size + 1, nullptr)) {
-        return nullptr;
-    }
-
-    url_aggregator url;
-    std::string_view url_string_view(url_buffer.data(), url_buffer.size());
-
-    if (argc > 1) {
-        // Handle base URL
-        size_t base_str_size;
-        NAPI_GUARD(napi_get_value_string_utf8(env, argv[1], nullptr, 0, &base_str_size)) {
+    // parseMany passes the url it already parsed
+    if (t_parsedUrl != nullptr && napi_util::is_of_type(env, argv[0], napi_external)) {
+        url_aggregator *parsed;
+        NAPI_GUARD(napi_get_value_external(env, argv[0], reinterpret_cast<void **>(&parsed))) {
             return nullptr;
         }
-
-        std::vector<char> base_buffer(base_str_size + 1);
-        NAPI_GUARD(napi_get_value_string_utf8(env, argv[1], base_buffer.data(), base_str_size + 1,
-                                              nullptr)) {
+        if (parsed != t_parsedUrl) {
+            napi_throw_type_error(env, nullptr, "Invalid URL");
             return nullptr;
         }
+        t_parsedUrl = nullptr;
+        URL *urlImpl = new URL(std::move(*parsed));
+        napi_wrap(env, jsThis, urlImpl, URL::Destructor, urlImpl, nullptr);
+        return jsThis;
+    }
 
-        std::string_view base_string_view(base_buffer.data(), base_buffer.size());
+    Utf8Arg input(env, argv[0]);
+    if (!input.ok()) {
+        return nullptr;
+    }
 
-        if (!can_parse(url_string_view, &base_string_view)) {
-            napi_throw_type_error(env, nullptr, "Invalid URL");
+    ada::result<url_aggregator> result;
+    if (argc > 1 && !napi_util::is_undefined(env, argv[1])) {
+        // Handle base URL
+        Utf8Arg base(env, argv[1]);
+        if (!base.ok()) {
             return nullptr;
         }
 
-        auto base_url = ada::parse<ada::url_aggregator>(base_string_view, nullptr);
-        auto result = ada::parse<ada::url_aggregator>(url_string_view, &base_url.value());
-
-        if (!result) {
+        auto base_url = ada::parse<url_aggregator>(base.view(), nullptr);
+        if (!base_url) {
             napi_throw_type_error(env, nullptr, "Invalid URL");
             return nullptr;
         }
-        url = result.value();
+        result = ada::parse<url_aggregator>(input.view(), &base_url.value());
     } else {
-        auto result = ada::parse<ada::url_aggregator>(url_string_view, nullptr);
-        if (!result) {
-            napi_throw_type_error(env, nullptr, "Invalid URL");
-            return nullptr;
-        }
-        url = result.value();
+        result = ada::parse<url_aggregator>(input.view(), nullptr);
     }
 
-    URL *urlImpl = new URL(url);
+    if (!result) {
+        napi_throw_type_error(env, nullptr, "Invalid URL");
+        return nullptr;
+    }
+
+    URL *urlImpl = new URL(std::move(result.value()));
     napi_wrap(env, jsThis, urlImpl, URL::Destructor, urlImpl, nullptr);
 
     return jsThis;
@@ -248,41 +326,94 @@ napi_value URL::CanParse(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
-    size_t str_size;
-    NAPI_GUARD(napi_get_value_string_utf8(env, argv[0], nullptr, 0, &str_size)) {
+    Utf8Arg input(env, argv[0]);
+    if (!input.ok()) {
         return nullptr;
     }
 
-    std::vector<char> buffer(str_size + 1);
-    NAPI_GUARD(napi_get_value_string_utf8(env, argv[0], buffer.data(), str_size + 1, nullptr)) {
+    bool result;
+    if (argc > 1 && !napi_util::is_undefined(env, argv[1])) {
+        Utf8Arg base(env, argv[1]);
+        if (!base.ok()) {
+            return nullptr;
+        }
+
+        auto base_view = base.view();
+        result = can_parse(input.view(), &base_view);
+    } else {
+        result = can_parse(input.view(), nullptr);
+    }
+
+    return result ? napi_util::get_true(env) : napi_util::get_false(env);
+}
+
+// Static method, parses an array of strings against an optional base, parsed once, into an array
+// of URLs with null for the invalid ones
+napi_value URL::ParseMany(napi_env env, napi_callback_info info) {
+    NAPI_CALLBACK_BEGIN(2)
+
+    bool isArray = false;
+    if (argc > 0) {
+        napi_is_array(env, argv[0], &isArray);
+    }
+    if (!isArray) {
+        napi_throw_type_error(env, nullptr, "parseMany requires an array of strings");
         return nullptr;
     }
 
-    bool result;
-    if (argc > 1) {
-        size_t base_str_size;
-        NAPI_GUARD(napi_get_value_string_utf8(env, argv[1], nullptr, 0, &base_str_size)) {
+    ada::result<url_aggregator> base_url;
+    url_aggregator *base_pointer = nullptr;
+    if (argc > 1 && !napi_util::is_undefined(env, argv[1])) {
+        Utf8Arg base(env, argv[1]);
+        if (!base.ok()) {
             return nullptr;
         }
 
-        std::vector<char> base_buffer(base_str_size + 1);
-        NAPI_GUARD(napi_get_value_string_utf8(env, argv[1], base_buffer.data(), base_str_size + 1,
-                                              nullptr)) {
+        base_url = ada::parse<url_aggregator>(base.view(), nullptr);
+        if (!base_url) {
+            napi_throw_type_error(env, nullptr, "Invalid base URL");
             return nullptr;
         }
+        base_pointer = &base_url.value();
+    }
 
-        std::string_view base_string_view(base_buffer.data());
-        result = can_parse(buffer.data(), &base_string_view);
-    } else {
-        result = can_parse(buffer.data(), nullptr);
+    // every runtime, workers included, has its own URL class
+    napi_value ctor;
+    NAPI_GUARD(napi_get_named_property(env, napi_util::global(env), "URL", &ctor)) {
+        return nullptr;
     }
 
-    napi_value returnValue;
-    NAPI_GUARD(napi_get_boolean(env, result, &returnValue)) {
+    uint32_t length;
+    napi_get_array_length(env, argv[0], &length);
+
+    napi_value result;
+    NAPI_GUARD(napi_create_array_with_length(env, length, &result)) {
         return nullptr;
     }
 
-    return returnValue;
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value item;
+        napi_get_element(env, argv[0], i, &item);
+
+        napi_value url = napi_util::null(env);
+        if (napi_util::is_of_type(env, item, napi_string)) {
+            Utf8Arg input(env, item);
+            auto parsed = ada::parse<url_aggregator>(input.view(), base_pointer);
+            if (parsed) {
+                napi_value external;
+                napi_create_external(env, &parsed.value(), nullptr, nullptr, &external);
+                t_parsedUrl = &parsed.value();
+                auto newStatus = napi_new_instance(env, ctor, 1, &external, &url);
+                t_parsedUrl = nullptr;
+                NAPI_GUARD(newStatus) {
+                    return nullptr;
+                }
+            }
+        }
+        napi_set_element(env, result, i, url);
+    }
+
+    return result;
 }
 
 void URL::Destructor(napi_env env, void *data, void *hint) {
@@ -319,9 +450,10 @@ void URL::Init(napi_env env) {
     }
 
     // Add static methods
-    static const int static_prop_count = 1;
+    static const int static_prop_count = 2;
     napi_property_descriptor static_properties[static_prop_count] = {
-            {"canParse", nullptr, CanParse, nullptr, nullptr, nullptr, napi_static, nullptr},
+            {"canParse",  nullptr, CanParse,  nullptr, nullptr, nullptr, napi_static, nullptr},
+            {"parseMany", nullptr, ParseMany, nullptr, nullptr, nullptr, napi_static, nullptr},
     };
 
     NAPI_GUARD(napi_define_properties(env, ctor,
@@ -3,6 +3,7 @@
 
 #include "native_api_util.h"
 #include "ada/ada.h"
+#include <cstdint>
 #include <vector>
 
 using namespace ada;
@@ -12,13 +13,46 @@ namespace tns {
         static void Init(napi_env env);
         static void Destructor(napi_env env, void* nativeObject, void* finalize_hint);
 
+        /*
+         * The components of the URL, as indexes of the string cache
+         */
+        enum Component {
+            Hash,
+            Host,
+            HostName,
+            Href,
+            Origin,
+            Password,
+            PathName,
+            Port,
+            Protocol,
+            Search,
+            UserName,
+            ComponentCount
+        };
+
         explicit URL(url_aggregator url);
+        ~URL();
         url_aggregator* GetURL();
 
+        /*
+         * The JS string of a component. A component read a second time is kept in a per instance
+         * cache until the next setter call, so repeated reads return the same string without copying
+         * it out of the url again.
+         */
+        napi_value GetComponent(napi_env env, Component component);
+
+        /*
+         * Drops the cached strings, the setters can change any component
+         */
+        void Invalidate();
+
     private:
         static napi_value New(napi_env env, napi_callback_info info);
         static napi_ref constructor;
 
+        napi_value CreateComponent(napi_env env, Component component);
+
         static napi_value GetHash(napi_env env, napi_callback_info info);
         static napi_value SetHash(napi_env env, napi_callback_info info);
 
@@ -53,8 +87,15 @@ namespace tns {
 
         static napi_value ToString(napi_env env, napi_callback_info info);
         static napi_value CanParse(napi_env env, napi_callback_info info);
+        static napi_value ParseMany(napi_env env, napi_callback_info info);
 
         url_aggregator url_;
+        napi_env env_;
+        // an array with the cached component strings
+        napi_ref cache_;
+        // bit sets of the components that were read and that are in the cache
+        uint32_t read_;
+        uint32_t cached_;
     };
 }
 
@@ -0,0 +1,328 @@
+/**
+ * Copyright (c) 2017 Node.js API collaborators. All Rights Reserved.
+ *
+ * Use of this source code is governed by a MIT license that can be
+ * found in the LICENSE file in the root of the source tree.
+ */
+
+// Copyright 2024 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "code_cache.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#if OS_ANDROID
+#include "basic/log/logging.h"
+#else
+#define VLOGD(...) ((void)0)
+#endif  // OS_ANDROID
+
+#ifdef PROFILE_CODECACHE
+#define INCREASE(target) ++(target)
+#else
+#define INCREASE(target)
+#endif  // PROFILE_CODECACHE
+
+constexpr double CacheBlob::MAGIC;
+
+CacheBlob::~CacheBlob() {
+  for (auto it : cache_map_) delete it.second;
+  if (mapping_) munmap(mapping_, mapping_size_);
+}
+
+bool CacheBlob::insert(const std::string& filename, const uint8_t* data,
+                       int length) {
+  // too large (more than half of MAX) cached data must be discarded
+  if (length == 0 || data == nullptr) {
+    INCREASE(expired_query_);
+    return false;
+  }
+  uint32_t checksum = CachedData::checksum(data, length);
+  std::unique_lock<std::mutex> lock(write_mutex_);
+  auto it = cache_map_.find(filename);
+  if (it != cache_map_.end()) {
+    // the file holds the old unit, rewrite it as a whole
+    remove_unit(it);
+    switch_to_writing();
+  }
+  if (!get_enough_space(length)) {
+    delete[] data;
+    return false;
+  }
+
+  CachedData* target = new CachedData(length, data, filename);
+  target->checksum_ = checksum;
+  cache_map_[filename] = target;
+  if (mode_ == kAppending) append_vec_.push_back(target);
+  INCREASE(target->used_times_);
+  heat_ranking_.insert(target);
+  current_size_ += length;
+
+  return true;
+}
+
+// That len will be not nullptr is ensured by the context.
+const CachedData* CacheBlob::find(const std::string& filename, int* len) {
+  INCREASE(total_query_);
+  // output holds the lock while it copies the units, don't wait for it
+  if (!write_mutex_.try_lock()) {
+    INCREASE(missed_query_);
+    *len = -1;
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(write_mutex_, std::adopt_lock);
+  auto it = cache_map_.find(filename);
+  if (it == cache_map_.end()) {
+    INCREASE(missed_query_);
+    *len = 0;
+    return nullptr;
+  }
+
+  CachedData* result = it->second;
+  if (!result->verified_) {
+    if (CachedData::checksum(result->data_, result->length_) !=
+        result->checksum_) {
+      // the file was corrupted, rewrite it without the unit
+      remove_unit(it);
+      switch_to_writing();
+      INCREASE(expired_query_);
+      *len = 0;
+      return nullptr;
+    }
+    result->verified_ = true;
+  }
+
+  // every time a cache is searched, its heat-ranking
+  // rises and thus the ranking list changes
+  heat_ranking_.erase(result);
+  ++result->used_times_;
+  heat_ranking_.insert(result);
+  *len = result->length_;
+
+  // NOTE:
+  // The result cached data is safe beyond this scope,
+  // because units are only deleted by insert and remove,
+  // which are called from the thread of the caller.
+  return result;
+}
+
+void CacheBlob::remove(const std::string& filename) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  auto it = cache_map_.find(filename);
+  if (it != cache_map_.end()) {
+    remove_unit(it);
+    switch_to_writing();
+  }
+}
+
+void CacheBlob::remove_unit(CacheMap::iterator it) {
+  CachedData* unit = it->second;
+  current_size_ -= unit->length_;
+  heat_ranking_.erase(unit);
+  cache_map_.erase(it);
+  delete unit;
+}
+
+void CacheBlob::switch_to_writing() {
+  mode_ = kWriting;
+  append_vec_.clear();
+}
+
+// cache file structure:
+// Header:
+// | magic number      | --> 8 bytes
+// Body  :
+// | file name size    | --> 2 bytes
+// | file name         | --> x bytes
+// | cache data length | --> 4 bytes
+// | checksum          | --> 4 bytes
+// | cache data        | --> y bytes
+// ...
+void CacheBlob::output() {
+  std::lock_guard<std::mutex> output_lock(output_mutex_);
+
+  // copy the units while holding the lock, write them without it
+  std::string bytes;
+  bool appending;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (mode_ == kAppending && append_vec_.empty()) return;
+    appending = mode_ == kAppending;
+    if (appending) {
+      for (auto it : append_vec_) write_cache_unit(&bytes, it);
+    } else {
+      size_t total = DOUBLE_SIZE + current_size_;
+      for (auto& it : cache_map_) total += SHORT_SIZE + 2 * INT_SIZE + it.first.size();
+      bytes.reserve(total);
+      bytes.append(reinterpret_cast<const char*>(&MAGIC), DOUBLE_SIZE);
+      for (auto& it : cache_map_) write_cache_unit(&bytes, it.second);
+    }
+    // from now on the file holds the blob, the units inserted meanwhile
+    // are appended by the next output
+    mode_ = kAppending;
+    append_vec_.clear();
+  }
+
+  bool succeeded;
+  if (appending) {
+    succeeded = write_file(target_path_, bytes, "ab");
+  } else {
+    // never truncate the file, the units loaded by input still point into it
+    std::string temp_path = target_path_ + ".tmp" + std::to_string(getpid()) +
+                            "-" + std::to_string(reinterpret_cast<uintptr_t>(this));
+    succeeded = write_file(temp_path, bytes, "wb") &&
+                rename(temp_path.c_str(), target_path_.c_str()) == 0;
+    if (!succeeded) unlink(temp_path.c_str());
+  }
+
+  if (succeeded) {
+    VLOGD("codecache: output cache file %s succeed.\n", target_path_.c_str());
+  } else {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    switch_to_writing();
+  }
+}
+
+bool CacheBlob::write_file(const std::string& path, const std::string& bytes,
+                           const char* mode) {
+  FILE* file_out = fopen(path.c_str(), mode);
+  if (!file_out) return false;
+  bool succeeded = fwrite(bytes.data(), 1, bytes.size(), file_out) == bytes.size();
+  return fclose(file_out) == 0 && succeeded;
+}
+
+// steps to rebuild blob:
+// 1. map the file and check magic number;
+// 2. read 2 bytes to get the size (x) of file name;
+// 3. read x bytes to get the file name;
+// 4. read 4 bytes to get the size (y) of cache data;
+// 5. read 4 bytes to get the checksum of cache data, checked by find;
+// 6. the next y bytes are the actual content of cache data;
+// 7. go back to step 2 until the end of the file
+bool CacheBlob::input() {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (mapping_) return false;
+
+  int fd = open(target_path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  struct stat st;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > DOUBLE_SIZE) {
+    mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  const uint8_t* cursor = static_cast<const uint8_t*>(mapping);
+  const uint8_t* end = cursor + st.st_size;
+  double maybe_magic;
+  memcpy(&maybe_magic, cursor, DOUBLE_SIZE);
+  // check whether file is valid.
+  if (maybe_magic != MAGIC) {
+    munmap(mapping, st.st_size);
+    return false;
+  }
+
+  mapping_ = mapping;
+  mapping_size_ = st.st_size;
+  mode_ = kAppending;
+  cursor += DOUBLE_SIZE;
+  while (cursor < end) {
+    if (!read_cache_unit(&cursor, end)) {
+      // an output was interrupted, drop its tail with the next output
+      switch_to_writing();
+      break;
+    }
+  }
+  return true;
+}
+
+#ifdef PROFILE_CODECACHE
+void CacheBlob::dump_status(void* p) {
+  std::vector<std::pair<std::string, int> >* status_vec =
+      reinterpret_cast<std::vector<std::pair<std::string, int> >*>(p);
+  status_vec->push_back(std::pair<std::string, int>("Total", total_query_));
+  status_vec->push_back(std::pair<std::string, int>("Missed", missed_query_));
+  status_vec->push_back(std::pair<std::string, int>("Expired", expired_query_));
+  status_vec->push_back(std::pair<std::string, int>(
+      "Updated", mode_ == kAppending && append_vec_.empty() ? 0 : 1));
+  status_vec->push_back(std::pair<std::string, int>("Size", current_size_));
+  status_vec->push_back(std::pair<std::string, int>("Heat Ranking, total ",
+                                                    heat_ranking_.size()));
+  for (auto it = heat_ranking_.rbegin(); it != heat_ranking_.rend(); ++it) {
+    CachedData* dt = *it;
+    status_vec->push_back(
+        std::pair<std::string, int>(dt->file_name_, dt->used_times_));
+  }
+}
+#endif  // PROFILE_CODECACHE
+
+void CacheBlob::write_cache_unit(std::string* out, const CachedData* unit) {
+  // write file name
+  uint16_t size = static_cast<uint16_t>(unit->file_name_.size());
+  out->append(reinterpret_cast<const char*>(&size), SHORT_SIZE);
+  out->append(unit->file_name_.c_str(), size);
+
+  uint32_t length = unit->length_;
+  out->append(reinterpret_cast<const char*>(&length), INT_SIZE);
+  out->append(reinterpret_cast<const char*>(&unit->checksum_), INT_SIZE);
+  out->append(reinterpret_cast<const char*>(unit->data_), unit->length_);
+}
+
+bool CacheBlob::read_cache_unit(const uint8_t** cursor, const uint8_t* end) {
+  const uint8_t* p = *cursor;
+  uint16_t filename_length;
+  if (end - p < SHORT_SIZE) return false;
+  memcpy(&filename_length, p, SHORT_SIZE);
+  p += SHORT_SIZE;
+  if (end - p < filename_length + 2 * INT_SIZE) return false;
+  std::string name(reinterpret_cast<const char*>(p), filename_length);
+  p += filename_length;
+
+  uint32_t data_length;
+  memcpy(&data_length, p, INT_SIZE);
+  p += INT_SIZE;
+  uint32_t checksum;
+  memcpy(&checksum, p, INT_SIZE);
+  p += INT_SIZE;
+  if (static_cast<size_t>(end - p) < data_length) return false;
+  *cursor = p + data_length;
+
+  // a unit appended again replaces the one before it
+  auto it = cache_map_.find(name);
+  if (it != cache_map_.end()) remove_unit(it);
+  if (!get_enough_space(static_cast<int>(data_length))) return true;
+
+  CachedData* cd =
+      new CachedData(static_cast<int>(data_length), p, name, false);
+  cd->checksum_ = checksum;
+  cd->verified_ = false;
+  current_size_ += data_length;
+  heat_ranking_.insert(cd);
+  cache_map_[name] = cd;
+  return true;
+}
+
+bool CacheBlob::get_enough_space(int data_size) {
+  // 0. check whether available space is enough
+  if (data_size > max_capacity_) return false;
+  // 1. evict the coldest units, each eviction costs O(log n)
+  while (current_size_ + data_size > max_capacity_) {
+    CachedData* coldest = *heat_ranking_.begin();
+    remove_unit(cache_map_.find(coldest->file_name_));
+    // the file holds the evicted unit, rewrite it as a whole
+    switch_to_writing();
+  }
+  return true;
+}
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2017 Node.js API collaborators. All Rights Reserved.
+ *
+ * Use of this source code is governed by a MIT license that can be
+ * found in the LICENSE file in the root of the source tree.
+ */
+
+// Copyright 2024 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef SRC_NAPI_COMMON_CODE_CACHE_H_
+#define SRC_NAPI_COMMON_CODE_CACHE_H_
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct CachedData {
+  CachedData() : length_(0), data_(nullptr), file_name_(""), owned_(true) {}
+
+  // `data` is deleted with the unit unless it is not `owned`, e.g. when it
+  // points into the mapped cache file.
+  CachedData(int length, const uint8_t* data, const std::string& name,
+             bool owned = true)
+      : length_(length), data_(data), file_name_(name), owned_(owned) {}
+
+  // carefully copy and move objects of this class
+  ~CachedData() {
+    if (data_ && owned_) delete[] data_;
+  }
+
+  // hotter units first: used more often, then larger
+  static bool compare(const CachedData* left, const CachedData* right) {
+    if (left->used_times_ > right->used_times_) {
+      return true;
+    } else if (left->used_times_ < right->used_times_) {
+      return false;
+    } else {
+      return left->length_ > right->length_;
+    }
+  }
+
+  // FNV-1a of the data, units loaded from the file are checked against it
+  // the first time they are found
+  static uint32_t checksum(const uint8_t* data, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+      hash ^= data[i];
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  int used_times_ = 0;
+  int length_;
+  const uint8_t* data_;
+  const std::string file_name_;
+  bool owned_;
+  uint32_t checksum_ = 0;
+  bool verified_ = true;
+};
+
+// Orders the units from the coldest to the hottest, the reverse of
+// CachedData::compare, with the name to tell equally hot units apart.
+struct ColderFirst {
+  bool operator()(const CachedData* left, const CachedData* right) const {
+    if (CachedData::compare(right, left)) return true;
+    if (CachedData::compare(left, right)) return false;
+    return left->file_name_ < right->file_name_;
+  }
+};
+
+typedef std::unordered_map<std::string, CachedData*> CacheMap;
+typedef std::vector<CachedData*> CacheVector;
+typedef std::set<CachedData*, ColderFirst> HeatRanking;
+#define SHORT_SIZE 2
+#define INT_SIZE 4
+#define DOUBLE_SIZE 8
+
+class CacheBlob {
+ private:
+  enum CacheMode { kWriting, kAppending };
+  // changes with the layout of the units, files of another layout are ignored
+  static constexpr double MAGIC = 2.71828182;
+
+ public:
+  explicit CacheBlob(const std::string& path, int max_cap = 1 << 20)
+      : current_size_(0),
+        target_path_(path),
+        max_capacity_(max_cap) {}
+
+  virtual ~CacheBlob();
+
+  // NOTE: insert, find and remove must be called from one thread, output may
+  // run on any other thread at the same time.
+  // The blob takes ownership of `data`, which must be allocated with new[].
+  bool insert(const std::string& filename, const uint8_t* data, int length);
+  // Returns null with `len` 0 for a miss and with `len` -1 when output holds
+  // the blob, in which case the caller should not insert the unit either.
+  // A unit whose data does not match its checksum is dropped and misses.
+  const CachedData* find(const std::string& filename, int* len);
+  void remove(const std::string& filename);
+  // Writes the units added since the last input or output to the end of the
+  // cache file, or the whole blob to a new file that replaces it when units
+  // were removed.
+  void output();
+  // Maps the cache file, the units loaded from it point into the mapping.
+  bool input();
+  int size() const { return current_size_; }
+
+#ifdef PROFILE_CODECACHE
+  void dump_status(void* p);
+#endif  // PROFILE_CODECACHE
+
+ private:
+  static void write_cache_unit(std::string* out, const CachedData* unit);
+  bool read_cache_unit(const uint8_t** cursor, const uint8_t* end);
+  void remove_unit(CacheMap::iterator it);
+  void switch_to_writing();
+  // Evicts the coldest units until `data_size` more bytes fit.
+  bool get_enough_space(int data_size);
+  static bool write_file(const std::string& path, const std::string& bytes,
+                         const char* mode);
+
+  CacheMap cache_map_;
+  // ranking of the units by their frequency of being used.
+  HeatRanking heat_ranking_;
+  int current_size_;
+  const std::string target_path_;
+  int max_capacity_;
+  // guards the units against output, which runs on another thread
+  std::mutex write_mutex_;
+  // serializes output calls
+  std::mutex output_mutex_;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+
+#ifdef PROFILE_CODECACHE
+  mutable int total_query_ = 0;
+  mutable int missed_query_ = 0;
+  mutable int expired_query_ = 0;
+#endif  // PROFILE_CODECACHE
+  CacheMode mode_ = kWriting;
+  // units that are not in the cache file yet, used in kAppending mode
+  CacheVector append_vec_;
+};
+
+#endif  // SRC_NAPI_COMMON_CODE_CACHE_H_
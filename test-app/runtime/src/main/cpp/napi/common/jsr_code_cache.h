@@ -0,0 +1,233 @@
+#ifndef TEST_APP_JSR_CODE_CACHE_H
+#define TEST_APP_JSR_CODE_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include "code_cache.h"
+#include "js_native_api.h"
+
+/*
+ * The bytecode of compiled scripts, for the engines that can serialize it. It is looked up in two
+ * CacheBlobs: the read-only bundle precompiled with the app (see napi/quickjs/tools) and the cache
+ * of the scripts compiled on the device, which is written out on a background thread.
+ *
+ * Scripts are keyed by their file, relative to the app root, and the FNV-1a hash of their source
+ * seeded with the engine version: bytecode only ever runs for the exact source and engine that
+ * produced it, a changed file or an engine update simply misses.
+ *
+ * Every runtime has its own cache, but only the first one that opens a cache file writes to it, the
+ * ones of the worker threads started after it only read the file as it was when they started.
+ * Units whose data does not match its checksum are dropped by the blob.
+ *
+ * Find, Store and Remove must be called on the JS thread of the env.
+ */
+class JsrCodeCache {
+public:
+    explicit JsrCodeCache(const std::string &engineVersion)
+            : m_seed(Hash(engineVersion.data(), engineVersion.size(), FNV_OFFSET)) {
+    }
+
+    void SetCachePath(const std::string &path) {
+        m_writer.reset();
+        m_cache = std::make_shared<CacheBlob>(path, CACHE_CAPACITY);
+        m_flushPending = std::make_shared<std::atomic<bool>>(false);
+        m_cache->input();
+
+        // blobs append to and replace their file without coordinating with each other
+        std::lock_guard<std::mutex> lock(WritersMutex());
+        if (Writers().insert(path).second) {
+            m_writer = std::make_shared<WriterClaim>(path);
+        }
+    }
+
+    /*
+     * Maps the bundle at `path`, built for the app at `root`, and keys the cached scripts of the
+     * app relative to `root` too. Returns false when there is no bundle.
+     */
+    bool SetBundle(const std::string &path, const std::string &root) {
+        m_root = root;
+        auto bundle = std::unique_ptr<CacheBlob>(new CacheBlob(path, INT_MAX));
+        if (!bundle->input()) {
+            return false;
+        }
+        m_bundle = std::move(bundle);
+        return true;
+    }
+
+    bool Enabled() const {
+        return m_cache != nullptr || m_bundle != nullptr;
+    }
+
+    bool CanStore() const {
+        return m_cache != nullptr && m_writer != nullptr;
+    }
+
+    std::string Key(const char *file, const char *source, size_t length) const {
+        std::string name(file != nullptr ? file : "");
+        if (name.compare(0, FILE_PROTOCOL_LENGTH, FILE_PROTOCOL) == 0) {
+            name.erase(0, FILE_PROTOCOL_LENGTH);
+        }
+        if (!m_root.empty() && name.compare(0, m_root.size(), m_root) == 0) {
+            name.erase(0, m_root.size());
+        }
+
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) Hash(source, length, m_seed));
+        return name + '#' + hex;
+    }
+
+    /*
+     * Returns the bytecode for `key`, or null with `length` 0 when there is none and with `length`
+     * -1 when the cache is being written out, in which case the script should not be stored
+     */
+    const uint8_t *Find(const std::string &key, int *length) {
+        *length = 0;
+        if (m_bundle) {
+            auto unit = m_bundle->find(key, length);
+            if (unit != nullptr) {
+                return unit->data_;
+            }
+        }
+        if (m_cache) {
+            auto unit = m_cache->find(key, length);
+            if (unit != nullptr) {
+                return unit->data_;
+            }
+        }
+        return nullptr;
+    }
+
+    /*
+     * Adds the bytecode of a script, allocated with new[], and schedules writing the cache out
+     */
+    void Store(const std::string &key, uint8_t *data, size_t length) {
+        if (!CanStore()) {
+            delete[] data;
+            return;
+        }
+        // the blob deletes the data when it doesn't fit
+        if (data != nullptr && m_cache->insert(key, data, (int) length)) {
+            ScheduleFlush();
+        }
+    }
+
+    /*
+     * Drops bytecode the engine failed to load
+     */
+    void Remove(const std::string &key) {
+        if (m_cache) {
+            m_cache->remove(key);
+        }
+    }
+
+    /*
+     * Runs `source` through its bytecode when there is some, or compiles and runs it and stores
+     * its bytecode. `runBytecode(data, length)` returns napi_invalid_arg, without a pending
+     * exception, for bytecode the engine can't load. `runSource(&data, &length)` runs the source
+     * and returns its bytecode allocated with new[], it is called with null pointers when the
+     * bytecode is not needed.
+     */
+    template<typename RunBytecode, typename RunSource>
+    napi_status Run(const char *file, const char *source, size_t length,
+                    RunBytecode runBytecode, RunSource runSource) {
+        auto key = Key(file, source, length);
+        int cachedLength;
+        auto cached = Find(key, &cachedLength);
+        if (cached != nullptr) {
+            napi_status status = runBytecode(cached, (size_t) cachedLength);
+            if (status != napi_invalid_arg) {
+                return status;
+            }
+            Remove(key);
+            cachedLength = 0;
+        }
+
+        // don't wait for the cache while it is written out
+        if (cachedLength != 0 || !CanStore()) {
+            return runSource(nullptr, nullptr);
+        }
+
+        uint8_t *data = nullptr;
+        size_t dataLength = 0;
+        napi_status status = runSource(&data, &dataLength);
+        Store(key, data, dataLength);
+        return status;
+    }
+
+    static uint64_t Hash(const char *data, size_t length, uint64_t hash) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char) data[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+private:
+    static std::mutex &WritersMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // the cache files a JsrCodeCache writes to
+    static std::set<std::string> &Writers() {
+        static std::set<std::string> writers;
+        return writers;
+    }
+
+    /*
+     * Held while the blob may write the file, including by a flush that outlives the env
+     */
+    struct WriterClaim {
+        explicit WriterClaim(const std::string &path) : path(path) {
+        }
+
+        ~WriterClaim() {
+            std::lock_guard<std::mutex> lock(WritersMutex());
+            Writers().erase(path);
+        }
+
+        const std::string path;
+    };
+
+    void ScheduleFlush() {
+        if (m_flushPending->exchange(true)) {
+            return;
+        }
+
+        // the thread shares the blob, it may outlive the env
+        auto blob = m_cache;
+        auto pending = m_flushPending;
+        auto writer = m_writer;
+        std::thread([blob, pending, writer]() {
+            std::this_thread::sleep_for(FLUSH_DELAY);
+            pending->store(false);
+            blob->output();
+        }).detach();
+    }
+
+    static constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+    static constexpr const char *FILE_PROTOCOL = "file://";
+    static constexpr size_t FILE_PROTOCOL_LENGTH = 7;
+    static constexpr int CACHE_CAPACITY = 32 << 20;
+    // the scripts compiled within this time after the first one are written out together
+    static constexpr std::chrono::milliseconds FLUSH_DELAY{2000};
+
+    uint64_t m_seed;
+    std::string m_root;
+    std::unique_ptr<CacheBlob> m_bundle;
+    std::shared_ptr<CacheBlob> m_cache;
+    std::shared_ptr<std::atomic<bool>> m_flushPending;
+    // set when this one writes the cache file
+    std::shared_ptr<WriterClaim> m_writer;
+};
+
+#endif //TEST_APP_JSR_CODE_CACHE_H
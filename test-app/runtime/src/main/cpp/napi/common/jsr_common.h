@@ -21,11 +21,149 @@ napi_status js_execute_script(napi_env env,
 
 napi_status js_execute_pending_jobs(napi_env env);
 
+typedef void (*js_pending_jobs_callback)(napi_env env, void *data);
+
+/*
+ * Registers `callback` to be invoked whenever the engine queued jobs (promise reactions,
+ * FinalizationRegistry cleanups) that it will not run by itself before control returns to the
+ * event loop, e.g. jobs queued by a garbage collection outside of any JS call. Jobs queued while
+ * JS runs are drained by the engines when the outermost call returns and are not reported.
+ *
+ * The callback may be invoked from within the engine and must not call into JS, it is expected
+ * to schedule a js_execute_pending_jobs call. Pass a null callback to unregister. Engines that
+ * cannot tell when this happens return napi_generic_failure.
+ *
+ * While a callback is registered, V8 defers the Node-API finalizers of the objects a GC collects
+ * to js_execute_pending_jobs, which runs them in batches under a time budget and reports the
+ * rest again.
+ */
+napi_status js_set_pending_jobs_callback(napi_env env, js_pending_jobs_callback callback, void *data);
+
+/*
+ * Compiles `source` as the body of a function taking `params` and returns that function.
+ *
+ * The engine takes ownership of `source`: `finalize_cb` is called for it once the engine no
+ * longer references the buffer, which may happen before this function returns when the source
+ * had to be copied. When `finalize_cb` is null the buffer must outlive the runtime
+ * (e.g. it points into the mapped APK) and engines may reference it without copying.
+ *
+ * Only V8 compiles the function from the buffer itself (ASCII sources are referenced, not
+ * copied). The other engines can only evaluate complete scripts and copy the source into
+ * `(function(<params>){ <source>\n})`, see js_compile_wrapped_function.
+ */
+napi_status js_compile_function(napi_env env,
+                                const char *source,
+                                size_t length,
+                                const char *file,
+                                const char *const *params,
+                                size_t param_count,
+                                napi_finalize finalize_cb,
+                                void *finalize_hint,
+                                napi_value *result);
+
+/*
+ * Compiles `source` as js_compile_function will, on the calling thread and without an env, so
+ * that the js_compile_function of the same file and source only has to load the result. Meant
+ * for background threads: the source is not taken over and may be freed once this returns.
+ *
+ * QuickJS keeps the bytecode, Hermes the prepared script and V8 a code cache of the eagerly
+ * compiled function. The other engines return napi_generic_failure.
+ */
+napi_status js_precompile_function(const char *source,
+                                   size_t length,
+                                   const char *file,
+                                   const char *const *params,
+                                   size_t param_count);
+
+/*
+ * Drops what js_precompile_function compiled and no js_compile_function took
+ */
+napi_status js_release_precompiled_functions();
+
 napi_status js_get_engine_ptr(napi_env env, int64_t *engine_ptr);
 napi_status js_adjust_external_memory(napi_env env, int64_t changeInBytes, int64_t* externalMemory);
+/*
+ * Lets the engines that keep their compiled code in a single cache file use the one at `path`.
+ * The scripts compiled by js_compile_function and js_run_cached_script are then looked up in it
+ * by file and source and added when missing, the engine writes the file out in the background.
+ * The other engines ignore it.
+ */
+napi_status js_set_code_cache_path(napi_env env, const char *path);
+
+/*
+ * Lets the engines that can load precompiled code use the bundle at `path`, built for the app
+ * at `root` (see napi/quickjs/tools). Scripts whose source matches the one the bundle was built
+ * from run from it, the others are compiled as usual. The other engines ignore it.
+ */
+napi_status js_set_code_bundle(napi_env env, const char *path, const char *root);
 napi_status js_cache_script(napi_env env, const char *source, const char *file);
 napi_status js_run_cached_script(napi_env env, const char * file, napi_value script, void* cache, napi_value *result);
 
 napi_status js_get_runtime_version(napi_env env, napi_value* version);
 
+/*
+ * Returns an object with the numbers of the allocator the engine creates ArrayBuffers with:
+ * liveBytes, peakBytes, allocations, frees, reused and pooledBytes. Engines that allocate them
+ * in their own heap return napi_generic_failure.
+ */
+napi_status js_get_array_buffer_allocator_stats(napi_env env, napi_value* result);
+
+/*
+ * Creates a strong reference to `value` for code that holds it briefly and deletes it with
+ * napi_delete_reference, e.g. the callback of a timer. It takes no finalizer and the engines
+ * may leave it out of what they release with the env, so it must be deleted before the env is
+ * freed. Engines without a cheaper kind of reference create a regular one with a count of 1.
+ */
+napi_status js_create_strong_reference(napi_env env, napi_value value, napi_ref* result);
+
+#ifdef __cplusplus
+#include <string>
+
+inline std::string js_function_source_prologue(const char *const *params, size_t param_count) {
+    std::string prologue("(function(");
+    for (size_t i = 0; i < param_count; i++) {
+        if (i > 0) prologue += ", ";
+        prologue += params[i];
+    }
+    prologue += "){ ";
+
+    return prologue;
+}
+
+inline std::string js_wrap_function_source(const char *source,
+                                           size_t length,
+                                           const char *const *params,
+                                           size_t param_count) {
+    // the prologue is kept on the first line so that line numbers match the original source
+    std::string wrapped = js_function_source_prologue(params, param_count);
+    wrapped.reserve(wrapped.size() + length + 3);
+    wrapped.append(source, length);
+    wrapped += "\n})";
+
+    return wrapped;
+}
+
+/*
+ * js_compile_function for the engines that evaluate complete scripts: wraps the source, releases
+ * the buffer of the caller and hands the wrapper to `evaluate(std::string &wrapped)`, which
+ * evaluates it to the function.
+ */
+template<typename Evaluate>
+inline napi_status js_compile_wrapped_function(napi_env env,
+                                               const char *source,
+                                               size_t length,
+                                               const char *const *params,
+                                               size_t param_count,
+                                               napi_finalize finalize_cb,
+                                               void *finalize_hint,
+                                               Evaluate evaluate) {
+    std::string wrapped = js_wrap_function_source(source, length, params, param_count);
+    if (finalize_cb) {
+        finalize_cb(env, const_cast<char *>(source), finalize_hint);
+    }
+
+    return evaluate(wrapped);
+}
+#endif
+
 #endif //TEST_APP_JSR_COMMON_H
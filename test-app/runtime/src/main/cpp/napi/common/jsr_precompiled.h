@@ -0,0 +1,85 @@
+#ifndef TEST_APP_JSR_PRECOMPILED_H
+#define TEST_APP_JSR_PRECOMPILED_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+ * The code js_precompile_function compiled on background threads (bytecode or a code cache,
+ * depending on the engine), until the js_compile_function of the same file and source takes it.
+ *
+ * Entries are looked up by file first, so that js_compile_function only hashes the source of the
+ * files that were precompiled. Any thread may add or take entries.
+ */
+class JsrPrecompiled {
+public:
+    static void Add(const char *file, const char *source, size_t length,
+                    std::unique_ptr<uint8_t[]> data, size_t dataLength) {
+        auto hash = Hash(source, length);
+        std::lock_guard<std::mutex> lock(Mutex());
+        auto &entry = Entries()[file];
+        entry.sourceHash = hash;
+        entry.data = std::move(data);
+        entry.length = dataLength;
+    }
+
+    /*
+     * The code precompiled for `file`, null when there is none or it was compiled from another source
+     */
+    static std::unique_ptr<uint8_t[]> Take(const char *file, const char *source, size_t length,
+                                           size_t *dataLength) {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(Mutex());
+            auto &entries = Entries();
+            if (entries.empty()) {
+                return nullptr;
+            }
+            auto it = entries.find(file);
+            if (it == entries.end()) {
+                return nullptr;
+            }
+            entry = std::move(it->second);
+            entries.erase(it);
+        }
+
+        if (entry.sourceHash != Hash(source, length)) {
+            return nullptr;
+        }
+        *dataLength = entry.length;
+        return std::move(entry.data);
+    }
+
+    static void Clear() {
+        std::lock_guard<std::mutex> lock(Mutex());
+        Entries().clear();
+    }
+
+private:
+    struct Entry {
+        size_t sourceHash;
+        std::unique_ptr<uint8_t[]> data;
+        size_t length;
+    };
+
+    static size_t Hash(const char *source, size_t length) {
+        return std::hash<std::string_view>{}(std::string_view(source, length));
+    }
+
+    static std::mutex &Mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::unordered_map<std::string, Entry> &Entries() {
+        static std::unordered_map<std::string, Entry> entries;
+        return entries;
+    }
+};
+
+#endif //TEST_APP_JSR_PRECOMPILED_H
@@ -3,7 +3,9 @@
 
 #include "js_native_api.h"
 #include <dlfcn.h>
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 #ifndef NAPI_PREAMBLE
 #define NAPI_PREAMBLE napi_status status;
@@ -26,19 +28,11 @@
   size_t argc;                                                                    \
   void *data;                                                                     \
   napi_value jsThis;                                                              \
-  NAPI_GUARD(napi_get_cb_info(env, info, &argc, nullptr, &jsThis, &data))         \
+  napi_util::CallbackArgs argv;                                                   \
+  NAPI_GUARD(argv.get(env, info, argc, &jsThis, &data))                           \
   {                                                                               \
     NAPI_THROW_LAST_ERROR                                                         \
     return NULL;                                                                  \
-  }                                                                               \
-  std::vector<napi_value> argv(argc);                                             \
-  if (argc > 0)                                                                   \
-  {                                                                               \
-    NAPI_GUARD(napi_get_cb_info(env, info, &argc, argv.data(), nullptr, nullptr)) \
-    {                                                                             \
-      NAPI_THROW_LAST_ERROR                                                       \
-      return NULL;                                                                \
-    }                                                                             \
   }
 
 #define NAPI_ERROR_INFO                                                     \
@@ -88,6 +82,46 @@ napi_util::undefined(env);
 
 namespace napi_util {
 
+    /*
+     * The arguments of a NAPI_CALLBACK_BEGIN_VARGS callback, on the stack unless there are more
+     * than STACK_ARGS of them
+     */
+    class CallbackArgs {
+    public:
+        static constexpr size_t STACK_ARGS = 8;
+
+        CallbackArgs() = default;
+
+        CallbackArgs(const CallbackArgs &) = delete;
+
+        CallbackArgs &operator=(const CallbackArgs &) = delete;
+
+        napi_status get(napi_env env, napi_callback_info info, size_t &argc, napi_value *jsThis, void **data) {
+            argc = STACK_ARGS;
+            napi_status status = napi_get_cb_info(env, info, &argc, m_stack, jsThis, data);
+            if (status != napi_ok || argc <= STACK_ARGS) {
+                return status;
+            }
+
+            m_heap.resize(argc);
+            m_args = m_heap.data();
+            return napi_get_cb_info(env, info, &argc, m_args, nullptr, nullptr);
+        }
+
+        napi_value *data() {
+            return m_args;
+        }
+
+        napi_value &operator[](size_t index) {
+            return m_args[index];
+        }
+
+    private:
+        napi_value m_stack[STACK_ARGS];
+        std::vector<napi_value> m_heap;
+        napi_value *m_args = m_stack;
+    };
+
     inline napi_value undefined(napi_env env) {
         napi_value undefined;
         napi_get_undefined(env, &undefined);
@@ -1,6 +1,11 @@
 #include "jsr.h"
 #include "js_runtime.h"
 #include "File.h"
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 using namespace facebook::jsi;
 std::unordered_map<napi_env, JSR *> JSR::env_to_jsr_cache;
@@ -91,6 +96,282 @@ napi_status js_free_runtime(napi_runtime runtime) {
 }
 
 
+#ifndef __SHERMES__
+namespace {
+    /*
+     * What a prepared script was made from: the wrapped source of a module, a script given to
+     * js_cache_script or a bytecode file run by js_run_cached_script
+     */
+    enum class ScriptKind : char {
+        Module,
+        Script,
+        Bytecode
+    };
+
+    /*
+     * A prepared script shared by the runtimes of all threads: Hermes can run a prepared script
+     * in any of its runtimes. The map holds a reference and each run holds one, a script replaced
+     * by a changed source is deleted by the runtime that releases it last.
+     */
+    struct PreparedScript {
+        // of the source, 0 for bytecode files
+        size_t sourceHash;
+        jsr_prepared_script script;
+        int refs;
+    };
+
+    std::mutex s_preparedScriptsMutex;
+    std::unordered_map<std::string, PreparedScript *> s_preparedScripts;
+
+    std::string FilePath(const char *file) {
+        std::string path(file);
+        if (path.rfind("file://", 0) == 0) {
+            path.erase(0, 7);
+        }
+        return path;
+    }
+
+    std::string ScriptKey(ScriptKind kind, const std::string &path) {
+        return static_cast<char>(kind) + path;
+    }
+
+    size_t HashSource(const char *source, size_t length) {
+        auto hash = std::hash<std::string_view>{}(std::string_view(source, length));
+        return hash == 0 ? 1 : hash;
+    }
+
+    /*
+     * The SHA-1 of `data`, which hermesc writes to the bytecode header as the hash of the source
+     * it compiled
+     */
+    std::array<uint8_t, 20> Sha1(const char *data, size_t length) {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        auto rotate = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+        uint64_t bits = static_cast<uint64_t>(length) * 8;
+        // the data, 0x80, zeros and the length in bits fill whole blocks of 64 bytes
+        size_t padded = ((length + 8) / 64 + 1) * 64;
+        for (size_t offset = 0; offset < padded; offset += 64) {
+            uint32_t w[80];
+            for (int i = 0; i < 16; i++) {
+                uint32_t word = 0;
+                for (int j = 0; j < 4; j++) {
+                    size_t at = offset + i * 4 + j;
+                    uint8_t byte = 0;
+                    if (at < length) {
+                        byte = static_cast<uint8_t>(data[at]);
+                    } else if (at == length) {
+                        byte = 0x80;
+                    } else if (at >= padded - 8) {
+                        byte = static_cast<uint8_t>(bits >> (8 * (padded - 1 - at)));
+                    }
+                    word = (word << 8) | byte;
+                }
+                w[i] = word;
+            }
+            for (int i = 16; i < 80; i++) {
+                w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            }
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; i++) {
+                uint32_t f, k;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                uint32_t temp = rotate(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotate(b, 30);
+                b = a;
+                a = temp;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+
+        std::array<uint8_t, 20> digest{};
+        for (int i = 0; i < 20; i++) {
+            digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+        }
+        return digest;
+    }
+
+    /*
+     * The script of `key` when it was prepared from the same source, with a reference the caller
+     * gives back with ReleasePreparedScript
+     */
+    PreparedScript *AcquirePreparedScript(const std::string &key, size_t sourceHash) {
+        std::lock_guard<std::mutex> lock(s_preparedScriptsMutex);
+        auto it = s_preparedScripts.find(key);
+        if (it == s_preparedScripts.end() || it->second->sourceHash != sourceHash) {
+            return nullptr;
+        }
+        it->second->refs++;
+        return it->second;
+    }
+
+    void ReleasePreparedScript(napi_env env, PreparedScript *prepared) {
+        {
+            std::lock_guard<std::mutex> lock(s_preparedScriptsMutex);
+            if (--prepared->refs > 0) {
+                return;
+            }
+        }
+        jsr_delete_prepared_script(env, prepared->script);
+        delete prepared;
+    }
+
+    /*
+     * Adds the script and returns it with a reference for the caller, or the one of another
+     * runtime when it prepared the same source first
+     */
+    PreparedScript *AddPreparedScript(napi_env env, const std::string &key, size_t sourceHash,
+                                      jsr_prepared_script script) {
+        std::unique_lock<std::mutex> lock(s_preparedScriptsMutex);
+        auto &entry = s_preparedScripts[key];
+        if (entry != nullptr && entry->sourceHash == sourceHash) {
+            entry->refs++;
+            auto existing = entry;
+            lock.unlock();
+            jsr_delete_prepared_script(env, script);
+            return existing;
+        }
+
+        // a changed source, the old script goes once the runtimes running it are done
+        auto replaced = entry;
+        entry = new PreparedScript{sourceHash, script, 2};
+        auto added = entry;
+        lock.unlock();
+        if (replaced != nullptr) {
+            ReleasePreparedScript(env, replaced);
+        }
+        return added;
+    }
+
+    napi_status RunPreparedScript(napi_env env, PreparedScript *prepared, napi_value *result) {
+        napi_status status = jsr_prepared_script_run(env, prepared->script, result);
+        ReleasePreparedScript(env, prepared);
+        return status;
+    }
+
+    jsr_prepared_script PrepareBuffer(napi_env env, const uint8_t *data, size_t length,
+                                      jsr_data_delete_cb deleteCallback, void *deleterData,
+                                      const char *file) {
+        jsr_prepared_script script = nullptr;
+        if (jsr_create_prepared_script(env, data, length, deleteCallback, deleterData, file,
+                                       &script) != napi_ok) {
+            // the buffer was handed over either way
+            bool pending;
+            if (napi_is_exception_pending(env, &pending) == napi_ok && pending) {
+                napi_value exception;
+                napi_get_and_clear_last_exception(env, &exception);
+            }
+            return nullptr;
+        }
+        return script;
+    }
+
+    // the SHA-1 of the source follows the magic and the version in the bytecode header
+    const size_t SOURCE_HASH_OFFSET = 12;
+
+    /*
+     * Prepares the bytecode at `path`. With a `source`, the bytecode must have been compiled by
+     * hermesc from it, the wrapped source of a module (see js_wrap_function_source) shipped
+     * next to it, and is left out once the module changed.
+     */
+    jsr_prepared_script PrepareBytecode(napi_env env, const std::string &path, const char *file,
+                                        const std::string *source) {
+        tns::FileContent content;
+        if (!tns::File::ReadContent(path, content)) {
+            return nullptr;
+        }
+        auto data = reinterpret_cast<const uint8_t *>(content.data);
+        if (!facebook::hermes::HermesRuntime::isHermesBytecode(data, content.length)) {
+            return nullptr;
+        }
+        if (source != nullptr) {
+            auto sourceHash = Sha1(source->data(), source->size());
+            if (content.length < SOURCE_HASH_OFFSET + sourceHash.size() ||
+                memcmp(data + SOURCE_HASH_OFFSET, sourceHash.data(), sourceHash.size()) != 0) {
+                return nullptr;
+            }
+        }
+
+        // mapped bytecode lives as long as the process
+        if (content.isMapped) {
+            return PrepareBuffer(env, data, content.length, nullptr, nullptr, file);
+        }
+        return PrepareBuffer(env, data, content.length, [](void *data, void *deleterData) {
+            delete[] static_cast<char *>(deleterData);
+        }, content.buffer.release(), file);
+    }
+
+    /*
+     * Prepares a module from the bytecode shipped with it when it was compiled from `wrapped`,
+     * otherwise from `wrapped` itself, which it then takes over
+     */
+    napi_status PrepareModule(napi_env env, const std::string &path, const char *file,
+                              std::string &wrapped, jsr_prepared_script *script) {
+        *script = nullptr;
+        auto extension = path.rfind(".js");
+        if (extension != std::string::npos && extension + 3 == path.size()) {
+            *script = PrepareBytecode(env, path.substr(0, extension) + ".hbc", file, &wrapped);
+        }
+        if (*script != nullptr) {
+            return napi_ok;
+        }
+
+        auto copy = new std::string(std::move(wrapped));
+        return jsr_create_prepared_script(
+                env, reinterpret_cast<const uint8_t *>(copy->data()), copy->size(),
+                [](void *data, void *deleterData) {
+                    delete static_cast<std::string *>(deleterData);
+                }, copy, file, script);
+    }
+
+    /*
+     * The runtime js_precompile_function prepares modules with on a thread, freed when the
+     * thread exits. It stays out of env_to_jsr_cache, which only the JS threads use.
+     */
+    class Precompiler {
+    public:
+        Precompiler() : m_jsr(new JSR()) {
+            m_jsr->rt->createNapiEnv(&m_env);
+        }
+
+        ~Precompiler() {
+            m_jsr->threadSafeRuntime.reset();
+            m_jsr->rt = nullptr;
+        }
+
+        JSR *Jsr() const {
+            return m_jsr.get();
+        }
+
+        napi_env Env() const {
+            return m_env;
+        }
+
+    private:
+        std::unique_ptr<JSR> m_jsr;
+        napi_env m_env = nullptr;
+    };
+}
+#endif
+
 napi_status js_execute_script(napi_env env,
                               napi_value script,
                               const char *file,
@@ -102,6 +383,89 @@ napi_status js_execute_script(napi_env env,
     #endif
 }
 
+napi_status js_compile_function(napi_env env,
+                                const char *source,
+                                size_t length,
+                                const char *file,
+                                const char *const *params,
+                                size_t param_count,
+                                napi_finalize finalize_cb,
+                                void *finalize_hint,
+                                napi_value *result) {
+    return js_compile_wrapped_function(env, source, length, params, param_count, finalize_cb, finalize_hint,
+                                       [&](std::string &wrapped) {
+#ifndef __SHERMES__
+        // modules are prepared once, from the bytecode shipped with them or from their source
+        auto path = FilePath(file);
+        auto key = ScriptKey(ScriptKind::Module, path);
+        auto sourceHash = HashSource(wrapped.data(), wrapped.size());
+        auto prepared = AcquirePreparedScript(key, sourceHash);
+        if (prepared != nullptr) {
+            return RunPreparedScript(env, prepared, result);
+        }
+
+        jsr_prepared_script script;
+        napi_status status = PrepareModule(env, path, file, wrapped, &script);
+        if (status != napi_ok) {
+            return status;
+        }
+        return RunPreparedScript(env, AddPreparedScript(env, key, sourceHash, script), result);
+#else
+        napi_value script;
+        napi_status status = napi_create_string_utf8(env, wrapped.c_str(), wrapped.size(), &script);
+        if (status != napi_ok) {
+            return status;
+        }
+
+        return js_execute_script(env, script, file, result);
+#endif
+    });
+}
+
+napi_status js_precompile_function(const char *source,
+                                   size_t length,
+                                   const char *file,
+                                   const char *const *params,
+                                   size_t param_count) {
+#ifndef __SHERMES__
+    // the runtimes of all threads share the prepared scripts, js_compile_function finds it there
+    std::string wrapped = js_wrap_function_source(source, length, params, param_count);
+    auto path = FilePath(file);
+    auto key = ScriptKey(ScriptKind::Module, path);
+    auto sourceHash = HashSource(wrapped.data(), wrapped.size());
+    static thread_local Precompiler precompiler;
+    napi_env env = precompiler.Env();
+    auto prepared = AcquirePreparedScript(key, sourceHash);
+    if (prepared != nullptr) {
+        ReleasePreparedScript(env, prepared);
+        return napi_ok;
+    }
+
+    jsr_prepared_script script;
+    precompiler.Jsr()->lock();
+    napi_status status = PrepareModule(env, path, file, wrapped, &script);
+    if (status != napi_ok) {
+        // a syntax error is reported when the JS thread prepares the module itself
+        bool pending;
+        if (napi_is_exception_pending(env, &pending) == napi_ok && pending) {
+            napi_value exception;
+            napi_get_and_clear_last_exception(env, &exception);
+        }
+    } else {
+        ReleasePreparedScript(env, AddPreparedScript(env, key, sourceHash, script));
+    }
+    precompiler.Jsr()->unlock();
+    return status;
+#else
+    return napi_generic_failure;
+#endif
+}
+
+napi_status js_release_precompiled_functions() {
+    // prepared scripts stay in the map the runtimes share
+    return napi_ok;
+}
+
 napi_status js_execute_pending_jobs(napi_env env) {
     #ifdef __SHERMES__
     auto itFound = JSR::env_to_jsr_cache.find(env);
@@ -116,6 +480,11 @@ napi_status js_execute_pending_jobs(napi_env env) {
     #endif
 }
 
+napi_status js_set_pending_jobs_callback(napi_env env, js_pending_jobs_callback callback, void *data) {
+    // the microtask queue lives inside the prebuilt Hermes runtime and has no enqueue hook
+    return napi_generic_failure;
+}
+
 napi_status js_get_engine_ptr(napi_env env, int64_t *engine_ptr) {
     return napi_ok;
 }
@@ -126,12 +495,63 @@ js_adjust_external_memory(napi_env env, int64_t changeInBytes, int64_t *external
     return napi_ok;
 }
 
+napi_status js_set_code_cache_path(napi_env env, const char *path) {
+    return napi_ok;
+}
+
+napi_status js_set_code_bundle(napi_env env, const char *path, const char *root) {
+    return napi_ok;
+}
+
 napi_status js_cache_script(napi_env env, const char *source, const char *file) {
+#ifndef __SHERMES__
+    auto key = ScriptKey(ScriptKind::Script, FilePath(file));
+    auto length = strlen(source);
+    auto sourceHash = HashSource(source, length);
+    auto prepared = AcquirePreparedScript(key, sourceHash);
+    if (prepared == nullptr) {
+        auto copy = new std::string(source, length);
+        auto script = PrepareBuffer(env, reinterpret_cast<const uint8_t *>(copy->data()), copy->size(),
+                                    [](void *data, void *deleterData) {
+                                        delete static_cast<std::string *>(deleterData);
+                                    }, copy, file);
+        if (script == nullptr) {
+            return napi_generic_failure;
+        }
+        prepared = AddPreparedScript(env, key, sourceHash, script);
+    }
+    ReleasePreparedScript(env, prepared);
+#endif
     return napi_ok;
 }
 
 napi_status js_run_cached_script(napi_env env, const char *file, napi_value script, void *cache,
                                  napi_value *result) {
+#ifndef __SHERMES__
+    // the script js_cache_script prepared from the same source, otherwise the file is bytecode
+    auto path = FilePath(file);
+    size_t length;
+    if (napi_get_value_string_utf8(env, script, nullptr, 0, &length) == napi_ok) {
+        std::string source(length, '\0');
+        napi_get_value_string_utf8(env, script, &source[0], length + 1, &length);
+        auto prepared = AcquirePreparedScript(ScriptKey(ScriptKind::Script, path),
+                                              HashSource(source.data(), length));
+        if (prepared != nullptr) {
+            return RunPreparedScript(env, prepared, result);
+        }
+    }
+
+    auto key = ScriptKey(ScriptKind::Bytecode, path);
+    auto prepared = AcquirePreparedScript(key, 0);
+    if (prepared == nullptr) {
+        auto bytecode = PrepareBytecode(env, path, file, nullptr);
+        if (bytecode == nullptr) {
+            return napi_cannot_run_js;
+        }
+        prepared = AddPreparedScript(env, key, 0, bytecode);
+    }
+    return RunPreparedScript(env, prepared, result);
+#else
     int length = 0;
     auto data = tns::File::ReadBinary(file, length);
     if (!data) {
@@ -139,6 +559,7 @@ napi_status js_run_cached_script(napi_env env, const char *file, napi_value scri
     }
 
     return napi_run_bytecode(env, data, length, file, result);
+#endif
 }
 
 napi_status js_get_runtime_version(napi_env env, napi_value *version) {
@@ -146,3 +567,11 @@ napi_status js_get_runtime_version(napi_env env, napi_value *version) {
     return napi_ok;
 }
 
+
+napi_status js_get_array_buffer_allocator_stats(napi_env env, napi_value* result) {
+    return napi_generic_failure;
+}
+
+napi_status js_create_strong_reference(napi_env env, napi_value value, napi_ref* result) {
+    return napi_create_reference(env, value, 1, result);
+}
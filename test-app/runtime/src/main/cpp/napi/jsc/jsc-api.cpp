@@ -117,6 +117,34 @@ class JSString {
         JSStringRef _string;
 };
 
+// A property name from the keys of the env, or a JSString of its own once they are full
+class PropertyKey {
+        public:
+        PropertyKey(const PropertyKey&) = delete;
+
+        PropertyKey(napi_env env, const char* utf8name)
+        : _string{env->property_keys.key(utf8name)}
+        , _owned{_string == nullptr} {
+            if (_owned) {
+                _string = JSStringCreateWithUTF8CString(utf8name);
+            }
+        }
+
+        ~PropertyKey() {
+            if (_owned) {
+                JSStringRelease(_string);
+            }
+        }
+
+        operator JSStringRef() const {
+            return _string;
+        }
+
+        private:
+        JSStringRef _string;
+        bool _owned;
+};
+
 inline JSValueRef ToJSValue(const napi_value value) {
     return reinterpret_cast<JSValueRef>(value);
 }
@@ -214,9 +242,9 @@ class NativeInfo {
         }
 
     template<typename T>
-    static T* GetNativeInfo(JSContextRef ctx, JSObjectRef obj, const char * propertyKey) {
+    static T* GetNativeInfo(JSContextRef ctx, JSObjectRef obj, JSStringRef propertyKey) {
         JSValueRef exception {};
-        JSValueRef native_info = JSObjectGetProperty(ctx, obj, JSString(propertyKey), &exception);
+        JSValueRef native_info = JSObjectGetProperty(ctx, obj, propertyKey, &exception);
 
         NativeInfo* info = Get<NativeInfo>(JSValueToObject(ctx, native_info, &exception));
         if (info != nullptr && info->Type() == T::StaticType) {
@@ -230,9 +258,9 @@ class NativeInfo {
         JSObjectSetPropertyForKey(ctx, obj, propertyKey, info, kJSPropertyAttributeDontEnum | kJSPropertyAttributeReadOnly | kJSPropertyAttributeDontDelete, nullptr);
     }
 
-    static void SetNativeInfo(JSContextRef ctx, JSObjectRef obj, JSClassRef classRef, const char * propertyKey, void * data) {
+    static void SetNativeInfo(JSContextRef ctx, JSObjectRef obj, JSClassRef classRef, JSStringRef propertyKey, void * data) {
             JSObjectRef info{JSObjectMake(ctx, classRef, data)};
-            JSObjectSetProperty(ctx, obj, JSString(propertyKey), info, kJSPropertyAttributeDontEnum | kJSPropertyAttributeReadOnly | kJSPropertyAttributeDontDelete, nullptr);
+            JSObjectSetProperty(ctx, obj, propertyKey, info, kJSPropertyAttributeDontEnum | kJSPropertyAttributeReadOnly | kJSPropertyAttributeDontDelete, nullptr);
         }
 
         protected:
@@ -263,16 +291,16 @@ class ConstructorInfo : public NativeInfo {
             if (length) {
                 napi_value name;
                 napi_create_string_utf8(env, utf8name, length, &name);
-                JSObjectSetProperty(env->context, constructor, JSString("name"), ToJSValue(name), kJSPropertyAttributeNone, &exception);
+                JSObjectSetProperty(env->context, constructor, env->property_keys.static_key("name"), ToJSValue(name), kJSPropertyAttributeNone, &exception);
             }
-            JSObjectRef prototype{(JSObjectRef) JSObjectGetProperty(env->context, constructor, JSString("prototype"), &exception)};
+            JSObjectRef prototype{(JSObjectRef) JSObjectGetProperty(env->context, constructor, env->property_keys.static_key("prototype"), &exception)};
 
 //            JSObjectSetPrototype(env->context, prototype, JSObjectGetPrototype(env->context, constructor));
 //            JSObjectSetPrototype(env->context, constructor, prototype);
 
-            NativeInfo::SetNativeInfo(env->context, constructor, info->_class, "[[jsc_constructor_info]]", info);
+            NativeInfo::SetNativeInfo(env->context, constructor, info->_class, InfoKey(), info);
 
-            JSObjectSetProperty(env->context, prototype, JSString("constructor"), constructor,
+            JSObjectSetProperty(env->context, prototype, env->property_keys.static_key("constructor"), constructor,
                                 kJSPropertyAttributeNone, &exception);
             CHECK_JSC(env, exception);
 
@@ -298,6 +326,13 @@ class ConstructorInfo : public NativeInfo {
             JSClassRelease(_class);
         }
 
+        // JSStrings are not bound to a context, the constructors of every env share this one so
+        // that a call does not have to find its env first
+        static JSStringRef InfoKey() {
+            static JSStringRef key = JSStringCreateWithUTF8CString("[[jsc_constructor_info]]");
+            return key;
+        }
+
         // JSObjectCallAsConstructorCallback
         static JSObjectRef CallAsConstructor(JSContextRef ctx,
         JSObjectRef constructor,
@@ -305,7 +340,7 @@ class ConstructorInfo : public NativeInfo {
         const JSValueRef arguments[],
         JSValueRef* exception) {
 //           ConstructorInfo* info = NativeInfo::FindInPrototypeChain<ConstructorInfo>(ctx, constructor);
-            ConstructorInfo* info = NativeInfo::GetNativeInfo<ConstructorInfo>(ctx, constructor, "[[jsc_constructor_info]]");
+            ConstructorInfo* info = NativeInfo::GetNativeInfo<ConstructorInfo>(ctx, constructor, InfoKey());
 
             // Make sure any errors encountered last time we were in N-API are gone.
             napi_clear_last_error(info->_env);
@@ -396,9 +431,10 @@ class FunctionInfo : public NativeInfo {
         ~FunctionInfo() {}
 
     static void initialize(JSContextRef ctx, JSObjectRef object) {
+        FunctionInfo* info = reinterpret_cast<FunctionInfo *>(JSObjectGetPrivate(object));
         JSObjectRef global = JSContextGetGlobalObject(ctx);
         JSValueRef value =
-                JSObjectGetProperty(ctx, global, JSString("Function"), nullptr);
+                JSObjectGetProperty(ctx, global, info->_env->property_keys.static_key("Function"), nullptr);
         JSObjectRef funcCtor = JSValueToObject(ctx, value, nullptr);
         if (!funcCtor) {
             // We can't do anything if Function is not an object
@@ -457,10 +493,6 @@ class BaseInfoT : public NativeInfo {
         public:
         static const NativeType StaticType = TType;
 
-        ~BaseInfoT() {
-            JSClassRelease(_class);
-        }
-
         napi_env Env() const {
             return _env;
         }
@@ -479,13 +511,17 @@ class BaseInfoT : public NativeInfo {
         }
 
         protected:
+        // one class per NativeType, shared by the envs of all threads
         BaseInfoT(napi_env env, const char* className)
         : NativeInfo{TType}
         , _env{env} {
-            JSClassDefinition definition{kJSClassDefinitionEmpty};
-            definition.className = className;
-            definition.finalize = Finalize;
-            _class = JSClassCreate(&definition);
+            static JSClassRef infoClass = [className]() {
+                JSClassDefinition definition{kJSClassDefinitionEmpty};
+                definition.className = className;
+                definition.finalize = Finalize;
+                return JSClassCreate(&definition);
+            }();
+            _class = infoClass;
         }
 
         // JSObjectFinalizeCallback
@@ -551,7 +587,7 @@ class ReferenceInfo : public BaseInfoT<ReferenceInfo, NativeType::Reference> {
                 // JSObjectSetPrototype(env->context, prototype, JSObjectGetPrototype(env->context, ToJSObject(env, object)));
                // JSObjectSetPrototype(env->context, ToJSObject(env, object), prototype);
 
-                NativeInfo::SetNativeInfo(env->context, ToJSObject(env, object), info->_class, "[[jsc_reference_info]]", info);
+                NativeInfo::SetNativeInfo(env->context, ToJSObject(env, object), info->_class, env->property_keys.static_key("[[jsc_reference_info]]"), info);
 
                 info->AddFinalizer(finalizer);
             }
@@ -570,8 +606,7 @@ class WrapperInfo : public BaseInfoT<WrapperInfo, NativeType::Wrapper> {
         static napi_status Wrap(napi_env env, napi_value object, WrapperInfo** result) {
             WrapperInfo* info{};
 
-            napi_value propertyKey;
-            napi_create_string_utf8(env, "[[jsc_wrapper_info]]", NAPI_AUTO_LENGTH, &propertyKey);
+            napi_value propertyKey{ToNapi(JSValueMakeString(env->context, env->property_keys.static_key("[[jsc_wrapper_info]]")))};
             bool hasOwnProperty;
             napi_has_own_property(env, object, propertyKey, &hasOwnProperty);
 
@@ -594,7 +629,7 @@ class WrapperInfo : public BaseInfoT<WrapperInfo, NativeType::Wrapper> {
         }
 
         static napi_status Unwrap(napi_env env, napi_value object, WrapperInfo** result) {
-            *result = NativeInfo::GetNativeInfo<WrapperInfo>(env->context, ToJSObject(env, object), "[[jsc_wrapper_info]]");
+            *result = NativeInfo::GetNativeInfo<WrapperInfo>(env->context, ToJSObject(env, object), env->property_keys.static_key("[[jsc_wrapper_info]]"));
             return napi_ok;
         }
 
@@ -740,6 +775,39 @@ void napi_env__::deinit_symbol(JSValueRef symbol) {
     JSValueUnprotect(context, symbol);
 }
 
+PropertyKeys::~PropertyKeys() {
+    for (auto& entry : by_address_) {
+        JSStringRelease(entry.second);
+    }
+    for (auto& entry : by_name_) {
+        JSStringRelease(entry.second);
+    }
+}
+
+JSStringRef PropertyKeys::static_key(const char* name) {
+    auto it = by_address_.find(name);
+    if (it != by_address_.end()) {
+        return it->second;
+    }
+    JSStringRef string{JSStringCreateWithUTF8CString(name)};
+    by_address_.emplace(name, string);
+    return string;
+}
+
+JSStringRef PropertyKeys::key(const char* utf8name) {
+    auto it = by_name_.find(std::string_view{utf8name});
+    if (it != by_name_.end()) {
+        return it->second;
+    }
+    if (by_name_.size() >= MAX_KEYS) {
+        return nullptr;
+    }
+    const std::string& name{names_.emplace_back(utf8name)};
+    JSStringRef string{JSStringCreateWithUTF8CString(name.c_str())};
+    by_name_.emplace(std::string_view{name}, string);
+    return string;
+}
+
 // Warning: Keep in-sync with napi_status enum
 static const char* error_messages[] = {
         nullptr,
@@ -986,7 +1054,7 @@ napi_status napi_set_named_property(napi_env env,
     JSObjectSetProperty(
             env->context,
             ToJSObject(env, object),
-            JSString(utf8name),
+            PropertyKey(env, utf8name),
             ToJSValue(value),
             kJSPropertyAttributeNone,
             &exception);
@@ -1005,7 +1073,7 @@ napi_status napi_has_named_property(napi_env env,
     *result = JSObjectHasProperty(
             env->context,
             ToJSObject(env, object),
-            JSString(utf8name));
+            PropertyKey(env, utf8name));
 
     return napi_ok;
 }
@@ -1022,7 +1090,7 @@ napi_status napi_get_named_property(napi_env env,
     *result = ToNapi(JSObjectGetProperty(
             env->context,
             ToJSObject(env, object),
-            JSString(utf8name),
+            PropertyKey(env, utf8name),
             &exception));
     CHECK_JSC(env, exception);
 
@@ -1108,6 +1176,12 @@ napi_status napi_delete_element(napi_env env,
     return napi_ok;
 }
 
+// Sets a property of a descriptor object made by napi_define_properties
+static void SetDescriptorProperty(napi_env env, napi_value descriptor, const char* name, JSValueRef value) {
+    JSObjectSetProperty(env->context, ToJSObject(env, descriptor), env->property_keys.static_key(name), value,
+                        kJSPropertyAttributeNone, nullptr);
+}
+
 napi_status napi_define_properties(napi_env env,
                                    napi_value object,
                                    size_t property_count,
@@ -1117,59 +1191,61 @@ napi_status napi_define_properties(napi_env env,
         CHECK_ARG(env, properties);
     }
 
+    if (property_count > 0 && env->define_property_function == nullptr) {
+        napi_value global{}, object_ctor{}, function{};
+        CHECK_NAPI(napi_get_global(env, &global));
+        CHECK_NAPI(napi_get_named_property(env, global, "Object", &object_ctor));
+        CHECK_NAPI(napi_get_named_property(env, object_ctor, "defineProperty", &function));
+        env->define_property_function = ToJSValue(function);
+        JSValueProtect(env->context, env->define_property_function);
+    }
+
     for (size_t i = 0; i < property_count; i++) {
         const napi_property_descriptor* p{properties + i};
 
         napi_value descriptor{};
         CHECK_NAPI(napi_create_object(env, &descriptor));
 
-        napi_value configurable{};
-        CHECK_NAPI(napi_get_boolean(env, (p->attributes & napi_configurable), &configurable));
-        CHECK_NAPI(napi_set_named_property(env, descriptor, "configurable", configurable));
-
-        napi_value enumerable{};
-        CHECK_NAPI(napi_get_boolean(env, (p->attributes & napi_configurable), &enumerable));
-        CHECK_NAPI(napi_set_named_property(env, descriptor, "enumerable", enumerable));
+        SetDescriptorProperty(env, descriptor, "configurable",
+                              JSValueMakeBoolean(env->context, (p->attributes & napi_configurable)));
+        SetDescriptorProperty(env, descriptor, "enumerable",
+                              JSValueMakeBoolean(env->context, (p->attributes & napi_enumerable)));
 
         if (p->getter != nullptr || p->setter != nullptr) {
             if (p->getter != nullptr) {
                 napi_value getter{};
                 CHECK_NAPI(napi_create_function(env, p->utf8name, NAPI_AUTO_LENGTH, p->getter, p->data, &getter));
-                CHECK_NAPI(napi_set_named_property(env, descriptor, "get", getter));
+                SetDescriptorProperty(env, descriptor, "get", ToJSValue(getter));
             }
             if (p->setter != nullptr) {
                 napi_value setter{};
                 CHECK_NAPI(napi_create_function(env, p->utf8name, NAPI_AUTO_LENGTH, p->setter, p->data, &setter));
-                CHECK_NAPI(napi_set_named_property(env, descriptor, "set", setter));
+                SetDescriptorProperty(env, descriptor, "set", ToJSValue(setter));
             }
         } else if (p->method != nullptr) {
             napi_value method{};
             CHECK_NAPI(napi_create_function(env, p->utf8name, NAPI_AUTO_LENGTH, p->method, p->data, &method));
-            CHECK_NAPI(napi_set_named_property(env, descriptor, "value", method));
+            SetDescriptorProperty(env, descriptor, "value", ToJSValue(method));
         } else {
             RETURN_STATUS_IF_FALSE(env, p->value != nullptr, napi_invalid_arg);
 
-            napi_value writable{};
-            CHECK_NAPI(napi_get_boolean(env, (p->attributes & napi_writable), &writable));
-            CHECK_NAPI(napi_set_named_property(env, descriptor, "writable", writable));
-
-            CHECK_NAPI(napi_set_named_property(env, descriptor, "value", p->value));
+            SetDescriptorProperty(env, descriptor, "writable",
+                                  JSValueMakeBoolean(env->context, (p->attributes & napi_writable)));
+            SetDescriptorProperty(env, descriptor, "value", ToJSValue(p->value));
         }
 
         napi_value propertyName{};
         if (p->utf8name == nullptr) {
             propertyName = p->name;
         } else {
-            CHECK_NAPI(napi_create_string_utf8(env, p->utf8name, NAPI_AUTO_LENGTH, &propertyName));
+            propertyName = ToNapi(JSValueMakeString(env->context, PropertyKey(env, p->utf8name)));
         }
 
-        napi_value global{}, object_ctor{}, function{};
-        CHECK_NAPI(napi_get_global(env, &global));
-        CHECK_NAPI(napi_get_named_property(env, global, "Object", &object_ctor));
-        CHECK_NAPI(napi_get_named_property(env, object_ctor, "defineProperty", &function));
-
-        napi_value args[] = { object, propertyName, descriptor };
-        CHECK_NAPI(napi_call_function(env, object_ctor, function, 3, args, nullptr));
+        JSValueRef exception{};
+        JSValueRef args[] = { ToJSValue(object), ToJSValue(propertyName), ToJSValue(descriptor) };
+        JSObjectCallAsFunction(env->context, ToJSObject(env, ToNapi(env->define_property_function)), nullptr,
+                               3, args, &exception);
+        CHECK_JSC(env, exception);
     }
 
     return napi_ok;
@@ -1197,7 +1273,7 @@ napi_status napi_get_array_length(napi_env env,
     JSValueRef length = JSObjectGetProperty(
             env->context,
             ToJSObject(env, value),
-            JSString("length"),
+            env->property_keys.static_key("length"),
             &exception);
     CHECK_JSC(env, exception);
 
@@ -1271,7 +1347,7 @@ napi_status napi_create_array_with_length(napi_env env,
     JSObjectSetProperty(
             env->context,
             array,
-            JSString("length"),
+            env->property_keys.static_key("length"),
             JSValueMakeNumber(env->context, static_cast<double>(length)),
             kJSPropertyAttributeNone,
             &exception);
@@ -2644,6 +2720,20 @@ napi_status napi_get_all_property_names(napi_env env,
         getter_methods.push_back(method);
     }
 
+    // JSC has no API for the attributes of a property, they are read from its descriptor
+    const int attribute_filter = key_filter & (napi_key_writable | napi_key_enumerable | napi_key_configurable);
+    napi_value get_own_property_descriptor{};
+    if (attribute_filter != 0) {
+        CHECK_NAPI(napi_get_named_property(env, object_ctor, "getOwnPropertyDescriptor", &get_own_property_descriptor));
+    }
+
+    auto has_attribute = [&](napi_value descriptor, const char* name, bool* value) -> napi_status {
+        napi_value attribute{};
+        CHECK_NAPI(napi_get_named_property(env, descriptor, name, &attribute));
+        *value = JSValueToBoolean(env->context, ToJSValue(attribute));
+        return napi_ok;
+    };
+
     napi_value current = object;
     while (true) {
         for (napi_value method : getter_methods) {
@@ -2656,13 +2746,30 @@ napi_status napi_get_all_property_names(napi_env env,
                 napi_value key{};
                 CHECK_NAPI(napi_get_element(env, properties, i, &key));
                 // TODO: coerce to number if napi_key_keep_numbers
-                // TODO: filter writable/enumerable/configurable
-#if 0
-                napi_value descriptor{};
-        std::array<napi_value, 2> args { current, key };
-        // Object.getOwnPropertyDescriptor(current, key)
-        CHECK_NAPI(napi_call_function(env, object_ctor, getOwnPropertyDescriptor, 2, args.data(), &descriptor));
-#endif
+                if (attribute_filter != 0) {
+                    napi_value descriptor{};
+                    std::array<napi_value, 2> args { current, key };
+                    // Object.getOwnPropertyDescriptor(current, key)
+                    CHECK_NAPI(napi_call_function(env, object_ctor, get_own_property_descriptor, 2, args.data(), &descriptor));
+
+                    bool value = false;
+                    if (attribute_filter & napi_key_enumerable) {
+                        CHECK_NAPI(has_attribute(descriptor, "enumerable", &value));
+                        if (!value) continue;
+                    }
+                    if (attribute_filter & napi_key_configurable) {
+                        CHECK_NAPI(has_attribute(descriptor, "configurable", &value));
+                        if (!value) continue;
+                    }
+                    if (attribute_filter & napi_key_writable) {
+                        // accessors count as writable when they have a setter
+                        CHECK_NAPI(has_attribute(descriptor, "writable", &value));
+                        if (!value) {
+                            CHECK_NAPI(has_attribute(descriptor, "set", &value));
+                        }
+                        if (!value) continue;
+                    }
+                }
                 CHECK_NAPI(napi_call_function(env, array, push, 1, &key, NULL));
             }
         }
@@ -9,10 +9,38 @@
 #include "js_native_api_types.h"
 #include <JavaScriptCore/JavaScript.h>
 #include <unordered_set>
+#include <unordered_map>
+#include <deque>
 #include <list>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <cassert>
 
+// Interned property names, so that the named property calls do not create and release a
+// JSString each time. static_key() is for names that outlive the env, e.g. literals, and looks
+// them up by address, key() looks up the others by content.
+class PropertyKeys {
+public:
+    PropertyKeys() = default;
+    PropertyKeys(const PropertyKeys&) = delete;
+    PropertyKeys& operator=(const PropertyKeys&) = delete;
+    ~PropertyKeys();
+
+    JSStringRef static_key(const char* name);
+
+    // nullptr once MAX_KEYS names are interned, the caller makes a JSString of its own
+    JSStringRef key(const char* utf8name);
+
+    static constexpr size_t MAX_KEYS = 8192;
+
+private:
+    std::unordered_map<const char*, JSStringRef> by_address_;
+    std::unordered_map<std::string_view, JSStringRef> by_name_;
+    // the names the keys of by_name_ point to
+    std::deque<std::string> names_;
+};
+
 struct napi_env__ {
     JSGlobalContextRef context{};
     JSValueRef last_exception{};
@@ -25,6 +53,10 @@ struct napi_env__ {
     JSValueRef reference_info_symbol{};
     JSValueRef wrapper_info_symbol{};
 
+    PropertyKeys property_keys{};
+    // Object.defineProperty, looked up once for napi_define_properties
+    JSValueRef define_property_function{};
+
     const std::thread::id thread_id{std::this_thread::get_id()};
 
     napi_env__(JSGlobalContextRef context) : context{context} {
@@ -38,11 +70,15 @@ struct napi_env__ {
 
     ~napi_env__() {
         deinit_refs();
-        JSGlobalContextRelease(context);
+        // the values are unprotected while the context is still retained
+        if (define_property_function != nullptr) {
+            JSValueUnprotect(context, define_property_function);
+        }
         deinit_symbol(wrapper_info_symbol);
         deinit_symbol(reference_info_symbol);
         deinit_symbol(function_info_symbol);
         deinit_symbol(constructor_info_symbol);
+        JSGlobalContextRelease(context);
         napi_envs.erase(context);
     }
 
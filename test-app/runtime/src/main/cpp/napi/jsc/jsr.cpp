@@ -60,10 +60,48 @@ napi_status js_execute_script(napi_env env,
 
 }
 
+napi_status js_compile_function(napi_env env,
+                                const char *source,
+                                size_t length,
+                                const char *file,
+                                const char *const *params,
+                                size_t param_count,
+                                napi_finalize finalize_cb,
+                                void *finalize_hint,
+                                napi_value *result) {
+    return js_compile_wrapped_function(env, source, length, params, param_count, finalize_cb, finalize_hint,
+                                       [&](std::string &wrapped) {
+        napi_value script;
+        napi_status status = napi_create_string_utf8(env, wrapped.c_str(), wrapped.size(), &script);
+        if (status != napi_ok) {
+            return status;
+        }
+
+        return js_execute_script(env, script, file, result);
+    });
+}
+
+napi_status js_precompile_function(const char *source,
+                                   size_t length,
+                                   const char *file,
+                                   const char *const *params,
+                                   size_t param_count) {
+    return napi_generic_failure;
+}
+
+napi_status js_release_precompiled_functions() {
+    return napi_ok;
+}
+
 napi_status js_execute_pending_jobs(napi_env env) {
     return napi_ok;
 }
 
+napi_status js_set_pending_jobs_callback(napi_env env, js_pending_jobs_callback callback, void *data) {
+    // JavaScriptCore drains its microtask queue on its own and has no hook to report jobs left
+    return napi_generic_failure;
+}
+
 napi_status js_get_engine_ptr(napi_env env, int64_t *engine_ptr) {
     *engine_ptr = (int64_t) 0;
     return napi_ok;
@@ -73,6 +111,14 @@ napi_status js_adjust_external_memory(napi_env env, int64_t changeInBytes, int64
     return napi_ok;
 }
 
+napi_status js_set_code_cache_path(napi_env env, const char *path) {
+    return napi_ok;
+}
+
+napi_status js_set_code_bundle(napi_env env, const char *path, const char *root) {
+    return napi_ok;
+}
+
 napi_status js_cache_script(napi_env env, const char *source, const char *file) {
     return napi_ok;
 }
@@ -88,3 +134,11 @@ napi_status js_get_runtime_version(napi_env env, napi_value* version) {
 
     return napi_ok;
 }
+
+napi_status js_get_array_buffer_allocator_stats(napi_env env, napi_value* result) {
+    return napi_generic_failure;
+}
+
+napi_status js_create_strong_reference(napi_env env, napi_value value, napi_ref* result) {
+    return napi_create_reference(env, value, 1, result);
+}
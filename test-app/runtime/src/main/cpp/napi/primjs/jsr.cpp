@@ -9,6 +9,53 @@ struct napi_runtime__ {
     LEPUSContext* context;
 };
 
+namespace {
+    JsrCodeCache *GetCodeCache(napi_env env, bool create) {
+        auto jsr = JSR::env_to_jsr_cache.Get(env);
+        if (jsr == nullptr) {
+            return nullptr;
+        }
+        if (!jsr->code_cache && create) {
+            jsr->code_cache.reset(new JsrCodeCache(std::to_string(LEPUS_GetPrimjsVersion())));
+        }
+        return jsr->code_cache.get();
+    }
+
+    napi_status ExecuteSource(napi_env env, const char *source, size_t length, const char *file,
+                              napi_value *result) {
+        napi_value script;
+        napi_status status = napi_create_string_utf8(env, source, length, &script);
+        if (status != napi_ok) {
+            return status;
+        }
+        return js_execute_script(env, script, file, result);
+    }
+
+    /*
+     * Runs the bytecode of `source` from the code cache, or compiles `source` and adds its
+     * bytecode to the cache
+     */
+    napi_status RunScriptWithCodeCache(napi_env env, const char *source, size_t length,
+                                       const char *file, napi_value *result) {
+        auto cache = GetCodeCache(env, false);
+        if (cache == nullptr || !cache->Enabled()) {
+            return ExecuteSource(env, source, length, file, result);
+        }
+
+        return cache->Run(file, source, length,
+                          [&](const uint8_t *data, size_t dataLength) {
+                              return napi_run_code_cache(env, data, dataLength, result);
+                          },
+                          [&](uint8_t **data, size_t *dataLength) {
+                              if (data == nullptr) {
+                                  return ExecuteSource(env, source, length, file, result);
+                              }
+                              return napi_run_script_gen_code_cache(env, source, length, file,
+                                                                    data, dataLength, result);
+                          });
+    }
+}
+
 napi_status js_create_runtime(napi_runtime *runtime) {
     auto _runtime = new napi_runtime__();
     LEPUSRuntime* rt = LEPUS_NewRuntimeWithMode(0);
@@ -85,23 +132,102 @@ napi_status js_execute_script(napi_env env,
     return napi_run_script_source(env, script, file, result);
 }
 
+napi_status js_compile_function(napi_env env,
+                                const char *source,
+                                size_t length,
+                                const char *file,
+                                const char *const *params,
+                                size_t param_count,
+                                napi_finalize finalize_cb,
+                                void *finalize_hint,
+                                napi_value *result) {
+    return js_compile_wrapped_function(env, source, length, params, param_count, finalize_cb, finalize_hint,
+                                       [&](std::string &wrapped) {
+        return RunScriptWithCodeCache(env, wrapped.c_str(), wrapped.size(), file, result);
+    });
+}
+
+napi_status js_precompile_function(const char *source,
+                                   size_t length,
+                                   const char *file,
+                                   const char *const *params,
+                                   size_t param_count) {
+    return napi_generic_failure;
+}
+
+napi_status js_release_precompiled_functions() {
+    return napi_ok;
+}
+
 napi_status js_execute_pending_jobs(napi_env env) {
     return primjs_execute_pending_jobs(env);
 }
 
+napi_status js_set_pending_jobs_callback(napi_env env, js_pending_jobs_callback callback, void *data) {
+    return napi_generic_failure;
+}
+
 napi_status
 js_adjust_external_memory(napi_env env, int64_t changeInBytes, int64_t *externalMemory) {
     napi_adjust_external_memory(env, changeInBytes, externalMemory);
     return napi_ok;
 }
 
-napi_status js_cache_script(napi_env env, const char *source, const char *file) {
+napi_status js_set_code_cache_path(napi_env env, const char *path) {
+    auto cache = GetCodeCache(env, true);
+    if (cache == nullptr) {
+        return napi_invalid_arg;
+    }
+
+    cache->SetCachePath(path);
     return napi_ok;
 }
 
+napi_status js_set_code_bundle(napi_env env, const char *path, const char *root) {
+    auto cache = GetCodeCache(env, true);
+    if (cache == nullptr) {
+        return napi_invalid_arg;
+    }
+
+    cache->SetBundle(path, root);
+    return napi_ok;
+}
+
+napi_status js_cache_script(napi_env env, const char *source, const char *file) {
+    auto cache = GetCodeCache(env, false);
+    if (cache == nullptr || !cache->CanStore()) {
+        return napi_ok;
+    }
+
+    size_t length = strlen(source);
+    auto key = cache->Key(file, source, length);
+    int cachedLength;
+    if (cache->Find(key, &cachedLength) != nullptr || cachedLength != 0) {
+        return napi_ok;
+    }
+
+    uint8_t *data = nullptr;
+    size_t dataLength = 0;
+    napi_status status = napi_gen_code_cache(env, source, length, file, &data, &dataLength);
+    cache->Store(key, data, dataLength);
+    return status;
+}
+
 napi_status js_run_cached_script(napi_env env, const char *file, napi_value script, void *cache,
                                  napi_value *result) {
-    return napi_ok;
+    size_t length;
+    napi_status status = napi_get_value_string_utf8(env, script, nullptr, 0, &length);
+    if (status != napi_ok) {
+        return status;
+    }
+
+    std::string source(length, '\0');
+    status = napi_get_value_string_utf8(env, script, &source[0], length + 1, &length);
+    if (status != napi_ok) {
+        return status;
+    }
+
+    return RunScriptWithCodeCache(env, source.data(), length, file, result);
 }
 
 
@@ -109,3 +235,11 @@ napi_status js_get_runtime_version(napi_env env, napi_value *version) {
     napi_create_string_utf8(env, "PrimJS", NAPI_AUTO_LENGTH, version);
     return napi_ok;
 }
+
+napi_status js_get_array_buffer_allocator_stats(napi_env env, napi_value* result) {
+    return napi_generic_failure;
+}
+
+napi_status js_create_strong_reference(napi_env env, napi_value value, napi_ref* result) {
+    return napi_create_reference(env, value, 1, result);
+}
@@ -8,7 +8,9 @@
 #include "napi_env_quickjs.h"
 #include "mutex"
 #include <map>
+#include <memory>
 #include "ConcurrentMap.h"
+#include "jsr_code_cache.h"
 
 class JSR {
 public:
@@ -21,6 +23,9 @@ public:
         js_mutex.unlock();
     }
 
+    // bytecode of the compiled scripts, see js_set_code_cache_path and js_set_code_bundle
+    std::unique_ptr<JsrCodeCache> code_cache;
+
     static tns::SimpleMap<napi_env, JSR *> env_to_jsr_cache;
 };
 
@@ -45,6 +45,23 @@ NAPI_EXTERN napi_value napi_quickjs_value_to_js_value(napi_env env,
 
 NAPI_EXTERN napi_status primjs_execute_pending_jobs(napi_env env);
 
+// Runs the bytecode written by napi_run_script_gen_code_cache, returns
+// napi_invalid_arg without a pending exception when it can't be loaded.
+NAPI_EXTERN napi_status napi_run_code_cache(napi_env env, const uint8_t* data,
+                                            size_t length, napi_value* result);
+
+// Compiles `script` without running it and returns its bytecode in `data`,
+// allocated with new[] and owned by the caller.
+NAPI_EXTERN napi_status napi_gen_code_cache(napi_env env, const char* script,
+                                            size_t length, const char* filename,
+                                            uint8_t** data, size_t* data_length);
+
+// Runs `script` and returns its bytecode in `data`, allocated with new[] and
+// owned by the caller. `data` is null when the bytecode could not be written.
+NAPI_EXTERN napi_status napi_run_script_gen_code_cache(
+    napi_env env, const char* script, size_t length, const char* filename,
+    uint8_t** data, size_t* data_length, napi_value* result);
+
 EXTERN_C_END
 
 #endif  // SRC_NAPI_QUICKJS_NAPI_ENV_QUICKJS_H_
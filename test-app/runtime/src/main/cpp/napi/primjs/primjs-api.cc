@@ -2471,113 +2471,95 @@ napi_status NAPI_CDECL napi_run_script_source(napi_env env,
     return napi_clear_last_error(env);
 }
 
-#ifdef ENABLE_CODECACHE
-
-napi_status napi_run_code_cache(napi_env env, const uint8_t* data, int length,
+napi_status napi_run_code_cache(napi_env env, const uint8_t* data, size_t length,
                                 napi_value* result) {
-  LEPUSValue result_val = LEPUS_UNDEFINED;
   LEPUSValue top_func =
-      LEPUS_EvalBinary(env->ctx->ctx, data, static_cast<size_t>(length),
+      LEPUS_EvalBinary(env->ctx->ctx, data, length,
                        LEPUS_EVAL_BINARY_LOAD_ONLY);
-  if (!LEPUS_IsException(top_func) && !LEPUS_IsUndefined(top_func)) {
-    LEPUSValue global = LEPUS_GetGlobalObject(env->ctx->ctx);
-    env->ctx->CreateHandle(top_func, true);
-    result_val = LEPUS_EvalFunction(env->ctx->ctx, top_func, global);
+  if (LEPUS_IsException(top_func) || LEPUS_IsUndefined(top_func)) {
+    // stale or foreign bytecode, let the caller compile the source
+    JS_FreeValue_Comp(env->ctx->ctx, LEPUS_GetException(env->ctx->ctx));
+    return napi_set_last_error(env, napi_invalid_arg);
   }
+
+  LEPUSValue global = LEPUS_GetGlobalObject(env->ctx->ctx);
+  env->ctx->CreateHandle(top_func, true);
+  js_enter(env);
+  LEPUSValue result_val = LEPUS_EvalFunction(env->ctx->ctx, top_func, global);
+  js_exit(env);
+  JS_FreeValue_Comp(env->ctx->ctx, global);
   CHECK_QJS(env, !LEPUS_IsException(result_val));
 
   *result = env->ctx->CreateHandle(result_val);
   return napi_clear_last_error(env);
 }
 
-napi_status napi_run_script_cache(napi_env env, const char* script,
-                                  size_t length, const char* filename,
-                                  napi_value* result) {
+napi_status napi_gen_code_cache(napi_env env, const char* script,
+                                size_t length, const char* filename,
+                                uint8_t** data, size_t* data_length) {
   if (length == NAPI_AUTO_LENGTH) {
     length = std::strlen(script);
   }
 
-  LEPUSValue result_val = LEPUS_UNINITIALIZED;
-  {
-    int len = -1;
-    const uint8_t* data = nullptr;
-    env->napi_get_code_cache(env, filename, &data, &len);
-    if (data) {
-      // TODO(yang): check whether the script is obsolate
-      LOG_TIME_START();
-      LEPUSValue top_func =
-          LEPUS_EvalBinary(env->ctx->ctx, data, static_cast<size_t>(len),
-                           LEPUS_EVAL_BINARY_LOAD_ONLY);
-      if (!LEPUS_IsException(top_func) && !LEPUS_IsUndefined(top_func)) {
-        LEPUSValue global = LEPUS_GetGlobalObject(env->ctx->ctx);
-        env->ctx->CreateHandle(top_func, true);
-        result_val = LEPUS_EvalFunction(env->ctx->ctx, top_func, global);
-      }
-      LOG_TIME_END("----- script eval with cache -----");
-    } else if (len == 0) {
-      // if len is 0, we need to make cache.
-      // if len is -1, someone is modifying the cache, we do not make cache.
-      LOG_TIME_START();
-      LEPUSValue top_func =
-          LEPUS_Eval(env->ctx->ctx, script, length, filename,
-                     LEPUS_EVAL_FLAG_COMPILE_ONLY | LEPUS_EVAL_TYPE_GLOBAL);
-      CHECK_QJS(env,
-                !LEPUS_IsException(top_func) && !LEPUS_IsUndefined(top_func));
-      LEPUSValue global = LEPUS_GetGlobalObject(env->ctx->ctx);
-      env->ctx->CreateHandle(top_func, true);
-
-      size_t obj_len;
-      data = LEPUS_WriteObject(env->ctx->ctx, &obj_len, top_func,
-                               LEPUS_WRITE_OBJ_BYTECODE);
-      env->napi_store_code_cache(env, filename, data,
-                                 static_cast<int32_t>(obj_len));
-      js_free_comp(env->ctx->ctx,
-                   reinterpret_cast<void*>(const_cast<uint8_t*>(data)));
-      result_val = LEPUS_EvalFunction(env->ctx->ctx, top_func, global);
-      LOG_TIME_END(
-          "---- evaluating %s and making code cache for it lengthed %d -----",
-          filename, (int)obj_len);
-    }
-  }
-  if (LEPUS_IsUninitialized(result_val)) {
-    LOG_TIME_START();
-    result_val = LEPUS_Eval(env->ctx->ctx, script, length,
-                            filename ? filename : "", LEPUS_EVAL_TYPE_GLOBAL);
-    LOG_TIME_END("----- script eval without cache -----");
+  *data = nullptr;
+  *data_length = 0;
+  LEPUSValue top_func =
+      LEPUS_Eval(env->ctx->ctx, script, length, filename ? filename : "",
+                 LEPUS_EVAL_FLAG_COMPILE_ONLY | LEPUS_EVAL_TYPE_GLOBAL);
+  CHECK_QJS(env, !LEPUS_IsException(top_func) && !LEPUS_IsUndefined(top_func));
+  env->ctx->CreateHandle(top_func, true);
+
+  size_t obj_len = 0;
+  uint8_t* cache = LEPUS_WriteObject(env->ctx->ctx, &obj_len, top_func,
+                                     LEPUS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue_Comp(env->ctx->ctx, top_func);
+  if (cache) {
+    *data = new uint8_t[obj_len];
+    *data_length = obj_len;
+    memcpy(*data, cache, obj_len);
+    js_free_comp(env->ctx->ctx, reinterpret_cast<void*>(cache));
   }
-  CHECK_QJS(env, !LEPUS_IsException(result_val));
 
-  *result = env->ctx->CreateHandle(result_val);
   return napi_clear_last_error(env);
 }
 
-// `data` memory need to be freed from outside
-napi_status napi_gen_code_cache(napi_env env, const char* script,
-                                size_t script_len, const uint8_t** data,
-                                int* length) {
-  if (script_len == NAPI_AUTO_LENGTH) {
-    script_len = std::strlen(script);
+napi_status napi_run_script_gen_code_cache(napi_env env, const char* script,
+                                           size_t length, const char* filename,
+                                           uint8_t** data, size_t* data_length,
+                                           napi_value* result) {
+  if (length == NAPI_AUTO_LENGTH) {
+    length = std::strlen(script);
   }
+
+  *data = nullptr;
+  *data_length = 0;
   LEPUSValue top_func =
-      LEPUS_Eval(env->ctx->ctx, script, script_len, "",
+      LEPUS_Eval(env->ctx->ctx, script, length, filename ? filename : "",
                  LEPUS_EVAL_FLAG_COMPILE_ONLY | LEPUS_EVAL_TYPE_GLOBAL);
   CHECK_QJS(env, !LEPUS_IsException(top_func) && !LEPUS_IsUndefined(top_func));
+  LEPUSValue global = LEPUS_GetGlobalObject(env->ctx->ctx);
   env->ctx->CreateHandle(top_func, true);
 
-  size_t obj_len;
+  size_t obj_len = 0;
   uint8_t* cache = LEPUS_WriteObject(env->ctx->ctx, &obj_len, top_func,
                                      LEPUS_WRITE_OBJ_BYTECODE);
-  *data = static_cast<uint8_t*>(std::malloc(obj_len));
-  *length = static_cast<int32_t>(obj_len);
-  memcpy(static_cast<void*>(const_cast<uint8_t*>(*data)),
-         static_cast<void*>(cache), obj_len);
-  js_free_comp(env->ctx->ctx, reinterpret_cast<void*>(cache));
+  if (cache) {
+    *data = new uint8_t[obj_len];
+    *data_length = obj_len;
+    memcpy(*data, cache, obj_len);
+    js_free_comp(env->ctx->ctx, reinterpret_cast<void*>(cache));
+  }
+
+  js_enter(env);
+  LEPUSValue result_val = LEPUS_EvalFunction(env->ctx->ctx, top_func, global);
+  js_exit(env);
+  JS_FreeValue_Comp(env->ctx->ctx, global);
+  CHECK_QJS(env, !LEPUS_IsException(result_val));
 
+  *result = env->ctx->CreateHandle(result_val);
   return napi_clear_last_error(env);
 }
 
-#endif  // ENABLE_CODECACHE
-
 napi_status napi_add_finalizer(napi_env env, napi_value js_object,
                                void *native_object, napi_finalize finalize_cb,
                                void *finalize_hint, napi_ref *result) {
@@ -1,9 +1,124 @@
 #include "jsr.h"
 #include "quicks-runtime.h"
 
+#include <cstring>
+#include "quickjs.h"
+#include "jsr_precompiled.h"
+
 JSR::JSR() = default;
 tns::SimpleMap<napi_env, JSR *> JSR::env_to_jsr_cache;
 
+namespace {
+    JsrCodeCache *GetCodeCache(napi_env env, bool create) {
+        auto jsr = JSR::env_to_jsr_cache.Get(env);
+        if (jsr == nullptr) {
+            return nullptr;
+        }
+        if (!jsr->code_cache && create) {
+            jsr->code_cache.reset(new JsrCodeCache(JS_GetVersion()));
+        }
+        return jsr->code_cache.get();
+    }
+
+    /*
+     * Compiles `source` and returns its bytecode allocated with new[], as the code cache owns it
+     */
+    napi_status CompileSource(napi_env env, const char *source, size_t length, const char *file,
+                              uint8_t **data, size_t *dataLength, napi_value *result) {
+        uint8_t *bytecode = nullptr;
+        napi_status status = qjs_compile_source(env, source, length, file, &bytecode, dataLength,
+                                                result);
+        *data = nullptr;
+        if (bytecode != nullptr) {
+            *data = new uint8_t[*dataLength];
+            memcpy(*data, bytecode, *dataLength);
+            qjs_free_bytecode(env, bytecode);
+        }
+        return status;
+    }
+
+    /*
+     * Runs `source`, which must be null terminated, from the bytecode in the code bundle or cache
+     * when it matches, otherwise from the bytecode js_precompile_function compiled for it or from
+     * the source, and adds its bytecode to the cache
+     */
+    napi_status RunSource(napi_env env, const char *source, size_t length, const char *file,
+                          napi_value *result) {
+        size_t precompiledLength = 0;
+        auto precompiled = JsrPrecompiled::Take(file, source, length, &precompiledLength);
+        auto runPrecompiled = [&]() {
+            if (precompiled == nullptr) {
+                return napi_invalid_arg;
+            }
+            return qjs_execute_bytecode(env, precompiled.get(), precompiledLength, result);
+        };
+
+        auto cache = GetCodeCache(env, false);
+        if (cache == nullptr || !cache->Enabled()) {
+            napi_status status = runPrecompiled();
+            if (status != napi_invalid_arg) {
+                return status;
+            }
+            return qjs_execute_source(env, source, length, file, result);
+        }
+
+        return cache->Run(file, source, length,
+                          [&](const uint8_t *data, size_t dataLength) {
+                              return qjs_execute_bytecode(env, data, dataLength, result);
+                          },
+                          [&](uint8_t **data, size_t *dataLength) {
+                              napi_status status = runPrecompiled();
+                              if (status != napi_invalid_arg) {
+                                  // the cache takes over the bytecode compiled in the background
+                                  if (data != nullptr) {
+                                      *data = precompiled.release();
+                                      *dataLength = precompiledLength;
+                                  }
+                                  return status;
+                              }
+                              if (data == nullptr) {
+                                  return qjs_execute_source(env, source, length, file, result);
+                              }
+                              return CompileSource(env, source, length, file, data, dataLength,
+                                                   result);
+                          });
+    }
+
+    /*
+     * The runtime js_precompile_function compiles with on a thread, freed when the thread exits.
+     * It has no JSR: env_to_jsr_cache is only ever used from the JS threads.
+     */
+    class Precompiler {
+    public:
+        Precompiler() {
+            if (qjs_create_runtime(&m_runtime) != napi_ok) {
+                m_runtime = nullptr;
+                return;
+            }
+            if (qjs_create_napi_env(&m_env, m_runtime) != napi_ok) {
+                m_env = nullptr;
+            }
+        }
+
+        ~Precompiler() {
+            if (m_env != nullptr) {
+                qjs_free_napi_env(m_env);
+            }
+            if (m_runtime != nullptr) {
+                qjs_free_runtime(m_runtime);
+            }
+        }
+
+        napi_env Env() const {
+            return m_env;
+        }
+
+    private:
+        napi_runtime m_runtime = nullptr;
+        napi_env m_env = nullptr;
+    };
+}
+
 napi_status js_create_runtime(napi_runtime *runtime) {
     return qjs_create_runtime(runtime);
 }
@@ -48,23 +163,129 @@ napi_status js_execute_script(napi_env env,
     return qjs_execute_script(env, script, file, result);
 }
 
+napi_status js_compile_function(napi_env env,
+                                const char *source,
+                                size_t length,
+                                const char *file,
+                                const char *const *params,
+                                size_t param_count,
+                                napi_finalize finalize_cb,
+                                void *finalize_hint,
+                                napi_value *result) {
+    // JS_Eval takes a plain null terminated buffer, so the wrapped source is evaluated as is
+    // instead of going through a JS string and back
+    return js_compile_wrapped_function(env, source, length, params, param_count, finalize_cb, finalize_hint,
+                                       [&](std::string &wrapped) {
+        return RunSource(env, wrapped.c_str(), wrapped.size(), file, result);
+    });
+}
+
+napi_status js_precompile_function(const char *source,
+                                   size_t length,
+                                   const char *file,
+                                   const char *const *params,
+                                   size_t param_count) {
+    static thread_local Precompiler precompiler;
+    napi_env env = precompiler.Env();
+    if (env == nullptr) {
+        return napi_generic_failure;
+    }
+
+    std::string wrapped = js_wrap_function_source(source, length, params, param_count);
+    qjs_update_stack_top(env);
+    uint8_t *data;
+    size_t dataLength;
+    napi_status status = CompileSource(env, wrapped.c_str(), wrapped.size(), file, &data,
+                                       &dataLength, nullptr);
+    if (data == nullptr) {
+        // a syntax error is reported when the JS thread compiles the source itself
+        napi_handle_scope scope;
+        napi_value exception;
+        napi_open_handle_scope(env, &scope);
+        napi_get_and_clear_last_exception(env, &exception);
+        napi_close_handle_scope(env, scope);
+        return status != napi_ok ? status : napi_generic_failure;
+    }
+
+    JsrPrecompiled::Add(file, wrapped.c_str(), wrapped.size(),
+                        std::unique_ptr<uint8_t[]>(data), dataLength);
+    return napi_ok;
+}
+
+napi_status js_release_precompiled_functions() {
+    JsrPrecompiled::Clear();
+    return napi_ok;
+}
+
 napi_status js_execute_pending_jobs(napi_env env) {
     return qjs_execute_pending_jobs(env);
 }
 
+napi_status js_set_pending_jobs_callback(napi_env env, js_pending_jobs_callback callback, void *data) {
+    return qjs_set_pending_jobs_callback(env, callback, data);
+}
+
 napi_status
 js_adjust_external_memory(napi_env env, int64_t changeInBytes, int64_t *externalMemory) {
     napi_adjust_external_memory(env, changeInBytes, externalMemory);
     return napi_ok;
 }
 
-napi_status js_cache_script(napi_env env, const char *source, const char *file) {
+napi_status js_set_code_cache_path(napi_env env, const char *path) {
+    auto cache = GetCodeCache(env, true);
+    if (cache == nullptr) {
+        return napi_invalid_arg;
+    }
+
+    cache->SetCachePath(path);
     return napi_ok;
 }
 
+napi_status js_set_code_bundle(napi_env env, const char *path, const char *root) {
+    auto cache = GetCodeCache(env, true);
+    if (cache == nullptr) {
+        return napi_invalid_arg;
+    }
+
+    cache->SetBundle(path, root);
+    return napi_ok;
+}
+
+napi_status js_cache_script(napi_env env, const char *source, const char *file) {
+    auto cache = GetCodeCache(env, false);
+    if (cache == nullptr || !cache->CanStore()) {
+        return napi_ok;
+    }
+
+    size_t length = strlen(source);
+    auto key = cache->Key(file, source, length);
+    int cachedLength;
+    if (cache->Find(key, &cachedLength) != nullptr || cachedLength != 0) {
+        return napi_ok;
+    }
+
+    uint8_t *data;
+    size_t dataLength;
+    napi_status status = CompileSource(env, source, length, file, &data, &dataLength, nullptr);
+    cache->Store(key, data, dataLength);
+    return status;
+}
+
 napi_status js_run_cached_script(napi_env env, const char *file, napi_value script, void *cache,
                                  napi_value *result) {
-    return napi_ok;
+    size_t length;
+    napi_status status = napi_get_value_string_utf8(env, script, nullptr, 0, &length);
+    if (status != napi_ok) {
+        return status;
+    }
+
+    std::string source(length, '\0');
+    status = napi_get_value_string_utf8(env, script, &source[0], length + 1, &length);
+    if (status != napi_ok) {
+        return status;
+    }
+
+    return RunSource(env, source.c_str(), length, file, result);
 }
 
 
@@ -73,3 +294,11 @@ napi_status js_get_runtime_version(napi_env env, napi_value *version) {
 
     return napi_ok;
 }
+
+napi_status js_get_array_buffer_allocator_stats(napi_env env, napi_value* result) {
+    return napi_generic_failure;
+}
+
+napi_status js_create_strong_reference(napi_env env, napi_value value, napi_ref* result) {
+    return napi_create_reference(env, value, 1, result);
+}
@@ -85,8 +85,17 @@ static const JSMallocFunctions mi_mf = {
  *         NAPI UNDEFINED AND NULL
  * --------------------------------------
  */
-static JSValueConst JSUndefined = JS_UNDEFINED;
-static JSValueConst JSNull = JS_NULL;
+/*
+ * JS_UNDEFINED and co. are compound literals, which only clang accepts in static initializers
+ */
+#if defined(JS_NAN_BOXING) && JS_NAN_BOXING
+#define JS_STATIC_VALUE(tag, val) JS_MKVAL(tag, val)
+#else
+#define JS_STATIC_VALUE(tag, val) { { .int32 = val }, tag }
+#endif
+
+static JSValueConst JSUndefined = JS_STATIC_VALUE(JS_TAG_UNDEFINED, 0);
+static JSValueConst JSNull = JS_STATIC_VALUE(JS_TAG_NULL, 0);
 
 /**
  * --------------------------------------
@@ -184,6 +193,8 @@ typedef struct napi_env__ {
     ExternalInfo *gcAfter;
     int js_enter_state;
     int64_t usedMemory;
+    void (*pendingJobsCallback)(napi_env env, void *data);
+    void *pendingJobsData;
 } napi_env__;
 
 typedef struct napi_runtime__ {
@@ -218,6 +229,8 @@ typedef struct ExternalBufferInfo {
  * -------------------------------------
  */
 
+static void qjs_notify_pending_jobs(napi_env env, JSRuntime *rt);
+
 static inline void js_enter(napi_env env) {
     env->js_enter_state++;
 }
@@ -434,6 +447,9 @@ napi_status napi_close_handle_scope(napi_env env, napi_handle_scope scope) {
     LIST_REMOVE(scope, node);
     mi_free(scope);
 
+    // releasing the last handle to an object queues its FinalizationRegistry cleanups
+    qjs_notify_pending_jobs(env, JS_GetRuntime(env->context));
+
     return napi_clear_last_error(env);
 }
 
@@ -479,6 +495,8 @@ napi_close_escapable_handle_scope(napi_env env, napi_escapable_handle_scope esca
     LIST_REMOVE(escapableScope, node);
     mi_free(escapableScope);
 
+    qjs_notify_pending_jobs(env, JS_GetRuntime(env->context));
+
     return napi_clear_last_error(env);
 }
 
@@ -781,6 +799,7 @@ napi_status napi_reference_unref(napi_env env, napi_ref ref, uint32_t *result) {
         JS_FreeValue(env->context, JS_WeakRef_Ctor);
         JS_FreeValue(env->context, ref->value);
         ref->value = weak_ref;
+        qjs_notify_pending_jobs(env, JS_GetRuntime(env->context));
     }
 
     uint8_t count = --ref->referenceCount;
@@ -818,6 +837,7 @@ napi_status napi_delete_reference(napi_env env, napi_ref ref) {
     if (!JS_IsUndefined(ref->value)) {
         JS_FreeValue(env->context, ref->value);
         ref->value = JSUndefined;
+        qjs_notify_pending_jobs(env, JS_GetRuntime(env->context));
     }
 
     LIST_REMOVE(ref, node);
@@ -1939,6 +1959,26 @@ napi_status napi_get_value_int64(napi_env env,
     return napi_clear_last_error(env);
 }
 
+/*
+ * Copies what fits of `src` into `dst` of `size` bytes, null terminated, and returns the number of
+ * bytes copied. UTF-8 is cut at a character boundary.
+ */
+static size_t CopyCString(char *dst, size_t size, const char *src, size_t length, bool utf8) {
+    if (size == 0) {
+        return 0;
+    }
+
+    size_t copied = length < size - 1 ? length : size - 1;
+    if (utf8 && copied < length) {
+        while (copied > 0 && (src[copied] & 0xC0) == 0x80) {
+            copied--;
+        }
+    }
+    memcpy(dst, src, copied);
+    dst[copied] = '\0';
+    return copied;
+}
+
 napi_status napi_get_value_string_latin1(napi_env env, napi_value value, char *str, size_t length,
                                          size_t *result) {
     CHECK_ARG(env)
@@ -1954,11 +1994,9 @@ napi_status napi_get_value_string_latin1(napi_env env, napi_value value, char *s
     if (str == NULL) {
         CHECK_ARG(result)
         *result = cstr_len;
-    } else if (length != 0) {
-        strcpy(str, cstr);
-        str[cstr_len] = '\0';
-    } else if (result != NULL) {
-        *result = 0;
+    } else {
+        size_t copied = CopyCString(str, length, cstr, cstr_len, false);
+        if (result != NULL) *result = copied;
     }
 
     JS_FreeCString(env->context, cstr);
@@ -1980,11 +2018,9 @@ napi_status napi_get_value_string_utf8(napi_env env, napi_value value, char *str
     if (str == NULL) {
         CHECK_ARG(result)
         *result = cstr_len;
-    } else if (length != 0) {
-        strcpy(str, cstr);
-        str[cstr_len] = '\0';
-    } else if (result != NULL) {
-        *result = 0;
+    } else {
+        size_t copied = CopyCString(str, length, cstr, cstr_len, true);
+        if (result != NULL) *result = copied;
     }
 
     JS_FreeCString(env->context, cstr);
@@ -2003,22 +2039,17 @@ void Utf8ShiftAndMask(uint32_t *codePoint, const uint8_t byte) {
 
 uint32_t Utf8ToUtf32CodePoint(const char *src, size_t length) {
     uint32_t unicode = 0;
-    const
-    size_t lengthSizeOne = 1;
-    const
-    size_t lengthSizeTwo = 2;
-    const
-    size_t lengthSizeThree = 3;
-    const
-    size_t lengthSizeFour = 4;
-    const
-    size_t offsetZero = 0;
-    const
-    size_t offsetOne = 1;
-    const
-    size_t offsetTwo = 2;
-    const
-    size_t offsetThree = 3;
+    // enumerators, `const` variables are not constant expressions in C
+    enum {
+        lengthSizeOne = 1,
+        lengthSizeTwo = 2,
+        lengthSizeThree = 3,
+        lengthSizeFour = 4,
+        offsetZero = 0,
+        offsetOne = 1,
+        offsetTwo = 2,
+        offsetThree = 3
+    };
     switch (length) {
         case lengthSizeOne:
             return src[offsetZero];
@@ -2159,8 +2190,8 @@ napi_status napi_get_value_uint32(napi_env env,
  * https://nodejs.org/api/n-api.html#functions-to-get-global-instances
  */
 
-static JSValue JSTrueValue = JS_TRUE;
-static JSValue JSFalseValue = JS_FALSE;
+static JSValue JSTrueValue = JS_STATIC_VALUE(JS_TAG_BOOL, 1);
+static JSValue JSFalseValue = JS_STATIC_VALUE(JS_TAG_BOOL, 0);
 
 napi_status napi_get_boolean(napi_env env, bool value, napi_value *result) {
     CHECK_ARG(env)
@@ -3683,7 +3714,7 @@ napi_status napi_type_tag_object(napi_env env, napi_value object, const napi_typ
 
     bool isTypeTagged = false;
 
-    uint64_t words[size] = {tag->lower, tag->upper};
+    uint64_t words[2] = {tag->lower, tag->upper};
     isTypeTagged = JS_HasProperty(env->context, jsValue, env->atoms.napi_typetag);
     if (!isTypeTagged) {
         JSValue value = JS_CreateBigIntWords(env->context, 0, size, words);
@@ -3719,7 +3750,7 @@ napi_check_object_type_tag(napi_env env, napi_value object, const napi_type_tag
     JSValue value = JS_GetProperty(env->context, jsValue, env->atoms.napi_typetag);
     int sign = 0;
     size_t wordCount = size;
-    uint64_t words[size] = {0};
+    uint64_t words[2] = {0};
     *result = JS_GetBigIntWords(env->context, value, &sign, &wordCount, words);
     if (result && wordCount >= size) {
         if ((words[0] == tag->lower) && (words[1] == tag->upper)) {
@@ -4001,11 +4032,19 @@ napi_status qjs_create_runtime(napi_runtime *runtime) {
     return napi_ok;
 }
 
+static void qjs_notify_pending_jobs(napi_env env, JSRuntime *rt) {
+    if (env->pendingJobsCallback != NULL && env->js_enter_state <= 0 && JS_IsJobPending(rt)) {
+        env->pendingJobsCallback(env, env->pendingJobsData);
+    }
+}
+
 static void JS_AfterGCCallback(JSRuntime *rt) {
     napi_env env = (napi_env) JS_GetRuntimeOpaque(rt);
     if (env->gcAfter != NULL) {
         env->gcAfter->finalizeCallback(env, env->gcAfter->data, env->gcAfter->finalizeHint);
     }
+    // FinalizationRegistry callbacks are queued by the collector, which may run outside of any JS call
+    qjs_notify_pending_jobs(env, rt);
 }
 
 static int JS_BeforeGCCallback(JSRuntime *rt) {
@@ -4034,9 +4073,11 @@ JSFinalizeValueCallback(JSContext *ctx, JSValueConst this_val, int argc, JSValue
     if (!JS_IsUndefined(heldValue)) {
         ExternalInfo *info = (ExternalInfo *) JS_GetOpaque(heldValue,
                                                            env->runtime->externalClassId);
-        if (info != NULL) {
+        if (info != NULL && info->finalizeCallback != NULL) {
             info->finalizeCallback(env, info->data,
                                    info->finalizeHint);
+            // the held value is released after this, its own finalizer must not call it again
+            info->finalizeCallback = NULL;
         }
     }
     return JS_UNDEFINED;
@@ -4062,6 +4103,9 @@ napi_status qjs_create_napi_env(napi_env *env, napi_runtime runtime) {
 
     (*env)->js_enter_state = 0;
 
+    (*env)->pendingJobsCallback = NULL;
+    (*env)->pendingJobsData = NULL;
+
     JS_SetRuntimeOpaque(runtime->runtime, *env);
 
     JS_SetGCAfterCallback(runtime->runtime, JS_AfterGCCallback);
@@ -4242,7 +4286,7 @@ napi_status qjs_free_runtime(napi_runtime runtime) {
 
     mi_free(env);
 
-    return napi_clear_last_error(env);
+    return napi_ok;
 }
 
 
@@ -4253,17 +4297,22 @@ napi_status qjs_execute_script(napi_env env,
     CHECK_ARG(env)
     CHECK_ARG(script)
 
-    JSValue eval_result;
-    const char *cScript = JS_ToCString(env->context, *((JSValue *) script));
-    js_enter(env);
-    eval_result = JS_Eval(env->context, cScript, strlen(cScript), file, JS_EVAL_TYPE_GLOBAL);
+    size_t length;
+    const char *cScript = JS_ToCStringLen(env->context, &length, *((JSValue *) script));
+    napi_status status = qjs_execute_source(env, cScript, length, file, result);
     JS_FreeCString(env->context, cScript);
-    js_exit(env);
+
+    return status;
+}
+
+static napi_status SetEvalResult(napi_env env, JSValue eval_result, napi_value *result) {
     if (JS_IsException(eval_result)) {
-        const char *exceptionMessage = JS_ToCString(env->context, eval_result);
+        // eval_result only marks the failure, the error itself is the pending exception
+        JSValue exception = JS_GetException(env->context);
+        const char *exceptionMessage = JS_ToCString(env->context, exception);
         napi_set_last_error(env, napi_cannot_run_js, exceptionMessage, 0, NULL);
         JS_FreeCString(env->context, exceptionMessage);
-        JS_Throw(env->context, eval_result);
+        JS_Throw(env->context, exception);
         return napi_cannot_run_js;
     }
 
@@ -4276,6 +4325,88 @@ napi_status qjs_execute_script(napi_env env,
     return napi_clear_last_error(env);
 }
 
+napi_status qjs_execute_source(napi_env env,
+                               const char *source,
+                               size_t length,
+                               const char *file,
+                               napi_value *result) {
+    CHECK_ARG(env)
+    CHECK_ARG(source)
+
+    JSValue eval_result;
+    js_enter(env);
+    eval_result = JS_Eval(env->context, source, length, file, JS_EVAL_TYPE_GLOBAL);
+    js_exit(env);
+
+    return SetEvalResult(env, eval_result, result);
+}
+
+napi_status qjs_compile_source(napi_env env,
+                               const char *source,
+                               size_t length,
+                               const char *file,
+                               uint8_t **data,
+                               size_t *data_length,
+                               napi_value *result) {
+    CHECK_ARG(env)
+    CHECK_ARG(source)
+    CHECK_ARG(data)
+    CHECK_ARG(data_length)
+
+    *data = NULL;
+    *data_length = 0;
+    JSValue function = JS_Eval(env->context, source, length, file,
+                               JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(function)) {
+        return SetEvalResult(env, function, result);
+    }
+
+    // the source is kept for Function.prototype.toString, the debug info for stack traces
+    *data = JS_WriteObject(env->context, data_length, function, JS_WRITE_OBJ_BYTECODE);
+    if (*data == NULL) {
+        *data_length = 0;
+        JS_FreeValue(env->context, JS_GetException(env->context));
+    }
+
+    if (!result) {
+        JS_FreeValue(env->context, function);
+        return napi_clear_last_error(env);
+    }
+
+    JSValue eval_result;
+    js_enter(env);
+    eval_result = JS_EvalFunction(env->context, function);
+    js_exit(env);
+
+    return SetEvalResult(env, eval_result, result);
+}
+
+napi_status qjs_execute_bytecode(napi_env env,
+                                 const uint8_t *data,
+                                 size_t length,
+                                 napi_value *result) {
+    CHECK_ARG(env)
+    CHECK_ARG(data)
+
+    JSValue function = JS_ReadObject(env->context, data, length, JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(function)) {
+        // bytecode of another engine build, the caller compiles the source instead
+        JS_FreeValue(env->context, JS_GetException(env->context));
+        return napi_set_last_error(env, napi_invalid_arg, NULL, 0, NULL);
+    }
+
+    JSValue eval_result;
+    js_enter(env);
+    eval_result = JS_EvalFunction(env->context, function);
+    js_exit(env);
+
+    return SetEvalResult(env, eval_result, result);
+}
+
+void qjs_free_bytecode(napi_env env, uint8_t *data) {
+    js_free(env->context, data);
+}
+
 
 napi_status qjs_runtime_before_gc_callback(napi_env env, napi_finalize cb, void *data) {
     CHECK_ARG(env)
@@ -4311,6 +4442,8 @@ napi_status qjs_execute_pending_jobs(napi_env env) {
         JSContext *context;
         error = JS_ExecutePendingJob(JS_GetRuntime(env->context), &context);
         if (error == -1) {
+            // the jobs behind the one that threw are still queued
+            qjs_notify_pending_jobs(env, JS_GetRuntime(env->context));
             return napi_set_last_error(env, napi_pending_exception, NULL, 0, NULL);
         }
     } while (error != 0);
@@ -4318,6 +4451,13 @@ napi_status qjs_execute_pending_jobs(napi_env env) {
     return napi_clear_last_error(env);
 }
 
+napi_status qjs_set_pending_jobs_callback(napi_env env, void (*callback)(napi_env env, void *data), void *data) {
+    CHECK_ARG(env)
+    env->pendingJobsCallback = callback;
+    env->pendingJobsData = data;
+    return napi_clear_last_error(env);
+}
+
 napi_status qjs_update_stack_top(napi_env env) {
     CHECK_ARG(env)
     JS_UpdateStackTop(env->runtime->runtime);
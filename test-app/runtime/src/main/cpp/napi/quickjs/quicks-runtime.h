@@ -21,6 +21,39 @@ NAPI_EXTERN napi_status NAPI_CDECL qjs_execute_script(napi_env env,
                                                       const char *file,
                                                       napi_value *result);
 
+/*
+ * Evaluates `source`, which must be null terminated at `source[length]`, without copying it.
+ */
+NAPI_EXTERN napi_status NAPI_CDECL qjs_execute_source(napi_env env,
+                                                      const char *source,
+                                                      size_t length,
+                                                      const char *file,
+                                                      napi_value *result);
+
+/*
+ * Compiles `source` like qjs_execute_source and returns its bytecode in `data`, to be freed with
+ * qjs_free_bytecode. `data` is null when the bytecode could not be written. The compiled script
+ * runs as well unless `result` is null.
+ */
+NAPI_EXTERN napi_status NAPI_CDECL qjs_compile_source(napi_env env,
+                                                      const char *source,
+                                                      size_t length,
+                                                      const char *file,
+                                                      uint8_t **data,
+                                                      size_t *data_length,
+                                                      napi_value *result);
+
+/*
+ * Runs bytecode written by qjs_compile_source. Returns napi_invalid_arg, without a pending
+ * exception, for bytecode this build of the engine can't read.
+ */
+NAPI_EXTERN napi_status NAPI_CDECL qjs_execute_bytecode(napi_env env,
+                                                        const uint8_t *data,
+                                                        size_t length,
+                                                        napi_value *result);
+
+NAPI_EXTERN void NAPI_CDECL qjs_free_bytecode(napi_env env, uint8_t *data);
+
 NAPI_EXTERN napi_status NAPI_CDECL qjs_runtime_before_gc_callback(napi_env env, napi_finalize cb, void *data);
 
 NAPI_EXTERN napi_status NAPI_CDECL qjs_runtime_after_gc_callback(napi_env env, napi_finalize cb, void *data);
@@ -28,6 +61,14 @@ NAPI_EXTERN napi_status NAPI_CDECL qjs_runtime_after_gc_callback(napi_env env, n
 
 NAPI_EXTERN napi_status NAPI_CDECL qjs_execute_pending_jobs(napi_env env);
 
+/*
+ * `callback` is invoked when jobs got queued that are not drained by a returning napi call, see
+ * js_set_pending_jobs_callback.
+ */
+NAPI_EXTERN napi_status NAPI_CDECL qjs_set_pending_jobs_callback(napi_env env,
+                                                                 void (*callback)(napi_env env, void *data),
+                                                                 void *data);
+
 NAPI_EXTERN napi_status NAPI_CDECL qjs_update_stack_top(napi_env env);
 
 EXTERN_C_END
@@ -0,0 +1,146 @@
+// Precompiles the modules of an app to QuickJS bytecode, in a single bundle the runtime maps at
+// startup (see js_set_code_bundle). Built with the host test project:
+//
+//   cmake --build build/host-tests --target qjs_code_bundle
+//   build/host-tests/qjs_code_bundle <app dir> <device app dir> <bundle>
+//
+// The bundle belongs at app/ns-code-bundle.bin in the assets. <device app dir> is the app
+// directory on the device, e.g. /data/data/<package>/files/app, it is only used for the file
+// names in stack traces. A module runs from the bundle when its source is the one it was built
+// from and the engine is the same QuickJS version, otherwise it is compiled as usual.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "jsr.h"
+#include "quickjs.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    // must match ModuleInternal::MODULE_PARAMS, otherwise the modules simply miss the bundle
+    const char *const MODULE_PARAMS[] = {"module", "exports", "require", "__filename", "__dirname"};
+    const size_t MODULE_PARAM_COUNT = sizeof(MODULE_PARAMS) / sizeof(MODULE_PARAMS[0]);
+
+    bool ReadFile(const fs::path &path, std::string &content) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        content = buffer.str();
+        return true;
+    }
+
+    std::string TakeException(napi_env env) {
+        bool pending;
+        napi_is_exception_pending(env, &pending);
+        if (!pending) {
+            return "no bytecode";
+        }
+
+        napi_value exception, message;
+        napi_get_and_clear_last_exception(env, &exception);
+        napi_coerce_to_string(env, exception, &message);
+        size_t length;
+        napi_get_value_string_utf8(env, message, nullptr, 0, &length);
+        std::string result(length, '\0');
+        napi_get_value_string_utf8(env, message, &result[0], length + 1, &length);
+        return result;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <app dir> <device app dir> <bundle>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fs::path appDir(argv[1]);
+    std::string deviceRoot(argv[2]);
+    if (deviceRoot.empty() || deviceRoot.back() != '/') {
+        deviceRoot += '/';
+    }
+
+    std::vector<fs::path> files;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(appDir, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_regular_file() && it->path().extension() == ".js") {
+            files.push_back(it->path());
+        }
+    }
+    if (error) {
+        fprintf(stderr, "cannot read %s: %s\n", argv[1], error.message().c_str());
+        return EXIT_FAILURE;
+    }
+    std::sort(files.begin(), files.end());
+
+    napi_runtime runtime;
+    napi_env env;
+    js_create_runtime(&runtime);
+    js_create_napi_env(&env, runtime);
+
+    // keys relative to the app, the bundle has no root of its own
+    JsrCodeCache keys(JS_GetVersion());
+    CacheBlob bundle(argv[3], INT_MAX);
+    size_t compiled = 0, skipped = 0, sourceBytes = 0, bytecodeBytes = 0;
+    for (auto &file: files) {
+        std::string source;
+        if (!ReadFile(file, source)) {
+            fprintf(stderr, "cannot read %s\n", file.c_str());
+            return EXIT_FAILURE;
+        }
+
+        auto relative = fs::relative(file, appDir).generic_string();
+        auto wrapped = js_wrap_function_source(source.data(), source.size(), MODULE_PARAMS,
+                                               MODULE_PARAM_COUNT);
+        auto url = "file://" + deviceRoot + relative;
+
+        napi_handle_scope scope;
+        napi_open_handle_scope(env, &scope);
+        uint8_t *bytecode = nullptr;
+        size_t length = 0;
+        napi_status status = qjs_compile_source(env, wrapped.c_str(), wrapped.size(), url.c_str(),
+                                                &bytecode, &length, nullptr);
+        if (status != napi_ok || bytecode == nullptr) {
+            // the runtime compiles it from source and reports the error
+            fprintf(stderr, "skipping %s: %s\n", relative.c_str(), TakeException(env).c_str());
+            napi_close_handle_scope(env, scope);
+            skipped++;
+            continue;
+        }
+
+        auto data = new uint8_t[length];
+        memcpy(data, bytecode, length);
+        qjs_free_bytecode(env, bytecode);
+        napi_close_handle_scope(env, scope);
+
+        if (!bundle.insert(keys.Key(relative.c_str(), wrapped.data(), wrapped.size()), data, (int) length)) {
+            fprintf(stderr, "%s does not fit in a bundle\n", relative.c_str());
+            return EXIT_FAILURE;
+        }
+        compiled++;
+        sourceBytes += source.size();
+        bytecodeBytes += length;
+    }
+
+    bundle.output();
+    js_free_napi_env(env);
+    js_free_runtime(runtime);
+
+    std::error_code sizeError;
+    if (!fs::exists(argv[3], sizeError)) {
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+    printf("%zu modules, %zu source bytes, %zu bytecode bytes, %zu skipped -> %s\n", compiled,
+           sourceBytes, bytecodeBytes, skipped, argv[3]);
+    return EXIT_SUCCESS;
+}
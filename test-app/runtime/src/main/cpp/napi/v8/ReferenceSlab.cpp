@@ -0,0 +1,89 @@
+#include "ReferenceSlab.h"
+#include <cstdlib>
+
+using namespace v8impl;
+
+ReferenceSlab::ReferenceSlab()
+        : m_freeList(nullptr), m_next(nullptr), m_end(nullptr), m_chunks(), m_liveSlots(0),
+          m_peakSlots(0) {
+}
+
+ReferenceSlab::~ReferenceSlab() {
+    for (auto chunk: m_chunks) {
+        if (chunk->liveSlots == 0) {
+            free(chunk);
+        } else {
+            chunk->slab = nullptr;
+        }
+    }
+}
+
+void* ReferenceSlab::Allocate() {
+    void* slot;
+    if (m_freeList != nullptr) {
+        slot = m_freeList;
+        m_freeList = m_freeList->next;
+    } else {
+        if (m_next == m_end && !Grow()) {
+            return nullptr;
+        }
+        slot = m_next;
+        m_next += SLOT_SIZE;
+    }
+
+    ChunkOf(slot)->liveSlots++;
+    if (++m_liveSlots > m_peakSlots) {
+        m_peakSlots = m_liveSlots;
+    }
+    return slot;
+}
+
+void ReferenceSlab::Free(void* slot) {
+    if (slot == nullptr) {
+        return;
+    }
+
+    auto chunk = ChunkOf(slot);
+    chunk->liveSlots--;
+    auto slab = chunk->slab;
+    if (slab == nullptr) {
+        if (chunk->liveSlots == 0) {
+            free(chunk);
+        }
+        return;
+    }
+
+    auto freeSlot = static_cast<FreeSlot*>(slot);
+    freeSlot->next = slab->m_freeList;
+    slab->m_freeList = freeSlot;
+    slab->m_liveSlots--;
+}
+
+ReferenceSlab::Stats ReferenceSlab::GetStats() const {
+    Stats stats;
+    stats.liveSlots = m_liveSlots;
+    stats.peakSlots = m_peakSlots;
+    stats.chunkBytes = (int64_t) (m_chunks.size() * CHUNK_SIZE);
+    return stats;
+}
+
+bool ReferenceSlab::Grow() {
+    void* memory;
+    if (posix_memalign(&memory, CHUNK_SIZE, CHUNK_SIZE) != 0) {
+        return false;
+    }
+
+    auto chunk = static_cast<Chunk*>(memory);
+    chunk->slab = this;
+    chunk->liveSlots = 0;
+    m_chunks.push_back(chunk);
+
+    auto bytes = static_cast<char*>(memory);
+    m_next = bytes + HEADER_SIZE;
+    m_end = m_next + (CHUNK_SIZE - HEADER_SIZE) / SLOT_SIZE * SLOT_SIZE;
+    return true;
+}
+
+ReferenceSlab::Chunk* ReferenceSlab::ChunkOf(void* slot) {
+    return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(slot) & ~(uintptr_t) (CHUNK_SIZE - 1));
+}
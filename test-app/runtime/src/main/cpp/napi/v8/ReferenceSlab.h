@@ -0,0 +1,76 @@
+#ifndef REFERENCESLAB_H_
+#define REFERENCESLAB_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace v8impl {
+/*
+ * The memory of the references of an env, in SLOT_SIZE slots carved out of CHUNK_SIZE chunks
+ * that are aligned to their size, so that a slot finds its chunk, and through it the slab, from
+ * its address. Freed slots go on an intrusive free list and are reused before the chunks grow.
+ *
+ * Userland references may be deleted after the env: the slab hands the chunks that still have
+ * live slots over to them when it is destroyed, the last slot freed releases its chunk.
+ *
+ * Not thread safe, like the env it belongs to.
+ */
+class ReferenceSlab {
+    public:
+        struct Stats {
+            int64_t liveSlots;
+            int64_t peakSlots;
+            // the bytes of the chunks, what the references cost in the heap
+            int64_t chunkBytes;
+        };
+
+        ReferenceSlab();
+
+        ~ReferenceSlab();
+
+        ReferenceSlab(const ReferenceSlab &) = delete;
+
+        ReferenceSlab &operator=(const ReferenceSlab &) = delete;
+
+        // a SLOT_SIZE slot, or nullptr when out of memory
+        void* Allocate();
+
+        // frees a slot of any slab, also of one that was destroyed since
+        static void Free(void* slot);
+
+        Stats GetStats() const;
+
+        // the size of a v8impl::Reference, checked where it is defined
+        static constexpr size_t SLOT_SIZE = sizeof(void*) == 8 ? 80 : 44;
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    private:
+        struct Chunk {
+            // nullptr once the slab is gone
+            ReferenceSlab* slab;
+            size_t liveSlots;
+        };
+
+        struct FreeSlot {
+            FreeSlot* next;
+        };
+
+        bool Grow();
+
+        static Chunk* ChunkOf(void* slot);
+
+        static constexpr size_t HEADER_SIZE = (sizeof(Chunk) + alignof(std::max_align_t) - 1) &
+                                              ~(alignof(std::max_align_t) - 1);
+
+        FreeSlot* m_freeList;
+        // the part of the last chunk that was never handed out
+        char* m_next;
+        char* m_end;
+        std::vector<Chunk*> m_chunks;
+        int64_t m_liveSlots;
+        int64_t m_peakSlots;
+};
+}
+
+#endif /* REFERENCESLAB_H_ */
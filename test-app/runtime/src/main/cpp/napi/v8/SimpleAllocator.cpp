@@ -1,26 +1,146 @@
 #include "SimpleAllocator.h"
 #include <cstdlib>
+#include <cstring>
 
 using namespace tns;
 
-SimpleAllocator::SimpleAllocator() {
+namespace {
+    // the classes start above SMALL_MAX, 2^SMALL_POWER bytes
+    constexpr int SMALL_POWER = 16;
+    static_assert(SimpleAllocator::SMALL_MAX == (size_t) 1 << SMALL_POWER, "SMALL_POWER must match SMALL_MAX");
+}
+
+SimpleAllocator::SimpleAllocator()
+        : m_freeLists(), m_pooledBytes(0), m_reused(0), m_live(0), m_peakBytes(0), m_allocations(0) {
 }
 
 SimpleAllocator::~SimpleAllocator() {
+    for (auto& list: m_freeLists) {
+        while (list != nullptr) {
+            auto block = list;
+            list = block->next;
+            free(block);
+        }
+    }
 }
 
 void* SimpleAllocator::Allocate(size_t length) {
-    void* data = calloc(length, 1);
-    return data;
+    return Allocate(length, true);
 }
 
 void* SimpleAllocator::AllocateUninitialized(size_t length) {
-    void* data = malloc(length);
-    return data;
+    return Allocate(length, false);
+}
+
+void* SimpleAllocator::Allocate(size_t length, bool zeroed) {
+    void* data;
+    if (length <= SMALL_MAX || length > LARGE_MAX) {
+        data = zeroed ? calloc(length, 1) : malloc(length);
+    } else {
+        int index = ClassOf(length);
+        size_t size = ClassSize(index);
 
+        Block* block = nullptr;
+        if (m_pooledBytes.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            block = Pop(index, size);
+            if (block != nullptr) {
+                m_reused++;
+            }
+        }
+
+        if (block != nullptr) {
+            if (zeroed) {
+                memset(block, 0, length);
+            }
+            Account(length);
+            return block;
+        }
+
+        // the whole class, for the free list
+        data = zeroed ? calloc(size, 1) : malloc(size);
+    }
+
+    if (data != nullptr) {
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        Account(length);
+    }
+    return data;
 }
 
 void SimpleAllocator::Free(void* data, size_t length) {
+    if (data == nullptr) {
+        return;
+    }
+
+    auto live = m_live.fetch_sub(LIVE_BUFFER + length, std::memory_order_relaxed) - LIVE_BUFFER - length;
+    if (length > SMALL_MAX && length <= LARGE_MAX && (live & (LIVE_BUFFER - 1)) >= POOL_LIVE_BYTES) {
+        int index = ClassOf(length);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (Push(index, static_cast<Block*>(data), ClassSize(index))) {
+            return;
+        }
+    }
+
     free(data);
 }
 
+SimpleAllocator::Block* SimpleAllocator::Pop(int index, size_t size) {
+    auto block = m_freeLists[index];
+    if (block != nullptr) {
+        m_freeLists[index] = block->next;
+        m_pooledBytes.store(m_pooledBytes.load(std::memory_order_relaxed) - size, std::memory_order_relaxed);
+    }
+    return block;
+}
+
+bool SimpleAllocator::Push(int index, Block* block, size_t size) {
+    auto pooled = m_pooledBytes.load(std::memory_order_relaxed);
+    if (pooled + size > LARGE_POOL_BYTES) {
+        return false;
+    }
+    block->next = m_freeLists[index];
+    m_freeLists[index] = block;
+    m_pooledBytes.store(pooled + size, std::memory_order_relaxed);
+    return true;
+}
+
+SimpleAllocator::Stats SimpleAllocator::GetStats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.reused = m_reused;
+        stats.pooledBytes = (int64_t) m_pooledBytes.load(std::memory_order_relaxed);
+    }
+    stats.allocations = m_allocations.load(std::memory_order_relaxed) + stats.reused;
+
+    auto live = m_live.load(std::memory_order_relaxed);
+    stats.liveBytes = (int64_t) (live & (LIVE_BUFFER - 1));
+    stats.frees = stats.allocations - (int64_t) (live >> LIVE_BYTES_BITS);
+    stats.peakBytes = m_peakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SimpleAllocator::Account(size_t length) {
+    auto live = m_live.fetch_add(LIVE_BUFFER + length, std::memory_order_relaxed) + LIVE_BUFFER + length;
+    auto bytes = (int64_t) (live & (LIVE_BUFFER - 1));
+    auto peak = m_peakBytes.load(std::memory_order_relaxed);
+    while (bytes > peak && !m_peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+/*
+ * The classes of the lengths above SMALL_MAX, four per power of two: 80KB, 96KB, 112KB, 128KB,
+ * 160KB, ... so that rounding up wastes at most a fifth of a buffer
+ */
+int SimpleAllocator::ClassOf(size_t length) {
+    // 2^power < length <= 2^(power + 1), the two bits below the top one of length - 1 are the
+    // quarter of the class
+    int power = 63 - __builtin_clzll((unsigned long long) (length - 1));
+    return (power - SMALL_POWER) * 4 + (int) (((length - 1) >> (power - 2)) & 3);
+}
+
+size_t SimpleAllocator::ClassSize(int index) {
+    int power = SMALL_POWER + index / 4;
+    return ((size_t) 1 << power) + (size_t) (index % 4 + 1) * ((size_t) 1 << (power - 2));
+}
@@ -1,11 +1,38 @@
 #ifndef SIMPLEALLOCATOR_H_
 #define SIMPLEALLOCATOR_H_
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include "v8.h"
 
 namespace tns {
+/*
+ * The ArrayBuffer allocator of all the isolates, which may live on different threads.
+ *
+ * Buffers up to SMALL_MAX bytes and above LARGE_MAX go straight to calloc/malloc, whose
+ * per-thread caches recycle the small ones without a lock. The others are rounded up to size
+ * classes a quarter of a power of two apart. The ones freed while at least POOL_LIVE_BYTES of
+ * other buffers are alive stay on the free list of their class, within LARGE_POOL_BYTES, and
+ * the next allocations of the class reuse them and only clear the bytes they asked for. That
+ * spares malloc growing and trimming its heap with the bursts of large buffers. While fewer are
+ * alive the buffers go back to malloc too: it reuses the same memory for the next buffer of any
+ * size, where the free lists would keep one buffer per class.
+ */
 class SimpleAllocator: public v8::ArrayBuffer::Allocator {
     public:
+        struct Stats {
+            // the bytes of the buffers that are alive, as requested by V8
+            int64_t liveBytes;
+            int64_t peakBytes;
+            int64_t allocations;
+            int64_t frees;
+            // the allocations served from the free lists
+            int64_t reused;
+            // the bytes of the buffers on the free lists
+            int64_t pooledBytes;
+        };
+
         SimpleAllocator();
 
         ~SimpleAllocator() override;
@@ -15,6 +42,51 @@ class SimpleAllocator: public v8::ArrayBuffer::Allocator {
         void* AllocateUninitialized(size_t length) override;
 
         void Free(void* data, size_t length) override;
+
+        Stats GetStats() const;
+
+        static constexpr size_t SMALL_MAX = 64 * 1024;
+        static constexpr size_t LARGE_MAX = 4 * 1024 * 1024;
+        static constexpr size_t POOL_LIVE_BYTES = 1024 * 1024;
+        static constexpr size_t LARGE_POOL_BYTES = 8 * 1024 * 1024;
+
+    private:
+        struct Block {
+            Block* next;
+        };
+
+        void* Allocate(size_t length, bool zeroed);
+
+        Block* Pop(int index, size_t size);
+
+        bool Push(int index, Block* block, size_t size);
+
+        void Account(size_t length);
+
+        static int ClassOf(size_t length);
+
+        static size_t ClassSize(int index);
+
+        // the classes above SMALL_MAX up to LARGE_MAX, four per power of two
+        static constexpr int CLASS_COUNT = 24;
+        static constexpr int LIVE_BYTES_BITS = 40;
+        // a buffer in m_live
+        static constexpr uint64_t LIVE_BUFFER = (uint64_t) 1 << LIVE_BYTES_BITS;
+
+        // guards the lists and their numbers
+        mutable std::mutex m_mutex;
+        Block* m_freeLists[CLASS_COUNT];
+        // written under m_mutex, read without it to skip the lock while the lists are empty
+        std::atomic<size_t> m_pooledBytes;
+        int64_t m_reused;
+
+        // the buffers that are alive above LIVE_BYTES_BITS and their bytes below, so that a
+        // single add accounts for an allocation or a free, the frees are the allocations that
+        // are not alive anymore
+        std::atomic<uint64_t> m_live;
+        std::atomic<int64_t> m_peakBytes;
+        // the allocations not served from the free lists, the others are m_reused
+        std::atomic<int64_t> m_allocations;
 };
 }
 
@@ -3,15 +3,20 @@
 #include <libgen.h>
 #include <dlfcn.h>
 #include <sys/stat.h>
+#include <cstring>
 #include <ctime>
 #include <utime.h>
+#include <vector>
 #include "v8-fast-api-calls.h"
 #include "NativeScriptAssert.h"
+#include "jsr_precompiled.h"
 
 using namespace v8;
 using namespace tns;
 
 tns::SimpleAllocator g_allocator;
+static const auto FINALIZER_DRAIN_BUDGET = std::chrono::milliseconds(4);
+
 JSR::JSR(): isolate(nullptr) {
     v8::Isolate::CreateParams create_params;
     create_params.array_buffer_allocator = &g_allocator;
@@ -108,11 +113,196 @@ napi_status js_execute_script(napi_env env,
     return napi_run_script_source(env, script, file, result);
 }
 
+namespace {
+    /*
+     * The isolate js_precompile_function compiles with on a thread, disposed of when the thread
+     * exits. It has its own allocator and stays out of env_to_jsr_cache, which only the JS
+     * threads use.
+     */
+    class Precompiler {
+    public:
+        Precompiler() : m_allocator(v8::ArrayBuffer::Allocator::NewDefaultAllocator()) {
+            v8::Isolate::CreateParams createParams;
+            createParams.array_buffer_allocator = m_allocator.get();
+            m_isolate = v8::Isolate::New(createParams);
+        }
+
+        ~Precompiler() {
+            m_context.Reset();
+            m_isolate->Dispose();
+        }
+
+        v8::Isolate *GetIsolate() const {
+            return m_isolate;
+        }
+
+        // call within a handle scope of the isolate
+        v8::Local<v8::Context> GetContext() {
+            if (m_context.IsEmpty()) {
+                m_context.Reset(m_isolate, v8::Context::New(m_isolate));
+            }
+            return m_context.Get(m_isolate);
+        }
+
+    private:
+        std::unique_ptr<v8::ArrayBuffer::Allocator> m_allocator;
+        v8::Isolate *m_isolate;
+        v8::Global<v8::Context> m_context;
+    };
+
+    v8::ScriptOrigin CreateOrigin(v8::Isolate *isolate, v8::Local<v8::String> file) {
+#ifdef __V8_13__
+        return v8::ScriptOrigin(file);
+#else
+        return v8::ScriptOrigin(isolate, file);
+#endif
+    }
+}
+
+napi_status js_compile_function(napi_env env,
+                                const char *source,
+                                size_t length,
+                                const char *file,
+                                const char *const *params,
+                                size_t param_count,
+                                napi_finalize finalize_cb,
+                                void *finalize_hint,
+                                napi_value *result) {
+    // taken before the source may be released
+    size_t cachedLength = 0;
+    auto cached = JsrPrecompiled::Take(file, source, length, &cachedLength);
+
+    // one-byte external strings are latin1, so only pure ascii sources can be referenced as is
+    bool isAscii = true;
+    for (size_t i = 0; i < length; i++) {
+        if ((unsigned char) source[i] >= 0x80) {
+            isAscii = false;
+            break;
+        }
+    }
+
+    napi_value sourceValue;
+    napi_status status;
+    if (isAscii) {
+        status = node_api_create_external_string_latin1(env, const_cast<char *>(source), length,
+                                                        finalize_cb, finalize_hint, &sourceValue,
+                                                        nullptr);
+    } else {
+        status = napi_create_string_utf8(env, source, length, &sourceValue);
+        if (finalize_cb) {
+            finalize_cb(env, const_cast<char *>(source), finalize_hint);
+        }
+    }
+    if (status != napi_ok) {
+        return status;
+    }
+
+    NAPI_PREAMBLE(env);
+
+    auto context = env->context();
+    auto fileString = v8::String::NewFromUtf8(env->isolate, file);
+    CHECK_MAYBE_EMPTY(env, fileString, napi_generic_failure);
+
+    auto origin = CreateOrigin(env->isolate, fileString.ToLocalChecked());
+
+    std::vector<v8::Local<v8::String>> arguments;
+    arguments.reserve(param_count);
+    for (size_t i = 0; i < param_count; i++) {
+        arguments.push_back(v8::String::NewFromUtf8(env->isolate, params[i], v8::NewStringType::kInternalized).ToLocalChecked());
+    }
+
+    // compiling the function directly (instead of a wrapping function expression) lets V8
+    // keep the external source string as is and report positions relative to the file
+    auto sourceString = v8impl::V8LocalValueFromJsValue(sourceValue).As<v8::String>();
+    auto options = ScriptCompiler::kNoCompileOptions;
+    std::unique_ptr<ScriptCompiler::Source> scriptSource;
+    if (cached != nullptr) {
+        // the code cache js_precompile_function made, V8 compiles the source when it rejects it
+        auto cachedData = new ScriptCompiler::CachedData(cached.release(), (int) cachedLength,
+                                                         ScriptCompiler::CachedData::BufferOwned);
+        scriptSource.reset(new ScriptCompiler::Source(sourceString, origin, cachedData));
+        options = ScriptCompiler::kConsumeCodeCache;
+    } else {
+        scriptSource.reset(new ScriptCompiler::Source(sourceString, origin));
+    }
+    auto maybeFunction = ScriptCompiler::CompileFunction(context, scriptSource.get(), param_count, arguments.data(), 0, nullptr, options);
+    CHECK_MAYBE_EMPTY(env, maybeFunction, napi_generic_failure);
+
+    *result = v8impl::JsValueFromV8LocalValue(maybeFunction.ToLocalChecked());
+    return GET_RETURN_STATUS(env);
+}
+
+napi_status js_precompile_function(const char *source,
+                                   size_t length,
+                                   const char *file,
+                                   const char *const *params,
+                                   size_t param_count) {
+    if (!JSR::s_mainThreadInitialized) {
+        return napi_generic_failure;
+    }
+
+    static thread_local Precompiler precompiler;
+    auto isolate = precompiler.GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolateScope(isolate);
+    v8::HandleScope handleScope(isolate);
+    auto context = precompiler.GetContext();
+    v8::Context::Scope contextScope(context);
+    v8::TryCatch tryCatch(isolate);
+
+    v8::Local<v8::String> sourceString;
+    v8::Local<v8::String> fileString;
+    if (!v8::String::NewFromUtf8(isolate, source, v8::NewStringType::kNormal, (int) length).ToLocal(&sourceString) ||
+        !v8::String::NewFromUtf8(isolate, file).ToLocal(&fileString)) {
+        return napi_generic_failure;
+    }
+
+    std::vector<v8::Local<v8::String>> arguments;
+    arguments.reserve(param_count);
+    for (size_t i = 0; i < param_count; i++) {
+        arguments.push_back(v8::String::NewFromUtf8(isolate, params[i], v8::NewStringType::kInternalized).ToLocalChecked());
+    }
+
+    // eagerly, so that the cache holds the code of the inner functions too
+    ScriptCompiler::Source scriptSource(sourceString, CreateOrigin(isolate, fileString));
+    v8::Local<v8::Function> function;
+    if (!ScriptCompiler::CompileFunction(context, &scriptSource, param_count, arguments.data(), 0, nullptr,
+                                         ScriptCompiler::kEagerCompile).ToLocal(&function)) {
+        // a syntax error is reported when the JS thread compiles the source itself
+        return napi_generic_failure;
+    }
+
+    std::unique_ptr<ScriptCompiler::CachedData> cache(ScriptCompiler::CreateCodeCacheForFunction(function));
+    if (cache == nullptr || cache->length <= 0) {
+        return napi_generic_failure;
+    }
+    std::unique_ptr<uint8_t[]> data(new uint8_t[cache->length]);
+    memcpy(data.get(), cache->data, cache->length);
+    JsrPrecompiled::Add(file, source, length, std::move(data), cache->length);
+    return napi_ok;
+}
+
+napi_status js_release_precompiled_functions() {
+    JsrPrecompiled::Clear();
+    return napi_ok;
+}
+
 napi_status js_execute_pending_jobs(napi_env env) {
+    // what is left over runs on the next request, so that tearing down a large screen doesn't
+    // stall a frame
+    if (env->DrainFinalizers(FINALIZER_DRAIN_BUDGET) && env->pending_jobs_callback != nullptr) {
+        env->pending_jobs_callback(env, env->pending_jobs_data);
+    }
     env->isolate->PerformMicrotaskCheckpoint();
     return napi_ok;
 }
 
+napi_status js_set_pending_jobs_callback(napi_env env, js_pending_jobs_callback callback, void *data) {
+    env->pending_jobs_callback = callback;
+    env->pending_jobs_data = data;
+    return napi_ok;
+}
+
 napi_status js_get_engine_ptr(napi_env env, int64_t *engine_ptr) {
     *engine_ptr = reinterpret_cast<int64_t>(env->context()->GetIsolate());
     return napi_ok;
@@ -123,6 +313,14 @@ napi_status js_adjust_external_memory(napi_env env, int64_t changeInBytes, int64
     return napi_ok;
 }
 
+napi_status js_set_code_cache_path(napi_env env, const char *path) {
+    return napi_ok;
+}
+
+napi_status js_set_code_bundle(napi_env env, const char *path, const char *root) {
+    return napi_ok;
+}
+
 napi_status js_cache_script(napi_env env, const char *source, const char *file) {
     v8::Local<v8::String> sourceString = v8::String::NewFromUtf8(env->isolate, source).ToLocalChecked();
     v8::Local<v8::String> fileString = v8::String::NewFromUtf8(env->isolate, file).ToLocalChecked();
@@ -212,3 +410,33 @@ napi_status js_get_runtime_version(napi_env env, napi_value* version) {
 
     return napi_ok;
 }
+
+napi_status js_get_array_buffer_allocator_stats(napi_env env, napi_value* result) {
+    auto stats = g_allocator.GetStats();
+    napi_create_object(env, result);
+
+    auto set = [env, result](const char* name, int64_t value) {
+        napi_value jsValue;
+        napi_create_double(env, (double) value, &jsValue);
+        napi_set_named_property(env, *result, name, jsValue);
+    };
+
+    set("liveBytes", stats.liveBytes);
+    set("peakBytes", stats.peakBytes);
+    set("allocations", stats.allocations);
+    set("frees", stats.frees);
+    set("reused", stats.reused);
+    set("pooledBytes", stats.pooledBytes);
+
+    return napi_ok;
+}
+
+napi_status js_create_strong_reference(napi_env env, napi_value value, napi_ref* result) {
+    CHECK_ENV_NOT_IN_GC(env);
+    CHECK_ARG(env, value);
+    CHECK_ARG(env, result);
+
+    auto reference = v8impl::Reference::NewUntracked(env, v8impl::V8LocalValueFromJsValue(value), 1);
+    *result = reinterpret_cast<napi_ref>(reference);
+    return napi_clear_last_error(env);
+}
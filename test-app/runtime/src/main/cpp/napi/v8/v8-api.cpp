@@ -80,7 +80,9 @@
   } while (0)
 
 void napi_env__::InvokeFinalizerFromGC(v8impl::RefTracker *finalizer) {
-    if (module_api_version != NAPI_VERSION_EXPERIMENTAL) {
+    // When the embedder drains the queue, the finalizers of everything a GC collected run in
+    // batches after the pause instead of one by one inside it.
+    if (module_api_version != NAPI_VERSION_EXPERIMENTAL || pending_jobs_callback != nullptr) {
         EnqueueFinalizer(finalizer);
     } else {
         // The experimental code calls finalizers immediately to release native
@@ -94,6 +96,30 @@ void napi_env__::InvokeFinalizerFromGC(v8impl::RefTracker *finalizer) {
     }
 }
 
+bool napi_env__::DrainFinalizers(std::chrono::steady_clock::duration budget) {
+    if (pending_finalizers.empty()) {
+        return false;
+    }
+
+    // reading the clock costs more than most finalizers
+    const int CLOCK_INTERVAL = 32;
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    v8::HandleScope handle_scope(isolate);
+    v8::Context::Scope context_scope(context());
+    for (int count = 1; !pending_finalizers.empty(); count++) {
+        // a finalizer may delete the others, which takes them off the queue
+        auto it = pending_finalizers.begin();
+        auto finalizer = *it;
+        pending_finalizers.erase(it);
+        finalizer->Finalize();
+
+        if (count % CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+    return !pending_finalizers.empty();
+}
+
 namespace v8impl {
     namespace {
 
@@ -349,6 +375,14 @@ namespace v8impl {
 
             RETURN_STATUS_IF_FALSE(env, success.FromMaybe(false), napi_generic_failure);
 
+            // Even with the default kAuto policy V8 only runs the reactions when a call into JS
+            // returns, a deferred settled from native code (a looper or Java callback) would wait
+            // for the next one. The callback coalesces the requests, inside a JS call the
+            // checkpoint it schedules finds the queue already drained.
+            if (env->pending_jobs_callback != nullptr) {
+                env->pending_jobs_callback(env, env->pending_jobs_data);
+            }
+
             return GET_RETURN_STATUS(env);
         }
 
@@ -643,20 +677,39 @@ namespace v8impl {
     TrackedFinalizer::TrackedFinalizer(napi_env env,
                                        napi_finalize finalize_callback,
                                        void *finalize_data,
-                                       void *finalize_hint)
+                                       void *finalize_hint,
+                                       bool tracked)
             : Finalizer(env, finalize_callback, finalize_data, finalize_hint),
               RefTracker() {
-        Link(finalize_callback == nullptr ? &env->reflist : &env->finalizing_reflist);
+        if (tracked) {
+            Link(finalize_callback == nullptr ? &env->reflist : &env->finalizing_reflist);
+        }
     }
 
     TrackedFinalizer *TrackedFinalizer::New(napi_env env,
                                             napi_finalize finalize_callback,
                                             void *finalize_data,
                                             void *finalize_hint) {
-        return new TrackedFinalizer(
+        return new(env) TrackedFinalizer(
                 env, finalize_callback, finalize_data, finalize_hint);
     }
 
+    void *TrackedFinalizer::operator new(size_t size, napi_env env) {
+        void *ptr = env->reference_slab.Allocate();
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void TrackedFinalizer::operator delete(void *ptr) {
+        ReferenceSlab::Free(ptr);
+    }
+
+    void TrackedFinalizer::operator delete(void *ptr, napi_env env) {
+        ReferenceSlab::Free(ptr);
+    }
+
 // When a TrackedFinalizer is being deleted, it may have been queued to call its
 // finalizer.
     TrackedFinalizer::~TrackedFinalizer() {
@@ -699,8 +752,9 @@ namespace v8impl {
                      Ownership ownership,
                      napi_finalize finalize_callback,
                      void *finalize_data,
-                     void *finalize_hint)
-            : TrackedFinalizer(env, finalize_callback, finalize_data, finalize_hint),
+                     void *finalize_hint,
+                     bool tracked)
+            : TrackedFinalizer(env, finalize_callback, finalize_data, finalize_hint, tracked),
               refcount_(initial_refcount),
               ownership_(ownership) {}
 
@@ -710,12 +764,12 @@ namespace v8impl {
                           napi_finalize finalize_callback,
                           void *finalize_data,
                           void *finalize_hint) {
-        return new RefBase(env,
-                           initial_refcount,
-                           ownership,
-                           finalize_callback,
-                           finalize_data,
-                           finalize_hint);
+        return new(env) RefBase(env,
+                                initial_refcount,
+                                ownership,
+                                finalize_callback,
+                                finalize_data,
+                                finalize_hint);
     }
 
     void *RefBase::Data() {
@@ -746,13 +800,16 @@ namespace v8impl {
     template<typename... Args>
     Reference::Reference(napi_env env, v8::Local<v8::Value> value, Args &&... args)
             : RefBase(env, std::forward<Args>(args)...),
-              persistent_(env->isolate, value),
-              can_be_weak_(CanBeHeldWeakly(value)) {
+              can_be_weak_(CanBeHeldWeakly(value)),
+              persistent_(env->isolate, value) {
         if (RefCount() == 0) {
             SetWeak();
         }
     }
 
+    static_assert(sizeof(Reference) <= ReferenceSlab::SLOT_SIZE,
+                  "a Reference must fit in a slot of the ReferenceSlab");
+
     Reference::~Reference() {
         // Reset the handle. And no weak callback will be invoked.
         persistent_.Reset();
@@ -765,13 +822,26 @@ namespace v8impl {
                               napi_finalize finalize_callback,
                               void *finalize_data,
                               void *finalize_hint) {
-        return new Reference(env,
-                             value,
-                             initial_refcount,
-                             ownership,
-                             finalize_callback,
-                             finalize_data,
-                             finalize_hint);
+        return new(env) Reference(env,
+                                  value,
+                                  initial_refcount,
+                                  ownership,
+                                  finalize_callback,
+                                  finalize_data,
+                                  finalize_hint);
+    }
+
+    Reference *Reference::NewUntracked(napi_env env,
+                                       v8::Local<v8::Value> value,
+                                       uint32_t initial_refcount) {
+        return new(env) Reference(env,
+                                  value,
+                                  initial_refcount,
+                                  Ownership::kUserland,
+                                  nullptr,
+                                  nullptr,
+                                  nullptr,
+                                  /*tracked:*/ false);
     }
 
     uint32_t Reference::Ref() {
@@ -2,12 +2,14 @@
 #define SRC_JS_NATIVE_API_V8_H_
 
 #include "napi.h"
+#include <chrono>
 #include <unordered_set>
 #include <stdexcept>
 #include <string>
 
 #include "js_native_api_types.h"
 #include "v8-api-internals.h"
+#include "ReferenceSlab.h"
 
 #define NODE_API_DEFAULT_MODULE_API_VERSION 8
 
@@ -159,9 +161,19 @@ struct napi_env__ {
   // Implementation should drain the queue at the time it is safe to call
   // into JavaScript.
   virtual void EnqueueFinalizer(v8impl::RefTracker* finalizer) {
+    bool first = pending_finalizers.empty();
     pending_finalizers.emplace(finalizer);
+    // js_execute_pending_jobs drains the queue, a single request covers
+    // everything queued until then
+    if (first && pending_jobs_callback != nullptr) {
+      pending_jobs_callback(this, pending_jobs_data);
+    }
   }
 
+  // Run the queued finalizers until the queue is empty or `budget` has
+  // passed. Returns true when finalizers are left.
+  bool DrainFinalizers(std::chrono::steady_clock::duration budget);
+
   // Remove the finalizer from the scheduled second pass weak callback queue.
   // The finalizer can be deleted after this call.
   virtual void DequeueFinalizer(v8impl::RefTracker* finalizer) {
@@ -205,6 +217,8 @@ struct napi_env__ {
   // have such a callback. See `NapiEnvironmentnment()` above for details.
   v8impl::RefTracker::RefList reflist;
   v8impl::RefTracker::RefList finalizing_reflist;
+  // The memory of the tracked finalizers and references of the env.
+  v8impl::ReferenceSlab reference_slab;
   // The invocation order of the finalizers is not determined.
   std::unordered_set<v8impl::RefTracker*> pending_finalizers;
   napi_extended_error_info last_error;
@@ -214,6 +228,9 @@ struct napi_env__ {
   void* instance_data = nullptr;
   int32_t module_api_version = NODE_API_DEFAULT_MODULE_API_VERSION;
   bool in_gc_finalizer = false;
+  // See js_set_pending_jobs_callback
+  void (*pending_jobs_callback)(napi_env env, void* data) = nullptr;
+  void* pending_jobs_data = nullptr;
 
  protected:
   // Should not be deleted directly. Delete with `napi_env__::DeleteMe()`
@@ -418,7 +435,8 @@ class TryCatch : public v8::TryCatch {
 };
 
 // Ownership of a reference.
-enum class Ownership {
+// A byte, so that `Reference::can_be_weak_` fits in the padding of `RefBase`.
+enum class Ownership : uint8_t {
   // The reference is owned by the runtime. No userland call is needed to
   // destruct the reference.
   kRuntime,
@@ -428,12 +446,15 @@ enum class Ownership {
 };
 
 // Wrapper around Finalizer that can be tracked.
+// Allocated from the slab of the env, see `ReferenceSlab`. An untracked one is
+// not on the lists of the env and is not finalized with it.
 class TrackedFinalizer : public Finalizer, public RefTracker {
  protected:
   TrackedFinalizer(napi_env env,
                    napi_finalize finalize_callback,
                    void* finalize_data,
-                   void* finalize_hint);
+                   void* finalize_hint,
+                   bool tracked = true);
 
  public:
   static TrackedFinalizer* New(napi_env env,
@@ -442,6 +463,11 @@ class TrackedFinalizer : public Finalizer, public RefTracker {
                                void* finalize_hint);
   ~TrackedFinalizer() override;
 
+  static void* operator new(size_t size, napi_env env);
+  static void operator delete(void* ptr);
+  // Only called when a constructor throws.
+  static void operator delete(void* ptr, napi_env env);
+
  protected:
   void Finalize() override;
   void FinalizeCore(bool deleteMe);
@@ -455,7 +481,8 @@ class RefBase : public TrackedFinalizer {
           Ownership ownership,
           napi_finalize finalize_callback,
           void* finalize_data,
-          void* finalize_hint);
+          void* finalize_hint,
+          bool tracked = true);
 
  public:
   static RefBase* New(napi_env env,
@@ -495,6 +522,12 @@ class Reference : public RefBase {
                         void* finalize_data = nullptr,
                         void* finalize_hint = nullptr);
 
+  // A userland reference without a finalizer that skips the lists of the env,
+  // for values held briefly. It must be deleted before the env is.
+  static Reference* NewUntracked(napi_env env,
+                                 v8::Local<v8::Value> value,
+                                 uint32_t initial_refcount);
+
   virtual ~Reference();
   uint32_t Ref();
   uint32_t Unref();
@@ -508,10 +541,19 @@ class Reference : public RefBase {
 
   void SetWeak();
 
-  v8impl::Persistent<v8::Value> persistent_;
   bool can_be_weak_;
+  v8impl::Persistent<v8::Value> persistent_;
 };
 
 }  // end of namespace v8impl
 
+napi_status NAPI_CDECL
+node_api_create_external_string_latin1(napi_env env,
+                                       char* str,
+                                       size_t length,
+                                       napi_finalize finalize_callback,
+                                       void* finalize_hint,
+                                       napi_value* result,
+                                       bool* copied);
+
 #endif  // SRC_JS_NATIVE_API_V8_H_
\ No newline at end of file
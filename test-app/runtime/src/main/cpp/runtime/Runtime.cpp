@@ -24,8 +24,14 @@
 #include "ArrayHelper.h"
 #include "SimpleProfiler.h"
 #include "ManualInstrumentation.h"
+#include "Tracing.h"
+#include "CallStats.h"
 #include "GlobalHelpers.h"
 #include "Timers.h"
+#include "FrameScheduler.h"
+#include "ModuleResolver.h"
+#include "MainThreadQueue.h"
+#include "JType.h"
 #ifdef __JSC__
 #include "WeakRef.h"
 #endif
@@ -84,6 +90,7 @@ Runtime::Runtime(JNIEnv *jEnv, jobject runtime, int id)
     m_runtime = jEnv->NewGlobalRef(runtime);
     m_objectManager = new ObjectManager(m_runtime);
     m_loopTimer = new MessageLoopTimer();
+    m_performance = new Performance();
     id_to_runtime_cache.Insert(id, this);
 //    pendingError = nullptr;
 
@@ -147,6 +154,10 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
 
     Constants::APP_ROOT_FOLDER_PATH = filesRoot + "/app/";
 
+    if (!s_mainThreadInitialized) {
+        ModuleResolver::Init(filesRoot, isDebuggable);
+    }
+
     DEBUG_WRITE("Initializing NativeScript NAPI Runtime");
 
     auto flags = ArgConverter::jstringToString(JniLocalRef(_env->GetObjectArrayElement(args, 0)));
@@ -159,6 +170,17 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
     js_set_runtime_flags(flags.c_str());
     js_create_runtime(&rt);
     js_create_napi_env(&env, rt);
+    if (!s_mainThreadInitialized) {
+        // overlap reading and compiling the startup modules with the runtime initialization
+        // below, V8 can only compile them once its platform was initialized with the flags
+        m_module.StartPreload(filesRoot + "/.ns-module-list");
+    }
+    // bytecode precompiled with the app, keyed by the module paths relative to the app root
+    js_set_code_bundle(env, (Constants::APP_ROOT_FOLDER_PATH + "ns-code-bundle.bin").c_str(),
+                       (ModuleResolver::GetAppRoot() + "/").c_str());
+    if (Constants::CACHE_COMPILED_CODE) {
+        js_set_code_cache_path(env, (filesRoot + "/.ns-code-cache").c_str());
+    }
 #ifdef __V8__
     v8::Locker locker(env->isolate);
     v8::Isolate::Scope isolate_scope(env->isolate);
@@ -179,13 +201,15 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
 #endif
 
 #ifdef APPLICATION_IN_DEBUG
-    Console::createConsole(env, JsV8InspectorClient::consoleLogCallback, maxLogcatObjectSize, forceLog);
+    Console::createConsole(env, JsV8InspectorClient::consoleLogCallback, maxLogcatObjectSize, forceLog, isDebuggable);
 #else
-    Console::createConsole(env, nullptr, maxLogcatObjectSize, forceLog);
+    Console::createConsole(env, nullptr, maxLogcatObjectSize, forceLog, isDebuggable);
 #endif
 
     Timers::InitStatic(env, global);
 
+    FrameScheduler::InitStatic(env, global);
+
     napi_util::napi_set_function(env, global, "__log", CallbackHandlers::LogMethodCallback);
     napi_util::napi_set_function(env, global, "__dumpReferenceTables",
                                  CallbackHandlers::DumpReferenceTablesMethodCallback);
@@ -209,6 +233,8 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
     napi_util::napi_set_function(env, global, "__time", CallbackHandlers::TimeCallback);
     napi_util::napi_set_function(env, global, "__releaseNativeCounterpart",
                                  CallbackHandlers::ReleaseNativeCounterpartCallback);
+    napi_util::napi_set_function(env, global, "__getJavaFields",
+                                 CallbackHandlers::GetJavaFieldsCallback);
     napi_util::napi_set_function(env, global, "__postFrameCallback",
                                  CallbackHandlers::PostFrameCallback);
     napi_util::napi_set_function(env, global, "__removeFrameCallback",
@@ -219,6 +245,15 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
                                      napi_create_int32(_env, 0, &mode);
                                      return mode;
                                  });
+    // undefined on the engines that keep ArrayBuffers in their own heap
+    napi_util::napi_set_function(env, global, "__getArrayBufferAllocatorStats",
+                                 [](napi_env _env, napi_callback_info) -> napi_value {
+                                     napi_value stats;
+                                     if (js_get_array_buffer_allocator_stats(_env, &stats) != napi_ok) {
+                                         return napi_util::undefined(_env);
+                                     }
+                                     return stats;
+                                 });
 
     napi_util::napi_set_function(env, global, "napiFunction",
                                  [](napi_env _env, napi_callback_info) -> napi_value {
@@ -226,6 +261,8 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
                                  });
 
     SimpleProfiler::Init(env, global);
+    tns::instrumentation::Tracing::Init(env, global);
+    tns::instrumentation::CallStats::Init(env, global);
 
     CallbackHandlers::CreateGlobalCastFunctions(env);
 
@@ -248,26 +285,24 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
         s_main_rt = this;
         s_main_thread_id = this_thread::get_id();
 
-        pipe2(m_mainLooper_fd, O_NONBLOCK | O_CLOEXEC);
         m_mainLooper = ALooper_forThread();
 
         ALooper_acquire(m_mainLooper);
 
-        // try using 2MB
-        int ret = fcntl(m_mainLooper_fd[1], F_SETPIPE_SZ, 2 * (1024 * 1024));
-
-        // try using 1MB
-        if (ret != 0) {
-            ret = fcntl(m_mainLooper_fd[1], F_SETPIPE_SZ, 1 * (1024 * 1024));
+        int drainBudgetMs = MainThreadQueue::DEFAULT_DRAIN_BUDGET_MS;
+        JniLocalRef drainBudget(_env->GetObjectArrayElement(args, 14));
+        if (!drainBudget.IsNull()) {
+            drainBudgetMs = JType::IntValue(JEnv(), drainBudget);
         }
+        MainThreadQueue::Init(m_mainLooper, drainBudgetMs);
 
-        // try using 512KB
-        if (ret != 0) {
-            ret = fcntl(m_mainLooper_fd[1], F_SETPIPE_SZ, (512 * 1024));
-        }
+        CallbackHandlers::PostNativeFrameCallback(FirstFrameCallback64, FirstFrameCallback,
+                                                  reinterpret_cast<void *>((intptr_t) m_id));
 
-        ALooper_addFd(m_mainLooper, m_mainLooper_fd[0], ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT,
-                      CallbackHandlers::RunOnMainThreadFdCallback, nullptr);
+        napi_util::napi_set_function(env, global, "__runOnMainThread",
+                                     MainThreadQueue::RunOnMainThreadCallback);
+        napi_util::napi_set_function(env, global, "__getMainThreadQueueStats",
+                                     MainThreadQueue::GetStatsCallback);
 
         napi_value worker;
         napi_define_class(env, "Worker", strlen("Worker"), CallbackHandlers::NewThreadCallback,
@@ -294,13 +329,17 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
                                      CallbackHandlers::WorkerGlobalCloseCallback, nullptr);
         napi_util::napi_set_function(env, global, "terminate",
                                      CallbackHandlers::WorkerGlobalCloseCallback, nullptr);
+        napi_util::napi_set_function(env, global, "__runOnMainThread",
+                                     MainThreadQueue::RunOnMainThreadCallback);
         napi_util::define_property(env, global, "__ns__worker", napi_util::get_true(env));
     }
 
     napi_util::define_property(env, global, "global", nullptr, GlobalAccessorCallback);
 
     if (!s_mainThreadInitialized) {
+        auto metadataStart = m_performance->Now();
         MetadataNode::BuildMetadata(filesRoot);
+        m_performance->Record(Performance::RUNTIME, "metadata", metadataStart, m_performance->Now());
     } else {
         // Do not set 'self' accessor to main thread
         napi_util::define_property(env, global, "self", nullptr, GlobalAccessorCallback);
@@ -310,7 +349,7 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
 
     ArrayHelper::Init(env);
 
-    Performance::createPerformance(env, global);
+    m_performance->Init(env, global);
 
     m_arrayBufferHelper.CreateConvertFunctions(env, global, m_objectManager);
 
@@ -318,6 +357,8 @@ void Runtime::Init(JNIEnv *_env, jstring filesPath, jstring nativeLibsDir,
 
     s_mainThreadInitialized = true;
 
+    m_performance->Record(Performance::RUNTIME, "init", 0, m_performance->Now());
+
     napi_close_handle_scope(env, handleScope);
 
     DEBUG_WRITE("%s", "NativeScript Runtime Loaded!");
@@ -352,19 +393,12 @@ Runtime::~Runtime() {
     js_free_runtime(rt);
 #endif
 
+    // after the env is gone, the finalizers of the observers check it
+    delete this->m_performance;
+
     if (m_isMainThread) {
-        if (m_mainLooper_fd[0] != -1) {
-            ALooper_removeFd(m_mainLooper, m_mainLooper_fd[0]);
-        }
+        MainThreadQueue::Dispose();
         ALooper_release(m_mainLooper);
-
-        if (m_mainLooper_fd[0] != -1) {
-            close(m_mainLooper_fd[0]);
-        }
-
-        if (m_mainLooper_fd[1] != -1) {
-            close(m_mainLooper_fd[1]);
-        }
     }
 }
 
@@ -375,6 +409,13 @@ std::string Runtime::ReadFileText(const std::string &filePath) {
     return File::ReadText(filePath);
 }
 
+bool Runtime::ReadFileContent(const std::string &filePath, FileContent &content) {
+#ifdef APPLICATION_IN_DEBUG
+    std::lock_guard<std::mutex> lock(m_fileWriteMutex);
+#endif
+    return File::ReadContent(filePath, content);
+}
+
 void Runtime::DestroyRuntime() {
     is_destroying = true;
     MetadataNode::onDisposeEnv(env);
@@ -390,6 +431,8 @@ void Runtime::DestroyRuntime() {
     Runtime::thread_id_to_rt_cache.Remove(this->my_thread_id);
     id_to_runtime_cache.Remove(m_id);
     env_to_runtime_cache.Remove(env);
+    this->m_loopTimer->Destroy();
+    this->m_performance->Destroy();
     js_free_napi_env(env);
 
 #ifndef __V8__
@@ -399,6 +442,7 @@ void Runtime::DestroyRuntime() {
 
 bool Runtime::NotifyGC(JNIEnv *jEnv, jobject obj, jintArray object_ids) {
     if (this->is_destroying) return true;
+    tns::instrumentation::TraceScope trace("NotifyGC");
     m_objectManager->OnGarbageCollected(jEnv, object_ids);
     bool success = __sync_bool_compare_and_swap(&m_runGC, false, true);
     return success;
@@ -434,6 +478,7 @@ bool Runtime::TryCallGC() {
     bool success = __sync_bool_compare_and_swap(&m_runGC, true, false);
 
     if (success) {
+        tns::instrumentation::TraceScope trace("GC");
         napi_value result;
         napi_call_function(env, global, napi_util::get_ref_value(env, m_gcFunc), 0, nullptr, &result);
     }
@@ -444,6 +489,17 @@ bool Runtime::TryCallGC() {
 void Runtime::RunModule(JNIEnv *_jEnv, jobject obj, jstring scriptFile) {
     JEnv jEnv(_jEnv);
     string filePath = ArgConverter::jstringToString(scriptFile);
+
+    // stops the preload threads and writes the module list even when the main module throws
+    struct PreloadScope {
+        ModuleInternal *module;
+        ~PreloadScope() {
+            if (module != nullptr) {
+                module->FinishPreload();
+            }
+        }
+    } preloadScope { m_isMainThread ? &m_module : nullptr };
+
     m_module.Load(env, filePath);
     bool pendingException;
     napi_is_exception_pending(env, &pendingException);
@@ -463,6 +519,14 @@ void Runtime::RunWorker(jstring scriptFile) {
     m_module.LoadWorker(env, filePath);
 }
 
+std::string Runtime::ResolveMainModule() {
+    try {
+        return ModuleResolver::Resolve(env, "./", "");
+    } catch (NativeScriptException &) {
+        return ModuleResolver::Resolve(env, "./bootstrap", "");
+    }
+}
+
 jobject Runtime::RunScript(JNIEnv *_env, jobject obj, jstring scriptFile) {
     int status;
     auto filename = ArgConverter::jstringToString(scriptFile);
@@ -502,16 +566,40 @@ napi_runtime Runtime::GetNapiRuntime() {
     return rt;
 }
 
-int Runtime::GetId() {
-    return this->m_id;
+Performance *Runtime::GetPerformance() const {
+    return m_performance;
 }
 
-int Runtime::GetWriter() {
-    return m_mainLooper_fd[1];
+ConversionArena &Runtime::GetConversionArena() {
+    return m_conversionArena;
 }
 
-int Runtime::GetReader() {
-    return m_mainLooper_fd[0];
+void Runtime::ScheduleLoopTick() {
+    m_loopTimer->Schedule();
+}
+
+void Runtime::FirstFrameCallback64(int64_t frameTimeNanos, void *data) {
+    int id = (int) reinterpret_cast<intptr_t>(data);
+    auto runtime = id_to_runtime_cache.Get(id);
+    if (runtime != nullptr) {
+        auto performance = runtime->m_performance;
+        performance->Record(Performance::RUNTIME, "first-frame", 0, performance->FromMonotonic(frameTimeNanos));
+    }
+}
+
+void Runtime::FirstFrameCallback(long frameTimeNanos, void *data) {
+    int id = (int) reinterpret_cast<intptr_t>(data);
+    auto runtime = id_to_runtime_cache.Get(id);
+    if (runtime != nullptr) {
+        // `long` truncates the frame time on 32-bit devices
+        auto performance = runtime->m_performance;
+        auto frameTime = sizeof(long) < sizeof(int64_t) ? performance->Now() : performance->FromMonotonic(frameTimeNanos);
+        performance->Record(Performance::RUNTIME, "first-frame", 0, frameTime);
+    }
+}
+
+int Runtime::GetId() {
+    return this->m_id;
 }
 
 jobject
@@ -677,6 +765,11 @@ void Runtime::SetManualInstrumentationMode(jstring mode) {
     auto modeStr = ArgConverter::jstringToString(mode);
     if (modeStr == "timeline") {
         tns::instrumentation::Frame::enable();
+    } else if (modeStr == "trace") {
+        // record from startup, the trace is written by __stopTracing
+        tns::instrumentation::Tracing::Start();
+    } else if (modeStr == "callstats") {
+        tns::instrumentation::CallStats::Start();
     }
 }
 
@@ -702,7 +795,5 @@ int Runtime::m_androidVersion = Runtime::GetAndroidVersion();
 ALooper *Runtime::m_mainLooper = nullptr;
 tns::ConcurrentMap<std::thread::id, Runtime*> Runtime::thread_id_to_rt_cache;
 
-int Runtime::m_mainLooper_fd[2];
-
 Runtime *Runtime::s_main_rt = nullptr;
 std::thread::id Runtime::s_main_thread_id;
\ No newline at end of file
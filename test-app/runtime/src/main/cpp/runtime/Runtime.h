@@ -13,16 +13,20 @@
 #include "native_api_util.h"
 #include "ObjectManager.h"
 #include "ArrayBufferHelper.h"
+#include "ConversionArena.h"
 #include <thread>
 #include "jsr.h"
 #include "NativeScriptException.h"
 #include <sstream>
 #include "ConcurrentMap.h"
+#include "File.h"
 
 namespace tns {
 
     class JSMethodCache;
 
+    class Performance;
+
     class Runtime {
     public:
 
@@ -66,16 +70,20 @@ namespace tns {
 
         jobject RunScript(JNIEnv *_env, jobject obj, jstring scriptFile);
 
+        /*
+         * The path of the app's entry point: package.json "main" or index.js of the app folder,
+         * otherwise bootstrap.js. Throws NativeScriptException when there is none.
+         */
+        std::string ResolveMainModule();
+
         std::string ReadFileText(const std::string &filePath);
 
+        bool ReadFileContent(const std::string &filePath, FileContent &content);
+
         bool NotifyGC(JNIEnv *jEnv, jobject obj, jintArray object_ids);
 
         bool TryCallGC();
 
-        static int GetWriter();
-
-        static int GetReader();
-
         static void SetManualInstrumentationMode(jstring mode);
 
         int GetId();
@@ -88,10 +96,24 @@ namespace tns {
 
         napi_runtime GetNapiRuntime();
 
+        Performance *GetPerformance() const;
+
+        ConversionArena &GetConversionArena();
+
+        /*
+         * Requests a js_execute_pending_jobs call on the runtime thread, after which the weak
+         * instances of the object manager are flushed, see MessageLoopTimer::Schedule
+         */
+        void ScheduleLoopTick();
+
         static ALooper *GetMainLooper() {
             return m_mainLooper;
         }
 
+        static Runtime *GetMainRuntime() {
+            return s_main_rt;
+        }
+
         void Lock();
 
         void Unlock();
@@ -145,6 +167,10 @@ namespace tns {
 
         static napi_value GlobalAccessorCallback(napi_env env, napi_callback_info info);
 
+        static void FirstFrameCallback64(int64_t frameTimeNanos, void *data);
+
+        static void FirstFrameCallback(long frameTimeNanos, void *data);
+
         int m_id;
         jobject m_runtime;
 
@@ -153,6 +179,7 @@ namespace tns {
         napi_handle_scope global_scope;
 
         MessageLoopTimer *m_loopTimer;
+        Performance *m_performance;
         int64_t m_lastUsedMemory;
         napi_ref m_gcFunc;
         volatile bool m_runGC;
@@ -162,6 +189,8 @@ namespace tns {
 
         ArrayBufferHelper m_arrayBufferHelper;
 
+        ConversionArena m_conversionArena;
+
         bool m_isMainThread;
 
         ModuleInternal m_module;
@@ -178,8 +207,6 @@ namespace tns {
 
         static ALooper *m_mainLooper;
 
-        static int m_mainLooper_fd[2];
-
         static tns::ConcurrentMap<int, Runtime *> id_to_runtime_cache;
 
         static tns::ConcurrentMap<napi_env, Runtime *> env_to_runtime_cache;
@@ -2,15 +2,73 @@
 #define ASSETEXTRACTOR_
 
 #include "JEnv.h"
+#include "ZipDirectory.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace tns {
 class AssetExtractor {
     public:
         static void ExtractAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir, jboolean _forceOverwrite);
 
+        /*
+         * Makes the `assets/` entries of the APK readable through `File` under `filesDir`
+         */
+        static bool MountApk(JNIEnv* env, jstring apk, jstring filesDir);
+
     private:
+        struct ManifestEntry {
+            uint32_t crc;
+            uint64_t size;
+        };
+
+        typedef std::unordered_map<std::string, ManifestEntry> Manifest;
+
+        struct ExtractionStats {
+            ExtractionStats();
+
+            void Record(int64_t micros);
+
+            void Log(const std::string& input, int threadCount, int64_t totalMicros) const;
+
+            static const int BUCKET_COUNT = 6;
+            static const int64_t BUCKET_LIMITS_US[BUCKET_COUNT - 1];
+
+            int extracted;
+            int unchanged;
+            int served;
+            int failed;
+            uint64_t bytes;
+            int64_t maxMicros;
+            int buckets[BUCKET_COUNT];
+        };
+
+        static void ExtractAssetsWithLibzip(const std::string& apk, const std::string& filePrefix, int prefixLen, const std::string& baseDir, bool forceOverwrite);
+
+        /*
+         * Whether the asset is a script the runtime reads, rather than a file the app may open itself
+         */
+        static bool IsScript(const std::string& name);
+
+        static bool ExtractEntry(const ZipDirectory& zip, const ZipDirectory::Entry& entry, const std::string& assetFullname, std::vector<uint8_t>& buffer);
+
+        static bool CopyStoredEntry(const ZipDirectory& zip, int64_t offset, const ZipDirectory::Entry& entry, int fd);
+
+        static bool InflateEntry(const uint8_t* data, const ZipDirectory::Entry& entry, int fd, std::vector<uint8_t>& buffer);
+
+        static Manifest ReadManifest(const std::string& path);
+
+        static void WriteManifest(const std::string& path, const Manifest& manifest);
+
+        static int GetWorkerCount(size_t pendingCount);
+
         static std::string jstringToString(JNIEnv* env, jstring value);
         static void mkdir_rec(const char* dir);
+
+        static const char* MANIFEST_FILE_NAME;
+        static const int MAX_WORKER_COUNT = 4;
+        static const size_t IO_BUFFER_SIZE = 65536;
 };
 }
 #endif /* ASSETEXTRACTOR_ */
@@ -0,0 +1,217 @@
+#include "ZipDirectory.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+using namespace tns;
+
+namespace {
+const uint32_t EOCD_SIGNATURE = 0x06054b50;
+const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+
+const size_t EOCD_SIZE = 22;
+const size_t CENTRAL_HEADER_SIZE = 46;
+const size_t LOCAL_HEADER_SIZE = 30;
+const size_t MAX_COMMENT_SIZE = 0xffff;
+
+inline uint16_t ReadU16(const uint8_t* p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+inline uint32_t ReadU32(const uint8_t* p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+}
+
+ZipDirectory::ZipDirectory()
+    : m_fd(-1), m_base(nullptr), m_size(0) {
+}
+
+ZipDirectory::~ZipDirectory() {
+    Close();
+}
+
+bool ZipDirectory::Open(const std::string& path) {
+    Close();
+
+    m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size < (off_t) EOCD_SIZE) {
+        Close();
+        return false;
+    }
+
+    m_size = (size_t) st.st_size;
+    void* base = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED) {
+        m_size = 0;
+        Close();
+        return false;
+    }
+    m_base = (const uint8_t*) base;
+
+    if (!ReadCentralDirectory()) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void ZipDirectory::Close() {
+    if (m_base != nullptr) {
+        munmap((void*) m_base, m_size);
+        m_base = nullptr;
+    }
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_entries.clear();
+}
+
+bool ZipDirectory::ReadCentralDirectory() {
+    // the end of central directory record is followed only by the (optional) archive comment
+    size_t searchStart = m_size > EOCD_SIZE + MAX_COMMENT_SIZE ? m_size - EOCD_SIZE - MAX_COMMENT_SIZE : 0;
+    const uint8_t* eocd = nullptr;
+    for (size_t i = m_size - EOCD_SIZE + 1; i-- > searchStart;) {
+        if (ReadU32(m_base + i) == EOCD_SIGNATURE) {
+            eocd = m_base + i;
+            break;
+        }
+    }
+    if (eocd == nullptr) {
+        return false;
+    }
+
+    uint16_t entryCount = ReadU16(eocd + 10);
+    uint32_t cdSize = ReadU32(eocd + 12);
+    uint32_t cdOffset = ReadU32(eocd + 16);
+
+    if (entryCount == 0xffff || cdSize == 0xffffffff || cdOffset == 0xffffffff) {
+        // zip64
+        return false;
+    }
+    if ((uint64_t) cdOffset + cdSize > m_size) {
+        return false;
+    }
+
+    m_entries.reserve(entryCount);
+
+    const uint8_t* p = m_base + cdOffset;
+    const uint8_t* end = p + cdSize;
+    for (uint16_t i = 0; i < entryCount; i++) {
+        if (p + CENTRAL_HEADER_SIZE > end || ReadU32(p) != CENTRAL_HEADER_SIGNATURE) {
+            return false;
+        }
+
+        uint16_t nameLength = ReadU16(p + 28);
+        uint16_t extraLength = ReadU16(p + 30);
+        uint16_t commentLength = ReadU16(p + 32);
+        if (p + CENTRAL_HEADER_SIZE + nameLength > end) {
+            return false;
+        }
+
+        Entry entry;
+        entry.method = ReadU16(p + 10);
+        entry.mtime = DosTimeToUnix(ReadU16(p + 12), ReadU16(p + 14));
+        entry.crc = ReadU32(p + 16);
+        entry.compressedSize = ReadU32(p + 20);
+        entry.size = ReadU32(p + 24);
+        entry.localHeaderOffset = ReadU32(p + 42);
+        entry.name.assign((const char*) p + CENTRAL_HEADER_SIZE, nameLength);
+
+        if (entry.compressedSize == 0xffffffff || entry.size == 0xffffffff || entry.localHeaderOffset == 0xffffffff) {
+            return false;
+        }
+
+        m_entries.emplace_back(std::move(entry));
+
+        p += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+int64_t ZipDirectory::GetDataOffset(const Entry& entry) const {
+    if (entry.localHeaderOffset + LOCAL_HEADER_SIZE > m_size) {
+        return -1;
+    }
+
+    // the local header may carry a different (e.g. zipalign padded) extra field than the central one
+    const uint8_t* header = m_base + entry.localHeaderOffset;
+    if (ReadU32(header) != LOCAL_HEADER_SIGNATURE) {
+        return -1;
+    }
+
+    uint64_t offset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + ReadU16(header + 26) + ReadU16(header + 28);
+    if (offset + entry.compressedSize > m_size) {
+        return -1;
+    }
+
+    return (int64_t) offset;
+}
+
+const uint8_t* ZipDirectory::GetData(const Entry& entry) const {
+    auto offset = GetDataOffset(entry);
+    return offset < 0 ? nullptr : m_base + offset;
+}
+
+bool ZipDirectory::ReadEntry(const Entry& entry, uint8_t* out) const {
+    auto data = GetData(entry);
+    if (data == nullptr) {
+        return false;
+    }
+
+    if (entry.method == METHOD_STORED) {
+        memcpy(out, data, entry.size);
+        return true;
+    }
+
+    if (entry.method != METHOD_DEFLATED) {
+        return false;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        return false;
+    }
+
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = (uInt) entry.compressedSize;
+    stream.next_out = out;
+    stream.avail_out = (uInt) entry.size;
+
+    int ret = inflate(&stream, Z_FINISH);
+    bool success = ret == Z_STREAM_END && stream.total_out == entry.size;
+    inflateEnd(&stream);
+
+    return success && crc32(crc32(0L, Z_NULL, 0), out, (uInt) entry.size) == entry.crc;
+}
+
+time_t ZipDirectory::DosTimeToUnix(uint16_t dosTime, uint16_t dosDate) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+
+    // let mktime decide if DST is in effect, the same way libzip does it
+    tm.tm_isdst = -1;
+    tm.tm_year = ((dosDate >> 9) & 0x7f) + 1980 - 1900;
+    tm.tm_mon = ((dosDate >> 5) & 0x0f) - 1;
+    tm.tm_mday = dosDate & 0x1f;
+    tm.tm_hour = (dosTime >> 11) & 0x1f;
+    tm.tm_min = (dosTime >> 5) & 0x3f;
+    tm.tm_sec = (dosTime << 1) & 0x3e;
+
+    return mktime(&tm);
+}
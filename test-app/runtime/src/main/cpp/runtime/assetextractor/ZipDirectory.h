@@ -0,0 +1,85 @@
+#ifndef ZIPDIRECTORY_H_
+#define ZIPDIRECTORY_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace tns {
+/*
+ * A read-only view over the central directory of a zip archive (the APK).
+ *
+ * The archive is memory mapped once and the central directory is parsed in a single pass,
+ * so that callers can get the crc, sizes and the offset of the raw entry data without going
+ * through libzip (which hides the data offset and is not safe to share between threads).
+ * Zip64 archives are not supported, Open() returns false for them and callers are expected
+ * to fall back to libzip.
+ */
+class ZipDirectory {
+    public:
+        struct Entry {
+            std::string name;
+            uint32_t crc;
+            uint16_t method;
+            uint64_t compressedSize;
+            uint64_t size;
+            uint64_t localHeaderOffset;
+            time_t mtime;
+        };
+
+        static const uint16_t METHOD_STORED = 0;
+        static const uint16_t METHOD_DEFLATED = 8;
+
+        ZipDirectory();
+
+        ~ZipDirectory();
+
+        bool Open(const std::string& path);
+
+        void Close();
+
+        const std::vector<Entry>& Entries() const {
+            return m_entries;
+        }
+
+        /*
+         * Returns the offset of the entry's raw (possibly compressed) bytes within the archive
+         * or -1 when the local file header is malformed.
+         */
+        int64_t GetDataOffset(const Entry& entry) const;
+
+        const uint8_t* GetData(const Entry& entry) const;
+
+        /*
+         * Copies or inflates the whole entry into `out`, which must hold at least `entry.size` bytes.
+         */
+        bool ReadEntry(const Entry& entry, uint8_t* out) const;
+
+        int GetFd() const {
+            return m_fd;
+        }
+
+        const uint8_t* GetBase() const {
+            return m_base;
+        }
+
+        size_t GetSize() const {
+            return m_size;
+        }
+
+    private:
+        ZipDirectory(const ZipDirectory&) = delete;
+        ZipDirectory& operator=(const ZipDirectory&) = delete;
+
+        bool ReadCentralDirectory();
+
+        static time_t DosTimeToUnix(uint16_t dosTime, uint16_t dosDate);
+
+        int m_fd;
+        const uint8_t* m_base;
+        size_t m_size;
+        std::vector<Entry> m_entries;
+};
+}
+
+#endif /* ZIPDIRECTORY_H_ */
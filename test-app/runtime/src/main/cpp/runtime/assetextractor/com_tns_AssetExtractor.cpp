@@ -19,4 +19,8 @@ extern "C" JNIEXPORT void Java_com_tns_AssetExtractor_extractAssets(JNIEnv* env,
         NativeScriptException nsEx(std::string("Error: c++ exception!"));
         nsEx.ReThrowToJava(nullptr);
     }
-}
\ No newline at end of file
+}
+
+extern "C" JNIEXPORT jboolean Java_com_tns_AssetExtractor_mountApk(JNIEnv* env, jclass clazz, jstring apk, jstring filesDir) {
+    return AssetExtractor::MountApk(env, apk, filesDir) ? JNI_TRUE : JNI_FALSE;
+}
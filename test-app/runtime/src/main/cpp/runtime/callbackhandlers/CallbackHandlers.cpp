@@ -19,6 +19,8 @@
 #include "ArgConverter.h"
 #include "JsArgConverter.h"
 #include "GlobalHelpers.h"
+#include "Tracing.h"
+#include "CallStats.h"
 #include <regex>
 
 #ifdef USE_MIMALLOC
@@ -92,14 +94,17 @@ void CallbackHandlers::Init(napi_env env) {
 napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, const string &className,
                                  const string &methodName, MetadataEntry *entry,
                                  bool isFromInterface, bool isStatic, napi_callback_info info, size_t argc, napi_value* argv) {
+    instrumentation::TraceScope trace("CallJavaMethod", methodName);
+    instrumentation::CallStatsScope stats;
 
     JEnv jEnv;
     jclass clazz;
     jmethodID mid;
-    string *sig = nullptr;
-    string *returnType = nullptr;
+    const string *sig = nullptr;
+    const std::vector<std::string> *parsedSig = nullptr;
+    const string *returnType = nullptr;
     auto retType = MethodReturnType::Unknown;
-    MethodCache::CacheMethodInfo mi;
+    const MethodCache::CacheMethodInfo *mi;
     bool isSuper = false;
 
     if ((entry != nullptr) && entry->getIsResolved()) {
@@ -171,6 +176,7 @@ napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, con
         mid = reinterpret_cast<jmethodID>(entry->memberId);
         clazz = entry->clazz;
         sig = &entry->getSig();
+        parsedSig = &entry->getParsedSig();
         returnType = &entry->getReturnType();
         retType = entry->getRetType();
     } else {
@@ -179,7 +185,7 @@ napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, con
         clazz = jEnv.FindClass(className);
         if (clazz != nullptr) {
             mi = MethodCache::ResolveMethodSignature(env, className, methodName, argc, argv, isStatic);
-            if (mi.mid == nullptr) {
+            if (mi == nullptr || mi->mid == nullptr) {
                 DEBUG_WRITE("Cannot resolve class=%s, method=%s, isStatic=%d, isSuper=%d",
                             className.c_str(), methodName.c_str(), isStatic, isSuper);
                 return nullptr;
@@ -191,7 +197,7 @@ napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, con
                         callerClassName.c_str(), methodName.c_str(), className.c_str());
             mi = MethodCache::ResolveMethodSignature(env, callerClassName, methodName, argc, argv,
                                                      isStatic);
-            if (mi.mid == nullptr) {
+            if (mi == nullptr || mi->mid == nullptr) {
                 DEBUG_WRITE(
                         "Cannot resolve class=%s, method=%s, isStatic=%d, isSuper=%d, callerClass=%s",
                         className.c_str(), methodName.c_str(), isStatic, isSuper,
@@ -200,13 +206,16 @@ napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, con
             }
         }
 
-        clazz = mi.clazz;
-        mid = mi.mid;
-        sig = &mi.signature;
-        returnType = &mi.returnType;
-        retType = mi.retType;
+        clazz = mi->clazz;
+        mid = mi->mid;
+        sig = &mi->signature;
+        parsedSig = &mi->parsedSig;
+        returnType = &mi->returnType;
+        retType = mi->retType;
     }
 
+    stats.SetJavaMethod(mid, className, methodName, *sig);
+
     if (!isStatic) {
         DEBUG_WRITE("CallJavaMethod on instance %s", methodName.c_str());
     } else {
@@ -214,8 +223,8 @@ napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, con
     }
 
     JsArgConverter argConverter = (entry != nullptr && entry->isExtensionFunction)
-                                  ? JsArgConverter(env, caller, argv, argc, *sig, entry)
-                                  : JsArgConverter(env, argv, argc, false, *sig, entry);
+                                  ? JsArgConverter(env, caller, argv, argc, *parsedSig)
+                                  : JsArgConverter(env, argv, argc, false, *parsedSig);
 
 
     if (!argConverter.IsValid()) {
@@ -252,6 +261,8 @@ napi_value CallbackHandlers::CallJavaMethod(napi_env env, napi_value caller, con
         }
     }
 
+    stats.Converted();
+
     napi_value returnValue;
 
     switch (retType) {
@@ -705,64 +716,6 @@ CallbackHandlers::GetMethodOverrides(napi_env env, JEnv &jEnv, napi_value implem
     return methodOverrides;
 }
 
-napi_value CallbackHandlers::RunOnMainThreadCallback(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-
-    assert(argc == 1);
-    assert(napi_util::is_of_type(env, args[0], napi_function));
-
-    uint64_t key = ++count_;
-    bool inserted;
-
-    std::tie(std::ignore, inserted) = cache_.try_emplace(key, env, args[0]);
-    assert(inserted && "Main thread callback ID should not be duplicated");
-
-    auto value = Callback(key);
-    auto size = sizeof(Callback);
-    auto wrote = write(Runtime::GetWriter(), &value, size);
-
-
-
-    return nullptr;
-}
-
-int CallbackHandlers::RunOnMainThreadFdCallback(int fd, int events, void *data) {
-    struct Callback value;
-    auto size = sizeof(Callback);
-    ssize_t nr = read(fd, &value, sizeof(value));
-
-    auto key = value.id_;
-
-    auto it = cache_.find(key);
-    if (it == cache_.end()) {
-        return 1;
-    }
-
-    napi_env env = it->second.env_;
-    napi_ref callback_ref = it->second.callback_;
-
-    NapiScope scope(env);
-
-    napi_value cb = napi_util::get_ref_value(env, callback_ref);
-
-    napi_value global;
-    napi_get_global(env, &global);
-
-    cache_.erase(it);
-
-    napi_value result;
-    napi_status status = napi_call_function(env, global, cb, 0, nullptr, &result);
-
-    if (status != napi_ok) {
-        napi_throw_error(env, nullptr, "Error calling JavaScript callback");
-    }
-
-
-    return 1;
-}
-
 napi_value CallbackHandlers::LogMethodCallback(napi_env env, napi_callback_info info) {
     size_t argc = 1;
     napi_value args[1];
@@ -831,6 +784,35 @@ CallbackHandlers::ReleaseNativeCounterpartCallback(napi_env env, napi_callback_i
     return napi_util::undefined(env);
 }
 
+napi_value CallbackHandlers::GetJavaFieldsCallback(napi_env env, napi_callback_info info) {
+    NAPI_CALLBACK_BEGIN_VARGS();
+
+    try {
+        bool isArray = false;
+        if (argc == 2) {
+            napi_is_array(env, argv[1], &isArray);
+        }
+
+        if (!isArray || !napi_util::is_of_type(env, argv[0], napi_object)) {
+            throw NativeScriptException("__getJavaFields expects a Java object and an array of field names");
+        }
+
+        return fieldAccessor.GetJavaFields(env, argv[0], argv[1]);
+    } catch (NativeScriptException &e) {
+        e.ReThrowToNapi(env);
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToNapi(env);
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToNapi(env);
+    }
+
+    return napi_util::undefined(env);
+}
+
 void CallbackHandlers::validateProvidedArgumentsLength(napi_env env, napi_callback_info info,
                                                        int expectedSize) {
     size_t argc = 0;
@@ -964,6 +946,9 @@ vector<string> CallbackHandlers::GetTypeMetadata(const string &name, int index)
 napi_value CallbackHandlers::CallJSMethod(napi_env env, JNIEnv *_jEnv,
                                           napi_value jsObject, jclass claz,const string &methodName,int javaObjectId,
                                           jobjectArray args) {
+    instrumentation::TraceScope trace("CallJSMethod", methodName);
+    instrumentation::CallStatsScope stats;
+    stats.SetJsMethod(methodName);
     JEnv jEnv(_jEnv);
     napi_value result;
     napi_value method;
@@ -1005,6 +990,7 @@ napi_value CallbackHandlers::CallJSMethod(napi_env env, JNIEnv *_jEnv,
 #endif
             }
             ArgConverter::ConvertJavaArgsToJsArgs(env, args, argc, jsArgs);
+            stats.Converted();
             napi_call_function(env, jsObject, method, argc, jsArgs, &result);
 
             if (argc > 8) {
@@ -1015,6 +1001,7 @@ napi_value CallbackHandlers::CallJSMethod(napi_env env, JNIEnv *_jEnv,
 #endif
             }
         } else {
+            stats.Converted();
             napi_call_function(env, jsObject, method, 0, nullptr, &result);
         }
 
@@ -1116,6 +1103,25 @@ void CallbackHandlers::PostCallback(napi_env env, napi_callback_info info,
     }
 }
 
+bool CallbackHandlers::PostNativeFrameCallback(AChoreographer_frameCallback64 callback64,
+                                               AChoreographer_frameCallback callback, void *data) {
+    if (android_get_device_api_level() < 24) {
+        return false;
+    }
+
+    InitChoreographer();
+
+    ALooper_prepare(0);
+    auto instance = AChoreographer_getInstance_();
+    if (android_get_device_api_level() >= 29) {
+        AChoreographer_postFrameCallback64_(instance, callback64, data);
+    } else {
+        AChoreographer_postFrameCallback_(instance, callback, data);
+    }
+
+    return true;
+}
+
 napi_value CallbackHandlers::PostFrameCallback(napi_env env, napi_callback_info info) {
     if (android_get_device_api_level() >= 24) {
         InitChoreographer();
@@ -1245,12 +1251,6 @@ void CallbackHandlers::InitChoreographer() {
 }
 
 void CallbackHandlers::RemoveEnvEntries(napi_env env) {
-    for (auto &item: cache_) {
-        if (item.second.env_ == env) {
-            cache_.erase(item.first);
-        }
-    }
-
     for (auto &item: frameCallbackCache_) {
         if (item.second.env == env) {
             frameCallbackCache_.erase(item.first);
@@ -1429,8 +1429,7 @@ void CallbackHandlers::WorkerGlobalOnMessageCallback(napi_env env, jstring messa
         napi_get_named_property(env, globalObject, "onmessage", &callback);
 
         if (napi_util::is_of_type(env, callback, napi_function)) {
-            std::string msgString = ArgConverter::jstringToString(message);
-            napi_value dataObject = tns::JsonParseString(env, msgString.c_str());
+            napi_value dataObject = tns::JsonParseString(env, ArgConverter::jstringToJsString(env, message));
 
             napi_value obj;
             napi_create_object(env, &obj);
@@ -1536,9 +1535,7 @@ void CallbackHandlers::WorkerObjectOnMessageCallback(napi_env env, jint workerId
         napi_get_named_property(env, worker, "onmessage", &callback);
 
         if (napi_util::is_of_type(env, callback, napi_function)) {
-            std::string msgString = ArgConverter::jstringToString(message);
-
-            napi_value dataObject = tns::JsonParseString(env, msgString.c_str());
+            napi_value dataObject = tns::JsonParseString(env, ArgConverter::jstringToJsString(env, message));
 
             napi_value obj;
             napi_create_object(env, &obj);
@@ -1891,12 +1888,10 @@ void CallbackHandlers::TerminateWorkerThread(napi_env env) {
 
 }
 
-robin_hood::unordered_map<uint64_t, CallbackHandlers::CacheEntry> CallbackHandlers::cache_;
 robin_hood::unordered_map<jclass, jfieldID> CallbackHandlers::jclass_to_runtimeId_cache;
 
 robin_hood::unordered_map<uint64_t, CallbackHandlers::FrameCallbackCacheEntry> CallbackHandlers::frameCallbackCache_;
 
-std::atomic_int64_t CallbackHandlers::count_ = {0};
 std::atomic_uint64_t CallbackHandlers::frameCallbackCount_ = {0};
 
 int CallbackHandlers::nextWorkerId = 0;
@@ -75,10 +75,6 @@ namespace tns {
         static void SetJavaField(napi_env env, napi_value target,
                                  napi_value value, FieldCallbackData *fieldData);
 
-        static napi_value RunOnMainThreadCallback(napi_env env, napi_callback_info info);
-
-        static int RunOnMainThreadFdCallback(int fd, int events, void *data);
-
         static napi_value LogMethodCallback(napi_env env, napi_callback_info info);
 
         static napi_value TimeCallback(napi_env env, napi_callback_info info);
@@ -120,6 +116,8 @@ namespace tns {
 
         static napi_value ReleaseNativeCounterpartCallback(napi_env env, napi_callback_info info);
 
+        static napi_value GetJavaFieldsCallback(napi_env env, napi_callback_info info);
+
         static napi_value FindClass(napi_env env, const char *name);
 
         static napi_value NewThreadCallback(napi_env env, napi_callback_info info);
@@ -218,6 +216,12 @@ namespace tns {
                 AChoreographer *choreographer, AChoreographer_frameCallback64 callback,
                 void *data, uint32_t delayMillis);
 
+        /*
+         * Posts a native callback to the AChoreographer of the current thread, `callback64` is
+         * used from API 29 on. Returns false when there is no AChoreographer (API < 24).
+         */
+        static bool PostNativeFrameCallback(AChoreographer_frameCallback64 callback64,
+                                            AChoreographer_frameCallback callback, void *data);
 
         static jint lastCallId;
         static napi_value lastCallValue;
@@ -283,34 +287,6 @@ namespace tns {
             jobject _runtime;
         };
 
-        static std::atomic_int64_t count_;
-
-        struct Callback {
-            Callback() {}
-
-            Callback(uint64_t id)
-                    : id_(id) {
-            }
-
-            uint64_t id_;
-        };
-
-        struct CacheEntry {
-            CacheEntry(napi_env env, napi_value callback)
-                    : env_(env) {
-                napi_create_reference(env, callback, 1, &callback_);
-            }
-
-            ~CacheEntry() {
-                napi_delete_reference(env_, callback_);
-            }
-
-            napi_env env_;
-            napi_ref callback_;
-        };
-
-        static robin_hood::unordered_map<uint64_t, CacheEntry> cache_;
-
         static robin_hood::unordered_map<jclass, jfieldID> jclass_to_runtimeId_cache;
 
         static std::atomic_uint64_t frameCallbackCount_;
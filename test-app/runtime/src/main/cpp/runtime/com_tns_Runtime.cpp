@@ -1,6 +1,8 @@
 #include "Runtime.h"
 #include "NativeScriptException.h"
 #include "CallbackHandlers.h"
+#include "ArgConverter.h"
+#include "File.h"
 #include <sstream>
 
 #ifdef __HERMES__
@@ -150,6 +152,35 @@ extern "C" JNIEXPORT jobject Java_com_tns_Runtime_runScript(JNIEnv* _env, jobjec
     return result;
 }
 
+extern "C" JNIEXPORT jstring Java_com_tns_Runtime_resolveMainModule(JNIEnv* _env, jobject obj, jint runtimeId) {
+    jstring result = nullptr;
+
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) return result;
+
+    napi_env napiEnv = runtime->GetNapiEnv();
+    NapiScope scope(napiEnv);
+    try {
+        result = _env->NewStringUTF(runtime->ResolveMainModule().c_str());
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava(napiEnv);
+    } catch (std::exception e) {
+        std::stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << std::endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava(napiEnv);
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava(napiEnv);
+    }
+
+    return result;
+}
+
+extern "C" JNIEXPORT jboolean Java_com_tns_Runtime_fileExists(JNIEnv* _env, jclass clazz, jstring path) {
+    return File::Exists(ArgConverter::jstringToString(path)) ? JNI_TRUE : JNI_FALSE;
+}
+
 extern "C" JNIEXPORT jobject Java_com_tns_Runtime_callJSMethodNative(JNIEnv* _env, jobject obj, jint runtimeId, jint javaObjectID, jclass claz, jstring methodName,jint retType, jboolean isConstructor, jobjectArray packagedArgs) {
     jobject result = nullptr;
     auto runtime = TryGetRuntime(runtimeId);
@@ -15,6 +15,7 @@
 
 #include "ArgConverter.h"
 #include "Console.h"
+#include "LogWriter.h"
 
 using namespace tns;
 
@@ -36,9 +37,15 @@ const char *Console::LOG_TAG = "JS";
 std::map<napi_env, std::map<std::string, double>> Console::s_envToConsoleTimersMap;
 int Console::m_maxLogcatObjectSize;
 
-void Console::createConsole(napi_env env, ConsoleCallback callback, const int maxLogcatObjectSize, const bool forceLog) {
+void Console::createConsole(napi_env env, ConsoleCallback callback, const int maxLogcatObjectSize, const bool forceLog, const bool isDebuggable) {
     m_callback = callback;
     m_maxLogcatObjectSize = maxLogcatObjectSize;
+    LogWriter::SetMaxMessageSize(maxLogcatObjectSize);
+
+    // apps that are not debuggable only log warnings and errors unless "forceLog" is set
+    if (!isDebuggable && !forceLog) {
+        LogWriter::SetMinPriority(ANDROID_LOG_WARN);
+    }
 
     napi_value console;
     napi_create_object(env, &console);
@@ -67,6 +74,10 @@ void Console::createConsole(napi_env env, ConsoleCallback callback, const int ma
     napi_set_named_property(env, console, "time", timeFunc);
     napi_set_named_property(env, console, "timeEnd", timeEndFunc);
     napi_set_named_property(env, global, "console", console);
+
+    napi_util::napi_set_function(env, global, "__configureConsole", configureCallback, nullptr);
+    napi_util::napi_set_function(env, global, "__getConsoleStats", getStatsCallback, nullptr);
+    napi_util::napi_set_function(env, global, "__flushConsole", flushCallback, nullptr);
 }
 
 std::string transformJSObject(napi_env env, napi_value object) {
@@ -89,51 +100,113 @@ std::string transformJSObject(napi_env env, napi_value object) {
     return JsonStringifyObject(env, object, false);
 }
 
-std::string buildStringFromArg(napi_env env, napi_value val) {
+namespace {
+    // the message of the console call being formatted on this thread, reused between calls
+    thread_local std::string t_logBuffer;
+    thread_local bool t_logBufferInUse = false;
+
+    /*
+     * The per thread buffer, or a fresh string when a toString() called while formatting logs too
+     */
+    class LogBuffer {
+    public:
+        LogBuffer(const char *prefix)
+                : m_nested(t_logBufferInUse), m_value(m_nested ? m_local : t_logBuffer) {
+            t_logBufferInUse = true;
+            m_value.assign(prefix);
+        }
+
+        ~LogBuffer() {
+            if (!m_nested) {
+                t_logBufferInUse = false;
+            }
+        }
+
+        std::string &value() {
+            return m_value;
+        }
+
+    private:
+        bool m_nested;
+        std::string m_local;
+        std::string &m_value;
+    };
+}
+
+void appendStringValue(napi_env env, napi_value str, std::string &out) {
+    size_t length;
+    napi_get_value_string_utf8(env, str, nullptr, 0, &length);
+    auto offset = out.length();
+    out.resize(offset + length);
+    // writes the terminating '\0' at out[out.length()]
+    napi_get_value_string_utf8(env, str, &out[offset], length + 1, &length);
+}
+
+void appendArg(napi_env env, napi_value val, std::string &out) {
     napi_valuetype type;
     napi_typeof(env, val, &type);
 
-    if (type == napi_function) {
+    if (type == napi_string) {
+        appendStringValue(env, val, out);
+    } else if (type == napi_function) {
         napi_value funcString;
         napi_coerce_to_string(env, val, &funcString);
-        return napi_util::get_string_value(env, funcString);
+        appendStringValue(env, funcString, out);
     } else if (napi_util::is_array(env, val)) {
-        napi_value global;
-        napi_get_global(env, &global);
-        return JsonStringifyObject(env, val, false);
+        JsonStringifyObject(env, val, out, false);
     } else if (type == napi_object) {
-        return transformJSObject(env, val);
+        out += transformJSObject(env, val);
     } else if (type == napi_symbol) {
         napi_value symString;
         napi_coerce_to_string(env, val, &symString);
-        return "Symbol(" + ArgConverter::ConvertToString(env, symString) + ")";
+        out += "Symbol(";
+        appendStringValue(env, symString, out);
+        out += ")";
     } else {
         napi_value defaultToString;
         napi_coerce_to_string(env, val, &defaultToString);
-        return napi_util::get_string_value(env, defaultToString);
+        appendStringValue(env, defaultToString, out);
     }
 }
 
-std::string buildLogString(napi_env env, napi_callback_info info, int startingIndex = 0) {
-    NAPI_CALLBACK_BEGIN_VARGS()
+std::string buildStringFromArg(napi_env env, napi_value val) {
+    std::string result;
+    appendArg(env, val, result);
+    return result;
+}
 
-    std::stringstream ss;
+void appendLogString(napi_env env, napi_callback_info info, std::string &out, size_t startingIndex = 0) {
+    const size_t maxStackArgs = 8;
+    napi_value stackArgs[maxStackArgs];
+    size_t argc = maxStackArgs;
+    napi_get_cb_info(env, info, &argc, stackArgs, nullptr, nullptr);
+
+    napi_value *argv = stackArgs;
+    std::vector<napi_value> heapArgs;
+    if (argc > maxStackArgs) {
+        heapArgs.resize(argc);
+        napi_get_cb_info(env, info, &argc, heapArgs.data(), nullptr, nullptr);
+        argv = heapArgs.data();
+    }
 
     if (argc) {
         for (size_t i = startingIndex; i < argc; i++) {
             // separate args with a space
             if (i != 0) {
-                ss << " ";
+                out += ' ';
             }
 
-            std::string argString = buildStringFromArg(env, argv[i]);
-            ss << argString;
+            appendArg(env, argv[i], out);
         }
     } else {
-        ss << std::endl;
+        out += '\n';
     }
+}
 
-    return ss.str();
+std::string buildLogString(napi_env env, napi_callback_info info, int startingIndex = 0) {
+    std::string result;
+    appendLogString(env, info, result, startingIndex);
+    return result;
 }
 
 napi_value Console::assertCallback(napi_env env, napi_callback_info info) {
@@ -155,17 +228,17 @@ napi_value Console::assertCallback(napi_env env, napi_callback_info info) {
         }
 
         if (!expressionPasses) {
-            std::stringstream assertionError;
-            assertionError << "Assertion failed: ";
+            if (LogWriter::IsLoggable(ANDROID_LOG_ERROR)) {
+                LogBuffer log("Assertion failed: ");
 
-            if (argc > 1) {
-                assertionError << buildLogString(env, info, 1);
-            } else {
-                assertionError << "console.assert";
-            }
+                if (argc > 1) {
+                    appendLogString(env, info, log.value(), 1);
+                } else {
+                    log.value() += "console.assert";
+                }
 
-            std::string log = assertionError.str();
-            sendToADBLogcat(log, ANDROID_LOG_ERROR);
+                sendToADBLogcat(log.value(), ANDROID_LOG_ERROR);
+            }
 #ifdef __V8__
             sendToDevToolsFrontEnd(env, ConsoleAPIType::kAssert, info);
 #endif
@@ -189,9 +262,11 @@ napi_value Console::assertCallback(napi_env env, napi_callback_info info) {
 
 napi_value Console::errorCallback(napi_env env, napi_callback_info info) {
     try {
-        std::string log = "CONSOLE ERROR: ";
-        log += buildLogString(env, info);
-        sendToADBLogcat(log, ANDROID_LOG_ERROR);
+        if (LogWriter::IsLoggable(ANDROID_LOG_ERROR)) {
+            LogBuffer log("CONSOLE ERROR: ");
+            appendLogString(env, info, log.value());
+            sendToADBLogcat(log.value(), ANDROID_LOG_ERROR);
+        }
 #ifdef __V8__
         sendToDevToolsFrontEnd(env, ConsoleAPIType::kError, info);
 #endif
@@ -214,15 +289,12 @@ napi_value Console::errorCallback(napi_env env, napi_callback_info info) {
 }
 
 napi_value Console::infoCallback(napi_env env, napi_callback_info info) {
-    size_t argc = 0;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-
     try {
-        std::string log = "CONSOLE INFO: ";
-        log += buildLogString(env, info);
-
-        sendToADBLogcat(log, ANDROID_LOG_INFO);
+        if (LogWriter::IsLoggable(ANDROID_LOG_INFO)) {
+            LogBuffer log("CONSOLE INFO: ");
+            appendLogString(env, info, log.value());
+            sendToADBLogcat(log.value(), ANDROID_LOG_INFO);
+        }
 #ifdef __V8__
         sendToDevToolsFrontEnd(env, ConsoleAPIType::kInfo, info);
 #endif
@@ -244,15 +316,12 @@ napi_value Console::infoCallback(napi_env env, napi_callback_info info) {
 }
 
 napi_value Console::logCallback(napi_env env, napi_callback_info info) {
-    size_t argc = 0;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-
     try {
-        std::string log = "CONSOLE LOG: ";
-        log += buildLogString(env, info);
-
-        sendToADBLogcat(log, ANDROID_LOG_INFO);
+        if (LogWriter::IsLoggable(ANDROID_LOG_INFO)) {
+            LogBuffer log("CONSOLE LOG: ");
+            appendLogString(env, info, log.value());
+            sendToADBLogcat(log.value(), ANDROID_LOG_INFO);
+        }
 #ifdef __V8__
         sendToDevToolsFrontEnd(env, ConsoleAPIType::kLog, info);
 #endif
@@ -274,15 +343,12 @@ napi_value Console::logCallback(napi_env env, napi_callback_info info) {
 }
 
 napi_value Console::warnCallback(napi_env env, napi_callback_info info) {
-    size_t argc = 0;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-
     try {
-        std::string log = "CONSOLE WARN: ";
-        log += buildLogString(env, info);
-
-        sendToADBLogcat(log, ANDROID_LOG_WARN);
+        if (LogWriter::IsLoggable(ANDROID_LOG_WARN)) {
+            LogBuffer log("CONSOLE WARN: ");
+            appendLogString(env, info, log.value());
+            sendToADBLogcat(log.value(), ANDROID_LOG_WARN);
+        }
 #ifdef __V8__
         sendToDevToolsFrontEnd(env, ConsoleAPIType::kWarning, info);
 #endif
@@ -309,6 +375,13 @@ napi_value Console::dirCallback(napi_env env, napi_callback_info info) {
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
 
     try {
+        if (!LogWriter::IsLoggable(ANDROID_LOG_INFO)) {
+#ifdef __V8__
+            sendToDevToolsFrontEnd(env, ConsoleAPIType::kDir, info);
+#endif
+            return nullptr;
+        }
+
         std::stringstream ss;
 
         if (argc > 0) {
@@ -386,11 +459,14 @@ napi_value Console::dirCallback(napi_env env, napi_callback_info info) {
 }
 
 napi_value Console::traceCallback(napi_env env, napi_callback_info info) {
-    size_t argc = 0;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-
     try {
+        if (!LogWriter::IsLoggable(ANDROID_LOG_ERROR)) {
+#ifdef __V8__
+            sendToDevToolsFrontEnd(env, ConsoleAPIType::kTrace, info);
+#endif
+            return nullptr;
+        }
+
         std::stringstream ss;
 
         std::string logString = buildLogString(env, info);
@@ -420,7 +496,7 @@ napi_value Console::traceCallback(napi_env env, napi_callback_info info) {
         ss << stackStr << std::endl;
 
         std::string log = ss.str();
-        __android_log_write(ANDROID_LOG_ERROR, LOG_TAG, log.c_str());
+        LogWriter::Write(ANDROID_LOG_ERROR, log);
 #ifdef __V8__
         sendToDevToolsFrontEnd(env, ConsoleAPIType::kTrace, info);
 #endif
@@ -506,7 +582,7 @@ napi_value Console::timeEndCallback(napi_env env, napi_callback_info info) {
             std::string warning = std::string(
                     "No such label '" + label + "' for console.timeEnd()");
 
-            __android_log_write(ANDROID_LOG_WARN, LOG_TAG, warning.c_str());
+            LogWriter::Write(ANDROID_LOG_WARN, warning);
 #ifdef __V8__
             sendToDevToolsFrontEnd(env, ConsoleAPIType::kWarning, warning);
 #endif
@@ -529,7 +605,7 @@ napi_value Console::timeEndCallback(napi_env env, napi_callback_info info) {
            << diffMilliseconds << "ms";
         std::string log = ss.str();
 
-        __android_log_write(ANDROID_LOG_INFO, LOG_TAG, log.c_str());
+        LogWriter::Write(ANDROID_LOG_INFO, log);
 #ifdef __V8__
         sendToDevToolsFrontEnd(env, ConsoleAPIType::kTimeEnd, log);
 #endif
@@ -556,27 +632,111 @@ void Console::onDisposeEnv(napi_env env) {
 }
 
 void Console::sendToADBLogcat(const std::string &message, android_LogPriority logPriority) {
-    // limit the size of the message that we send to logcat using the predefined value in package.json
-    auto messageToLog = message;
-    if (messageToLog.length() > m_maxLogcatObjectSize) {
-        messageToLog = messageToLog.erase(m_maxLogcatObjectSize, std::string::npos);
-        messageToLog = messageToLog + "...";
-    }
+    // truncated to maxLogcatObjectSize and split into logcat sized chunks on the writer thread
+    LogWriter::Write(logPriority, message);
+}
+
+napi_value Console::configureCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
 
-    // split strings into chunks of 4000 characters
-    // __android_log_write can't send more than 4000 to the stdout at a time
-    auto messageLength = messageToLog.length();
-    int maxStringLength = 4000;
+    try {
+        if (argc < 1 || !napi_util::is_object(env, args[0])) {
+            throw NativeScriptException("__configureConsole expects an options object");
+        }
+        napi_value options = args[0];
+
+        napi_value level;
+        napi_get_named_property(env, options, "level", &level);
+        if (napi_util::is_of_type(env, level, napi_string)) {
+            auto name = ArgConverter::ConvertToString(env, level);
+            android_LogPriority priority;
+            if (name == "log" || name == "info") {
+                priority = ANDROID_LOG_INFO;
+            } else if (name == "warn") {
+                priority = ANDROID_LOG_WARN;
+            } else if (name == "error") {
+                priority = ANDROID_LOG_ERROR;
+            } else if (name == "none") {
+                priority = ANDROID_LOG_SILENT;
+            } else {
+                throw NativeScriptException("Unknown console level: " + name);
+            }
+            LogWriter::SetMinPriority(priority);
+        }
 
-    if (messageLength < maxStringLength) {
-        __android_log_write(logPriority, Console::LOG_TAG, messageToLog.c_str());
-    } else {
-        for (int i = 0; i < messageLength; i += maxStringLength) {
-            auto messagePart = messageToLog.substr(i, maxStringLength);
+        napi_value maxMessagesPerSecond;
+        napi_get_named_property(env, options, "maxMessagesPerSecond", &maxMessagesPerSecond);
+        if (napi_util::is_of_type(env, maxMessagesPerSecond, napi_number)) {
+            int64_t value;
+            napi_get_value_int64(env, maxMessagesPerSecond, &value);
+            LogWriter::SetMaxMessagesPerSecond(value);
+        }
+
+        napi_value dropWhenFull;
+        napi_get_named_property(env, options, "dropWhenFull", &dropWhenFull);
+        if (napi_util::is_of_type(env, dropWhenFull, napi_boolean)) {
+            bool value;
+            napi_get_value_bool(env, dropWhenFull, &value);
+            LogWriter::SetDropWhenFull(value);
+        }
 
-            __android_log_write(logPriority, Console::LOG_TAG, messagePart.c_str());
+        // a file path, or "logcat"
+        napi_value sink;
+        napi_get_named_property(env, options, "sink", &sink);
+        if (napi_util::is_of_type(env, sink, napi_string)) {
+            auto path = ArgConverter::ConvertToString(env, sink);
+            if (!LogWriter::SetFileSink(path == "logcat" ? std::string() : path)) {
+                throw NativeScriptException("Cannot open console sink: " + path);
+            }
         }
     }
+    catch (NativeScriptException &e) {
+        e.ReThrowToNapi(env);
+    }
+    catch (std::exception &e) {
+        std::stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << std::endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToNapi(env);
+    }
+    catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToNapi(env);
+    }
+
+    return nullptr;
+}
+
+napi_value Console::getStatsCallback(napi_env env, napi_callback_info info) {
+    auto stats = LogWriter::GetStats();
+
+    napi_value result, written, dropped, pending;
+    napi_create_object(env, &result);
+    napi_create_int64(env, stats.written, &written);
+    napi_create_int64(env, stats.dropped, &dropped);
+    napi_create_int64(env, stats.pending, &pending);
+    napi_set_named_property(env, result, "written", written);
+    napi_set_named_property(env, result, "dropped", dropped);
+    napi_set_named_property(env, result, "pending", pending);
+
+    return result;
+}
+
+napi_value Console::flushCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int32_t timeoutMs = 1000;
+    if (argc > 0 && napi_util::is_of_type(env, args[0], napi_number)) {
+        napi_get_value_int32(env, args[0], &timeoutMs);
+    }
+
+    napi_value result;
+    napi_get_boolean(env, LogWriter::Flush(timeoutMs), &result);
+    return result;
 }
 
 #ifdef __V8__
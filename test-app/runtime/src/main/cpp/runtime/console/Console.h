@@ -25,7 +25,7 @@ typedef void (*ConsoleCallback)(napi_env env, napi_callback_info info);
 namespace tns {
     class Console {
     public:
-        static void createConsole(napi_env env, ConsoleCallback callback, int maxLogcatObjectSize, bool forceLog);
+        static void createConsole(napi_env env, ConsoleCallback callback, int maxLogcatObjectSize, bool forceLog, bool isDebuggable);
 
         static napi_value assertCallback(napi_env env, napi_callback_info info);
         static napi_value errorCallback(napi_env env, napi_callback_info info);
@@ -39,6 +39,14 @@ namespace tns {
 
         static void onDisposeEnv(napi_env env);
 
+        /*
+         * __configureConsole({ level: "log" | "warn" | "error" | "none", sink: "logcat" | path,
+         *                      maxMessagesPerSecond, dropWhenFull })
+         */
+        static napi_value configureCallback(napi_env env, napi_callback_info info);
+        static napi_value getStatsCallback(napi_env env, napi_callback_info info);
+        static napi_value flushCallback(napi_env env, napi_callback_info info);
+
     private:
 
         static int m_maxLogcatObjectSize;
@@ -0,0 +1,258 @@
+#include "LogWriter.h"
+#include <chrono>
+#include <cstring>
+#include <pthread.h>
+#include <thread>
+
+using namespace tns;
+using namespace std;
+
+namespace {
+    int64_t NowMs() {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+void LogWriter::EnsureStarted() {
+    static once_flag started;
+    call_once(started, [] {
+        s_cells = new Cell[QUEUE_SIZE];
+        for (size_t i = 0; i < QUEUE_SIZE; i++) {
+            s_cells[i].sequence.store(i, memory_order_relaxed);
+        }
+        thread(Run).detach();
+    });
+}
+
+void LogWriter::Write(android_LogPriority priority, const std::string &message) {
+    if (!IsLoggable(priority)) {
+        return;
+    }
+
+    EnsureStarted();
+
+    if (IsRateLimited()) {
+        s_dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+
+    auto pos = s_enqueuePos.load(memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &s_cells[pos & (QUEUE_SIZE - 1)];
+        auto sequence = cell->sequence.load(memory_order_acquire);
+        auto diff = (intptr_t) sequence - (intptr_t) pos;
+        if (diff == 0) {
+            if (s_enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the writer is a full queue behind
+            if (s_dropWhenFull.load(memory_order_relaxed)) {
+                s_dropped.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            unique_lock<mutex> lock(s_mutex);
+            s_wakeup.notify_one();
+            s_flushed.wait_for(lock, chrono::milliseconds(10));
+            pos = s_enqueuePos.load(memory_order_relaxed);
+        } else {
+            pos = s_enqueuePos.load(memory_order_relaxed);
+        }
+    }
+
+    // limit the size of the message using the predefined value in package.json
+    auto maxSize = s_maxMessageSize.load(memory_order_relaxed);
+    if (message.length() > maxSize) {
+        cell->message.assign(message, 0, maxSize);
+        cell->message.append("...");
+    } else {
+        cell->message.assign(message);
+    }
+    cell->priority = priority;
+    cell->sequence.store(pos + 1, memory_order_release);
+
+    // pairs with the fence in Run, either the writer sees the message or we see it waiting
+    atomic_thread_fence(memory_order_seq_cst);
+    if (s_waiting.load(memory_order_relaxed)) {
+        lock_guard<mutex> lock(s_mutex);
+        s_wakeup.notify_one();
+    }
+}
+
+bool LogWriter::Flush(int timeoutMs) {
+    if (s_cells == nullptr) {
+        return true;
+    }
+
+    auto target = s_enqueuePos.load();
+    unique_lock<mutex> lock(s_mutex);
+    s_wakeup.notify_one();
+    return s_flushed.wait_for(lock, chrono::milliseconds(timeoutMs), [target] {
+        return s_writtenPos.load(memory_order_acquire) >= target;
+    });
+}
+
+void LogWriter::Run() {
+    pthread_setname_np(pthread_self(), "NSLogWriter");
+
+    while (true) {
+        bool wrote = false;
+        while (TryWrite(s_dequeuePos)) {
+            wrote = true;
+        }
+
+        auto dropped = s_dropped.load(memory_order_relaxed);
+        if (dropped != s_reportedDropped) {
+            char message[96];
+            auto length = snprintf(message, sizeof(message), "CONSOLE: %lld messages were dropped",
+                                   (long long) (dropped - s_reportedDropped));
+            Emit(ANDROID_LOG_WARN, message, length);
+            s_reportedDropped = dropped;
+        }
+
+        if (wrote) {
+            {
+                lock_guard<mutex> sinkLock(s_sinkMutex);
+                if (s_file != nullptr) {
+                    fflush(s_file);
+                }
+            }
+            lock_guard<mutex> lock(s_mutex);
+            s_flushed.notify_all();
+        }
+
+        unique_lock<mutex> lock(s_mutex);
+        s_waiting.store(true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        s_wakeup.wait_for(lock, chrono::milliseconds(100), [] {
+            auto &cell = s_cells[s_dequeuePos & (QUEUE_SIZE - 1)];
+            return cell.sequence.load(memory_order_acquire) == s_dequeuePos + 1;
+        });
+        s_waiting.store(false, memory_order_relaxed);
+    }
+}
+
+bool LogWriter::TryWrite(size_t &dequeuePos) {
+    auto &cell = s_cells[dequeuePos & (QUEUE_SIZE - 1)];
+    if (cell.sequence.load(memory_order_acquire) != dequeuePos + 1) {
+        return false;
+    }
+
+    Emit(cell.priority, cell.message.c_str(), cell.message.length());
+
+    // hand the cell, and the capacity of its message, back to the producers
+    cell.sequence.store(dequeuePos + QUEUE_SIZE, memory_order_release);
+    dequeuePos++;
+    s_writtenPos.store(dequeuePos, memory_order_release);
+    s_written.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void LogWriter::Emit(android_LogPriority priority, const char *message, size_t length) {
+    lock_guard<mutex> lock(s_sinkMutex);
+
+    if (s_file != nullptr) {
+        static const char levels[] = "  VDIWEFS";
+        fputc(priority < (int) sizeof(levels) - 1 ? levels[priority] : ' ', s_file);
+        fputc(' ', s_file);
+        fwrite(message, 1, length, s_file);
+        fputc('\n', s_file);
+        return;
+    }
+
+    if (length < MAX_CHUNK_SIZE) {
+        __android_log_write(priority, LOG_TAG, message);
+        return;
+    }
+
+    char chunk[MAX_CHUNK_SIZE + 1];
+    for (size_t i = 0; i < length; i += MAX_CHUNK_SIZE) {
+        auto chunkLength = std::min(MAX_CHUNK_SIZE, length - i);
+        memcpy(chunk, message + i, chunkLength);
+        chunk[chunkLength] = '\0';
+        __android_log_write(priority, LOG_TAG, chunk);
+    }
+}
+
+bool LogWriter::IsRateLimited() {
+    auto max = s_maxMessagesPerSecond.load(memory_order_relaxed);
+    if (max <= 0) {
+        return false;
+    }
+
+    auto now = NowMs();
+    auto windowStart = s_windowStartMs.load(memory_order_relaxed);
+    if (now - windowStart >= 1000 && s_windowStartMs.compare_exchange_strong(windowStart, now)) {
+        s_windowCount.store(0, memory_order_relaxed);
+    }
+
+    return s_windowCount.fetch_add(1, memory_order_relaxed) >= max;
+}
+
+void LogWriter::SetMinPriority(android_LogPriority priority) {
+    s_minPriority.store(priority, memory_order_relaxed);
+}
+
+void LogWriter::SetMaxMessageSize(size_t size) {
+    s_maxMessageSize.store(size, memory_order_relaxed);
+}
+
+void LogWriter::SetMaxMessagesPerSecond(int64_t count) {
+    s_maxMessagesPerSecond.store(count, memory_order_relaxed);
+}
+
+void LogWriter::SetDropWhenFull(bool drop) {
+    s_dropWhenFull.store(drop, memory_order_relaxed);
+}
+
+bool LogWriter::SetFileSink(const std::string &path) {
+    // what was logged before the switch goes to the previous sink
+    Flush(1000);
+
+    FILE *file = nullptr;
+    if (!path.empty()) {
+        file = fopen(path.c_str(), "a");
+        if (file == nullptr) {
+            return false;
+        }
+    }
+
+    lock_guard<mutex> lock(s_sinkMutex);
+    if (s_file != nullptr) {
+        fclose(s_file);
+    }
+    s_file = file;
+    return true;
+}
+
+LogWriter::Stats LogWriter::GetStats() {
+    auto pending = (int64_t) s_enqueuePos.load() - (int64_t) s_writtenPos.load();
+    return {s_written.load(), s_dropped.load(), pending};
+}
+
+LogWriter::Cell *LogWriter::s_cells = nullptr;
+std::atomic<size_t> LogWriter::s_enqueuePos(0);
+size_t LogWriter::s_dequeuePos = 0;
+std::atomic<size_t> LogWriter::s_writtenPos(0);
+
+std::atomic<int> LogWriter::s_minPriority(ANDROID_LOG_DEFAULT);
+std::atomic<size_t> LogWriter::s_maxMessageSize(1024);
+std::atomic<int64_t> LogWriter::s_maxMessagesPerSecond(0);
+std::atomic<bool> LogWriter::s_dropWhenFull(false);
+std::atomic<int64_t> LogWriter::s_windowStartMs(0);
+std::atomic<int64_t> LogWriter::s_windowCount(0);
+
+std::atomic<int64_t> LogWriter::s_written(0);
+std::atomic<int64_t> LogWriter::s_dropped(0);
+int64_t LogWriter::s_reportedDropped = 0;
+
+std::mutex LogWriter::s_mutex;
+std::condition_variable LogWriter::s_wakeup;
+std::condition_variable LogWriter::s_flushed;
+std::atomic<bool> LogWriter::s_waiting(false);
+
+std::mutex LogWriter::s_sinkMutex;
+FILE *LogWriter::s_file = nullptr;
+
+const char *LogWriter::LOG_TAG = "JS";
@@ -0,0 +1,117 @@
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <android/log.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace tns {
+
+/*
+ * Writes console output to logcat, or to a file, from a background thread.
+ *
+ * Messages are copied into the preallocated cells of a bounded lock-free multi-producer queue, the
+ * cells keep their capacity so that after warm up logging doesn't allocate. When the queue is full
+ * the caller waits for the writer, unless dropping is enabled. Messages over the rate limit, or
+ * that don't fit in the queue, are dropped and counted, the writer reports the number of dropped
+ * messages in the output.
+ *
+ * IsLoggable should be checked before formatting a message, so that filtered out levels cost
+ * nothing.
+ */
+class LogWriter {
+public:
+    struct Stats {
+        int64_t written;
+        int64_t dropped;
+        int64_t pending;
+    };
+
+    static inline bool IsLoggable(android_LogPriority priority) {
+        return priority >= s_minPriority.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Queues a message, messages longer than the max message size are truncated
+     */
+    static void Write(android_LogPriority priority, const std::string &message);
+
+    /*
+     * Waits until the queued messages are written or the timeout elapses
+     */
+    static bool Flush(int timeoutMs);
+
+    static void SetMinPriority(android_LogPriority priority);
+
+    static void SetMaxMessageSize(size_t size);
+
+    /*
+     * 0 disables the rate limit
+     */
+    static void SetMaxMessagesPerSecond(int64_t count);
+
+    static void SetDropWhenFull(bool drop);
+
+    /*
+     * Appends the output to the file at `path` instead of logcat, an empty path switches back
+     */
+    static bool SetFileSink(const std::string &path);
+
+    static Stats GetStats();
+
+    static const size_t QUEUE_SIZE = 1024;
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        android_LogPriority priority;
+        std::string message;
+    };
+
+    static void EnsureStarted();
+
+    static void Run();
+
+    static bool TryWrite(size_t &dequeuePos);
+
+    static void Emit(android_LogPriority priority, const char *message, size_t length);
+
+    static bool IsRateLimited();
+
+    static Cell *s_cells;
+    static std::atomic<size_t> s_enqueuePos;
+    // the writer thread is the only consumer
+    static size_t s_dequeuePos;
+    static std::atomic<size_t> s_writtenPos;
+
+    static std::atomic<int> s_minPriority;
+    static std::atomic<size_t> s_maxMessageSize;
+    static std::atomic<int64_t> s_maxMessagesPerSecond;
+    static std::atomic<bool> s_dropWhenFull;
+    static std::atomic<int64_t> s_windowStartMs;
+    static std::atomic<int64_t> s_windowCount;
+
+    static std::atomic<int64_t> s_written;
+    static std::atomic<int64_t> s_dropped;
+    static int64_t s_reportedDropped;
+
+    static std::mutex s_mutex;
+    static std::condition_variable s_wakeup;
+    static std::condition_variable s_flushed;
+    static std::atomic<bool> s_waiting;
+
+    static std::mutex s_sinkMutex;
+    static FILE *s_file;
+
+    static const char *LOG_TAG;
+    // __android_log_write can't send more than 4000 characters at a time
+    static constexpr size_t MAX_CHUNK_SIZE = 4000;
+};
+
+}
+
+#endif //LOGWRITER_H
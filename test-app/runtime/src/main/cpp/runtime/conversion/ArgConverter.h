@@ -63,9 +63,15 @@ namespace tns {
 
         static std::u16string ConvertToUtf16String(napi_env env, napi_value s);
 
+        // the UTF-8 of the string is only needed until the Java string is created
         inline static jstring ConvertToJavaString(napi_env env, napi_value jsValue) {
             JEnv jenv;
-            return jenv.NewStringUTF(napi_util::get_string_value(env, jsValue, 0));
+            size_t length = 0;
+            napi_get_value_string_utf8(env, jsValue, nullptr, 0, &length);
+            ConversionArena::Scope scope(Runtime::GetRuntime(env)->GetConversionArena());
+            auto buffer = scope.GetArena().Allocate<char>(length + 1);
+            napi_get_value_string_utf8(env, jsValue, buffer, length + 1, nullptr);
+            return jenv.NewStringUTF(buffer);
         }
 
         inline static napi_value convertToJsString(napi_env env, const jchar *data, int length) {
@@ -0,0 +1,59 @@
+#include "ConversionArena.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace tns;
+
+ConversionArena::ConversionArena()
+        : m_blocks(), m_block(0), m_offset(0) {
+}
+
+void* ConversionArena::Allocate(size_t size, size_t alignment) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    while (m_block < m_blocks.size()) {
+        auto& block = m_blocks[m_block];
+        auto start = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (start + size <= block.size) {
+            m_offset = start + size;
+            auto memory = block.data.get() + start;
+            memset(memory, 0, size);
+            return memory;
+        }
+        // the rest of the block waits for the scope to be closed
+        m_block++;
+        m_offset = 0;
+    }
+
+    // new[] memory is aligned for any type
+    auto blockSize = max(size, BLOCK_SIZE);
+    m_blocks.push_back({unique_ptr<char[]>(new char[blockSize]), blockSize});
+    m_block = m_blocks.size() - 1;
+    m_offset = size;
+    auto memory = m_blocks.back().data.get();
+    memset(memory, 0, size);
+    return memory;
+}
+
+void ConversionArena::Release(size_t block, size_t offset) {
+    m_block = block;
+    m_offset = offset;
+
+    // once no call converts, the blocks of big arrays go, those for the usual calls stay
+    if (block == 0 && offset == 0) {
+        m_blocks.erase(remove_if(m_blocks.begin(), m_blocks.end(), [](const Block& b) {
+            return b.size > BLOCK_SIZE;
+        }), m_blocks.end());
+    }
+}
+
+size_t ConversionArena::GetCapacity() const {
+    size_t capacity = 0;
+    for (auto& block: m_blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
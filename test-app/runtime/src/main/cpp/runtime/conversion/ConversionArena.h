@@ -0,0 +1,77 @@
+#ifndef CONVERSIONARENA_H_
+#define CONVERSIONARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace tns {
+/*
+ * Scratch memory of the argument converters of a runtime: the jvalues of a call, the local refs
+ * to delete after it and the elements of the arrays converted for it. The memory is bumped out
+ * of blocks that are kept between calls, a Scope hands back what was allocated in it, so calls
+ * made while another one converts, e.g. from a callback into JS, nest on top of it.
+ *
+ * Only for trivially destructible types, and not thread safe, like the runtime it belongs to.
+ */
+class ConversionArena {
+    public:
+        class Scope {
+            public:
+                explicit Scope(ConversionArena& arena)
+                    : m_arena(arena), m_block(arena.m_block), m_offset(arena.m_offset) {
+                }
+
+                ~Scope() {
+                    m_arena.Release(m_block, m_offset);
+                }
+
+                Scope(const Scope&) = delete;
+
+                Scope& operator=(const Scope&) = delete;
+
+                ConversionArena& GetArena() const {
+                    return m_arena;
+                }
+
+            private:
+                ConversionArena& m_arena;
+                size_t m_block;
+                size_t m_offset;
+        };
+
+        ConversionArena();
+
+        ConversionArena(const ConversionArena&) = delete;
+
+        ConversionArena& operator=(const ConversionArena&) = delete;
+
+        // zero filled, valid until the innermost open scope is closed
+        template<typename T>
+        T* Allocate(size_t count) {
+            return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void* Allocate(size_t size, size_t alignment);
+
+        // the bytes of the blocks kept for the next calls
+        size_t GetCapacity() const;
+
+        static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        void Release(size_t block, size_t offset);
+
+        std::vector<Block> m_blocks;
+        // where the next allocation goes, m_block == m_blocks.size() before the first one
+        size_t m_block;
+        size_t m_offset;
+};
+}
+
+#endif /* CONVERSIONARENA_H_ */
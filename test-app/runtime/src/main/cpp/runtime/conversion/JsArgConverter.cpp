@@ -11,22 +11,14 @@ using namespace std;
 using namespace tns;
 
 JsArgConverter::JsArgConverter(napi_env env, napi_value caller, napi_value *args, size_t argc,
-                               const std::string &methodSignature, MetadataEntry *entry)
-        : m_env(env), m_isValid(true), m_methodSignature(methodSignature), m_error(Error()) {
+                               const std::vector<std::string> &parsedSig)
+        : m_env(env), m_isValid(true), m_scope(Runtime::GetRuntime(env)->GetConversionArena()),
+          m_args(nullptr), m_args_refs(nullptr), m_tokens(&parsedSig), m_error(Error()) {
     int napiProvidedArgumentsLength = argc;
     m_argsLen = 1 + napiProvidedArgumentsLength;
 
     if (m_argsLen > 0) {
-        if ((entry != nullptr) && (entry->getIsResolved())) {
-            if (entry->parsedSig.empty()) {
-                JniSignatureParser parser(m_methodSignature);
-                entry->parsedSig = parser.Parse();
-            }
-            m_tokens = entry->parsedSig;
-        } else {
-            JniSignatureParser parser(m_methodSignature);
-            m_tokens = parser.Parse();
-        }
+        AllocateArgs();
 
         m_isValid = ConvertArg(env, caller, 0);
 
@@ -45,22 +37,14 @@ JsArgConverter::JsArgConverter(napi_env env, napi_value caller, napi_value *args
 }
 
 JsArgConverter::JsArgConverter(napi_env env, napi_value *args, size_t argc,
-                               bool hasImplementationObject, const std::string &methodSignature,
-                               MetadataEntry *entry)
-        : m_env(env), m_isValid(true), m_methodSignature(methodSignature), m_error(Error()) {
+                               bool hasImplementationObject,
+                               const std::vector<std::string> &parsedSig)
+        : m_env(env), m_isValid(true), m_scope(Runtime::GetRuntime(env)->GetConversionArena()),
+          m_args(nullptr), m_args_refs(nullptr), m_tokens(&parsedSig), m_error(Error()) {
     m_argsLen = !hasImplementationObject ? argc : argc - 1;
 
     if (m_argsLen > 0) {
-        if ((entry != nullptr) && (entry->getIsResolved())) {
-            if (entry->parsedSig.empty()) {
-                JniSignatureParser parser(m_methodSignature);
-                entry->parsedSig = parser.Parse();
-            }
-            m_tokens = entry->parsedSig;
-        } else {
-            JniSignatureParser parser(m_methodSignature);
-            m_tokens = parser.Parse();
-        }
+        AllocateArgs();
 
         for (size_t i = 0; i < m_argsLen; i++) {
             m_isValid = ConvertArg(env, args[i], i);
@@ -74,11 +58,13 @@ JsArgConverter::JsArgConverter(napi_env env, napi_value *args, size_t argc,
 
 JsArgConverter::JsArgConverter(napi_env env, napi_value *args, size_t argc,
                                const std::string &methodSignature)
-        : m_env(env), m_isValid(true), m_methodSignature(methodSignature), m_error(Error()) {
+        : m_env(env), m_isValid(true), m_scope(Runtime::GetRuntime(env)->GetConversionArena()),
+          m_args(nullptr), m_args_refs(nullptr), m_tokens(&m_parsedSig), m_error(Error()) {
     m_argsLen = argc;
 
-    JniSignatureParser parser(m_methodSignature);
-    m_tokens = parser.Parse();
+    JniSignatureParser parser(methodSignature);
+    m_parsedSig = parser.Parse();
+    AllocateArgs();
 
     for (size_t i = 0; i < m_argsLen; i++) {
         m_isValid = ConvertArg(env, args[i], i);
@@ -89,6 +75,12 @@ JsArgConverter::JsArgConverter(napi_env env, napi_value *args, size_t argc,
     }
 }
 
+void JsArgConverter::AllocateArgs() {
+    auto &arena = m_scope.GetArena();
+    m_args = arena.Allocate<jvalue>(m_argsLen);
+    m_args_refs = arena.Allocate<int>(m_argsLen);
+}
+
 tns::BufferCastType JsArgConverter::GetCastType(napi_typedarray_type type) {
     switch (type) {
         case napi_uint16_array:
@@ -114,7 +106,7 @@ bool JsArgConverter::ConvertArg(napi_env env, napi_value arg, int index) {
 
     char buff[1024];
 
-    const auto &typeSignature = m_tokens.at(index);
+    const auto &typeSignature = m_tokens->at(index);
 
     if (arg == nullptr) {
         SetConvertedObject(index, nullptr);
@@ -357,7 +349,7 @@ bool JsArgConverter::ConvertJavaScriptNumber(napi_env env, napi_value jsValue, i
 
     jvalue value = {0};
 
-    const auto &typeSignature = m_tokens.at(index);
+    const auto &typeSignature = m_tokens->at(index);
 
     const char typePrefix = typeSignature[0];
 
@@ -437,7 +429,7 @@ bool JsArgConverter::ConvertJavaScriptNumber(napi_env env, napi_value jsValue, i
 bool JsArgConverter::ConvertJavaScriptBoolean(napi_env env, napi_value jsValue, int index) {
     bool success;
 
-    const auto &typeSignature = m_tokens.at(index);
+    const auto &typeSignature = m_tokens->at(index);
 
     if (typeSignature == "Z") {
         bool argValue;
@@ -469,20 +461,24 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
 
     const jsize arrLength = jsLen;
 
-    const auto &arraySignature = m_tokens.at(index);
+    const auto &arraySignature = m_tokens->at(index);
 
-    std::string elementType = arraySignature.substr(1);
+    const char *elementType = arraySignature.c_str() + 1;
 
     const char elementTypePrefix = elementType[0];
 
     jclass elementClass;
     std::string strippedClassName;
 
+    // the elements are gone once they are copied to the Java array
+    ConversionArena::Scope scope(m_scope.GetArena());
+    auto &arena = scope.GetArena();
+
     JEnv jenv;
     switch (elementTypePrefix) {
         case 'Z': {
             arr = jenv.NewBooleanArray(arrLength);
-            std::vector<jboolean> bools(arrLength);
+            auto bools = arena.Allocate<jboolean>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -491,12 +487,12 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_bool(env, element, &boolValue);
                 bools[i] = (jboolean) boolValue;
             }
-            jenv.SetBooleanArrayRegion((jbooleanArray) arr, 0, arrLength, bools.data());
+            jenv.SetBooleanArrayRegion((jbooleanArray) arr, 0, arrLength, bools);
             break;
         }
         case 'B': {
             arr = jenv.NewByteArray(arrLength);
-            std::vector<jbyte> bytes(arrLength);
+            auto bytes = arena.Allocate<jbyte>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -504,27 +500,27 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_int32(env, element, &intValue);
                 bytes[i] = (jbyte) intValue;
             }
-            jenv.SetByteArrayRegion((jbyteArray) arr, 0, arrLength, bytes.data());
+            jenv.SetByteArrayRegion((jbyteArray) arr, 0, arrLength, bytes);
             break;
         }
         case 'C': {
             arr = jenv.NewCharArray(arrLength);
-            std::vector<jchar> chars(arrLength);
+            auto chars = arena.Allocate<jchar>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
+                // the first byte of the UTF-8 string is the char
+                char str[8] = {0};
                 size_t str_len;
-                napi_get_value_string_utf8(env, element, nullptr, 0, &str_len);
-                std::string str(str_len, '\0');
-                napi_get_value_string_utf8(env, element, &str[0], str_len + 1, &str_len);
+                napi_get_value_string_utf8(env, element, str, sizeof(str), &str_len);
                 chars[i] = (jchar) str[0];
             }
-            jenv.SetCharArrayRegion((jcharArray) arr, 0, arrLength, chars.data());
+            jenv.SetCharArrayRegion((jcharArray) arr, 0, arrLength, chars);
             break;
         }
         case 'S': {
             arr = jenv.NewShortArray(arrLength);
-            std::vector<jshort> shorts(arrLength);
+            auto shorts = arena.Allocate<jshort>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -532,12 +528,12 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_int32(env, element, &intValue);
                 shorts[i] = (jshort) intValue;
             }
-            jenv.SetShortArrayRegion((jshortArray) arr, 0, arrLength, shorts.data());
+            jenv.SetShortArrayRegion((jshortArray) arr, 0, arrLength, shorts);
             break;
         }
         case 'I': {
             arr = jenv.NewIntArray(arrLength);
-            std::vector<jint> ints(arrLength);
+            auto ints = arena.Allocate<jint>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -545,12 +541,12 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_int32(env, element, &intValue);
                 ints[i] = (jint) intValue;
             }
-            jenv.SetIntArrayRegion((jintArray) arr, 0, arrLength, ints.data());
+            jenv.SetIntArrayRegion((jintArray) arr, 0, arrLength, ints);
             break;
         }
         case 'J': {
             arr = jenv.NewLongArray(arrLength);
-            std::vector<jlong> longs(arrLength);
+            auto longs = arena.Allocate<jlong>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -558,12 +554,12 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_int64(env, element, &intValue);
                 longs[i] = (jlong) intValue;
             }
-            jenv.SetLongArrayRegion((jlongArray) arr, 0, arrLength, longs.data());
+            jenv.SetLongArrayRegion((jlongArray) arr, 0, arrLength, longs);
             break;
         }
         case 'F': {
             arr = jenv.NewFloatArray(arrLength);
-            std::vector<jfloat> floats(arrLength);
+            auto floats = arena.Allocate<jfloat>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -571,12 +567,12 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_double(env, element, &doubleValue);
                 floats[i] = (jfloat) doubleValue;
             }
-            jenv.SetFloatArrayRegion((jfloatArray) arr, 0, arrLength, floats.data());
+            jenv.SetFloatArrayRegion((jfloatArray) arr, 0, arrLength, floats);
             break;
         }
         case 'D': {
             arr = jenv.NewDoubleArray(arrLength);
-            std::vector<jdouble> doubles(arrLength);
+            auto doubles = arena.Allocate<jdouble>(arrLength);
             for (uint32_t i = 0; i < arrLength; i++) {
                 napi_value element;
                 napi_get_element(env, jsArr, i, &element);
@@ -584,11 +580,11 @@ bool JsArgConverter::ConvertJavaScriptArray(napi_env env, napi_value jsArr, int
                 napi_get_value_double(env, element, &doubleValue);
                 doubles[i] = (jdouble) doubleValue;
             }
-            jenv.SetDoubleArrayRegion((jdoubleArray) arr, 0, arrLength, doubles.data());
+            jenv.SetDoubleArrayRegion((jdoubleArray) arr, 0, arrLength, doubles);
             break;
         }
         case 'L':
-            strippedClassName = elementType.substr(1, elementType.length() - 2);
+            strippedClassName.assign(elementType + 1, strlen(elementType) - 2);
             elementClass = jenv.FindClass(strippedClassName);
             arr = jenv.NewObjectArray(arrLength, elementClass, nullptr);
             for (uint32_t i = 0; i < arrLength; i++) {
@@ -616,7 +612,7 @@ template<typename T>
 bool JsArgConverter::ConvertFromCastFunctionObject(T value, int index) {
     bool success = false;
 
-    const auto &typeSignature = m_tokens.at(index);
+    const auto &typeSignature = m_tokens->at(index);
 
     const char typeSignaturePrefix = typeSignature[0];
 
@@ -6,6 +6,7 @@
 #include "JEnv.h"
 #include "Runtime.h"
 #include "MetadataEntry.h"
+#include "ConversionArena.h"
 
 namespace tns {
 
@@ -21,14 +22,22 @@ namespace tns {
     class JsArgConverter {
     public:
 
-        JsArgConverter(napi_env env, napi_value caller, napi_value* args, size_t argc, const std::string& methodSignature, MetadataEntry* entry);
+        /*
+         * The parsed signatures are those cached for the method, see MetadataEntry::getParsedSig,
+         * they have to outlive the converter
+         */
+        JsArgConverter(napi_env env, napi_value caller, napi_value* args, size_t argc, const std::vector<std::string>& parsedSig);
 
-        JsArgConverter(napi_env env, napi_value* args, size_t argc, bool hasImplementationObject, const std::string& methodSignature, MetadataEntry* entry);
+        JsArgConverter(napi_env env, napi_value* args, size_t argc, bool hasImplementationObject, const std::vector<std::string>& parsedSig);
 
         JsArgConverter(napi_env env, napi_value* args, size_t argc, const std::string& methodSignature);
 
         ~JsArgConverter();
 
+        JsArgConverter(const JsArgConverter&) = delete;
+
+        JsArgConverter& operator=(const JsArgConverter&) = delete;
+
         jvalue* ToArgs();
 
         int Length() const;
@@ -63,6 +72,8 @@ namespace tns {
         static jmethodID AS_DOUBLE_BUFFER;
     private:
 
+        void AllocateArgs();
+
         bool ConvertArg(napi_env env, napi_value arg, int index);
 
         bool ConvertJavaScriptArray(napi_env env, napi_value jsArr, int index);
@@ -85,13 +96,16 @@ namespace tns {
 
         bool m_isValid;
 
-        jvalue m_args[255];
-        int m_args_refs[255];
+        // the jvalues and the indexes of those that are local refs, in the arena of the runtime
+        ConversionArena::Scope m_scope;
+        jvalue* m_args;
+        int* m_args_refs;
         int m_args_refs_size = 0;
 
-        std::string m_methodSignature;
+        const std::vector<std::string>* m_tokens;
 
-        std::vector<std::string> m_tokens;
+        // the tokens of a signature that was parsed for the call
+        std::vector<std::string> m_parsedSig;
 
         Error m_error;
     };
@@ -1,4 +1,6 @@
 #include "JsArgToArrayConverter.h"
+#include <cfloat>
+#include <climits>
 #include <sstream>
 #include "ObjectManager.h"
 #include "ArgConverter.h"
@@ -13,12 +15,12 @@ using namespace tns;
 
 JsArgToArrayConverter::JsArgToArrayConverter(napi_env env, napi_value arg,
                                              bool isImplementationObject, int classReturnType)
-        : m_arr(nullptr), m_argsAsObject(nullptr), m_argsLen(0), m_isValid(false), m_error(Error()),
-          m_return_type(classReturnType) {
+        : m_argsLen(0), m_return_type(classReturnType), m_isValid(false), m_error(Error()),
+          m_scope(Runtime::GetRuntime(env)->GetConversionArena()), m_storedIndexes(nullptr),
+          m_storedIndexesSize(0), m_argsAsObject(nullptr), m_arr(nullptr) {
     if (!isImplementationObject) {
         m_argsLen = 1;
-        m_argsAsObject = new jobject[m_argsLen];
-        memset(m_argsAsObject, 0, m_argsLen * sizeof(jobject));
+        AllocateArgs();
 
         m_isValid = ConvertArg(env, arg, 0);
     }
@@ -26,15 +28,15 @@ JsArgToArrayConverter::JsArgToArrayConverter(napi_env env, napi_value arg,
 
 JsArgToArrayConverter::JsArgToArrayConverter(napi_env env, size_t argc, napi_value *argv,
                                              bool hasImplementationObject)
-        : m_arr(nullptr), m_argsAsObject(nullptr), m_argsLen(0), m_isValid(false), m_error(Error()),
-          m_return_type(static_cast<int>(Type::Null)) {
+        : m_argsLen(0), m_return_type(static_cast<int>(Type::Null)), m_isValid(false),
+          m_error(Error()), m_scope(Runtime::GetRuntime(env)->GetConversionArena()),
+          m_storedIndexes(nullptr), m_storedIndexesSize(0), m_argsAsObject(nullptr), m_arr(nullptr) {
     m_argsLen = !hasImplementationObject ? argc : argc - 2;
 
     bool success = true;
 
     if (m_argsLen > 0) {
-        m_argsAsObject = new jobject[m_argsLen];
-        memset(m_argsAsObject, 0, m_argsLen * sizeof(jobject));
+        AllocateArgs();
 
         for (int i = 0; i < m_argsLen; i++) {
             success = ConvertArg(env, argv[i], i);
@@ -48,6 +50,12 @@ JsArgToArrayConverter::JsArgToArrayConverter(napi_env env, size_t argc, napi_val
     m_isValid = success;
 }
 
+void JsArgToArrayConverter::AllocateArgs() {
+    auto &arena = m_scope.GetArena();
+    m_argsAsObject = arena.Allocate<jobject>(m_argsLen);
+    m_storedIndexes = arena.Allocate<int>(m_argsLen);
+}
+
 bool JsArgToArrayConverter::ConvertArg(napi_env env, napi_value arg, int index) {
     bool success = false;
     stringstream s;
@@ -366,7 +374,7 @@ jobject JsArgToArrayConverter::GetConvertedArg() {
 void JsArgToArrayConverter::SetConvertedObject(JEnv &env, int index, jobject obj, bool isGlobal) {
     m_argsAsObject[index] = obj;
     if ((obj != nullptr) && !isGlobal) {
-        m_storedIndexes.push_back(index);
+        m_storedIndexes[m_storedIndexesSize++] = index;
     }
 }
 
@@ -416,13 +424,10 @@ JsArgToArrayConverter::~JsArgToArrayConverter() {
 
         env.DeleteGlobalRef(m_arr);
 
-        int length = m_storedIndexes.size();
-        for (int i = 0; i < length; i++) {
+        for (int i = 0; i < m_storedIndexesSize; i++) {
             int index = m_storedIndexes[i];
             env.DeleteLocalRef(m_argsAsObject[index]);
         }
-
-        delete[] m_argsAsObject;
     }
 }
 
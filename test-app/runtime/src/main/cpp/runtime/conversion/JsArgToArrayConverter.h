@@ -4,6 +4,7 @@
 #include "JEnv.h"
 #include "JniLocalRef.h"
 #include "js_native_api.h"
+#include "ConversionArena.h"
 #include <vector>
 #include <string>
 
@@ -16,6 +17,10 @@ class JsArgToArrayConverter {
 
         ~JsArgToArrayConverter();
 
+        JsArgToArrayConverter(const JsArgToArrayConverter&) = delete;
+
+        JsArgToArrayConverter& operator=(const JsArgToArrayConverter&) = delete;
+
         jobjectArray ToJavaArray();
 
         jobject GetConvertedArg();
@@ -38,6 +43,8 @@ class JsArgToArrayConverter {
         };
 
     private:
+        void AllocateArgs();
+
         bool ConvertArg(napi_env env, napi_value arg, int index);
 
         void SetConvertedObject(JEnv& env, int index, jobject obj, bool isGlobal = false);
@@ -50,7 +57,13 @@ class JsArgToArrayConverter {
 
         Error m_error;
 
-        std::vector<int> m_storedIndexes;
+        // the converted objects and the indexes of those that are local refs, in the arena of
+        // the runtime
+        ConversionArena::Scope m_scope;
+
+        int* m_storedIndexes;
+
+        int m_storedIndexesSize;
 
         jobject* m_argsAsObject;
 
@@ -3,6 +3,7 @@
 #include "ArgConverter.h"
 #include "NativeScriptAssert.h"
 #include "Runtime.h"
+#include "LogWriter.h"
 #include <sstream>
 
 using namespace std;
@@ -146,6 +147,9 @@ void NativeScriptException::OnUncaughtError(napi_env env, napi_value error) {
     string errorMessage = GetErrorMessage(env, error);
     string stackTrace = GetErrorStackTrace(env, error);
 
+    // the app is likely to crash, don't lose the console output that led to it
+    LogWriter::Flush(100);
+
     NativeScriptException e(errorMessage, stackTrace);
     e.ReThrowToJava(env);
 }
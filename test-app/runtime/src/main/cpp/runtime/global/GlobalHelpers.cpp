@@ -3,6 +3,7 @@
 #include "CallbackHandlers.h"
 #include "JEnv.h"
 #include "NativeScriptException.h"
+#include <cmath>
 #include <sstream>
 #include "robin_hood.h"
 #include "Util.h"
@@ -11,6 +12,7 @@
 using namespace std;
 
 static robin_hood::unordered_map<napi_env, napi_ref> envToPersistentSmartJSONStringify = robin_hood::unordered_map<napi_env, napi_ref>();
+static robin_hood::unordered_map<napi_env, napi_ref> envToPersistentJSONParse = robin_hood::unordered_map<napi_env, napi_ref>();
 
 napi_value GetSmartJSONStringifyFunction(napi_env env) {
     auto it = envToPersistentSmartJSONStringify.find(env);
@@ -73,13 +75,322 @@ napi_value GetSmartJSONStringifyFunction(napi_env env) {
 
 
 
+namespace {
+    // keeps the handles of a nested object from piling up, also when the conversion throws
+    class HandleScope {
+    public:
+        explicit HandleScope(napi_env env)
+                : m_env(env) {
+            napi_open_handle_scope(m_env, &m_scope);
+        }
+
+        ~HandleScope() {
+            napi_close_handle_scope(m_env, m_scope);
+        }
+
+    private:
+        napi_env m_env;
+        napi_handle_scope m_scope;
+    };
+
+    /*
+     * Writes the same text as JSON.stringify(value, null, 2) without calling into JS. Serialize
+     * returns false, leaving `out` as it was, when the value has something only JSON.stringify
+     * handles: an object that isn't a plain object or an array, a toJSON method, a BigInt or a
+     * nesting deeper than MAX_DEPTH, which is also where a circular structure ends up.
+     */
+    class NativeJsonWriter {
+    public:
+        NativeJsonWriter(napi_env env, std::string &out)
+                : m_env(env), m_out(out), m_objectPrototype(nullptr), m_arrayPrototype(nullptr) {
+        }
+
+        bool Serialize(napi_value value) {
+            napi_valuetype type;
+            napi_typeof(m_env, value, &type);
+            if (type != napi_object) {
+                return false;
+            }
+
+            napi_value object;
+            napi_get_named_property(m_env, napi_util::global(m_env), "Object", &object);
+            napi_get_named_property(m_env, object, "prototype", &m_objectPrototype);
+            napi_value array;
+            napi_get_named_property(m_env, napi_util::global(m_env), "Array", &array);
+            napi_get_named_property(m_env, array, "prototype", &m_arrayPrototype);
+
+            auto mark = m_out.size();
+            if (Write(value, 0) != Result::Written) {
+                m_out.resize(mark);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        enum class Result {
+            Written,
+            // undefined, functions and symbols, left out of objects and written as null in arrays
+            Skipped,
+            Unsupported
+        };
+
+        Result Write(napi_value value, int depth) {
+            napi_valuetype type;
+            napi_typeof(m_env, value, &type);
+            switch (type) {
+                case napi_undefined:
+                case napi_function:
+                case napi_symbol:
+                    return Result::Skipped;
+                case napi_null:
+                    m_out += "null";
+                    return Result::Written;
+                case napi_boolean: {
+                    bool b;
+                    napi_get_value_bool(m_env, value, &b);
+                    m_out += b ? "true" : "false";
+                    return Result::Written;
+                }
+                case napi_number:
+                    WriteNumber(value);
+                    return Result::Written;
+                case napi_string:
+                    WriteString(value);
+                    return Result::Written;
+                case napi_object:
+                    return WriteObject(value, depth);
+                default:
+                    return Result::Unsupported;
+            }
+        }
+
+        Result WriteObject(napi_value object, int depth) {
+            if (depth >= MAX_DEPTH) {
+                return Result::Unsupported;
+            }
+
+            napi_value prototype;
+            napi_get_prototype(m_env, object, &prototype);
+            bool isArray = false;
+            napi_is_array(m_env, object, &isArray);
+            if (!StrictEquals(prototype, isArray ? m_arrayPrototype : m_objectPrototype) &&
+                (isArray || !napi_util::is_null(m_env, prototype))) {
+                return Result::Unsupported;
+            }
+
+            bool hasToJSON = false;
+            napi_has_named_property(m_env, object, "toJSON", &hasToJSON);
+            if (hasToJSON) {
+                return Result::Unsupported;
+            }
+
+            HandleScope scope(m_env);
+            return isArray ? WriteArrayItems(object, depth) : WriteObjectProperties(object, depth);
+        }
+
+        Result WriteArrayItems(napi_value array, int depth) {
+            uint32_t length;
+            napi_get_array_length(m_env, array, &length);
+            if (length == 0) {
+                m_out += "[]";
+                return Result::Written;
+            }
+
+            m_out += '[';
+            for (uint32_t i = 0; i < length; i++) {
+                if (i > 0) {
+                    m_out += ',';
+                }
+                NewLine(depth + 1);
+
+                napi_value item;
+                Check(napi_get_element(m_env, array, i, &item));
+                auto result = Write(item, depth + 1);
+                if (result == Result::Unsupported) {
+                    return result;
+                } else if (result == Result::Skipped) {
+                    m_out += "null";
+                }
+            }
+            NewLine(depth);
+            m_out += ']';
+            return Result::Written;
+        }
+
+        Result WriteObjectProperties(napi_value object, int depth) {
+            napi_value keys;
+            Check(napi_get_all_property_names(m_env, object, napi_key_own_only,
+                                              static_cast<napi_key_filter>(napi_key_enumerable | napi_key_skip_symbols),
+                                              napi_key_numbers_to_strings, &keys));
+            uint32_t length;
+            napi_get_array_length(m_env, keys, &length);
+
+            m_out += '{';
+            bool empty = true;
+            for (uint32_t i = 0; i < length; i++) {
+                napi_value key, value;
+                napi_get_element(m_env, keys, i, &key);
+                Check(napi_get_property(m_env, object, key, &value));
+
+                auto mark = m_out.size();
+                if (!empty) {
+                    m_out += ',';
+                }
+                NewLine(depth + 1);
+                WriteString(key);
+                m_out += ": ";
+
+                auto result = Write(value, depth + 1);
+                if (result == Result::Unsupported) {
+                    return result;
+                } else if (result == Result::Skipped) {
+                    m_out.resize(mark);
+                } else {
+                    empty = false;
+                }
+            }
+            if (!empty) {
+                NewLine(depth);
+            }
+            m_out += '}';
+            return Result::Written;
+        }
+
+        void WriteNumber(napi_value value) {
+            double number;
+            napi_get_value_double(m_env, value, &number);
+            if (!std::isfinite(number)) {
+                m_out += "null";
+                return;
+            }
+
+            // integers print the same in every engine, the other doubles are formatted by the engine
+            if (std::fabs(number) <= 9007199254740992.0 && number == std::floor(number)) {
+                char buffer[24];
+                auto length = snprintf(buffer, sizeof(buffer), "%lld", (long long) number);
+                m_out.append(buffer, length);
+            } else {
+                napi_value string;
+                napi_coerce_to_string(m_env, value, &string);
+                size_t length;
+                napi_get_value_string_utf8(m_env, string, nullptr, 0, &length);
+                auto start = m_out.size();
+                m_out.resize(start + length + 1);
+                napi_get_value_string_utf8(m_env, string, &m_out[start], length + 1, &length);
+                m_out.resize(start + length);
+            }
+        }
+
+        void WriteString(napi_value value) {
+            size_t length;
+            napi_get_value_string_utf16(m_env, value, nullptr, 0, &length);
+            m_chars.resize(length + 1);
+            napi_get_value_string_utf16(m_env, value, m_chars.data(), length + 1, &length);
+
+            static const char hex[] = "0123456789abcdef";
+            m_out += '"';
+            for (size_t i = 0; i < length; i++) {
+                char16_t c = m_chars[i];
+                if (c >= 0x20 && c < 0x80) {
+                    if (c == '"' || c == '\\') {
+                        m_out += '\\';
+                    }
+                    m_out += (char) c;
+                } else if (c < 0x20) {
+                    switch (c) {
+                        case '\b': m_out += "\\b"; break;
+                        case '\f': m_out += "\\f"; break;
+                        case '\n': m_out += "\\n"; break;
+                        case '\r': m_out += "\\r"; break;
+                        case '\t': m_out += "\\t"; break;
+                        default:
+                            m_out += "\\u00";
+                            m_out += hex[c >> 4];
+                            m_out += hex[c & 0xf];
+                    }
+                } else if (c < 0x800) {
+                    m_out += (char) (0xc0 | (c >> 6));
+                    m_out += (char) (0x80 | (c & 0x3f));
+                } else if (c >= 0xd800 && c <= 0xdfff) {
+                    if (c <= 0xdbff && i + 1 < length && m_chars[i + 1] >= 0xdc00 && m_chars[i + 1] <= 0xdfff) {
+                        uint32_t codePoint = 0x10000 + ((c - 0xd800) << 10) + (m_chars[++i] - 0xdc00);
+                        m_out += (char) (0xf0 | (codePoint >> 18));
+                        m_out += (char) (0x80 | ((codePoint >> 12) & 0x3f));
+                        m_out += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+                        m_out += (char) (0x80 | (codePoint & 0x3f));
+                    } else {
+                        // lone surrogates are escaped, as JSON.stringify does
+                        m_out += "\\u";
+                        m_out += hex[c >> 12];
+                        m_out += hex[(c >> 8) & 0xf];
+                        m_out += hex[(c >> 4) & 0xf];
+                        m_out += hex[c & 0xf];
+                    }
+                } else {
+                    m_out += (char) (0xe0 | (c >> 12));
+                    m_out += (char) (0x80 | ((c >> 6) & 0x3f));
+                    m_out += (char) (0x80 | (c & 0x3f));
+                }
+            }
+            m_out += '"';
+        }
+
+        void NewLine(int depth) {
+            m_out += '\n';
+            m_out.append(depth * INDENT, ' ');
+        }
+
+        bool StrictEquals(napi_value a, napi_value b) {
+            bool equals = false;
+            napi_strict_equals(m_env, a, b, &equals);
+            return equals;
+        }
+
+        // a throwing getter or proxy trap fails the conversion, as it would in JSON.stringify
+        void Check(napi_status status) {
+            if (status == napi_ok) {
+                return;
+            }
+            napi_value exception;
+            napi_get_and_clear_last_exception(m_env, &exception);
+            if (!napi_util::is_null_or_undefined(m_env, exception)) {
+                throw tns::NativeScriptException(m_env, exception, "Error converting object to json");
+            }
+            throw tns::NativeScriptException("Error converting object to json");
+        }
+
+        static const int INDENT = 2;
+        static const int MAX_DEPTH = 128;
+
+        napi_env m_env;
+        std::string &m_out;
+        napi_value m_objectPrototype;
+        napi_value m_arrayPrototype;
+        std::vector<char16_t> m_chars;
+    };
+}
+
 std::string tns::JsonStringifyObject(napi_env env, napi_value value, bool handleCircularReferences) {
+    std::string result;
+    JsonStringifyObject(env, value, result, handleCircularReferences);
+    return result;
+}
+
+void tns::JsonStringifyObject(napi_env env, napi_value value, std::string &out, bool handleCircularReferences) {
     if (value == nullptr) {
-        return "";
+        return;
+    }
+
+    // the "[Circular]" replacer, which also replaces repeated references, is left to JS
+    if (!handleCircularReferences) {
+        NativeJsonWriter writer(env, out);
+        if (writer.Serialize(value)) {
+            return;
+        }
     }
 
     napi_value smartJSONStringifyFunction = GetSmartJSONStringifyFunction(env);
-    std::string result;
     if (smartJSONStringifyFunction != nullptr) {
         napi_value resultValue;
         napi_value args[2];
@@ -95,25 +406,45 @@ std::string tns::JsonStringifyObject(napi_env env, napi_value value, bool handle
                 throw NativeScriptException("Error converting object to json");
             }
         }
-        result = ArgConverter::ConvertToString(env, resultValue);
+        out += ArgConverter::ConvertToString(env, resultValue);
     }
-
-    return result;
 }
 
-napi_value tns::JsonParseString(napi_env env, const std::string& value) {
-    napi_value global;
+static napi_value GetJSONParseFunction(napi_env env) {
+    auto it = envToPersistentJSONParse.find(env);
+    if (it != envToPersistentJSONParse.end()) {
+        napi_value parse;
+        napi_get_reference_value(env, it->second, &parse);
+        return parse;
+    }
+
     napi_value json;
     napi_value parse;
-
-    napi_get_global(env, &global);
-    napi_get_named_property(env, global, "JSON", &json);
+    napi_get_named_property(env, napi_util::global(env), "JSON", &json);
     napi_get_named_property(env, json, "parse", &parse);
 
+    napi_ref parseRef;
+    napi_create_reference(env, parse, 1, &parseRef);
+    envToPersistentJSONParse.emplace(env, parseRef);
+
+    return parse;
+}
+
+napi_value tns::JsonParseString(napi_env env, const std::string& value) {
+    return JsonParseString(env, value.data(), value.length());
+}
+
+napi_value tns::JsonParseString(napi_env env, const char *data, size_t length) {
+    napi_value jsonString;
+    napi_create_string_utf8(env, data, length, &jsonString);
+    return JsonParseString(env, jsonString);
+}
+
+napi_value tns::JsonParseString(napi_env env, napi_value jsonString) {
     napi_value args[1];
-    args[0] = ArgConverter::convertToJsString(env, value);
+    args[0] = jsonString;
     napi_value result;
-    napi_status status = napi_call_function(env, json, parse, 1, args, &result);
+    napi_status status = napi_call_function(env, napi_util::global(env), GetJSONParseFunction(env), 1, args, &result);
     if (status != napi_ok) {
         napi_value exception;
         napi_get_and_clear_last_exception(env, &exception);
@@ -192,4 +523,10 @@ void tns::GlobalHelpers::onDisposeEnv(napi_env env) {
         napi_delete_reference(env, found->second);
     }
     envToPersistentSmartJSONStringify.erase(env);
+
+    found = envToPersistentJSONParse.find(env);
+    if (found != envToPersistentJSONParse.end()) {
+        napi_delete_reference(env, found->second);
+    }
+    envToPersistentJSONParse.erase(env);
 }
\ No newline at end of file
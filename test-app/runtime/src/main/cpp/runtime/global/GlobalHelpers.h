@@ -6,12 +6,23 @@
 #include <string>
 #include <map>
 #include <utility>
+#include <vector>
 
 namespace tns {
 std::string JsonStringifyObject(napi_env env, napi_value value, bool handleCircularReferences = true);
 
+/*
+ * Appends the JSON of `value` to `out`. Plain objects, arrays and primitives are written natively,
+ * anything else (class instances, toJSON, BigInt, very deep nesting) goes through JSON.stringify.
+ */
+void JsonStringifyObject(napi_env env, napi_value value, std::string &out, bool handleCircularReferences = true);
+
 napi_value JsonParseString(napi_env env, const std::string& value);
 
+napi_value JsonParseString(napi_env env, const char *data, size_t length);
+
+napi_value JsonParseString(napi_env env, napi_value jsonString);
+
 struct JsStacktraceFrame {
     JsStacktraceFrame(): line(0), col(0) {}
     JsStacktraceFrame(
@@ -0,0 +1,321 @@
+#include "CallStats.h"
+#include "ArgConverter.h"
+#include "NativeScriptException.h"
+#include "native_api_util.h"
+#include <algorithm>
+#include <android/log.h>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+
+using namespace tns;
+using namespace tns::instrumentation;
+using namespace std;
+
+namespace tns {
+namespace instrumentation {
+    // Merges the counters of an exiting thread into the retired table
+    struct ThreadTableOwner {
+        CallStats::Table *table = nullptr;
+
+        ~ThreadTableOwner() {
+            if (table == nullptr) {
+                return;
+            }
+            lock_guard<mutex> lock(CallStats::s_mutex);
+            auto &tables = CallStats::s_tables;
+            tables.erase(std::remove(tables.begin(), tables.end(), table), tables.end());
+            CallStats::Merge(*table, CallStats::s_retired);
+            delete table;
+        }
+    };
+}
+}
+
+namespace {
+    thread_local ThreadTableOwner t_owner;
+
+    void Add(CallStats::Counters &to, const CallStats::Counters &from) {
+        to.calls += from.calls;
+        to.exceptions += from.exceptions;
+        to.totalNs += from.totalNs;
+        to.maxNs = std::max(to.maxNs, from.maxNs);
+        to.convertNs += from.convertNs;
+        to.callNs += from.callNs;
+    }
+
+    napi_value ToMs(napi_env env, int64_t ns) {
+        napi_value result;
+        napi_create_double(env, ns / 1e6, &result);
+        return result;
+    }
+
+    napi_value ToNumber(napi_env env, uint64_t value) {
+        napi_value result;
+        napi_create_double(env, (double) value, &result);
+        return result;
+    }
+
+    size_t GetTop(napi_env env, size_t argc, napi_value *argv) {
+        if (argc > 0 && napi_util::is_of_type(env, argv[0], napi_number)) {
+            int64_t top;
+            napi_get_value_int64(env, argv[0], &top);
+            if (top > 0) {
+                return (size_t) top;
+            }
+        }
+        return 20;
+    }
+}
+
+int64_t CallStats::NowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+CallStats::Table *CallStats::GetThreadTable() {
+    if (t_owner.table == nullptr) {
+        auto table = new Table();
+        lock_guard<mutex> lock(s_mutex);
+        s_tables.push_back(table);
+        t_owner.table = table;
+    }
+    return t_owner.table;
+}
+
+CallStats::Record &CallStats::GetJavaRecord(Table *table, jmethodID mid, const string &className,
+                                            const string &methodName, const string &signature) {
+    lock_guard<mutex> lock(table->mutex);
+    auto it = table->javaMethods.find(mid);
+    if (it == table->javaMethods.end()) {
+        auto name = className + "." + methodName + signature;
+        std::replace(name.begin(), name.begin() + className.size(), '/', '.');
+        it = table->javaMethods.emplace(mid, Record{std::move(name), {}}).first;
+    }
+    return it->second;
+}
+
+CallStats::Record &CallStats::GetJsRecord(Table *table, const string &methodName) {
+    lock_guard<mutex> lock(table->mutex);
+    auto it = table->jsMethods.find(methodName);
+    if (it == table->jsMethods.end()) {
+        it = table->jsMethods.emplace(methodName, Record{methodName, {}}).first;
+    }
+    return it->second;
+}
+
+void CallStats::Merge(Table &from, Table &to) {
+    for (auto &it: from.javaMethods) {
+        auto &record = to.javaMethods[it.first];
+        if (record.name.empty()) {
+            record.name = it.second.name;
+        }
+        Add(record.counters, it.second.counters);
+    }
+    for (auto &it: from.jsMethods) {
+        auto &record = to.jsMethods[it.first];
+        if (record.name.empty()) {
+            record.name = it.second.name;
+        }
+        Add(record.counters, it.second.counters);
+    }
+}
+
+void CallStats::Start() {
+    lock_guard<mutex> lock(s_mutex);
+    // records are referenced by the scopes in flight, only their counters are reset
+    auto reset = [](Table &table) {
+        lock_guard<mutex> tableLock(table.mutex);
+        for (auto &it: table.javaMethods) {
+            it.second.counters = {};
+        }
+        for (auto &it: table.jsMethods) {
+            it.second.counters = {};
+        }
+    };
+    for (auto table: s_tables) {
+        reset(*table);
+    }
+    s_retired.javaMethods.clear();
+    s_retired.jsMethods.clear();
+    s_enabled.store(true, std::memory_order_release);
+}
+
+void CallStats::Stop() {
+    s_enabled.store(false, std::memory_order_release);
+}
+
+vector<CallStats::Report> CallStats::GetReport(size_t top) {
+    Table merged;
+    {
+        lock_guard<mutex> lock(s_mutex);
+        Merge(s_retired, merged);
+        for (auto table: s_tables) {
+            lock_guard<mutex> tableLock(table->mutex);
+            Merge(*table, merged);
+        }
+    }
+
+    vector<Report> report;
+    report.reserve(merged.javaMethods.size() + merged.jsMethods.size());
+    for (auto &it: merged.javaMethods) {
+        if (it.second.counters.calls > 0) {
+            report.push_back(Report{std::move(it.second.name), true, it.second.counters});
+        }
+    }
+    for (auto &it: merged.jsMethods) {
+        if (it.second.counters.calls > 0) {
+            report.push_back(Report{std::move(it.second.name), false, it.second.counters});
+        }
+    }
+
+    auto byTotal = [](const Report &a, const Report &b) {
+        return a.counters.totalNs > b.counters.totalNs;
+    };
+    if (report.size() > top) {
+        std::partial_sort(report.begin(), report.begin() + top, report.end(), byTotal);
+        report.resize(top);
+    } else {
+        std::sort(report.begin(), report.end(), byTotal);
+    }
+
+    return report;
+}
+
+bool CallStats::Dump(size_t top, const std::string &path) {
+    auto report = GetReport(top);
+
+    FILE *file = nullptr;
+    if (!path.empty()) {
+        file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+    }
+
+    char line[128];
+    snprintf(line, sizeof(line), "%10s %12s %10s %12s %12s %6s  %s",
+             "calls", "total ms", "max ms", "convert ms", "call ms", "throws", "method");
+    for (size_t i = 0; i <= report.size(); i++) {
+        if (i > 0) {
+            auto &c = report[i - 1].counters;
+            snprintf(line, sizeof(line), "%10llu %12.3f %10.3f %12.3f %12.3f %6llu  %s ",
+                     (unsigned long long) c.calls, c.totalNs / 1e6, c.maxNs / 1e6,
+                     c.convertNs / 1e6, c.callNs / 1e6, (unsigned long long) c.exceptions,
+                     report[i - 1].isJavaMethod ? "js -> java" : "java -> js");
+        }
+
+        if (file != nullptr) {
+            fputs(line, file);
+            if (i > 0) {
+                fputs(report[i - 1].name.c_str(), file);
+            }
+            fputc('\n', file);
+        } else {
+            __android_log_print(ANDROID_LOG_INFO, "TNS.CallStats", "%s%s", line,
+                                i > 0 ? report[i - 1].name.c_str() : "");
+        }
+    }
+
+    return file == nullptr || fclose(file) == 0;
+}
+
+CallStatsScope::~CallStatsScope() {
+    if (m_record == nullptr) {
+        return;
+    }
+
+    auto endNs = CallStats::NowNs();
+    auto convertedNs = m_convertedNs != 0 ? m_convertedNs : endNs;
+    auto totalNs = endNs - m_startNs;
+
+    lock_guard<mutex> lock(m_table->mutex);
+    auto &counters = m_record->counters;
+    counters.calls++;
+    counters.totalNs += totalNs;
+    counters.maxNs = std::max(counters.maxNs, totalNs);
+    counters.convertNs += convertedNs - m_startNs;
+    counters.callNs += endNs - convertedNs;
+    if (std::uncaught_exceptions() > m_exceptions) {
+        counters.exceptions++;
+    }
+}
+
+void CallStats::Init(napi_env env, napi_value global) {
+    napi_util::napi_set_function(env, global, "__startCallStats", StartCallStatsCallback, nullptr);
+    napi_util::napi_set_function(env, global, "__stopCallStats", StopCallStatsCallback, nullptr);
+    napi_util::napi_set_function(env, global, "__getCallStats", GetCallStatsCallback, nullptr);
+    napi_util::napi_set_function(env, global, "__dumpCallStats", DumpCallStatsCallback, nullptr);
+}
+
+napi_value CallStats::StartCallStatsCallback(napi_env env, napi_callback_info info) {
+    Start();
+    return nullptr;
+}
+
+napi_value CallStats::StopCallStatsCallback(napi_env env, napi_callback_info info) {
+    Stop();
+    return nullptr;
+}
+
+napi_value CallStats::GetCallStatsCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+    auto report = GetReport(GetTop(env, argc, argv));
+
+    napi_value result;
+    napi_create_array_with_length(env, report.size(), &result);
+    for (size_t i = 0; i < report.size(); i++) {
+        auto &c = report[i].counters;
+        napi_value entry;
+        napi_create_object(env, &entry);
+        napi_set_named_property(env, entry, "name", ArgConverter::convertToJsString(env, report[i].name));
+        napi_set_named_property(env, entry, "direction", ArgConverter::convertToJsString(
+                env, report[i].isJavaMethod ? "js-to-java" : "java-to-js"));
+        napi_set_named_property(env, entry, "calls", ToNumber(env, c.calls));
+        napi_set_named_property(env, entry, "totalTime", ToMs(env, c.totalNs));
+        napi_set_named_property(env, entry, "maxTime", ToMs(env, c.maxNs));
+        napi_set_named_property(env, entry, "conversionTime", ToMs(env, c.convertNs));
+        napi_set_named_property(env, entry, "callTime", ToMs(env, c.callNs));
+        napi_set_named_property(env, entry, "exceptions", ToNumber(env, c.exceptions));
+        napi_set_element(env, result, i, entry);
+    }
+
+    return result;
+}
+
+napi_value CallStats::DumpCallStatsCallback(napi_env env, napi_callback_info info) {
+    try {
+        size_t argc = 2;
+        napi_value argv[2];
+        napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+        string path;
+        if (argc > 1 && napi_util::is_of_type(env, argv[1], napi_string)) {
+            path = ArgConverter::ConvertToString(env, argv[1]);
+        }
+
+        if (!Dump(GetTop(env, argc, argv), path)) {
+            throw NativeScriptException("Cannot write call stats to: " + path);
+        }
+    } catch (NativeScriptException &e) {
+        e.ReThrowToNapi(env);
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToNapi(env);
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToNapi(env);
+    }
+    return nullptr;
+}
+
+std::atomic<bool> CallStats::s_enabled(false);
+std::mutex CallStats::s_mutex;
+std::vector<CallStats::Table *> CallStats::s_tables;
+CallStats::Table CallStats::s_retired;
@@ -0,0 +1,157 @@
+#ifndef CALLSTATS_H
+#define CALLSTATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "jni.h"
+#include "js_native_api.h"
+#include "robin_hood.h"
+
+namespace tns {
+namespace instrumentation {
+
+    /*
+     * Optional per method statistics of the JS -> Java (CallJavaMethod) and Java -> JS
+     * (CallJSMethod) bridges: number of calls, total and max time, the part of it spent in argument
+     * conversion vs. the call itself and the number of calls that threw.
+     *
+     * Every thread counts in its own table, tables are merged when the stats are requested.
+     * Java methods are keyed by their jmethodID, JS methods by name.
+     *
+     * From JS: `__startCallStats()` (resets the counters), `__stopCallStats()`,
+     * `__getCallStats(top?)` and `__dumpCallStats(top?, path?)` which logs the report or writes it
+     * to a file.
+     */
+    class CallStats {
+    public:
+        struct Counters {
+            uint64_t calls;
+            uint64_t exceptions;
+            int64_t totalNs;
+            int64_t maxNs;
+            int64_t convertNs;
+            int64_t callNs;
+        };
+
+        struct Report {
+            std::string name;
+            bool isJavaMethod;
+            Counters counters;
+        };
+
+        static inline bool IsEnabled() {
+            return s_enabled.load(std::memory_order_relaxed);
+        }
+
+        static void Start();
+
+        static void Stop();
+
+        /*
+         * The merged counters of all threads, ordered by total time
+         */
+        static std::vector<Report> GetReport(size_t top);
+
+        static bool Dump(size_t top, const std::string &path);
+
+        static void Init(napi_env env, napi_value global);
+
+        static int64_t NowNs();
+
+    private:
+        struct Record {
+            std::string name;
+            Counters counters;
+        };
+
+        struct Table {
+            std::mutex mutex;
+            robin_hood::unordered_node_map<jmethodID, Record> javaMethods;
+            robin_hood::unordered_node_map<std::string, Record> jsMethods;
+        };
+
+        static Table *GetThreadTable();
+
+        static void Merge(Table &from, Table &to);
+
+        static Record &GetJavaRecord(Table *table, jmethodID mid, const std::string &className,
+                                     const std::string &methodName, const std::string &signature);
+
+        static Record &GetJsRecord(Table *table, const std::string &methodName);
+
+        static napi_value StartCallStatsCallback(napi_env env, napi_callback_info info);
+
+        static napi_value StopCallStatsCallback(napi_env env, napi_callback_info info);
+
+        static napi_value GetCallStatsCallback(napi_env env, napi_callback_info info);
+
+        static napi_value DumpCallStatsCallback(napi_env env, napi_callback_info info);
+
+        static std::atomic<bool> s_enabled;
+        static std::mutex s_mutex;
+        static std::vector<Table *> s_tables;
+        // counters of the threads that exited
+        static Table s_retired;
+
+        friend class CallStatsScope;
+        friend struct ThreadTableOwner;
+    };
+
+    /*
+     * Measures one bridge call, the counters are updated when the scope ends
+     */
+    class CallStatsScope {
+    public:
+        inline CallStatsScope()
+                : m_record(nullptr), m_table(nullptr), m_startNs(0), m_convertedNs(0),
+                  m_exceptions(0) {
+            if (CallStats::IsEnabled()) {
+                m_table = CallStats::GetThreadTable();
+                m_startNs = CallStats::NowNs();
+                m_exceptions = std::uncaught_exceptions();
+            }
+        }
+
+        inline void SetJavaMethod(jmethodID mid, const std::string &className,
+                                  const std::string &methodName, const std::string &signature) {
+            if (m_table != nullptr) {
+                m_record = &CallStats::GetJavaRecord(m_table, mid, className, methodName, signature);
+            }
+        }
+
+        inline void SetJsMethod(const std::string &methodName) {
+            if (m_table != nullptr) {
+                m_record = &CallStats::GetJsRecord(m_table, methodName);
+            }
+        }
+
+        /*
+         * The arguments are converted, the rest of the scope is the call
+         */
+        inline void Converted() {
+            if (m_table != nullptr) {
+                m_convertedNs = CallStats::NowNs();
+            }
+        }
+
+        ~CallStatsScope();
+
+    private:
+        CallStats::Record *m_record;
+        CallStats::Table *m_table;
+        int64_t m_startNs;
+        int64_t m_convertedNs;
+        int m_exceptions;
+
+        CallStatsScope(const CallStatsScope &) = delete;
+        CallStatsScope &operator=(const CallStatsScope &) = delete;
+    };
+
+}
+}
+
+#endif //CALLSTATS_H
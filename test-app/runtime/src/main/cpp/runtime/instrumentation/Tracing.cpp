@@ -0,0 +1,338 @@
+#include "Tracing.h"
+#include "ArgConverter.h"
+#include "Constants.h"
+#include "NativeScriptException.h"
+#include "native_api_util.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+using namespace tns;
+using namespace tns::instrumentation;
+using namespace std;
+
+struct Tracing::ThreadBuffer {
+    // number of events ever written, only the owning thread writes
+    std::atomic<uint64_t> head;
+    std::atomic<bool> inUse;
+    int32_t tid;
+    char threadName[16];
+    ThreadBuffer *next;
+    Event events[BUFFER_SIZE];
+};
+
+// A copy of an event taken while its thread may still be tracing
+struct Tracing::Record {
+    int64_t timestampNs;
+    const char *name;
+    int64_t value;
+    int32_t tid;
+    char phase;
+    char arg[sizeof(Event::arg)];
+};
+
+namespace {
+    int64_t NowNs() {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec;
+    }
+
+    // Releases the buffer of an exiting thread for reuse by the next thread that traces
+    struct BufferOwner {
+        std::atomic<bool> *inUse = nullptr;
+
+        ~BufferOwner() {
+            if (inUse != nullptr) {
+                inUse->store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local BufferOwner t_owner;
+
+    void WriteEscaped(FILE *file, const char *str) {
+        for (; *str != '\0'; str++) {
+            auto c = (unsigned char) *str;
+            if (c == '"' || c == '\\') {
+                fputc('\\', file);
+                fputc(c, file);
+            } else if (c < 0x20) {
+                fprintf(file, "\\u%04x", c);
+            } else {
+                fputc(c, file);
+            }
+        }
+    }
+}
+
+bool Tracing::ReadEvent(const Event &event, uint64_t index, std::vector<Record> &records) {
+    auto sequence = (uint32_t) (2 * (index + 1));
+    if (event.sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+
+    records.emplace_back();
+    auto &record = records.back();
+    record.timestampNs = event.timestampNs;
+    record.name = event.name;
+    record.value = event.value;
+    record.tid = event.tid;
+    record.phase = event.phase;
+    memcpy(record.arg, event.arg, sizeof(record.arg));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (event.sequence.load(std::memory_order_relaxed) != sequence) {
+        records.pop_back();
+        return false;
+    }
+
+    return true;
+}
+
+Tracing::ThreadBuffer *Tracing::GetThreadBuffer() {
+    static thread_local ThreadBuffer *t_buffer = nullptr;
+    if (t_buffer != nullptr) {
+        return t_buffer;
+    }
+
+    ThreadBuffer *buffer = nullptr;
+    for (auto it = s_buffers.load(std::memory_order_acquire); it != nullptr; it = it->next) {
+        bool inUse = false;
+        if (it->inUse.compare_exchange_strong(inUse, true, std::memory_order_acq_rel)) {
+            buffer = it;
+            break;
+        }
+    }
+
+    if (buffer == nullptr) {
+        buffer = new ThreadBuffer();
+        buffer->head.store(0, std::memory_order_relaxed);
+        buffer->inUse.store(true, std::memory_order_relaxed);
+        buffer->next = s_buffers.load(std::memory_order_relaxed);
+        while (!s_buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+        }
+    }
+
+    buffer->tid = gettid();
+    memset(buffer->threadName, 0, sizeof(buffer->threadName));
+    prctl(PR_GET_NAME, buffer->threadName);
+
+    t_owner.inUse = &buffer->inUse;
+    t_buffer = buffer;
+    return buffer;
+}
+
+void Tracing::Emit(char phase, const char *name, int64_t value, const char *arg, size_t argLength) {
+    auto buffer = GetThreadBuffer();
+    auto head = buffer->head.load(std::memory_order_relaxed);
+    auto &event = buffer->events[head % BUFFER_SIZE];
+
+    // Stop reads the slot from another thread, it skips it while the sequence is odd or changed
+    event.sequence.store((uint32_t) (2 * head + 1), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.timestampNs = NowNs();
+    event.name = name;
+    event.value = value;
+    event.tid = buffer->tid;
+    event.phase = phase;
+    if (arg != nullptr && argLength == 0) {
+        argLength = strlen(arg);
+    }
+    if (argLength >= sizeof(event.arg)) {
+        // keep the end, it's the part that tells module paths apart
+        arg += argLength - (sizeof(event.arg) - 1);
+        argLength = sizeof(event.arg) - 1;
+    }
+    if (argLength > 0) {
+        memcpy(event.arg, arg, argLength);
+    }
+    event.arg[argLength] = '\0';
+
+    event.sequence.store((uint32_t) (2 * (head + 1)), std::memory_order_release);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracing::Start() {
+    s_startNs.store(NowNs(), std::memory_order_relaxed);
+    s_enabled.store(true, std::memory_order_release);
+}
+
+bool Tracing::Stop(const std::string &path) {
+    s_enabled.store(false, std::memory_order_release);
+    auto stopNs = NowNs();
+
+    auto file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    auto startNs = s_startNs.load(std::memory_order_relaxed);
+    auto pid = getpid();
+    bool first = true;
+
+    std::vector<Record> records;
+    std::vector<size_t> open;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    for (auto buffer = s_buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        auto head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = head > BUFFER_SIZE ? head - BUFFER_SIZE : 0;
+
+        records.clear();
+        open.clear();
+        for (auto i = begin; i < head; i++) {
+            if (!ReadEvent(buffer->events[i % BUFFER_SIZE], i, records)) {
+                // overwritten by a thread that kept tracing, as are the events before it
+                records.clear();
+                open.clear();
+                continue;
+            }
+
+            auto &record = records.back();
+            if (record.timestampNs < startNs || record.timestampNs > stopNs) {
+                records.pop_back();
+                continue;
+            }
+
+            // slices must begin and end within the trace, an end without its begin is dropped
+            // here and a begin without its end after the loop
+            if (record.phase == 'B') {
+                open.push_back(records.size() - 1);
+            } else if (record.phase == 'E') {
+                if (open.empty()) {
+                    records.pop_back();
+                } else {
+                    open.pop_back();
+                }
+            }
+        }
+        for (auto index : open) {
+            records[index].phase = '\0';
+        }
+
+        bool hasEvents = false;
+        for (auto &record : records) {
+            if (record.phase == '\0') {
+                continue;
+            }
+            hasEvents = true;
+
+            fputs(first ? "\n{\"name\":\"" : ",\n{\"name\":\"", file);
+            first = false;
+            WriteEscaped(file, record.name);
+            fprintf(file, "\",\"cat\":\"runtime\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+                    record.phase, record.timestampNs / 1000.0, pid, record.tid);
+
+            switch (record.phase) {
+                case 'B':
+                    if (record.arg[0] != '\0') {
+                        fputs(",\"args\":{\"detail\":\"", file);
+                        WriteEscaped(file, record.arg);
+                        fputs("\"}", file);
+                    }
+                    break;
+                case 'C':
+                    fprintf(file, ",\"args\":{\"value\":%lld}", (long long) record.value);
+                    break;
+                case 's':
+                    fprintf(file, ",\"id\":%lld", (long long) record.value);
+                    break;
+                case 'f':
+                    fprintf(file, ",\"id\":%lld,\"bp\":\"e\"", (long long) record.value);
+                    break;
+                default:
+                    break;
+            }
+            fputc('}', file);
+        }
+
+        if (hasEvents) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"",
+                    pid, buffer->tid);
+            WriteEscaped(file, buffer->threadName);
+            fputs("\"}}", file);
+        }
+    }
+    fputs("\n]}\n", file);
+
+    return fclose(file) == 0;
+}
+
+void Tracing::Begin(const char *name, const char *arg, size_t argLength) {
+    Emit('B', name, 0, arg, argLength);
+}
+
+void Tracing::End(const char *name) {
+    Emit('E', name, 0, nullptr, 0);
+}
+
+void Tracing::Counter(const char *name, int64_t value) {
+    Emit('C', name, value, nullptr, 0);
+}
+
+void Tracing::FlowStart(const char *name, int64_t id) {
+    Emit('s', name, id, nullptr, 0);
+}
+
+void Tracing::FlowEnd(const char *name, int64_t id) {
+    Emit('f', name, id, nullptr, 0);
+}
+
+void Tracing::Init(napi_env env, napi_value global) {
+    napi_util::napi_set_function(env, global, "__startTracing", StartTracingCallback, nullptr);
+    napi_util::napi_set_function(env, global, "__stopTracing", StopTracingCallback, nullptr);
+}
+
+napi_value Tracing::StartTracingCallback(napi_env env, napi_callback_info info) {
+    Start();
+    return nullptr;
+}
+
+napi_value Tracing::StopTracingCallback(napi_env env, napi_callback_info info) {
+    try {
+        size_t argc = 1;
+        napi_value argv[1];
+        napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+        string path;
+        if (argc > 0 && napi_util::is_of_type(env, argv[0], napi_string)) {
+            path = ArgConverter::ConvertToString(env, argv[0]);
+        } else {
+            // next to the app folder, i.e. in the files dir of the application
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            stringstream ss;
+            ss << Constants::APP_ROOT_FOLDER_PATH << "../trace-"
+               << ((int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000) << ".json";
+            path = ss.str();
+        }
+
+        if (!Stop(path)) {
+            throw NativeScriptException("Cannot write trace file: " + path);
+        }
+
+        return ArgConverter::convertToJsString(env, path);
+    } catch (NativeScriptException &e) {
+        e.ReThrowToNapi(env);
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToNapi(env);
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToNapi(env);
+    }
+    return nullptr;
+}
+
+std::atomic<bool> Tracing::s_enabled(false);
+std::atomic<int64_t> Tracing::s_startNs(0);
+std::atomic<int64_t> Tracing::s_nextFlowId(0);
+std::atomic<Tracing::ThreadBuffer *> Tracing::s_buffers(nullptr);
@@ -0,0 +1,131 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "js_native_api.h"
+
+namespace tns {
+namespace instrumentation {
+
+    /*
+     * Always compiled in, runtime enabled tracing of the runtime hot paths (JS <-> Java calls,
+     * module loads, GC notifications and timers).
+     *
+     * Every thread writes fixed size events to its own ring buffer, so recording is lock free and
+     * doesn't allocate. Event names must be string literals, a short per event argument (a method
+     * name or a module path) is copied inline. The buffers are dumped as Chrome trace event JSON
+     * which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+     *
+     * From JS: `__startTracing()` and `__stopTracing(path?)`, which returns the path of the trace.
+     */
+    class Tracing {
+    public:
+        static inline bool IsEnabled() {
+            return s_enabled.load(std::memory_order_relaxed);
+        }
+
+        static void Start();
+
+        /*
+         * Stops recording and writes the events recorded since Start to `path`. Slices that began
+         * before Start or had not ended by Stop are left out.
+         */
+        static bool Stop(const std::string &path);
+
+        static void Begin(const char *name, const char *arg = nullptr, size_t argLength = 0);
+
+        static void End(const char *name);
+
+        static void Counter(const char *name, int64_t value);
+
+        /*
+         * Connects the enclosing slice with the slice enclosing the FlowEnd with the same name and id
+         */
+        static void FlowStart(const char *name, int64_t id);
+
+        static void FlowEnd(const char *name, int64_t id);
+
+        /*
+         * Returns an id for FlowStart that is not reused for the lifetime of the process
+         */
+        static inline int64_t NewFlowId() {
+            return s_nextFlowId.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        static void Init(napi_env env, napi_value global);
+
+        // events per thread, 512KB
+        static const size_t BUFFER_SIZE = 8192;
+
+    private:
+        struct Event {
+            // odd while the owning thread writes the slot, 2 * (index + 1) once event `index` is in it
+            std::atomic<uint32_t> sequence;
+            int32_t tid;
+            int64_t timestampNs;
+            const char *name;
+            int64_t value;
+            char phase;
+            char arg[31];
+        };
+
+        struct ThreadBuffer;
+
+        struct Record;
+
+        static ThreadBuffer *GetThreadBuffer();
+
+        /*
+         * Appends event `index` to `records`, returns false when its slot holds another event
+         */
+        static bool ReadEvent(const Event &event, uint64_t index, std::vector<Record> &records);
+
+        static void Emit(char phase, const char *name, int64_t value, const char *arg, size_t argLength);
+
+        static napi_value StartTracingCallback(napi_env env, napi_callback_info info);
+
+        static napi_value StopTracingCallback(napi_env env, napi_callback_info info);
+
+        static std::atomic<bool> s_enabled;
+        static std::atomic<int64_t> s_startNs;
+        static std::atomic<int64_t> s_nextFlowId;
+        static std::atomic<ThreadBuffer *> s_buffers;
+    };
+
+    class TraceScope {
+    public:
+        inline TraceScope(const char *name)
+                : m_name(Tracing::IsEnabled() ? name : nullptr) {
+            if (m_name != nullptr) {
+                Tracing::Begin(m_name);
+            }
+        }
+
+        inline TraceScope(const char *name, const std::string &arg)
+                : m_name(Tracing::IsEnabled() ? name : nullptr) {
+            if (m_name != nullptr) {
+                Tracing::Begin(m_name, arg.data(), arg.size());
+            }
+        }
+
+        inline ~TraceScope() {
+            if (m_name != nullptr) {
+                Tracing::End(m_name);
+            }
+        }
+
+    private:
+        const char *m_name;
+
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+    };
+
+}
+}
+
+#endif //TRACING_H
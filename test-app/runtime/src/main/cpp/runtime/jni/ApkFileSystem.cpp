@@ -0,0 +1,147 @@
+#include "ApkFileSystem.h"
+#include "NativeScriptAssert.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace tns;
+using namespace std;
+
+bool ApkFileSystem::Mount(const string& apkPath, const string& filesRoot) {
+    if (s_zip != nullptr) {
+        return true;
+    }
+
+    // module paths are resolved to canonical paths, so the mount point has to be canonical too
+    char resolved[PATH_MAX];
+    string root = realpath(filesRoot.c_str(), resolved) != nullptr ? string(resolved) : filesRoot;
+    if (root.empty() || root.back() != '/') {
+        root += '/';
+    }
+
+    auto zip = new ZipDirectory();
+    if (!zip->Open(apkPath)) {
+        delete zip;
+        return false;
+    }
+
+    const string prefix("assets/");
+    auto& entries = zip->Entries();
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto& name = entries[i].name;
+        if (name.compare(0, prefix.length(), prefix) != 0 || name.back() == '/') {
+            continue;
+        }
+
+        auto path = root + name.substr(prefix.length());
+        s_files.emplace(path, i);
+
+        // register all parent directories of the entry, stopping at the first known one
+        auto slash = path.find_last_of('/');
+        while (slash != string::npos && slash >= root.length()) {
+            if (!s_directories.emplace(path.substr(0, slash)).second) {
+                break;
+            }
+            slash = path.find_last_of('/', slash - 1);
+        }
+    }
+
+    ReadOverrides(root);
+
+    s_root = root;
+    s_zip = zip;
+
+    DEBUG_WRITE("ApkFileSystem: mounted %zu files from %s at %s", s_files.size(), apkPath.c_str(), root.c_str());
+
+    return true;
+}
+
+void ApkFileSystem::ReadOverrides(const string& root) {
+    auto file = fopen((root + OVERRIDES_FILE_NAME).c_str(), "r");
+    if (file == nullptr) {
+        return;
+    }
+
+    char line[PATH_MAX];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        string name(line);
+        while (!name.empty() && (name.back() == '\n' || name.back() == '\r')) {
+            name.pop_back();
+        }
+        if (!name.empty()) {
+            s_files.erase(root + name);
+        }
+    }
+    fclose(file);
+}
+
+const ZipDirectory::Entry* ApkFileSystem::FindEntry(const string& path) {
+    if (s_zip == nullptr) {
+        return nullptr;
+    }
+
+    auto it = s_files.find(path);
+    if (it == s_files.end()) {
+        return nullptr;
+    }
+
+    return &s_zip->Entries()[it->second];
+}
+
+bool ApkFileSystem::IsFile(const string& path) {
+    return FindEntry(path) != nullptr;
+}
+
+bool ApkFileSystem::ServesAsset(const string& name) {
+    return s_zip != nullptr && s_files.count(s_root + name) > 0;
+}
+
+bool ApkFileSystem::IsDirectory(const string& path) {
+    if (s_zip == nullptr) {
+        return false;
+    }
+
+    if (!path.empty() && path.back() == '/') {
+        return s_directories.count(path.substr(0, path.length() - 1)) > 0;
+    }
+
+    return s_directories.count(path) > 0;
+}
+
+const char* ApkFileSystem::GetMappedData(const string& path, size_t& length) {
+    auto entry = FindEntry(path);
+    if (entry == nullptr || entry->method != ZipDirectory::METHOD_STORED) {
+        return nullptr;
+    }
+
+    auto data = s_zip->GetData(*entry);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    length = entry->size;
+
+    return (const char*) data;
+}
+
+unique_ptr<char[]> ApkFileSystem::ReadData(const string& path, size_t& length, size_t extraBuffer) {
+    auto entry = FindEntry(path);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    unique_ptr<char[]> buffer(new char[entry->size + extraBuffer]);
+    if (!s_zip->ReadEntry(*entry, (uint8_t*) buffer.get())) {
+        return nullptr;
+    }
+
+    length = entry->size;
+
+    return buffer;
+}
+
+const char* ApkFileSystem::OVERRIDES_FILE_NAME = ".ns-apk-overrides";
+ZipDirectory* ApkFileSystem::s_zip = nullptr;
+string ApkFileSystem::s_root;
+unordered_map<string, size_t> ApkFileSystem::s_files;
+unordered_set<string> ApkFileSystem::s_directories;
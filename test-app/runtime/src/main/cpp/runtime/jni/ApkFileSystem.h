@@ -0,0 +1,67 @@
+#ifndef APKFILESYSTEM_H_
+#define APKFILESYSTEM_H_
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "ZipDirectory.h"
+
+namespace tns {
+/*
+ * Resolves paths under the extracted files directory (e.g. /data/data/<pkg>/files/app/main.js)
+ * straight to the `assets/` entries of the APK, so that module sources can be read without
+ * going through the extracted copies.
+ *
+ * Entries stored uncompressed are served directly from the read-only mapping of the APK which
+ * lives until the process exits, deflated entries are inflated on demand.
+ *
+ * The APK takes precedence over the files directory, except for the paths listed in
+ * `<files>/.ns-apk-overrides` (one path relative to the files directory per line), which
+ * whoever writes newer copies of app files there (e.g. an update plugin) adds them to.
+ *
+ * The file system is mounted once from the main thread (before any runtime is created) and
+ * is read-only afterwards, so lookups are safe from any thread.
+ */
+class ApkFileSystem {
+    public:
+        static bool Mount(const std::string& apkPath, const std::string& filesRoot);
+
+        static bool IsMounted() {
+            return s_zip != nullptr;
+        }
+
+        static bool IsFile(const std::string& path);
+
+        /*
+         * Whether the asset (e.g. "app/main.js") is served from the APK
+         */
+        static bool ServesAsset(const std::string& name);
+
+        static bool IsDirectory(const std::string& path);
+
+        /*
+         * Returns a pointer into the APK mapping for stored entries, nullptr otherwise.
+         * The memory is never unmapped.
+         */
+        static const char* GetMappedData(const std::string& path, size_t& length);
+
+        /*
+         * Inflates (or copies) the entry. Returns nullptr when the path is not part of the APK.
+         */
+        static std::unique_ptr<char[]> ReadData(const std::string& path, size_t& length, size_t extraBuffer = 0);
+
+    private:
+        static const ZipDirectory::Entry* FindEntry(const std::string& path);
+
+        static void ReadOverrides(const std::string& root);
+
+        static const char* OVERRIDES_FILE_NAME;
+        static ZipDirectory* s_zip;
+        static std::string s_root;
+        static std::unordered_map<std::string, size_t> s_files;
+        static std::unordered_set<std::string> s_directories;
+};
+}
+
+#endif /* APKFILESYSTEM_H_ */
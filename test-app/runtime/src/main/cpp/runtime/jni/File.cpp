@@ -6,16 +6,25 @@
  */
 
 #include "File.h"
+#include "ApkFileSystem.h"
 #include <sstream>
 #include <fstream>
 #include <sys/mman.h>
 #include <assert.h>
+#include <sys/stat.h>
 
 using namespace std;
 
 namespace tns {
 
 string File::ReadText(const string& filePath) {
+    if (ApkFileSystem::IsMounted()) {
+        FileContent content;
+        if (ReadContent(filePath, content)) {
+            return string(content.data, content.length);
+        }
+    }
+
     int len;
     bool isNew;
     const char* content = ReadText(filePath, len, isNew);
@@ -29,6 +38,49 @@ string File::ReadText(const string& filePath) {
     return s;
 }
 
+bool File::ReadContent(const string& filePath, FileContent& content) {
+    size_t length = 0;
+
+    auto mapped = ApkFileSystem::GetMappedData(filePath, length);
+    if (mapped != nullptr) {
+        content.data = mapped;
+        content.length = length;
+        content.isMapped = true;
+        return true;
+    }
+
+    content.buffer = ApkFileSystem::ReadData(filePath, length);
+    if (!content.buffer) {
+        auto file = fopen(filePath.c_str(), READ_BINARY);
+        if (!file) {
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        length = ftell(file);
+        rewind(file);
+
+        content.buffer.reset(new char[length]);
+        length = fread(content.buffer.get(), 1, length, file);
+        fclose(file);
+    }
+
+    content.data = content.buffer.get();
+    content.length = length;
+    content.isMapped = false;
+
+    return true;
+}
+
+bool File::Exists(const string& filePath) {
+    if (ApkFileSystem::IsFile(filePath)) {
+        return true;
+    }
+
+    struct stat st;
+    return stat(filePath.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
 void* File::ReadBinary(const string& filePath, int& length) {
     length = 0;
 
@@ -9,12 +9,34 @@
 #define JNI_FILE_H_
 
 #include <string>
+#include <memory>
 
 namespace tns {
+/*
+ * The contents of a file. `data` either points into `buffer` or, when `isMapped` is set,
+ * into a read-only mapping of the APK that is never released.
+ */
+class FileContent {
+    public:
+        FileContent()
+            : data(nullptr), length(0), isMapped(false) {
+        }
+
+        const char* data;
+        size_t length;
+        bool isMapped;
+        std::unique_ptr<char[]> buffer;
+};
+
 class File {
     public:
         static const char* ReadText(const std::string& filePath, int& length, bool& isNew);
         static std::string ReadText(const std::string& filePath);
+        /*
+         * Reads the file from the mounted APK if it is served from it, from disk otherwise.
+         */
+        static bool ReadContent(const std::string& filePath, FileContent& content);
+        static bool Exists(const std::string& filePath);
         static bool WriteBinary(const std::string& filePath, const void* inData, int length);
         static void* ReadBinary(const std::string& filePath, int& length);
         static std::unique_ptr<char[]> ReadFile(const std::string &filePath, int &length, int extraBuffer = 0);
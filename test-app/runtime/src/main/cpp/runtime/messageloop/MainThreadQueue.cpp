@@ -0,0 +1,384 @@
+#include "MainThreadQueue.h"
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <sys/eventfd.h>
+#include <android/log.h>
+#include "NativeScriptAssert.h"
+#include "NativeScriptException.h"
+#include "Runtime.h"
+#include "ArgConverter.h"
+#include "GlobalHelpers.h"
+#include <vector>
+
+using namespace tns;
+using namespace std::chrono;
+
+void MainThreadQueue::Init(ALooper* looper, int drainBudgetMs) {
+    s_drainBudgetMicros = drainBudgetMs > 0 ? drainBudgetMs * 1000LL : 0;
+
+    s_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s_fd == -1) {
+        __android_log_print(ANDROID_LOG_ERROR, "TNS.MainThreadQueue", "Unable to create an eventfd: %s", strerror(errno));
+        return;
+    }
+
+    s_looper = looper;
+    ALooper_acquire(s_looper);
+    ALooper_addFd(s_looper, s_fd, ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT, MainThreadQueue::DrainCallback, nullptr);
+}
+
+void MainThreadQueue::Dispose() {
+    if (s_looper != nullptr) {
+        ALooper_removeFd(s_looper, s_fd);
+        ALooper_release(s_looper);
+        s_looper = nullptr;
+    }
+
+    if (s_fd != -1) {
+        close(s_fd);
+        s_fd = -1;
+    }
+
+    // the envs are gone by now, so are the references
+    Node* node;
+    while ((node = Pop()) != nullptr) {
+        delete node;
+    }
+}
+
+void MainThreadQueue::Post(napi_env env, napi_value callback, napi_value arguments) {
+    auto node = new Node();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->env = env;
+    napi_create_reference(env, callback, 1, &node->callback);
+    node->arguments = nullptr;
+    if (arguments != nullptr) {
+        napi_create_reference(env, arguments, 1, &node->arguments);
+    }
+
+    Post(node);
+}
+
+void MainThreadQueue::Post(napi_env env, std::string source, std::string arguments) {
+    auto node = new Node();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->env = env;
+    node->callback = nullptr;
+    node->arguments = nullptr;
+    node->source = std::move(source);
+    node->argumentsJson = std::move(arguments);
+
+    Post(node);
+}
+
+void MainThreadQueue::Post(Node* node) {
+    Push(node);
+
+    s_posted.fetch_add(1, std::memory_order_relaxed);
+    auto depth = s_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto maxDepth = s_maxDepth.load(std::memory_order_relaxed);
+    while (depth > maxDepth && !s_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {
+    }
+
+    // a wakeup that has not been handled yet drains this entry as well
+    if (!s_scheduled.exchange(true)) {
+        Ring();
+    }
+}
+
+void MainThreadQueue::Push(Node* node) {
+    auto prev = s_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+MainThreadQueue::Node* MainThreadQueue::Pop() {
+    auto tail = s_tail;
+    auto next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &s_stub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        s_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+        s_tail = next;
+        return tail;
+    }
+
+    if (tail != s_head.load(std::memory_order_acquire)) {
+        // a producer is linking its node right now, its Post rings again once it is done
+        return nullptr;
+    }
+
+    s_stub.next.store(nullptr, std::memory_order_relaxed);
+    Push(&s_stub);
+
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        s_tail = next;
+        return tail;
+    }
+
+    return nullptr;
+}
+
+void MainThreadQueue::Ring() {
+    uint64_t value = 1;
+    if (s_fd == -1 || write(s_fd, &value, sizeof(value)) != sizeof(value)) {
+        s_scheduled = false;
+    }
+}
+
+int MainThreadQueue::DrainCallback(int fd, int events, void* data) {
+    uint64_t value;
+    read(fd, &value, sizeof(value));
+
+    // cleared first, so that a post racing with the drain below rings again
+    s_scheduled = false;
+
+    Drain();
+
+    return 1;
+}
+
+void MainThreadQueue::Drain() {
+    auto start = steady_clock::now();
+    int64_t elapsed = 0;
+
+    std::unique_ptr<NapiScope> scope;
+    napi_env scopeEnv = nullptr;
+
+    Node* node;
+    while ((node = Pop()) != nullptr) {
+        s_depth.fetch_sub(1, std::memory_order_relaxed);
+
+        // the runtime was destroyed after the function was posted
+        if (Runtime::GetRuntimeUnchecked(node->env) != nullptr) {
+            if (node->env != scopeEnv) {
+                scope.reset();
+                scope.reset(new NapiScope(node->env, false));
+                scopeEnv = node->env;
+            }
+            Call(node);
+            s_executed.fetch_add(1, std::memory_order_relaxed);
+        }
+        delete node;
+
+        elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+        if (s_drainBudgetMicros > 0 && elapsed >= s_drainBudgetMicros) {
+            if (s_depth.load(std::memory_order_relaxed) > 0) {
+                s_budgetExceeded.fetch_add(1, std::memory_order_relaxed);
+                if (!s_scheduled.exchange(true)) {
+                    Ring();
+                }
+            }
+            break;
+        }
+    }
+
+    scope.reset();
+
+    s_drains.fetch_add(1, std::memory_order_relaxed);
+    s_lastDrainMicros.store(elapsed, std::memory_order_relaxed);
+    s_totalDrainMicros.fetch_add(elapsed, std::memory_order_relaxed);
+    if (elapsed > s_maxDrainMicros.load(std::memory_order_relaxed)) {
+        s_maxDrainMicros.store(elapsed, std::memory_order_relaxed);
+    }
+}
+
+void MainThreadQueue::Call(Node* node) {
+    auto env = node->env;
+
+    napi_handle_scope handleScope;
+    napi_open_handle_scope(env, &handleScope);
+
+    napi_value cb = nullptr;
+    napi_value arguments = nullptr;
+    if (node->callback != nullptr) {
+        cb = napi_util::get_ref_value(env, node->callback);
+        napi_delete_reference(env, node->callback);
+        if (node->arguments != nullptr) {
+            arguments = napi_util::get_ref_value(env, node->arguments);
+            napi_delete_reference(env, node->arguments);
+        }
+    } else {
+        // posted by a worker, the parentheses make the source a function expression
+        std::string source = "(" + node->source + "\n)";
+        napi_value script;
+        napi_create_string_utf8(env, source.c_str(), source.size(), &script);
+        js_execute_script(env, script, "<runOnMainThread>", &cb);
+        if (!node->argumentsJson.empty()) {
+            try {
+                arguments = JsonParseString(env, node->argumentsJson);
+            } catch (NativeScriptException& e) {
+                e.ReThrowToNapi(env);
+                cb = nullptr;
+            }
+        }
+    }
+
+    std::vector<napi_value> argv;
+    if (arguments != nullptr) {
+        uint32_t length = 0;
+        napi_get_array_length(env, arguments, &length);
+        argv.resize(length);
+        for (uint32_t i = 0; i < length; i++) {
+            napi_get_element(env, arguments, i, &argv[i]);
+        }
+    }
+
+    napi_value global;
+    napi_get_global(env, &global);
+
+    napi_value result;
+    if (cb != nullptr && napi_util::is_of_type(env, cb, napi_function)) {
+        napi_call_function(env, global, cb, argv.size(), argv.data(), &result);
+    }
+
+    bool pendingException;
+    napi_is_exception_pending(env, &pendingException);
+    if (pendingException) {
+        napi_value error;
+        napi_get_and_clear_last_exception(env, &error);
+        NativeScriptException::OnUncaughtError(env, error);
+    }
+
+    napi_close_handle_scope(env, handleScope);
+}
+
+MainThreadQueue::Stats MainThreadQueue::GetStats() {
+    Stats stats;
+    stats.depth = s_depth.load(std::memory_order_relaxed);
+    stats.maxDepth = s_maxDepth.load(std::memory_order_relaxed);
+    stats.posted = s_posted.load(std::memory_order_relaxed);
+    stats.executed = s_executed.load(std::memory_order_relaxed);
+    stats.drains = s_drains.load(std::memory_order_relaxed);
+    stats.budgetExceeded = s_budgetExceeded.load(std::memory_order_relaxed);
+    stats.lastDrainMicros = s_lastDrainMicros.load(std::memory_order_relaxed);
+    stats.maxDrainMicros = s_maxDrainMicros.load(std::memory_order_relaxed);
+    stats.totalDrainMicros = s_totalDrainMicros.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool MainThreadQueue::IsFunctionExpression(napi_env env, const std::string& source) {
+    // evaluating a function expression creates the function without running any of it, the
+    // source of native and bound functions ("{ [native code] }") and of methods doesn't parse
+    std::string expression = "(" + source + "\n)";
+    napi_value script;
+    napi_value function;
+    napi_create_string_utf8(env, expression.c_str(), expression.size(), &script);
+    if (js_execute_script(env, script, "<runOnMainThread>", &function) != napi_ok) {
+        napi_value error;
+        napi_get_and_clear_last_exception(env, &error);
+        return false;
+    }
+    return napi_util::is_of_type(env, function, napi_function);
+}
+
+napi_value MainThreadQueue::RunOnMainThreadCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    napi_get_cb_info(env, info, &argc, nullptr, nullptr, nullptr);
+    std::vector<napi_value> args(argc);
+    napi_get_cb_info(env, info, &argc, args.data(), nullptr, nullptr);
+
+    if (argc < 1 || !napi_util::is_of_type(env, args[0], napi_function)) {
+        napi_throw_type_error(env, nullptr, "__runOnMainThread expects a function");
+        return nullptr;
+    }
+
+    napi_value arguments = nullptr;
+    if (argc > 1) {
+        napi_create_array_with_length(env, argc - 1, &arguments);
+        for (size_t i = 1; i < argc; i++) {
+            napi_set_element(env, arguments, (uint32_t) (i - 1), args[i]);
+        }
+    }
+
+    auto mainRuntime = Runtime::GetMainRuntime();
+    if (mainRuntime != nullptr && Runtime::GetRuntimeUnchecked(env) == mainRuntime) {
+        Post(env, args[0], arguments);
+        return nullptr;
+    }
+
+    if (mainRuntime == nullptr) {
+        napi_throw_error(env, nullptr, "__runOnMainThread: the main runtime is not running");
+        return nullptr;
+    }
+
+    // only the source goes to the main runtime, anything else the function needs is passed as
+    // arguments instead of silently losing the variables it closes over
+    napi_value sourceValue;
+    napi_coerce_to_string(env, args[0], &sourceValue);
+    auto source = ArgConverter::ConvertToString(env, sourceValue);
+    if (!IsFunctionExpression(env, source)) {
+        napi_throw_type_error(env, nullptr,
+                              "__runOnMainThread: only the source of a function posted by a worker is sent to the main thread, "
+                              "native, bound and method functions can't be posted, pass a function expression and its data as further arguments");
+        return nullptr;
+    }
+
+    std::string argumentsJson;
+    if (arguments != nullptr) {
+        try {
+            argumentsJson = JsonStringifyObject(env, arguments, false);
+        } catch (NativeScriptException& e) {
+            e.ReThrowToNapi(env);
+            return nullptr;
+        }
+    }
+
+    Post(mainRuntime->GetNapiEnv(), std::move(source), std::move(argumentsJson));
+
+    return nullptr;
+}
+
+napi_value MainThreadQueue::GetStatsCallback(napi_env env, napi_callback_info info) {
+    auto stats = GetStats();
+
+    napi_value result;
+    napi_create_object(env, &result);
+
+    auto set = [env, result](const char* name, double value) {
+        napi_value jsValue;
+        napi_create_double(env, value, &jsValue);
+        napi_set_named_property(env, result, name, jsValue);
+    };
+
+    set("depth", (double) stats.depth);
+    set("maxDepth", (double) stats.maxDepth);
+    set("posted", (double) stats.posted);
+    set("executed", (double) stats.executed);
+    set("drains", (double) stats.drains);
+    set("budgetExceeded", (double) stats.budgetExceeded);
+    set("lastDrainMs", stats.lastDrainMicros / 1000.0);
+    set("maxDrainMs", stats.maxDrainMicros / 1000.0);
+    set("totalDrainMs", stats.totalDrainMicros / 1000.0);
+    set("budgetMs", s_drainBudgetMicros / 1000.0);
+
+    return result;
+}
+
+ALooper* MainThreadQueue::s_looper = nullptr;
+int MainThreadQueue::s_fd = -1;
+int64_t MainThreadQueue::s_drainBudgetMicros = MainThreadQueue::DEFAULT_DRAIN_BUDGET_MS * 1000LL;
+
+MainThreadQueue::Node MainThreadQueue::s_stub;
+std::atomic<MainThreadQueue::Node*> MainThreadQueue::s_head = {&MainThreadQueue::s_stub};
+MainThreadQueue::Node* MainThreadQueue::s_tail = &MainThreadQueue::s_stub;
+std::atomic<bool> MainThreadQueue::s_scheduled = {false};
+
+std::atomic<int64_t> MainThreadQueue::s_depth = {0};
+std::atomic<int64_t> MainThreadQueue::s_maxDepth = {0};
+std::atomic<int64_t> MainThreadQueue::s_posted = {0};
+std::atomic<int64_t> MainThreadQueue::s_executed = {0};
+std::atomic<int64_t> MainThreadQueue::s_drains = {0};
+std::atomic<int64_t> MainThreadQueue::s_budgetExceeded = {0};
+std::atomic<int64_t> MainThreadQueue::s_lastDrainMicros = {0};
+std::atomic<int64_t> MainThreadQueue::s_maxDrainMicros = {0};
+std::atomic<int64_t> MainThreadQueue::s_totalDrainMicros = {0};
@@ -0,0 +1,117 @@
+#ifndef MAINTHREADQUEUE_H
+#define MAINTHREADQUEUE_H
+
+#include "js_native_api.h"
+#include <android/looper.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace tns {
+
+/*
+ * Runs JS functions scheduled with `__runOnMainThread` on the main looper.
+ *
+ * Any thread can post; entries go to a lock-free multi-producer single-consumer queue and only the
+ * first post after a drain rings the eventfd doorbell, so a burst of posts costs one looper
+ * wakeup. A wakeup runs the queued functions back to back until the queue is empty or the drain
+ * budget is spent, the rest is left for the next looper iteration so that frames still get drawn.
+ *
+ * `__runOnMainThread(fn, ...args)` calls `fn` with `args`. Functions posted from a worker cannot
+ * be called in the main runtime: only their source is sent and evaluated there, so they do not
+ * see the variables of the worker they were created in and must get what they need through
+ * `args`, which are copied as JSON like the messages of `postMessage`. Functions whose source is
+ * not a function expression (native, bound and method shorthand functions) are rejected with a
+ * TypeError on the worker.
+ */
+class MainThreadQueue {
+public:
+    struct Stats {
+        int64_t depth;
+        int64_t maxDepth;
+        int64_t posted;
+        int64_t executed;
+        int64_t drains;
+        int64_t budgetExceeded;
+        int64_t lastDrainMicros;
+        int64_t maxDrainMicros;
+        int64_t totalDrainMicros;
+    };
+
+    /*
+     * Must be called on the main thread
+     */
+    static void Init(ALooper* looper, int drainBudgetMs);
+
+    static void Dispose();
+
+    /*
+     * Schedules `callback` to be called on the main thread, in `env`, with the elements of the
+     * `arguments` array, if any
+     */
+    static void Post(napi_env env, napi_value callback, napi_value arguments = nullptr);
+
+    /*
+     * Schedules the function `source` evaluates to to be called on the main thread, in `env`,
+     * with the elements of the JSON array `arguments`, if any
+     */
+    static void Post(napi_env env, std::string source, std::string arguments = std::string());
+
+    static Stats GetStats();
+
+    static napi_value RunOnMainThreadCallback(napi_env env, napi_callback_info info);
+
+    static napi_value GetStatsCallback(napi_env env, napi_callback_info info);
+
+    static const int DEFAULT_DRAIN_BUDGET_MS = 8;
+
+private:
+    struct Node {
+        std::atomic<Node*> next;
+        napi_env env;
+        napi_ref callback;
+        napi_ref arguments;
+        std::string source;
+        std::string argumentsJson;
+    };
+
+    static void Post(Node* node);
+
+    static bool IsFunctionExpression(napi_env env, const std::string& source);
+
+    static void Push(Node* node);
+
+    static Node* Pop();
+
+    static void Ring();
+
+    static void Drain();
+
+    static void Call(Node* node);
+
+    static int DrainCallback(int fd, int events, void* data);
+
+    static ALooper* s_looper;
+    static int s_fd;
+    static int64_t s_drainBudgetMicros;
+
+    static std::atomic<Node*> s_head;
+    static Node* s_tail;
+    static Node s_stub;
+    static std::atomic<bool> s_scheduled;
+
+    // updated by the main thread only except for the first three, all of them can be read anywhere
+    static std::atomic<int64_t> s_depth;
+    static std::atomic<int64_t> s_maxDepth;
+    static std::atomic<int64_t> s_posted;
+    static std::atomic<int64_t> s_executed;
+    static std::atomic<int64_t> s_drains;
+    static std::atomic<int64_t> s_budgetExceeded;
+    static std::atomic<int64_t> s_lastDrainMicros;
+    static std::atomic<int64_t> s_maxDrainMicros;
+    static std::atomic<int64_t> s_totalDrainMicros;
+};
+
+}
+
+#endif //MAINTHREADQUEUE_H
@@ -1,8 +1,7 @@
 #include "MessageLoopTimer.h"
-#include <android/looper.h>
 #include <unistd.h>
 #include <cerrno>
-#include <thread>
+#include <sys/eventfd.h>
 #include <android/log.h>
 #include "NativeScriptAssert.h"
 #include "Runtime.h"
@@ -11,8 +10,66 @@ using namespace tns;
 
 static const int SLEEP_INTERVAL_MS = 100;
 
+MessageLoopTimer::MessageLoopTimer()
+        : m_env(nullptr), m_looper(nullptr), m_fd(-1), m_hasEngineHook(false), m_scheduled(false), m_isRunning(false) {
+}
+
+MessageLoopTimer::~MessageLoopTimer() {
+    Destroy();
+}
+
 void MessageLoopTimer::Init(napi_env env) {
+    m_env = env;
+
     this->RegisterStartStopFunctions(env);
+
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_fd == -1) {
+        __android_log_print(ANDROID_LOG_ERROR, "NAPI", "Unable to create an eventfd: %s", strerror(errno));
+        return;
+    }
+
+    m_looper = ALooper_prepare(0);
+    ALooper_acquire(m_looper);
+    ALooper_addFd(m_looper, m_fd, ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT, MessageLoopTimer::PumpMessageLoopCallback, this);
+
+    m_hasEngineHook = js_set_pending_jobs_callback(env, MessageLoopTimer::PendingJobsCallback, this) == napi_ok;
+    if (!m_hasEngineHook) {
+        DEBUG_WRITE("%s", "MessageLoopTimer: the engine does not report pending jobs, polling while started");
+    }
+}
+
+void MessageLoopTimer::Destroy() {
+    StopWorker();
+
+    if (m_env != nullptr && m_hasEngineHook) {
+        js_set_pending_jobs_callback(m_env, nullptr, nullptr);
+    }
+    m_hasEngineHook = false;
+    m_env = nullptr;
+
+    if (m_looper != nullptr) {
+        ALooper_removeFd(m_looper, m_fd);
+        ALooper_release(m_looper);
+        m_looper = nullptr;
+    }
+
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void MessageLoopTimer::Schedule() {
+    // a wakeup that has not been handled yet covers everything queued in the meantime
+    if (m_fd == -1 || m_scheduled.exchange(true)) {
+        return;
+    }
+
+    uint64_t value = 1;
+    if (write(m_fd, &value, sizeof(value)) != sizeof(value)) {
+        m_scheduled = false;
+    }
 }
 
 void MessageLoopTimer::RegisterStartStopFunctions(napi_env env) {
@@ -41,29 +98,17 @@ napi_value MessageLoopTimer::StartCallback(napi_env env, napi_callback_info info
 
     auto self = static_cast<MessageLoopTimer *>(data);
 
-    if (self->m_isRunning) {
+    // the engine schedules the wakeups by itself
+    if (self->m_hasEngineHook || self->m_fd == -1 || self->m_isRunning) {
         return nullptr;
     }
 
-    self->m_isRunning = true;
-
-    auto looper = ALooper_forThread();
-    if (looper == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, "NAPI", "Unable to get looper for the current thread");
-        return nullptr;
-    }
-
-    int status = pipe(self->m_fd);
-    if (status != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, "NAPI", "Unable to create a pipe: %s", strerror(errno));
-        return nullptr;
+    if (self->m_worker.joinable()) {
+        self->m_worker.join();
     }
 
-    ALooper_addFd(looper, self->m_fd[0], 0, ALOOPER_EVENT_INPUT, MessageLoopTimer::PumpMessageLoopCallback, env);
-
-    std::thread worker(MessageLoopTimer::WorkerThreadRun, self);
-
-    worker.detach();
+    self->m_isRunning = true;
+    self->m_worker = std::thread(MessageLoopTimer::WorkerThreadRun, self);
 
     return nullptr;
 }
@@ -73,33 +118,65 @@ napi_value MessageLoopTimer::StopCallback(napi_env env, napi_callback_info info)
     napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
     auto self = static_cast<MessageLoopTimer *>(data);
 
-
     if (!self->m_isRunning) {
         return nullptr;
     }
 
-    self->m_isRunning = false;
+    {
+        std::lock_guard<std::mutex> lock(self->m_mutex);
+        self->m_isRunning = false;
+    }
+    self->m_stopped.notify_one();
 
     return nullptr;
 }
 
+void MessageLoopTimer::StopWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isRunning = false;
+    }
+    m_stopped.notify_one();
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void MessageLoopTimer::PendingJobsCallback(napi_env env, void* data) {
+    auto self = static_cast<MessageLoopTimer *>(data);
+    self->Schedule();
+}
+
 int MessageLoopTimer::PumpMessageLoopCallback(int fd, int events, void* data) {
-    uint8_t msg;
-    read(fd, &msg, sizeof(uint8_t));
-    auto env = (napi_env) data;
+    uint64_t value;
+    read(fd, &value, sizeof(value));
 
-    js_execute_pending_jobs(env);
+    auto self = static_cast<MessageLoopTimer *>(data);
+    // cleared first, so that jobs queued while draining get a wakeup of their own
+    self->m_scheduled = false;
+
+    if (self->m_env != nullptr) {
+        // the looper calls in without the engine entered, the finalizers may create values
+        NapiScope scope(self->m_env);
+        js_execute_pending_jobs(self->m_env);
+
+        // the proxies finalized by now are made weak in Java together
+        auto runtime = Runtime::GetRuntimeUnchecked(self->m_env);
+        if (runtime != nullptr && !runtime->is_destroying) {
+            runtime->GetObjectManager()->FlushWeakInstances();
+        }
+    }
 
     return 1;
 }
 
 void MessageLoopTimer::WorkerThreadRun(MessageLoopTimer* timer) {
+    std::unique_lock<std::mutex> lock(timer->m_mutex);
     while (timer->m_isRunning) {
-        uint8_t msg = 1;
-        write(timer->m_fd[1], &msg, sizeof(uint8_t));
-        std::this_thread::sleep_for(std::chrono::milliseconds(SLEEP_INTERVAL_MS));
+        timer->Schedule();
+        timer->m_stopped.wait_for(lock, std::chrono::milliseconds(SLEEP_INTERVAL_MS), [timer]() {
+            return !timer->m_isRunning;
+        });
     }
-
-    uint8_t msg = 0;
-    write(timer->m_fd[1], &msg, sizeof(uint8_t));
 }
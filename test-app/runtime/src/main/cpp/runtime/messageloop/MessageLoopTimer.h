@@ -2,19 +2,56 @@
 #define MESSAGELOOPTIMER_H
 
 #include "js_native_api.h"
+#include <android/looper.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace tns {
 
+/*
+ * Runs the engine's pending jobs (promise reactions, deferred finalizers and the like) that were
+ * queued outside of a JS call and would otherwise wait for the next call into JS.
+ *
+ * The engine reports such jobs through js_set_pending_jobs_callback and a single coalesced wakeup
+ * is posted to the looper of the runtime thread through an eventfd. Engines without that hook fall
+ * back to draining the jobs every SLEEP_INTERVAL_MS while `__messageLoopTimerStart` is in effect.
+ */
 class MessageLoopTimer {
 public:
+    MessageLoopTimer();
+
+    ~MessageLoopTimer();
+
     void Init(napi_env env);
+
+    /*
+     * Unregisters from the engine and the looper, must be called before the env is freed
+     */
+    void Destroy();
+
+    /*
+     * Requests a js_execute_pending_jobs call on the runtime thread, can be called from any thread
+     */
+    void Schedule();
+
 private:
-    bool m_isRunning;
-    int m_fd[2];
+    napi_env m_env;
+    ALooper* m_looper;
+    int m_fd;
+    bool m_hasEngineHook;
+    std::atomic<bool> m_scheduled;
+    std::atomic<bool> m_isRunning;
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
 
     void RegisterStartStopFunctions(napi_env env);
+    void StopWorker();
     static napi_value StartCallback(napi_env, napi_callback_info info);
     static napi_value StopCallback(napi_env env, napi_callback_info info);
+    static void PendingJobsCallback(napi_env env, void* data);
     static int PumpMessageLoopCallback(int fd, int events, void* data);
     static void WorkerThreadRun(MessageLoopTimer* timer);
 };
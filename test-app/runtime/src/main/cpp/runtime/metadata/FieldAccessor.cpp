@@ -1,5 +1,6 @@
 #include "FieldAccessor.h"
 #include "ArgConverter.h"
+#include "MetadataNode.h"
 #include "NativeScriptException.h"
 #include "Runtime.h"
 #include <sstream>
@@ -7,6 +8,68 @@
 using namespace std;
 using namespace tns;
 
+void FieldAccessor::ResolveField(JEnv &jEnv, FieldCallbackData *fieldData) {
+    auto &fieldMetadata = fieldData->metadata;
+    const auto &fieldTypeName = fieldMetadata.getSig();
+
+    auto isPrimitiveType = fieldTypeName.size() == 1;
+    auto isFieldArray = fieldTypeName[0] == '[';
+    auto fieldJniSig = isPrimitiveType
+                       ? fieldTypeName
+                       : (isFieldArray
+                          ? fieldTypeName
+                          : ("L" + fieldTypeName + ";"));
+
+    fieldData->clazz = jEnv.FindClass(fieldMetadata.getDeclaringType());
+    assert(fieldData->clazz != nullptr);
+    if (fieldMetadata.isStatic) {
+        fieldData->fid = jEnv.GetStaticFieldID(fieldData->clazz, fieldMetadata.getName(),
+                                               fieldJniSig);
+    } else {
+        fieldData->fid = jEnv.GetFieldID(fieldData->clazz, fieldMetadata.getName(),
+                                         fieldJniSig);
+    }
+    assert(fieldData->fid != nullptr);
+
+    if (!isPrimitiveType) {
+        fieldData->kind = fieldTypeName == "java/lang/String" ? FieldKind::String : FieldKind::Object;
+        return;
+    }
+
+    switch (fieldTypeName[0]) {
+        case 'Z':
+            fieldData->kind = FieldKind::Boolean;
+            break;
+        case 'B':
+            fieldData->kind = FieldKind::Byte;
+            break;
+        case 'C':
+            fieldData->kind = FieldKind::Char;
+            break;
+        case 'S':
+            fieldData->kind = FieldKind::Short;
+            break;
+        case 'I':
+            fieldData->kind = FieldKind::Int;
+            break;
+        case 'J':
+            fieldData->kind = FieldKind::Long;
+            break;
+        case 'F':
+            fieldData->kind = FieldKind::Float;
+            break;
+        case 'D':
+            fieldData->kind = FieldKind::Double;
+            break;
+        default: {
+            stringstream ss;
+            ss << "(InternalError): in FieldAccessor::ResolveField: Unknown field type: '"
+               << fieldTypeName[0] << "'";
+            throw NativeScriptException(ss.str());
+        }
+    }
+}
+
 napi_value
 FieldAccessor::GetJavaField(napi_env env, napi_value target, FieldCallbackData *fieldData) {
     JEnv jEnv;
@@ -14,179 +77,201 @@ FieldAccessor::GetJavaField(napi_env env, napi_value target, FieldCallbackData *
     auto runtime = Runtime::GetRuntime(env);
     auto objectManager = runtime->GetObjectManager();
 
-    napi_value fieldResult;
+    if (fieldData->fid == nullptr) {
+        ResolveField(jEnv, fieldData);
+    }
 
-    JniLocalRef targetJavaObject;
+    if (fieldData->metadata.isStatic) {
+        return ReadField(env, jEnv, objectManager, nullptr, fieldData);
+    }
 
-    auto &fieldMetadata = fieldData->metadata;
+    // Using fast, target is always the original *this*
+    JniLocalRef targetJavaObject = objectManager->GetJavaObjectByJsObjectFast(target);
 
-    const auto &fieldTypeName = fieldMetadata.getSig();
-    auto isStatic = fieldMetadata.isStatic;
+    if (targetJavaObject.IsNull()) {
+        stringstream ss;
+        ss << "Cannot access property '" << fieldData->metadata.getName().c_str()
+           << "' because there is no corresponding Java object";
+        throw NativeScriptException(ss.str());
+    }
 
-    auto isPrimitiveType = fieldTypeName.size() == 1;
-    if (fieldData->fid == nullptr) {
-        auto isFieldArray = fieldTypeName[0] == '[';
-        auto fieldJniSig = isPrimitiveType
-                           ? fieldTypeName
-                           : (isFieldArray
-                              ? fieldTypeName
-                              : ("L" + fieldTypeName + ";"));
-
-        if (isStatic) {
-            fieldData->clazz = jEnv.FindClass(fieldMetadata.getDeclaringType());
-            fieldData->fid = jEnv.GetStaticFieldID(fieldData->clazz, fieldMetadata.getName(),
-                                                   fieldJniSig);
-        } else {
-            fieldData->clazz = jEnv.FindClass(fieldMetadata.getDeclaringType());
-            fieldData->fid = jEnv.GetFieldID(fieldData->clazz, fieldMetadata.getName(),
-                                             fieldJniSig);
-        }
+    return ReadField(env, jEnv, objectManager, targetJavaObject, fieldData);
+}
+
+napi_value FieldAccessor::GetJavaFields(napi_env env, napi_value target, napi_value names) {
+    JEnv jEnv;
+
+    auto runtime = Runtime::GetRuntime(env);
+    auto objectManager = runtime->GetObjectManager();
+
+    JniLocalRef targetJavaObject = objectManager->GetJavaObjectByJsObjectFast(target);
+    if (targetJavaObject.IsNull()) {
+        throw NativeScriptException(
+                "Cannot read fields because there is no corresponding Java object");
     }
 
-    if (!isStatic) {
-        // Using fast, target is always the original *this*
-        targetJavaObject = objectManager->GetJavaObjectByJsObjectFast(target);
+    auto node = MetadataNode::GetInstanceMetadata(env, target);
 
-        if (targetJavaObject.IsNull()) {
-            stringstream ss;
-            ss << "Cannot access property '" << fieldMetadata.getName().c_str()
-               << "' because there is no corresponding Java object";
-            throw NativeScriptException(ss.str());
+    uint32_t length;
+    napi_get_array_length(env, names, &length);
+
+    napi_value result;
+    napi_create_object(env, &result);
+
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value name;
+        napi_get_element(env, names, i, &name);
+
+        FieldCallbackData *fieldData = nullptr;
+        if (node != nullptr && napi_util::is_of_type(env, name, napi_string)) {
+            fieldData = node->GetInstanceField(env, ArgConverter::ConvertToString(env, name));
         }
 
+        napi_value value;
+        if (fieldData != nullptr) {
+            if (fieldData->fid == nullptr) {
+                ResolveField(jEnv, fieldData);
+            }
+            value = ReadField(env, jEnv, objectManager, targetJavaObject, fieldData);
+        } else {
+            napi_get_property(env, target, name, &value);
+        }
+
+        napi_set_property(env, result, name, value);
     }
 
+    return result;
+}
+
+napi_value FieldAccessor::ReadField(napi_env env, JEnv &jEnv, ObjectManager *objectManager,
+                                    jobject target, FieldCallbackData *fieldData) {
+    napi_value fieldResult;
 
     auto fieldId = fieldData->fid;
     auto clazz = fieldData->clazz;
+    auto isStatic = target == nullptr;
 
-    if (isPrimitiveType) {
-        switch (fieldTypeName[0]) {
-            case 'Z': { // bool
-                jboolean result;
-                if (isStatic) {
-                    result = jEnv.GetStaticBooleanField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetBooleanField(targetJavaObject, fieldId);
-                }
-                fieldResult =
-                        result == JNI_TRUE ? napi_util::get_true(env) : napi_util::get_false(env);
-                break;
-            }
-            case 'B': { // byte
-                jbyte result;
-                if (isStatic) {
-                    result = jEnv.GetStaticByteField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetByteField(targetJavaObject, fieldId);
-                }
-                napi_create_int32(env, result, &fieldResult);
-                break;
-            }
-            case 'C': { // char
-                jchar result;
-                if (isStatic) {
-                    result = jEnv.GetStaticCharField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetCharField(targetJavaObject, fieldId);
-                }
-
-                JniLocalRef str(jEnv.NewString(&result, 1));
-                jboolean bol = true;
-                const char *resP = jEnv.GetStringUTFChars(str, &bol);
-                fieldResult = ArgConverter::convertToJsString(env, resP, 1);
-                jEnv.ReleaseStringUTFChars(str, resP);
-                break;
+    switch (fieldData->kind) {
+        case FieldKind::Boolean: {
+            jboolean result;
+            if (isStatic) {
+                result = jEnv.GetStaticBooleanField(clazz, fieldId);
+            } else {
+                result = jEnv.GetBooleanField(target, fieldId);
             }
-            case 'S': { // short
-                jshort result;
-                if (isStatic) {
-                    result = jEnv.GetStaticShortField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetShortField(targetJavaObject, fieldId);
-                }
-                napi_create_int32(env, result, &fieldResult);
-                break;
+            fieldResult =
+                    result == JNI_TRUE ? napi_util::get_true(env) : napi_util::get_false(env);
+            break;
+        }
+        case FieldKind::Byte: {
+            jbyte result;
+            if (isStatic) {
+                result = jEnv.GetStaticByteField(clazz, fieldId);
+            } else {
+                result = jEnv.GetByteField(target, fieldId);
             }
-            case 'I': { // int
-                jint result;
-                if (isStatic) {
-                    result = jEnv.GetStaticIntField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetIntField(targetJavaObject, fieldId);
-                }
-
-                napi_create_int32(env, result, &fieldResult);
-                break;
+            napi_create_int32(env, result, &fieldResult);
+            break;
+        }
+        case FieldKind::Char: {
+            jchar result;
+            if (isStatic) {
+                result = jEnv.GetStaticCharField(clazz, fieldId);
+            } else {
+                result = jEnv.GetCharField(target, fieldId);
             }
-            case 'J': { // long
-                jlong result;
-                if (isStatic) {
-                    result = jEnv.GetStaticLongField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetLongField(targetJavaObject, fieldId);
-                }
-
-                fieldResult = ArgConverter::ConvertFromJavaLong(env, result);
-                break;
+            fieldResult = ArgConverter::convertToJsString(env, &result, 1);
+            break;
+        }
+        case FieldKind::Short: {
+            jshort result;
+            if (isStatic) {
+                result = jEnv.GetStaticShortField(clazz, fieldId);
+            } else {
+                result = jEnv.GetShortField(target, fieldId);
             }
-            case 'F': { // float
-                jfloat result;
-                if (isStatic) {
-                    result = jEnv.GetStaticFloatField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetFloatField(targetJavaObject, fieldId);
-                }
-                napi_create_double(env, (double) result, &fieldResult);
-                break;
+            napi_create_int32(env, result, &fieldResult);
+            break;
+        }
+        case FieldKind::Int: {
+            jint result;
+            if (isStatic) {
+                result = jEnv.GetStaticIntField(clazz, fieldId);
+            } else {
+                result = jEnv.GetIntField(target, fieldId);
             }
-            case 'D': { // double
-                jdouble result;
-                if (isStatic) {
-                    result = jEnv.GetStaticDoubleField(clazz, fieldId);
-                } else {
-                    result = jEnv.GetDoubleField(targetJavaObject, fieldId);
-                }
-                napi_create_double(env, (double) result, &fieldResult);
-                break;
+            napi_create_int32(env, result, &fieldResult);
+            break;
+        }
+        case FieldKind::Long: {
+            jlong result;
+            if (isStatic) {
+                result = jEnv.GetStaticLongField(clazz, fieldId);
+            } else {
+                result = jEnv.GetLongField(target, fieldId);
             }
-            default: {
-                stringstream ss;
-                ss << "(InternalError): in FieldAccessor::GetJavaField: Unknown field type: '"
-                   << fieldTypeName[0] << "'";
-                throw NativeScriptException(ss.str());
+            fieldResult = ArgConverter::ConvertFromJavaLong(env, result);
+            break;
+        }
+        case FieldKind::Float: {
+            jfloat result;
+            if (isStatic) {
+                result = jEnv.GetStaticFloatField(clazz, fieldId);
+            } else {
+                result = jEnv.GetFloatField(target, fieldId);
             }
+            napi_create_double(env, (double) result, &fieldResult);
+            break;
         }
-    } else {
-        jobject result;
-
-        if (isStatic) {
-            result = jEnv.GetStaticObjectField(clazz, fieldId);
-        } else {
-            result = jEnv.GetObjectField(targetJavaObject, fieldId);
+        case FieldKind::Double: {
+            jdouble result;
+            if (isStatic) {
+                result = jEnv.GetStaticDoubleField(clazz, fieldId);
+            } else {
+                result = jEnv.GetDoubleField(target, fieldId);
+            }
+            napi_create_double(env, result, &fieldResult);
+            break;
         }
+        case FieldKind::String:
+        case FieldKind::Object: {
+            jobject result;
+            if (isStatic) {
+                result = jEnv.GetStaticObjectField(clazz, fieldId);
+            } else {
+                result = jEnv.GetObjectField(target, fieldId);
+            }
 
-        if (result != nullptr) {
+            if (result == nullptr) {
+                napi_get_null(env, &fieldResult);
+                break;
+            }
 
-            bool isString = fieldTypeName == "java/lang/String";
-            if (isString) {
+            if (fieldData->kind == FieldKind::String) {
                 fieldResult = ArgConverter::jstringToJsString(env, (jstring) result);
             } else {
                 int javaObjectID = objectManager->GetOrCreateObjectId(result);
                 auto objectResult = objectManager->GetJsObjectByJavaObject(javaObjectID);
 
                 if (napi_util::is_null_or_undefined(env, objectResult)) {
-                    objectResult = objectManager->CreateJSWrapper(javaObjectID, fieldTypeName,
+                    objectResult = objectManager->CreateJSWrapper(javaObjectID,
+                                                                  fieldData->metadata.getSig(),
                                                                   result);
                 }
 
                 fieldResult = objectResult;
             }
             jEnv.DeleteLocalRef(result);
-        } else {
-            napi_get_null(env, &fieldResult);
+            break;
+        }
+        default: {
+            stringstream ss;
+            ss << "(InternalError): in FieldAccessor::ReadField: Unresolved field '"
+               << fieldData->metadata.getName() << "'";
+            throw NativeScriptException(ss.str());
         }
     }
+
     return fieldResult;
 }
 
@@ -200,33 +285,10 @@ void FieldAccessor::SetJavaField(napi_env env, napi_value target, napi_value val
     JniLocalRef targetJavaObject;
 
     auto &fieldMetadata = fieldData->metadata;
-
-    const auto &fieldTypeName = fieldMetadata.getSig();
     auto isStatic = fieldMetadata.isStatic;
 
-    auto isPrimitiveType = fieldTypeName.size() == 1;
-    auto isFieldArray = fieldTypeName[0] == '[';
-
     if (fieldData->fid == nullptr) {
-        auto fieldJniSig = isPrimitiveType
-                           ? fieldTypeName
-                           : (isFieldArray
-                              ? fieldTypeName
-                              : ("L" + fieldTypeName + ";"));
-
-        if (isStatic) {
-            fieldData->clazz = jEnv.FindClass(fieldMetadata.getDeclaringType());
-            assert(fieldData->clazz != nullptr);
-            fieldData->fid = jEnv.GetStaticFieldID(fieldData->clazz, fieldMetadata.getName(),
-                                                   fieldJniSig);
-            assert(fieldData->fid != nullptr);
-        } else {
-            fieldData->clazz = jEnv.FindClass(fieldMetadata.getDeclaringType());
-            assert(fieldData->clazz != nullptr);
-            fieldData->fid = jEnv.GetFieldID(fieldData->clazz, fieldMetadata.getName(),
-                                             fieldJniSig);
-            assert(fieldData->fid != nullptr);
-        }
+        ResolveField(jEnv, fieldData);
     }
 
     if (!isStatic) {
@@ -244,123 +306,117 @@ void FieldAccessor::SetJavaField(napi_env env, napi_value target, napi_value val
     auto fieldId = fieldData->fid;
     auto clazz = fieldData->clazz;
 
-    if (isPrimitiveType) {
-        switch (fieldTypeName[0]) {
-            case 'Z': { // bool
-                // TODO: validate value is a boolean before calling
-                bool boolValue = napi_util::is_of_type(env, value, napi_boolean)
-                                 ? napi_util::get_bool(env, value) : false;
-                if (isStatic) {
-                    jEnv.SetStaticBooleanField(clazz, fieldId, boolValue);
-                } else {
-                    jEnv.SetBooleanField(targetJavaObject, fieldId,
-                                         boolValue);
-                }
-                break;
+    switch (fieldData->kind) {
+        case FieldKind::Boolean: {
+            // TODO: validate value is a boolean before calling
+            bool boolValue = napi_util::is_of_type(env, value, napi_boolean)
+                             ? napi_util::get_bool(env, value) : false;
+            if (isStatic) {
+                jEnv.SetStaticBooleanField(clazz, fieldId, boolValue);
+            } else {
+                jEnv.SetBooleanField(targetJavaObject, fieldId, boolValue);
             }
-            case 'B': { // byte
-                // TODO: validate value is a byte before calling
-                jbyte intValue = !napi_util::is_of_type(env, value, napi_number)
-                                 ? napi_util::get_int32(env, value) : 0;
-                if (isStatic) {
-                    jEnv.SetStaticByteField(clazz, fieldId, intValue);
-                } else {
-                    jEnv.SetByteField(targetJavaObject, fieldId, intValue);
-                }
-                break;
+            break;
+        }
+        case FieldKind::Byte: {
+            // TODO: validate value is a byte before calling
+            jbyte intValue = napi_util::is_of_type(env, value, napi_number)
+                             ? napi_util::get_int32(env, value) : 0;
+            if (isStatic) {
+                jEnv.SetStaticByteField(clazz, fieldId, intValue);
+            } else {
+                jEnv.SetByteField(targetJavaObject, fieldId, intValue);
             }
-            case 'C': { // char
-                const char *stringValue = napi_util::get_string_value(env, value, 1);
-                JniLocalRef strValue(jEnv.NewStringUTF(stringValue));
-                const char *chars = jEnv.GetStringUTFChars(strValue, 0);
+            break;
+        }
+        case FieldKind::Char: {
+            auto stringValue = napi_util::is_of_type(env, value, napi_string)
+                               ? ArgConverter::ConvertToUtf16String(env, value) : u16string();
+            jchar charValue = stringValue.empty() ? 0 : (jchar) stringValue[0];
 
-                if (isStatic) {
-                    jEnv.SetStaticCharField(clazz, fieldId, chars[0]);
-                } else {
-                    jEnv.SetCharField(targetJavaObject, fieldId, chars[0]);
-                }
-                jEnv.ReleaseStringUTFChars(strValue, chars);
-                break;
+            if (isStatic) {
+                jEnv.SetStaticCharField(clazz, fieldId, charValue);
+            } else {
+                jEnv.SetCharField(targetJavaObject, fieldId, charValue);
             }
-            case 'S': { // short
-                // TODO: validate value is a short before calling
-                short shortValue = !napi_util::is_of_type(env, value, napi_number)
-                                   ? napi_util::get_int32(env, value) : 0;
-                if (isStatic) {
-                    jEnv.SetStaticShortField(clazz, fieldId, shortValue);
-                } else {
-                    jEnv.SetShortField(targetJavaObject, fieldId, shortValue);
-                }
-                break;
+            break;
+        }
+        case FieldKind::Short: {
+            // TODO: validate value is a short before calling
+            jshort shortValue = napi_util::is_of_type(env, value, napi_number)
+                                ? napi_util::get_int32(env, value) : 0;
+            if (isStatic) {
+                jEnv.SetStaticShortField(clazz, fieldId, shortValue);
+            } else {
+                jEnv.SetShortField(targetJavaObject, fieldId, shortValue);
             }
-            case 'I': { // int
-                // TODO: validate value is a int before calling
-                int intValue = napi_util::is_of_type(env, value, napi_number)
-                               ? napi_util::get_int32(env, value) : 0;
-                if (isStatic) {
-                    jEnv.SetStaticIntField(clazz, fieldId, intValue);
-                } else {
-                    jEnv.SetIntField(targetJavaObject, fieldId, intValue);
-                }
-                break;
+            break;
+        }
+        case FieldKind::Int: {
+            // TODO: validate value is a int before calling
+            int intValue = napi_util::is_of_type(env, value, napi_number)
+                           ? napi_util::get_int32(env, value) : 0;
+            if (isStatic) {
+                jEnv.SetStaticIntField(clazz, fieldId, intValue);
+            } else {
+                jEnv.SetIntField(targetJavaObject, fieldId, intValue);
             }
-            case 'J': { // long
-                jlong longValue = static_cast<jlong>(ArgConverter::ConvertToJavaLong(env, value));
-                if (isStatic) {
-                    jEnv.SetStaticLongField(clazz, fieldId, longValue);
-                } else {
-                    jEnv.SetLongField(targetJavaObject, fieldId, longValue);
-                }
-                break;
+            break;
+        }
+        case FieldKind::Long: {
+            jlong longValue = static_cast<jlong>(ArgConverter::ConvertToJavaLong(env, value));
+            if (isStatic) {
+                jEnv.SetStaticLongField(clazz, fieldId, longValue);
+            } else {
+                jEnv.SetLongField(targetJavaObject, fieldId, longValue);
             }
-            case 'F': { // float
-                float floatValue = napi_util::is_of_type(env, value, napi_number)
-                                   ? napi_util::get_number(env,
-                                                           value) : 0.0;
-                if (isStatic) {
-                    jEnv.SetStaticFloatField(clazz, fieldId,
-                                             static_cast<jfloat>(floatValue));
-                } else {
-                    jEnv.SetFloatField(targetJavaObject, fieldId,
-                                       static_cast<jfloat>(floatValue));
-                }
-                break;
+            break;
+        }
+        case FieldKind::Float: {
+            float floatValue = napi_util::is_of_type(env, value, napi_number)
+                               ? napi_util::get_number(env, value) : 0.0;
+            if (isStatic) {
+                jEnv.SetStaticFloatField(clazz, fieldId, static_cast<jfloat>(floatValue));
+            } else {
+                jEnv.SetFloatField(targetJavaObject, fieldId, static_cast<jfloat>(floatValue));
+            }
+            break;
+        }
+        case FieldKind::Double: {
+            double doubleValue = napi_util::is_of_type(env, value, napi_number)
+                                 ? napi_util::get_number(env, value) : 0.0;
+            if (isStatic) {
+                jEnv.SetStaticDoubleField(clazz, fieldId, doubleValue);
+            } else {
+                jEnv.SetDoubleField(targetJavaObject, fieldId, doubleValue);
             }
-            case 'D': { // double
-                double doubleValue = napi_util::is_of_type(env, value, napi_number)
-                                     ? napi_util::get_number(env,
-                                                             value) : 0.0;
-                if (isStatic) {
-                    jEnv.SetStaticDoubleField(clazz, fieldId, doubleValue);
+            break;
+        }
+        case FieldKind::String:
+        case FieldKind::Object: {
+            JniLocalRef result;
+
+            if (!napi_util::is_null(env, value) && !napi_util::is_undefined(env, value)) {
+                if (fieldData->kind == FieldKind::String) {
+                    // TODO: validate valie is a string;
+                    result = ArgConverter::ConvertToJavaString(env, value);
                 } else {
-                    jEnv.SetDoubleField(targetJavaObject, fieldId, doubleValue);
+                    result = objectManager->GetJavaObjectByJsObject(value);
                 }
-                break;
             }
-            default: {
-                stringstream ss;
-                ss << "(InternalError): in FieldAccessor::SetJavaField: Unknown field type: '"
-                   << fieldTypeName[0] << "'";
-                throw NativeScriptException(ss.str());
-            }
-        }
-    } else {
-        bool isString = fieldTypeName == "java/lang/String";
-        JniLocalRef result;
 
-        if (!napi_util::is_null(env, value) && !napi_util::is_undefined(env, value)) {
-            if (isString) {
-                // TODO: validate valie is a string;
-                result = ArgConverter::ConvertToJavaString(env, value);
+            if (isStatic) {
+                jEnv.SetStaticObjectField(clazz, fieldId, result);
             } else {
-                result = objectManager->GetJavaObjectByJsObject(value);
+                jEnv.SetObjectField(targetJavaObject, fieldId, result);
             }
+            break;
         }
-
-        if (isStatic) {
-            jEnv.SetStaticObjectField(clazz, fieldId, result);
-        } else {
-            jEnv.SetObjectField(targetJavaObject, fieldId, result);
+        default: {
+            stringstream ss;
+            ss << "(InternalError): in FieldAccessor::SetJavaField: Unresolved field '"
+               << fieldMetadata.getName() << "'";
+            throw NativeScriptException(ss.str());
         }
     }
 }
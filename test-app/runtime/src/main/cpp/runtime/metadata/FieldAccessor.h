@@ -12,6 +12,18 @@ class FieldAccessor {
         napi_value GetJavaField(napi_env env, napi_value target, FieldCallbackData* fieldData);
 
         void SetJavaField(napi_env env, napi_value target, napi_value value, FieldCallbackData* fieldData);
+
+        /*
+         * Reads the instance fields listed in `names` (an array of strings) into a new plain object,
+         * resolving the Java object once. Names that are not Java instance fields of the target are
+         * read as regular JS properties.
+         */
+        napi_value GetJavaFields(napi_env env, napi_value target, napi_value names);
+
+    private:
+        static void ResolveField(JEnv& jEnv, FieldCallbackData* fieldData);
+
+        static napi_value ReadField(napi_env env, JEnv& jEnv, ObjectManager* objectManager, jobject target, FieldCallbackData* fieldData);
 };
 }
 
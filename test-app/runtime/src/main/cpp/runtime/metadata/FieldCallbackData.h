@@ -5,16 +5,32 @@
 #include "MetadataEntry.h"
 
 namespace tns {
+    enum class FieldKind : uint8_t {
+        Unresolved,
+        Boolean,
+        Byte,
+        Char,
+        Short,
+        Int,
+        Long,
+        Float,
+        Double,
+        String,
+        Object
+    };
+
     struct FieldCallbackData {
         FieldCallbackData(MetadataEntry metadata)
                 :
-                metadata(metadata), fid(nullptr), clazz(nullptr) {
+                metadata(metadata), fid(nullptr), clazz(nullptr), kind(FieldKind::Unresolved) {
 
         }
 
         MetadataEntry metadata;
         jfieldID fid;
         jclass clazz;
+        // resolved together with fid on first access
+        FieldKind kind;
     };
 
 }
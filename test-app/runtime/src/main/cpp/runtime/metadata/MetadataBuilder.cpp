@@ -10,6 +10,7 @@
 #include <set>
 #include <cerrno>
 #include <unistd.h>
+#include <sys/time.h>
 #include "NativeScriptException.h"
 #include "NativeScriptAssert.h"
 #include "File.h"
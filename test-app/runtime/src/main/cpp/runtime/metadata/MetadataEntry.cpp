@@ -2,6 +2,7 @@
 #include "MetadataEntry.h"
 #include "MetadataMethodInfo.h"
 #include "MetadataReader.h"
+#include "JniSignatureParser.h"
 
 using namespace tns;
 
@@ -121,6 +122,15 @@ bool MetadataEntry::getIsFinal() {
     return isFinal;
 }
 
+std::vector<std::string> &MetadataEntry::getParsedSig() {
+    if (!parsedSig.empty()) return parsedSig;
+
+    JniSignatureParser parser(getSig());
+    parsedSig = parser.Parse();
+
+    return parsedSig;
+}
+
 bool MetadataEntry::getIsResolved() {
     if (isResolvedSet) return isResolved;
 
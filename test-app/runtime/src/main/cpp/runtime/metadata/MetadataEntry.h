@@ -82,6 +82,9 @@ namespace tns {
 
         bool getIsResolved();
 
+        // the JNI types of the parameters in the signature
+        std::vector<std::string> &getParsedSig();
+
         MetadataTreeNode *treeNode;
         NodeType type;
         bool isExtensionFunction;
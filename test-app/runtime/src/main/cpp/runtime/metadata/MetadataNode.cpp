@@ -726,10 +726,34 @@ MetadataTreeNode *MetadataNode::GetOrCreateTreeNodeByName(const string &classNam
     return result;
 }
 
-string MetadataNode::GetName() {
+const string &MetadataNode::GetName() {
     return m_name;
 }
 
+FieldCallbackData *MetadataNode::GetInstanceField(napi_env env, const std::string &name) {
+    auto cache = GetMetadataNodeCache(env);
+    auto treeNode = m_treeNode;
+
+    // same walk as GetConstructorFunctionInternal, the most derived declaration wins
+    while (treeNode != nullptr) {
+        auto fields = cache->instanceFieldCallbackData.find(treeNode);
+        if (fields != cache->instanceFieldCallbackData.end()) {
+            auto field = fields->second.find(name);
+            if (field != fields->second.end()) {
+                return field->second;
+            }
+        }
+
+        auto baseTreeNode = s_metadataReader.GetBaseClassNode(treeNode);
+        if (baseTreeNode == treeNode || baseTreeNode == nullptr || baseTreeNode->offsetValue <= 0) {
+            break;
+        }
+        treeNode = baseTreeNode;
+    }
+
+    return nullptr;
+}
+
 MetadataNode *MetadataNode::GetOrCreate(const string &className) {
     MetadataNode *node = nullptr;
     
@@ -1145,7 +1169,9 @@ std::vector<MetadataNode::MethodCallbackData *> MetadataNode::SetClassMembersFro
                                    FieldAccessorGetterCallback, FieldAccessorSetterCallback,
                                    fieldInfo);
 
-        MetadataNode::GetMetadataNodeCache(env)->fieldCallbackData.push_back(fieldInfo);
+        auto cache = MetadataNode::GetMetadataNodeCache(env);
+        cache->fieldCallbackData.push_back(fieldInfo);
+        cache->instanceFieldCallbackData[treeNode].emplace(fieldName, fieldInfo);
 
     }
 
@@ -1328,7 +1354,9 @@ std::vector<MetadataNode::MethodCallbackData *> MetadataNode::SetInstanceMembers
                                        FieldAccessorGetterCallback, FieldAccessorSetterCallback,
                                        fieldInfo);
 
-            MetadataNode::GetMetadataNodeCache(env)->fieldCallbackData.push_back(fieldInfo);
+            auto cache = MetadataNode::GetMetadataNodeCache(env);
+            cache->fieldCallbackData.push_back(fieldInfo);
+            cache->instanceFieldCallbackData[treeNode].emplace(entry.name, fieldInfo);
         }
     }
 
@@ -54,7 +54,13 @@ public:
     static napi_value CreateExtendedJSWrapper(napi_env env, ObjectManager *objectManager,
                                        const std::string &proxyClassName, int javaObjectID);
 
-    std::string GetName();
+    const std::string &GetName();
+
+    /*
+     * Finds the accessor data of the instance field `name` declared by this class or one of its
+     * base classes, nullptr if there is no such field or it has not been defined yet
+     */
+    FieldCallbackData *GetInstanceField(napi_env env, const std::string &name);
 
     static void onDisposeEnv(napi_env env);
 
@@ -295,6 +301,8 @@ private:
         robin_hood::unordered_map<MetadataTreeNode *, CtorCacheData> CtorFuncCache;
         robin_hood::unordered_map<std::string, MetadataNode::ExtendedClassCacheData> ExtendedCtorFuncCache;
         std::vector<FieldCallbackData *> fieldCallbackData;
+        // instance fields by declaring class, for lookups that bypass the prototype accessors
+        robin_hood::unordered_map<MetadataTreeNode *, robin_hood::unordered_map<std::string, FieldCallbackData *>> instanceFieldCallbackData;
     };
 
     static bool s_profilerEnabled;
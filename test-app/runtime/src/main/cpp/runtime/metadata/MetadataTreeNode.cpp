@@ -1,4 +1,5 @@
 #include "MetadataTreeNode.h"
+#include <algorithm>
 
 using namespace std;
 using namespace tns;
@@ -1,6 +1,7 @@
 #ifndef METHODCACHE_H_
 #define METHODCACHE_H_
 
+#include <deque>
 #include <string>
 #include <map>
 #include "JEnv.h"
@@ -13,6 +14,7 @@
 #include "NumericCasts.h"
 #include "NativeScriptException.h"
 #include "JsArgToArrayConverter.h"
+#include "JniSignatureParser.h"
 #include "Util.h"
 
 namespace tns {
@@ -30,6 +32,8 @@ class MethodCache {
                 retType(MethodReturnType::Unknown), mid(nullptr), clazz(nullptr), isStatic(false) {
             }
             std::string signature;
+            // the JNI types of the parameters in the signature
+            std::vector<std::string> parsedSig;
             std::string returnType;
             MethodReturnType retType;
             jmethodID mid;
@@ -39,49 +43,53 @@ class MethodCache {
 
         static void Init();
 
-    inline static MethodCache::CacheMethodInfo ResolveMethodSignature(napi_env env, const string &className, const string &methodName, size_t argc, napi_value* argv, bool isStatic)
+    /*
+     * The cached method, nullptr when Java has none for the arguments. The cache keeps it, so
+     * that the calls after the first one don't allocate.
+     */
+    inline static const MethodCache::CacheMethodInfo *ResolveMethodSignature(napi_env env, const string &className, const string &methodName, size_t argc, napi_value* argv, bool isStatic)
     {
-        CacheMethodInfo method_info;
-
-        auto encoded_method_signature = EncodeSignature(env, className, methodName,argc, argv, isStatic);
-        auto it = s_method_ctor_signature_cache.find(encoded_method_signature);
+        auto &encoded = EncodeSignature(env, className, methodName,argc, argv, isStatic);
+        auto it = s_method_ctor_signature_cache.find(encoded);
 
-        if (it == s_method_ctor_signature_cache.end())
+        if (it != s_method_ctor_signature_cache.end())
         {
-            auto signature = ResolveJavaMethod(env, argc, argv, className, methodName);
+            return &(*it).second;
+        }
 
-            DEBUG_WRITE("ResolveMethodSignature %s='%s'", encoded_method_signature.c_str(), signature.c_str());
+        // the buffer is reused by the calls that resolving the method makes
+        string encoded_method_signature(encoded);
+        auto signature = ResolveJavaMethod(env, argc, argv, className, methodName);
 
-            if (!signature.empty())
-            {
-                JEnv jEnv;
-                auto clazz = jEnv.FindClass(className);
-                assert(clazz != nullptr);
-                method_info.clazz = clazz;
-                method_info.signature = signature;
-                method_info.returnType = MetadataReader::ParseReturnType(method_info.signature);
-                method_info.retType = MetadataReader::GetReturnType(method_info.returnType);
-                method_info.isStatic = isStatic;
-                method_info.mid = isStatic
-                                  ? jEnv.GetStaticMethodID(clazz, methodName, signature)
-                                  : jEnv.GetMethodID(clazz, methodName, signature);
-
-                s_method_ctor_signature_cache.emplace(encoded_method_signature, method_info);
-            }
-        }
-        else
+        DEBUG_WRITE("ResolveMethodSignature %s='%s'", encoded_method_signature.c_str(), signature.c_str());
+
+        if (signature.empty())
         {
-            method_info = (*it).second;
+            return nullptr;
         }
 
-        return method_info;
+        CacheMethodInfo method_info;
+        JEnv jEnv;
+        auto clazz = jEnv.FindClass(className);
+        assert(clazz != nullptr);
+        method_info.clazz = clazz;
+        method_info.signature = signature;
+        method_info.parsedSig = JniSignatureParser(signature).Parse();
+        method_info.returnType = MetadataReader::ParseReturnType(method_info.signature);
+        method_info.retType = MetadataReader::GetReturnType(method_info.returnType);
+        method_info.isStatic = isStatic;
+        method_info.mid = isStatic
+                          ? jEnv.GetStaticMethodID(clazz, methodName, signature)
+                          : jEnv.GetMethodID(clazz, methodName, signature);
+
+        return &(*s_method_ctor_signature_cache.emplace(encoded_method_signature, method_info).first).second;
     }
 
     inline static MethodCache::CacheMethodInfo ResolveConstructorSignature(napi_env env, const ArgsWrapper &argWrapper, const string &fullClassName, jclass javaClass, bool isInterface)
     {
         CacheMethodInfo constructor_info;
 
-        auto encoded_ctor_signature = EncodeSignature(env, fullClassName, "<init>", argWrapper.argc, argWrapper.argv, false);
+        string encoded_ctor_signature(EncodeSignature(env, fullClassName, "<init>", argWrapper.argc, argWrapper.argv, false));
         auto it = s_method_ctor_signature_cache.find(encoded_ctor_signature);
 
         if (it == s_method_ctor_signature_cache.end())
@@ -112,10 +120,20 @@ private:
         MethodCache() {
         }
 
-    // Encoded signature <className>.S/I.<methodName>.<argsCount>.<arg1class>.<...>
-    inline static string EncodeSignature(napi_env env, const string &className, const string &methodName, size_t argc, napi_value* argv, bool isStatic)
+    // Encoded signature <className>.S/I.<methodName>.<argsCount>.<arg1class>.<...>, in a buffer of
+    // the thread that is valid until the next call. The getters AppendType reads can run JS that
+    // resolves another method, so each nested call encodes into a buffer of its own.
+    inline static const string &EncodeSignature(napi_env env, const string &className, const string &methodName, size_t argc, napi_value* argv, bool isStatic)
     {
-        string sig(className);
+        // a deque keeps the buffers of the outer calls in place as it grows
+        thread_local std::deque<string> t_sigs;
+        thread_local size_t t_depth = 0;
+        if (t_sigs.size() == t_depth)
+        {
+            t_sigs.emplace_back();
+        }
+        auto &sig = t_sigs[t_depth];
+        sig.assign(className);
         sig.append(".");
         if (isStatic)
         {
@@ -128,24 +146,30 @@ private:
         sig.append(methodName);
         sig.append(".");
 
-        stringstream s;
-        s << argc;
-        sig.append(s.str());
+        char count[24];
+        snprintf(count, sizeof(count), "%zu", argc);
+        sig.append(count);
 
+        // AppendType throws for values it cannot convert
+        struct Nested {
+            Nested() { t_depth++; }
+            ~Nested() { t_depth--; }
+        } nested;
         for (int i = 0; i < argc; i++)
         {
             sig.append(".");
-            sig.append(GetType(env, argv[i]));
+            AppendType(env, argv[i], sig);
         }
 
         return sig;
     }
 
-    inline static string GetType(napi_env env, napi_value value)
+    // Appends the type of the value to the encoded signature
+    inline static void AppendType(napi_env env, napi_value value, string &sig)
     {
         napi_valuetype valueType;
         napi_typeof(env, value, &valueType);
-        string type = "";
+        const char *type = "";
 
         if (valueType == napi_object || valueType == napi_function)
         {
@@ -159,10 +183,14 @@ private:
                 napi_get_value_external(env, nullNode, &data);
                 auto treeNode = reinterpret_cast<MetadataNode *>(data);
 
-                type = (treeNode != nullptr) ? treeNode->GetName() : "<unknown>";
+                if (treeNode != nullptr) {
+                    sig.append(treeNode->GetName());
+                } else {
+                    sig.append("<unknown>");
+                }
 
-                DEBUG_WRITE("Parameter of type %s with NULL value is passed to the method.", type.c_str());
-                return type;
+                DEBUG_WRITE("Parameter of type %s with NULL value is passed to the method.", sig.c_str());
+                return;
             }
         }
 
@@ -172,73 +200,16 @@ private:
         } else if (valueType == napi_null) {
             type = "null";
         } else if (valueType == napi_undefined) {
-            type = "undefined";
+            type = "null";
         } else if (valueType == napi_number) {
-            type = "number";
-        } else if (valueType == napi_object) {
-            type = "object";
-        } else if (napi_util::is_array(env, value)) {
-            type = "array";
-        } else if (valueType == napi_function) {
-            type = "function";
-        } else if (napi_util::is_typedarray(env, value)) {
-            type = "typedarray";
-        } else if (valueType == napi_boolean) {
-            type = "bool";
-        } else if (napi_util::is_dataview(env, value)) {
-            type = "view";
-        } else if (napi_util::is_date(env, value)) {
-            type = "date";
-        }
-
-        // Handle special cases for typed arrays
-        if (type == "typedarray")
-        {
-            napi_typedarray_type arrayType;
-            napi_get_typedarray_info(env, value, &arrayType, nullptr, nullptr, nullptr, nullptr);
-            switch (arrayType)
-            {
-                case napi_int8_array:
-                case napi_uint8_array:
-                case napi_uint8_clamped_array:
-                    type = "bytebuffer";
-                    break;
-                case napi_int16_array:
-                case napi_uint16_array:
-                    type = "shortbuffer";
-                    break;
-                case napi_int32_array:
-                case napi_uint32_array:
-                    type = "intbuffer";
-                    break;
-                case napi_bigint64_array:
-                case napi_biguint64_array:
-                    type = "longbuffer";
-                    break;
-                case napi_float32_array:
-                    type = "floatbuffer";
-                    break;
-                case napi_float64_array:
-                    type = "doublebuffer";
-                    break;
-                default:
-                    type = "<unknown>";
-            }
-        }
-
-        // Handle special cases for numbers
-        if (type == "number")
-        {
+            // Handle special cases for numbers
             double d;
             napi_get_value_double(env, value, &d);
             int64_t i = (int64_t)d;
             bool isInteger = d == i;
             type = isInteger ? "intnumber" : "doublenumber";
-        }
-
-        // Handle special cases for objects
-        if (type == "object" || type == "function")
-        {
+        } else if (valueType == napi_object || valueType == napi_function) {
+            // Handle special cases for objects
             auto castType = NumericCasts::GetCastType(env, value);
             MetadataNode *node;
 
@@ -264,35 +235,73 @@ private:
                     break;
                 case CastType::None:
                     node = MetadataNode::GetNodeFromHandle(env, value);
-                    type = (node != nullptr) ? node->GetName() : "<unknown>";
-
-                    if (type == "<unknown>") {
-                        if (napi_util::is_number_object(env, value)) {
-                            napi_value numValue = napi_util::valueOf(env, value);
-                            bool isFloat = napi_util::is_float(env, numValue);
-                            if (isFloat) {
-                                type = "float";
-                            } else {
-                                type = "int";
-                            }
-                        } else if (napi_util::is_string_object(env, value)) {
-                            type = "string";
-                        } else if (napi_util::is_number_object(env, value)) {
-                            type = "bool";
+                    if (node != nullptr) {
+                        sig.append(node->GetName());
+                        return;
+                    }
+
+                    type = "<unknown>";
+                    if (napi_util::is_number_object(env, value)) {
+                        napi_value numValue = napi_util::valueOf(env, value);
+                        bool isFloat = napi_util::is_float(env, numValue);
+                        if (isFloat) {
+                            type = "float";
+                        } else {
+                            type = "int";
                         }
+                    } else if (napi_util::is_string_object(env, value)) {
+                        type = "string";
+                    } else if (napi_util::is_number_object(env, value)) {
+                        type = "bool";
                     }
 
                     break;
                 default:
                     throw NativeScriptException("Unsupported cast type");
             }
+        } else if (napi_util::is_array(env, value)) {
+            type = "array";
+        } else if (napi_util::is_typedarray(env, value)) {
+            // Handle special cases for typed arrays
+            napi_typedarray_type arrayType;
+            napi_get_typedarray_info(env, value, &arrayType, nullptr, nullptr, nullptr, nullptr);
+            switch (arrayType)
+            {
+                case napi_int8_array:
+                case napi_uint8_array:
+                case napi_uint8_clamped_array:
+                    type = "bytebuffer";
+                    break;
+                case napi_int16_array:
+                case napi_uint16_array:
+                    type = "shortbuffer";
+                    break;
+                case napi_int32_array:
+                case napi_uint32_array:
+                    type = "intbuffer";
+                    break;
+                case napi_bigint64_array:
+                case napi_biguint64_array:
+                    type = "longbuffer";
+                    break;
+                case napi_float32_array:
+                    type = "floatbuffer";
+                    break;
+                case napi_float64_array:
+                    type = "doublebuffer";
+                    break;
+                default:
+                    type = "<unknown>";
+            }
+        } else if (valueType == napi_boolean) {
+            type = "bool";
+        } else if (napi_util::is_dataview(env, value)) {
+            type = "view";
+        } else if (napi_util::is_date(env, value)) {
+            type = "date";
         }
 
-        if (type == "undefined") {
-            type = "null";
-        }
-
-        return type;
+        sig.append(type);
     }
 
     inline static string ResolveJavaMethod(napi_env env , size_t argc, napi_value* argv, const string &className, const string &methodName)
@@ -361,7 +370,7 @@ private:
          *  Used for caching the resolved constructor or method signature.
          * The encoded signature has template: <className>.S/I.<methodName>.<argsCount>.<arg1class>.<...>
          */
-        static robin_hood::unordered_map<std::string, CacheMethodInfo> s_method_ctor_signature_cache;
+        static robin_hood::unordered_node_map<std::string, CacheMethodInfo> s_method_ctor_signature_cache;
 };
 }
 
@@ -1,4 +1,5 @@
 #include "ModuleInternal.h"
+#include "ModuleResolver.h"
 #include "File.h"
 #include "JniLocalRef.h"
 #include "ArgConverter.h"
@@ -8,6 +9,8 @@
 #include "Util.h"
 #include "CallbackHandlers.h"
 #include "Runtime.h"
+#include "Performance.h"
+#include "Tracing.h"
 #include <sstream>
 #include <mutex>
 #include <libgen.h>
@@ -42,15 +45,6 @@ void ModuleInternal::DeInit() {
 
 void ModuleInternal::Init(napi_env env, const std::string& baseDir) {
     napi_status status;
-    JEnv jenv;
-
-    if (MODULE_CLASS == nullptr) {
-        MODULE_CLASS = jenv.FindClass("com/tns/Module");
-        assert(MODULE_CLASS != nullptr);
-
-        RESOLVE_PATH_METHOD_ID = jenv.GetStaticMethodID(MODULE_CLASS, "resolvePath", "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;");
-        assert(RESOLVE_PATH_METHOD_ID != nullptr);
-    }
 
     m_env = env;
 
@@ -90,6 +84,14 @@ void ModuleInternal::Init(napi_env env, const std::string& baseDir) {
     assert(status == napi_ok);
 }
 
+void ModuleInternal::StartPreload(const std::string& listPath) {
+    m_preloader.Start(listPath, Constants::APP_ROOT_FOLDER_PATH, MODULE_PARAMS, MODULE_PARAM_COUNT);
+}
+
+void ModuleInternal::FinishPreload() {
+    m_preloader.Finish();
+}
+
 napi_value ModuleInternal::GetRequireFunction(napi_env env, const std::string& dirName) {
     napi_value requireFunc;
 
@@ -213,10 +215,7 @@ void ModuleInternal::LoadWorker(napi_env env, const string& path) {
 }
 
 void ModuleInternal::CheckFileExists(napi_env env, const std::string& path, const std::string& baseDir) {
-    JEnv jEnv;
-    JniLocalRef jsModulename(jEnv.NewStringUTF(path.c_str()));
-    JniLocalRef jsBaseDir(jEnv.NewStringUTF(baseDir.c_str()));
-    jEnv.CallStaticObjectMethod(MODULE_CLASS, RESOLVE_PATH_METHOD_ID, (jstring) jsModulename, (jstring) jsBaseDir);
+    ModuleResolver::Resolve(env, path, baseDir);
 }
 
 napi_value ModuleInternal::LoadInternalModule(napi_env env, const std::string& moduleName) {
@@ -238,14 +237,9 @@ napi_value ModuleInternal::LoadInternalModule(napi_env env, const std::string& m
 }
 
 napi_value ModuleInternal::LoadImpl(napi_env env, const std::string& moduleName, const std::string& baseDir, bool& isData) {
-    auto pathKind = GetModulePathKind(moduleName);
-    auto cachePathKey = (pathKind == ModulePathKind::Global) ? moduleName : (baseDir + "*" + moduleName);
-
     napi_value result;
 
-    DEBUG_WRITE(">>LoadImpl cachePathKey=%s", cachePathKey.c_str());
-
-    auto it = m_loadedModules.find(cachePathKey);
+    DEBUG_WRITE(">>LoadImpl moduleName=%s baseDir=%s", moduleName.c_str(), baseDir.c_str());
 
     /**
      * Load internal modules like url,fs etc directly if someone does
@@ -254,49 +248,36 @@ napi_value ModuleInternal::LoadImpl(napi_env env, const std::string& moduleName,
     napi_value moduleObj = ModuleInternal::LoadInternalModule(env, moduleName);
     if (moduleObj) return moduleObj;
 
-    if (it == m_loadedModules.end()) {
-        std::string path;
-
-        // Search App System libs
-        std::string sys_lib("system_lib://");
-        if (moduleName.rfind(sys_lib, 0) == 0) {
-            auto pos = moduleName.find(sys_lib);
-            path = std::string(moduleName);
-            path.replace(pos, sys_lib.length(), "");
-        } else if (Util::EndsWith(moduleName, ".so")) {
-            path = "lib" + moduleName;
-        } else if (Util::EndsWith(moduleName, ".node")) {
-            std::string libName = moduleName;
-            Util::ReplaceAll(libName, ".node", "");
-            path = "lib" + libName + ".so";
-        } else {
-            JEnv jenv;
-            JniLocalRef jsModulename(jenv.NewStringUTF(moduleName.c_str()));
-            JniLocalRef jsBaseDir(jenv.NewStringUTF(baseDir.c_str()));
-            JniLocalRef jsModulePath(
-                    jenv.CallStaticObjectMethod(MODULE_CLASS, RESOLVE_PATH_METHOD_ID,
-                                               (jstring) jsModulename, (jstring) jsBaseDir));
-
-            path = ArgConverter::jstringToString((jstring) jsModulePath);
-        }
+    std::string libPath;
+    const std::string* path = &libPath;
+
+    // Search App System libs
+    std::string sys_lib("system_lib://");
+    if (moduleName.rfind(sys_lib, 0) == 0) {
+        libPath = moduleName.substr(sys_lib.length());
+    } else if (Util::EndsWith(moduleName, ".so")) {
+        libPath = "lib" + moduleName;
+    } else if (Util::EndsWith(moduleName, ".node")) {
+        std::string libName = moduleName;
+        Util::ReplaceAll(libName, ".node", "");
+        libPath = "lib" + libName + ".so";
+    } else {
+        // memoized, repeated requires of the same module only cost two lookups
+        path = &ModuleResolver::Resolve(env, moduleName, baseDir);
+    }
 
-        auto it2 = m_loadedModules.find(path);
+    auto it = m_loadedModules.find(*path);
 
-        if (it2 == m_loadedModules.end()) {
-            if (Util::EndsWith(path, ".js") || Util::EndsWith(path, ".so")) {
-                isData = false;
-                result = LoadModule(env, path, cachePathKey);
-            } else if (Util::EndsWith(path, ".json")) {
-                isData = true;
-                result = LoadData(env, path);
-            } else {
-                std::string errMsg = "Unsupported file extension: " + path;
-                throw NativeScriptException(errMsg);
-            }
+    if (it == m_loadedModules.end()) {
+        if (Util::EndsWith(*path, ".js") || Util::EndsWith(*path, ".so")) {
+            isData = false;
+            result = LoadModule(env, *path);
+        } else if (Util::EndsWith(*path, ".json")) {
+            isData = true;
+            result = LoadData(env, *path);
         } else {
-            auto& cacheEntry = it2->second;
-            isData = cacheEntry.isData;
-            result = napi_util::get_ref_value(env, cacheEntry.obj);
+            std::string errMsg = "Unsupported file extension: " + *path;
+            throw NativeScriptException(errMsg);
         }
     } else {
         auto& cacheEntry = it->second;
@@ -315,7 +296,8 @@ std::string ModuleInternal::EnsureFileProtocol(const std::string& path) {
     return path;
 }
 
-napi_value ModuleInternal::LoadModule(napi_env env, const std::string& modulePath, const std::string& moduleCacheKey) {
+napi_value ModuleInternal::LoadModule(napi_env env, const std::string& modulePath) {
+    instrumentation::TraceScope trace("LoadModule", modulePath);
     napi_value result;
 
     napi_value context;
@@ -334,15 +316,14 @@ napi_value ModuleInternal::LoadModule(napi_env env, const std::string& modulePat
     napi_set_named_property(env, moduleObj, "filename", fullRequiredModulePath);
 
     napi_ref poModuleObj = napi_util::make_ref(env, moduleObj);
-    TempModule tempModule(this, modulePath, moduleCacheKey, poModuleObj);
+    TempModule tempModule(this, modulePath, poModuleObj);
 
     napi_value moduleFunc;
 
     if (Util::EndsWith(modulePath, ".js")) {
-        napi_value script = LoadScript(env, modulePath, fullRequiredModulePath);
         DEBUG_WRITE("%s", modulePath.c_str());
 
-        napi_status status = js_execute_script(env, script, EnsureFileProtocol(modulePath).c_str(), &moduleFunc);
+        napi_status status = CompileModuleFunction(env, modulePath, &moduleFunc);
         if (status != napi_ok) {
             bool pendingException;
             napi_is_exception_pending(env, &pendingException);
@@ -426,14 +407,12 @@ napi_value ModuleInternal::LoadModule(napi_env env, const std::string& modulePat
     return result;
 }
 
-napi_value ModuleInternal::LoadScript(napi_env env, const std::string& path, napi_value fullRequiredModulePath) {
-    napi_value scriptText = ModuleInternal::WrapModuleContent(env, path);
-    return scriptText;
-}
-
 napi_value ModuleInternal::LoadData(napi_env env, const std::string& path) {
-    std::string jsonData = Runtime::GetRuntime(m_env)->ReadFileText(path);
-    napi_value json = JsonParseString(env, jsonData);
+    FileContent content;
+    if (!Runtime::GetRuntime(m_env)->ReadFileContent(path, content)) {
+        throw NativeScriptException("Cannot read file " + path);
+    }
+    napi_value json = JsonParseString(env, content.data, content.length);
 
     if (!napi_util::is_of_type(env, json, napi_object)) {
         bool pendingException;
@@ -452,42 +431,42 @@ napi_value ModuleInternal::LoadData(napi_env env, const std::string& path) {
     return json;
 }
 
-napi_value ModuleInternal::WrapModuleContent(napi_env env, const std::string& path) {
+napi_status ModuleInternal::CompileModuleFunction(napi_env env, const std::string& path, napi_value* result) {
+    auto runtime = Runtime::GetRuntime(m_env);
+    auto performance = runtime->GetPerformance();
+    auto start = performance->Now();
 
-    std::string content = Runtime::GetRuntime(m_env)->ReadFileText(path);
-
-    // TODO: Use statically allocated buffer for better performance
-    std::string result(MODULE_PROLOGUE);
-    result.reserve(content.length() + 1024);
-    result += content;
-    result += MODULE_EPILOGUE;
+    FileContent content;
+    if (!m_preloader.Take(path, content) && !runtime->ReadFileContent(path, content)) {
+        throw NativeScriptException("Cannot read module file " + path);
+    }
+    m_preloader.Record(path);
+
+    // sources mapped from the APK live as long as the process, everything else is handed over
+    // to the engine which may keep it as the backing store of the source string
+    napi_finalize finalize = nullptr;
+    char* source = const_cast<char*>(content.data);
+    if (!content.isMapped) {
+        source = content.buffer.release();
+        finalize = [](napi_env env, void* data, void* hint) {
+            delete[] static_cast<char*>(data);
+        };
+    }
 
-    napi_value wrappedContent;
-    napi_create_string_utf8(env, result.c_str(), result.size(), &wrappedContent);
+    auto status = js_compile_function(env, source, content.length, EnsureFileProtocol(path).c_str(),
+                                      MODULE_PARAMS, MODULE_PARAM_COUNT, finalize, nullptr, result);
 
-    return wrappedContent;
-}
+    performance->Record(Performance::RUNTIME, "compile", start, performance->Now(), path);
 
-ModuleInternal::ModulePathKind ModuleInternal::GetModulePathKind(const std::string& path) {
-    ModulePathKind kind;
-    switch (path[0]) {
-    case '.':
-        kind = ModulePathKind::Relative;
-        break;
-    case '/':
-        kind = ModulePathKind::Absolute;
-        break;
-    default:
-        kind = ModulePathKind::Global;
-        break;
-    }
-    return kind;
+    return status;
 }
 
-jclass ModuleInternal::MODULE_CLASS = nullptr;
-jmethodID ModuleInternal::RESOLVE_PATH_METHOD_ID = nullptr;
-
-const char* ModuleInternal::MODULE_PROLOGUE = "(function(module, exports, require, __filename, __dirname){ ";
-const char* ModuleInternal::MODULE_EPILOGUE = "\n})";
-int ModuleInternal::MODULE_PROLOGUE_LENGTH = std::string(ModuleInternal::MODULE_PROLOGUE).length();
+const char* const ModuleInternal::MODULE_PARAMS[] = { "module", "exports", "require", "__filename", "__dirname" };
+const size_t ModuleInternal::MODULE_PARAM_COUNT = sizeof(ModuleInternal::MODULE_PARAMS) / sizeof(ModuleInternal::MODULE_PARAMS[0]);
+#ifdef __V8__
+// V8 compiles the module source as a function body, positions are not shifted by a prologue
+int ModuleInternal::MODULE_PROLOGUE_LENGTH = 0;
+#else
+int ModuleInternal::MODULE_PROLOGUE_LENGTH = js_function_source_prologue(ModuleInternal::MODULE_PARAMS, ModuleInternal::MODULE_PARAM_COUNT).length();
+#endif
 
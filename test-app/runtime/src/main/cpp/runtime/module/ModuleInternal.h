@@ -6,6 +6,7 @@
 #include <string>
 #include <map>
 #include "robin_hood.h"
+#include "ModulePreloader.h"
 
 typedef napi_value napi_register_module_v(napi_env env, napi_value exports);
 
@@ -31,15 +32,19 @@ class ModuleInternal {
         static void CheckFileExists(napi_env env, const std::string& path, const std::string& baseDir);
         static std::string EnsureFileProtocol(const std::string& path);
 
+        /*
+         * Starts reading the modules recorded during the previous startup on background threads
+         */
+        void StartPreload(const std::string& listPath);
+
+        /*
+         * Called once the main module has been loaded, ends the startup module recording
+         */
+        void FinishPreload();
+
         static int MODULE_PROLOGUE_LENGTH;
         void DeInit();
     private:
-        enum class ModulePathKind {
-            Global,
-            Relative,
-            Absolute
-        };
-
         struct ModuleCacheEntry {
             ModuleCacheEntry(napi_ref _obj)
                     : obj(_obj), isData(false) {
@@ -62,26 +67,22 @@ class ModuleInternal {
 
         napi_value RequireCallbackImpl(napi_env env, napi_callback_info info);
 
-        napi_value WrapModuleContent(napi_env env, const std::string& path);
+        napi_status CompileModuleFunction(napi_env env, const std::string& path, napi_value* result);
 
         napi_value LoadImpl(napi_env env, const std::string& moduleName, const std::string& baseDir, bool& isData);
 
-        napi_value LoadModule(napi_env env, const std::string& path, const std::string& moduleCacheKey);
+        napi_value LoadModule(napi_env env, const std::string& path);
 
         napi_value LoadData(napi_env env, const std::string& path);
 
-        napi_value LoadScript(napi_env env, const std::string& modulePath, napi_value fullRequiredModulePath);
-
         napi_value GetRequireFunction(napi_env env, const std::string& dirName);
 
         // void SaveScriptCache(napi_env env, napi_value script, const std::string& path);
 
-        ModulePathKind GetModulePathKind(const std::string& path);
+        static const char* const MODULE_PARAMS[];
+        static const size_t MODULE_PARAM_COUNT;
 
-        static jclass MODULE_CLASS;
-        static jmethodID RESOLVE_PATH_METHOD_ID;
-        static const char* MODULE_PROLOGUE;
-        static const char* MODULE_EPILOGUE;
+        ModulePreloader m_preloader;
 
         napi_env m_env;
         napi_ref m_requireFunction;
@@ -91,16 +92,14 @@ class ModuleInternal {
 
         class TempModule {
             public:
-                TempModule(ModuleInternal* module, const std::string& modulePath, const std::string& cacheKey, napi_ref poModuleObj)
-                    :m_module(module), m_dispose(true), m_modulePath(modulePath), m_cacheKey(cacheKey), m_poModuleObj(poModuleObj) {
+                TempModule(ModuleInternal* module, const std::string& modulePath, napi_ref poModuleObj)
+                    :m_module(module), m_dispose(true), m_modulePath(modulePath), m_poModuleObj(poModuleObj) {
                     m_module->m_loadedModules.emplace(m_modulePath, ModuleCacheEntry(m_poModuleObj));
-                    m_module->m_loadedModules.emplace(m_cacheKey, ModuleCacheEntry(m_poModuleObj));
                 }
 
                 ~TempModule() {
                     if (m_dispose) {
                         m_module->m_loadedModules.erase(m_modulePath);
-                        m_module->m_loadedModules.erase(m_cacheKey);
                     }
                 }
 
@@ -112,7 +111,6 @@ class ModuleInternal {
                 bool m_dispose;
                 ModuleInternal* m_module;
                 std::string m_modulePath;
-                std::string m_cacheKey;
                 napi_ref m_poModuleObj;
         };
 
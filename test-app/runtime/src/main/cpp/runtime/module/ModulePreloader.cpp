@@ -0,0 +1,246 @@
+#include "ModulePreloader.h"
+#include "NativeScriptAssert.h"
+#include "jsr_common.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/mman.h>
+
+using namespace tns;
+using namespace std;
+using namespace std::chrono;
+
+ModulePreloader::ModulePreloader()
+    : m_params(nullptr), m_paramCount(0), m_recording(false), m_next(0), m_stopped(false), m_backgroundMicros(0),
+      m_compileMicros(0), m_compiled(0), m_hits(0), m_misses(0), m_waitMicros(0) {
+}
+
+ModulePreloader::~ModulePreloader() {
+    m_stopped = true;
+    for (auto& thread: m_threads) {
+        thread.join();
+    }
+}
+
+void ModulePreloader::Start(const string& listPath, const string& appRoot, const char* const* params, size_t paramCount) {
+    m_listPath = listPath;
+    m_params = params;
+    m_paramCount = paramCount;
+    m_recording = true;
+
+    m_preloadList = ReadList(listPath);
+    if (m_preloadList.empty()) {
+        m_preloadList = ReadList(appRoot + BUNDLED_LIST_NAME);
+        for (auto& path: m_preloadList) {
+            if (!path.empty() && path[0] != '/') {
+                path = appRoot + path;
+            }
+        }
+    }
+
+    if (m_preloadList.empty()) {
+        return;
+    }
+
+    // the index is built before any thread starts and is read-only afterwards
+    m_slots.reserve(m_preloadList.size());
+    for (auto& path: m_preloadList) {
+        if (m_slotIndex.emplace(path, m_slots.size()).second) {
+            unique_ptr<Slot> slot(new Slot());
+            slot->path = path;
+            slot->state = PENDING;
+            m_slots.push_back(std::move(slot));
+        }
+    }
+
+    int cores = (int) std::thread::hardware_concurrency();
+    int maxCount = MAX_THREAD_COUNT;
+    int count = std::min(std::max(cores - 1, 1), maxCount);
+    for (int i = 0; i < count; i++) {
+        m_threads.emplace_back(&ModulePreloader::Run, this);
+    }
+
+    DEBUG_WRITE("ModulePreloader: preloading %zu modules on %d threads", m_slots.size(), count);
+}
+
+void ModulePreloader::Run() {
+    while (!m_stopped) {
+        size_t index = m_next.fetch_add(1);
+        if (index >= m_slots.size()) {
+            break;
+        }
+
+        auto& slot = *m_slots[index];
+        int expected = PENDING;
+        if (!slot.state.compare_exchange_strong(expected, LOADING)) {
+            // the JS thread got to it first
+            continue;
+        }
+
+        auto start = steady_clock::now();
+        Load(slot);
+        m_backgroundMicros += duration_cast<microseconds>(steady_clock::now() - start).count();
+
+        m_loaded.notify_all();
+    }
+}
+
+void ModulePreloader::Load(Slot& slot) {
+    bool success = File::ReadContent(slot.path, slot.content);
+
+    if (success && slot.content.isMapped && slot.content.length > 0) {
+        // stored APK entries are not copied, just make sure their pages are resident
+        long pageSize = sysconf(_SC_PAGESIZE);
+        auto begin = (uintptr_t) slot.content.data & ~(uintptr_t) (pageSize - 1);
+        auto end = (uintptr_t) slot.content.data + slot.content.length;
+        madvise((void*) begin, end - begin, MADV_WILLNEED);
+    }
+
+    if (success) {
+        Compile(slot);
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        slot.state = success ? READY : FAILED;
+    }
+}
+
+void ModulePreloader::Compile(const Slot& slot) {
+    const string extension = ".js";
+    auto& path = slot.path;
+    if (path.size() < extension.size() || path.compare(path.size() - extension.size(), extension.size(), extension) != 0) {
+        return;
+    }
+
+    // the file name must match the one the JS thread compiles the module with
+    auto start = steady_clock::now();
+    auto file = "file://" + path;
+    if (js_precompile_function(slot.content.data, slot.content.length, file.c_str(), m_params, m_paramCount) == napi_ok) {
+        m_compiled++;
+    }
+    m_compileMicros += duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+bool ModulePreloader::Take(const string& path, FileContent& content) {
+    auto it = m_slotIndex.find(path);
+    if (it == m_slotIndex.end()) {
+        return false;
+    }
+
+    auto& slot = *m_slots[it->second];
+    int expected = PENDING;
+    if (slot.state.compare_exchange_strong(expected, TAKEN)) {
+        m_misses++;
+        return false;
+    }
+
+    if (expected == LOADING) {
+        auto start = steady_clock::now();
+        unique_lock<mutex> lock(m_mutex);
+        m_loaded.wait(lock, [&slot]() {
+            return slot.state != LOADING;
+        });
+        m_waitMicros += duration_cast<microseconds>(steady_clock::now() - start).count();
+    }
+
+    expected = READY;
+    if (!slot.state.compare_exchange_strong(expected, TAKEN)) {
+        m_misses++;
+        return false;
+    }
+
+    content.data = slot.content.data;
+    content.length = slot.content.length;
+    content.isMapped = slot.content.isMapped;
+    content.buffer = std::move(slot.content.buffer);
+    m_hits++;
+
+    return true;
+}
+
+void ModulePreloader::Record(const string& path) {
+    if (m_recording && m_recordedSet.insert(path).second) {
+        m_recorded.push_back(path);
+    }
+}
+
+void ModulePreloader::Finish() {
+    if (!m_recording) {
+        return;
+    }
+    m_recording = false;
+
+    m_stopped = true;
+    for (auto& thread: m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+
+    // what was compiled for modules the app no longer loads
+    js_release_precompiled_functions();
+
+    if (m_recorded != m_preloadList) {
+        WriteList(m_listPath, m_recorded);
+    }
+
+    if (!m_slots.empty()) {
+        __android_log_print(ANDROID_LOG_DEBUG, "TNS.ModulePreloader",
+                            "%d of %zu modules preloaded (%d read on the JS thread), %d compiled, %.2fms in background (%.2fms compiling), %.2fms waited",
+                            m_hits, m_slots.size(), m_misses, m_compiled.load(), m_backgroundMicros / 1000.0,
+                            m_compileMicros / 1000.0, m_waitMicros / 1000.0);
+    }
+
+    m_slots.clear();
+    m_slotIndex.clear();
+    m_preloadList.clear();
+    m_recorded.clear();
+    m_recordedSet.clear();
+}
+
+vector<string> ModulePreloader::ReadList(const string& path) {
+    vector<string> modules;
+
+    auto file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return modules;
+    }
+
+    char line[PATH_MAX + 2];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        string module(line);
+        while (!module.empty() && (module.back() == '\n' || module.back() == '\r')) {
+            module.pop_back();
+        }
+        if (!module.empty()) {
+            modules.push_back(module);
+        }
+    }
+
+    fclose(file);
+
+    return modules;
+}
+
+void ModulePreloader::WriteList(const string& path, const vector<string>& modules) {
+    auto tmpPath = path + ".tmp";
+    auto file = fopen(tmpPath.c_str(), "w");
+    if (file == nullptr) {
+        return;
+    }
+
+    bool success = true;
+    for (auto& module: modules) {
+        success = success && fprintf(file, "%s\n", module.c_str()) > 0;
+    }
+    success = fclose(file) == 0 && success;
+
+    if (!success || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+    }
+}
+
+const char* ModulePreloader::BUNDLED_LIST_NAME = "__module_list.txt";
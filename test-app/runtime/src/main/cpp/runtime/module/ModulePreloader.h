@@ -0,0 +1,107 @@
+#ifndef MODULEPRELOADER_H_
+#define MODULEPRELOADER_H_
+
+#include "File.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tns {
+/*
+ * Reads the modules the app needed during its previous startup on background threads, so that
+ * `require()` on the JS thread finds the source already in memory (inflated from the APK or read
+ * from disk, mapped APK pages faulted in).
+ *
+ * The list holds resolved module paths, one per line. It is recorded by the runtime until the main
+ * module returns and rewritten when it changes. A bundler may ship its own list as
+ * `app/__module_list.txt`, which is used when nothing was recorded yet.
+ *
+ * The threads also compile the `.js` modules as `require()` will (see js_precompile_function), so
+ * that the JS thread only loads the bytecode, prepared script or code cache. Engines that can't
+ * compile off-thread only get the source read.
+ */
+class ModulePreloader {
+    public:
+        ModulePreloader();
+
+        ~ModulePreloader();
+
+        /*
+         * Starts recording loaded modules and preloading the recorded list, if any. The modules
+         * are compiled as functions taking `params`, which must outlive the preloader.
+         */
+        void Start(const std::string& listPath, const std::string& appRoot, const char* const* params, size_t paramCount);
+
+        /*
+         * Hands over the preloaded content of `path`. Waits if a background thread is reading it
+         * right now and returns false if the module was not preloaded.
+         */
+        bool Take(const std::string& path, FileContent& content);
+
+        void Record(const std::string& path);
+
+        /*
+         * Stops recording, persists the list and releases everything that was not taken
+         */
+        void Finish();
+
+    private:
+        enum SlotState {
+            PENDING,
+            LOADING,
+            READY,
+            FAILED,
+            TAKEN
+        };
+
+        struct Slot {
+            std::string path;
+            FileContent content;
+            std::atomic<int> state;
+        };
+
+        void Run();
+
+        void Load(Slot& slot);
+
+        static std::vector<std::string> ReadList(const std::string& path);
+
+        static void WriteList(const std::string& path, const std::vector<std::string>& modules);
+
+        void Compile(const Slot& slot);
+
+        std::string m_listPath;
+        const char* const* m_params;
+        size_t m_paramCount;
+        bool m_recording;
+        std::vector<std::string> m_recorded;
+        std::unordered_set<std::string> m_recordedSet;
+        std::vector<std::string> m_preloadList;
+
+        std::vector<std::unique_ptr<Slot>> m_slots;
+        std::unordered_map<std::string, size_t> m_slotIndex;
+        std::vector<std::thread> m_threads;
+        std::atomic<size_t> m_next;
+        std::atomic<bool> m_stopped;
+        std::atomic<int64_t> m_backgroundMicros;
+        std::atomic<int64_t> m_compileMicros;
+        std::atomic<int> m_compiled;
+        std::mutex m_mutex;
+        std::condition_variable m_loaded;
+
+        int m_hits;
+        int m_misses;
+        int64_t m_waitMicros;
+
+        static const int MAX_THREAD_COUNT = 3;
+        static const char* BUNDLED_LIST_NAME;
+};
+}
+
+#endif /* MODULEPRELOADER_H_ */
@@ -0,0 +1,447 @@
+#include "ModuleResolver.h"
+#include "ApkFileSystem.h"
+#include "ArgConverter.h"
+#include "File.h"
+#include "GlobalHelpers.h"
+#include "NativeScriptAssert.h"
+#include "NativeScriptException.h"
+#include "Util.h"
+#include "native_api_util.h"
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace tns;
+using namespace std;
+
+void ModuleResolver::Init(const string& filesRoot, bool isDebuggable) {
+    lock_guard<mutex> lock(s_mutex);
+
+    if (!s_appRoot.empty()) {
+        return;
+    }
+
+    char resolved[PATH_MAX];
+    s_isDebuggable = isDebuggable;
+    s_filesRoot = filesRoot;
+    s_canonicalFilesRoot = realpath(filesRoot.c_str(), resolved) != nullptr ? string(resolved) : filesRoot;
+    s_appRoot = s_canonicalFilesRoot + "/app";
+    s_coreModulesRoot = s_appRoot + "/tns_modules/tns-core-modules";
+}
+
+const string& ModuleResolver::Resolve(napi_env env, const string& request, const string& baseDir) {
+    {
+        lock_guard<mutex> lock(s_mutex);
+
+        auto& resolutions = s_resolutions[baseDir];
+        auto it = resolutions.find(request);
+        if (it != resolutions.end()) {
+            if (!it->second.found) {
+                throw NativeScriptException(it->second.value);
+            }
+            return it->second.value;
+        }
+    }
+
+    // resolving may call into JS (package.json), which must not happen under the lock shared
+    // with the workers, another thread resolving the same request in between is harmless
+    string error;
+    auto path = ResolveUncached(env, request, baseDir, error);
+
+    lock_guard<mutex> lock(s_mutex);
+    auto& resolutions = s_resolutions[baseDir];
+    if (path.empty()) {
+        // the app folder does not change while the app runs, anything outside of it might and
+        // in debuggable apps LiveSync adds files at any time
+        if (!s_isDebuggable && !request.empty() && request[0] != '/' && IsInAppRoot(baseDir)) {
+            resolutions.emplace(request, Resolution { false, error });
+        }
+        throw NativeScriptException(error);
+    }
+
+    DEBUG_WRITE("ModuleResolver: %s from %s -> %s", request.c_str(), baseDir.c_str(), path.c_str());
+
+    return resolutions.emplace(request, Resolution { true, path }).first->second.value;
+}
+
+string ModuleResolver::ResolveUncached(napi_env env, const string& request, const string& baseDir, string& error) {
+    string base;
+    if (baseDir.empty() || request.compare(0, 2, "~/") == 0) {
+        base = s_appRoot;
+    } else if (s_filesRoot != s_canonicalFilesRoot && baseDir.compare(0, s_filesRoot.length(), s_filesRoot) == 0) {
+        // e.g. /data/user/0/<pkg>/files/app/ passed as the root require() dir
+        base = Normalize(s_canonicalFilesRoot + baseDir.substr(s_filesRoot.length()));
+    } else {
+        base = Normalize(baseDir);
+    }
+
+    bool isRelative = request == "." || request == ".." || request.compare(0, 2, "./") == 0 || request.compare(0, 3, "../") == 0;
+    bool isAbsolute = !request.empty() && request[0] == '/';
+    bool isAppRelative = request.compare(0, 2, "~/") == 0;
+
+    string found;
+    if (isRelative || isAbsolute || isAppRelative) {
+        string target;
+        if (isAbsolute) {
+            target = request;
+        } else if (isAppRelative) {
+            target = s_appRoot + "/" + request.substr(2);
+        } else {
+            target = base + "/" + request;
+        }
+
+        found = ResolveFileOrDirectory(env, Normalize(target));
+        if (found.empty()) {
+            error = isAppRelative
+                    ? NOT_FOUND_PREFIX + request + "\", relative to: /app/"
+                    : GetNotFoundMessage(request, base);
+        }
+    } else {
+        found = ResolveFileOrDirectory(env, Normalize(s_coreModulesRoot + "/" + request));
+        error = GetNotFoundMessage(request, s_coreModulesRoot);
+
+        if (found.empty()) {
+            for (auto& dir: GetNodeModulesPaths(base)) {
+                found = ResolvePackageExports(env, dir, request);
+                if (found.empty()) {
+                    found = ResolveFileOrDirectory(env, Normalize(dir + "/" + request));
+                }
+                if (!found.empty()) {
+                    break;
+                }
+                error = GetNotFoundMessage(request, dir);
+            }
+        }
+    }
+
+    return found.empty() ? found : Canonicalize(found);
+}
+
+string ModuleResolver::ResolvePackageExports(napi_env env, const string& nodeModulesDir, const string& request) {
+    // split "name/sub/path" and "@scope/name/sub/path" into the package name and a "./sub/path" subpath
+    auto separator = request.find('/');
+    if (!request.empty() && request[0] == '@' && separator != string::npos) {
+        separator = request.find('/', separator + 1);
+    }
+
+    auto packageDir = nodeModulesDir + "/" + request.substr(0, separator);
+    auto subpath = separator == string::npos ? string(".") : "." + request.substr(separator);
+
+    if (GetEntryKind(packageDir) != EntryKind::Directory) {
+        return string();
+    }
+
+    auto& package = GetPackage(env, packageDir);
+    if (!package.hasExports) {
+        return string();
+    }
+
+    for (auto& entry: package.exports) {
+        auto& key = entry.first;
+        auto& target = entry.second;
+
+        if (key == subpath) {
+            return ResolveFileOrDirectory(env, Normalize(packageDir + "/" + target));
+        }
+
+        // "./features/*": "./src/features/*.js"
+        auto star = key.find('*');
+        if (star == string::npos || subpath.length() < key.length() - 1) {
+            continue;
+        }
+
+        auto prefixLength = star;
+        auto suffixLength = key.length() - star - 1;
+        if (subpath.compare(0, prefixLength, key, 0, prefixLength) == 0 &&
+            subpath.compare(subpath.length() - suffixLength, suffixLength, key, star + 1, suffixLength) == 0) {
+            auto match = subpath.substr(prefixLength, subpath.length() - prefixLength - suffixLength);
+            auto resolvedTarget = target;
+            Util::ReplaceAll(resolvedTarget, "*", match);
+            return ResolveFileOrDirectory(env, Normalize(packageDir + "/" + resolvedTarget));
+        }
+    }
+
+    // the package does not export the subpath, fall back to plain file lookup like the Java resolver did
+    return string();
+}
+
+string ModuleResolver::ResolveFileOrDirectory(napi_env env, const string& path) {
+    if (Util::EndsWith(path, ".js") || Util::EndsWith(path, ".json") || Util::EndsWith(path, ".so")) {
+        if (IsFile(path)) {
+            return path;
+        }
+    } else if (IsFile(path + ".js")) {
+        return path + ".js";
+    }
+
+    if (GetEntryKind(path) != EntryKind::Directory) {
+        return string();
+    }
+
+    auto& package = GetPackage(env, path);
+    if (!package.main.empty()) {
+        auto found = ResolveFileOrDirectory(env, Normalize(path + "/" + package.main));
+        if (!found.empty()) {
+            return found;
+        }
+    }
+
+    auto index = path + "/index.js";
+    if (IsFile(index)) {
+        return index;
+    }
+
+    return string();
+}
+
+const ModuleResolver::PackageInfo& ModuleResolver::GetPackage(napi_env env, const string& dir) {
+    {
+        lock_guard<mutex> lock(s_mutex);
+        auto it = s_packages.find(dir);
+        if (it != s_packages.end()) {
+            return it->second;
+        }
+    }
+
+    PackageInfo package;
+    package.hasExports = false;
+
+    auto packagePath = dir + "/package.json";
+    FileContent content;
+    if (IsFile(packagePath) && File::ReadContent(packagePath, content)) {
+        napi_value json = JsonParseString(env, content.data, content.length);
+
+        if (napi_util::is_object(env, json)) {
+            napi_value main;
+            napi_get_named_property(env, json, "main", &main);
+            if (napi_util::is_of_type(env, main, napi_string)) {
+                package.main = ArgConverter::ConvertToString(env, main);
+            }
+
+            napi_value exports;
+            napi_get_named_property(env, json, "exports", &exports);
+            if (!napi_util::is_null_or_undefined(env, exports)) {
+                ReadExports(env, exports, package);
+            }
+        }
+    }
+
+    // the elements of the map never move, the reference stays valid after the lock is released
+    lock_guard<mutex> lock(s_mutex);
+    return s_packages.emplace(dir, std::move(package)).first->second;
+}
+
+void ModuleResolver::ReadExports(napi_env env, napi_value value, PackageInfo& package) {
+    package.hasExports = true;
+
+    if (!napi_util::is_object(env, value) || napi_util::is_array(env, value)) {
+        package.exports.emplace_back(".", GetConditionalTarget(env, value));
+        return;
+    }
+
+    napi_value keys;
+    napi_get_property_names(env, value, &keys);
+    uint32_t length = 0;
+    napi_get_array_length(env, keys, &length);
+
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value key;
+        napi_get_element(env, keys, i, &key);
+        auto name = ArgConverter::ConvertToString(env, key);
+
+        if (name.empty() || name[0] != '.') {
+            // a conditions object for the package root
+            package.exports.clear();
+            package.exports.emplace_back(".", GetConditionalTarget(env, value));
+            return;
+        }
+
+        napi_value target;
+        napi_get_property(env, value, key, &target);
+        auto resolvedTarget = GetConditionalTarget(env, target);
+        if (!resolvedTarget.empty()) {
+            package.exports.emplace_back(name, resolvedTarget);
+        }
+    }
+}
+
+string ModuleResolver::GetConditionalTarget(napi_env env, napi_value value) {
+    if (napi_util::is_of_type(env, value, napi_string)) {
+        return ArgConverter::ConvertToString(env, value);
+    }
+
+    if (napi_util::is_array(env, value)) {
+        uint32_t length = 0;
+        napi_get_array_length(env, value, &length);
+        for (uint32_t i = 0; i < length; i++) {
+            napi_value element;
+            napi_get_element(env, value, i, &element);
+            auto target = GetConditionalTarget(env, element);
+            if (!target.empty()) {
+                return target;
+            }
+        }
+        return string();
+    }
+
+    if (napi_util::is_object(env, value)) {
+        for (auto condition: { "require", "node", "default" }) {
+            bool hasCondition = false;
+            napi_has_named_property(env, value, condition, &hasCondition);
+            if (hasCondition) {
+                napi_value target;
+                napi_get_named_property(env, value, condition, &target);
+                return GetConditionalTarget(env, target);
+            }
+        }
+    }
+
+    return string();
+}
+
+vector<string> ModuleResolver::GetNodeModulesPaths(const string& baseDir) {
+    vector<string> dirs;
+
+    // walk up to (and including) the app folder, skipping node_modules and tns_modules themselves
+    string current = baseDir;
+    while (current.length() >= s_appRoot.length() && current.compare(0, s_appRoot.length(), s_appRoot) == 0) {
+        auto slash = current.find_last_of('/');
+        auto name = current.substr(slash + 1);
+
+        if (name != "node_modules" && name != "tns_modules") {
+            dirs.push_back(current.length() == s_appRoot.length() ? current + "/tns_modules" : current + "/node_modules");
+        }
+
+        if (current.length() == s_appRoot.length()) {
+            break;
+        }
+        current.resize(slash);
+    }
+
+    return dirs;
+}
+
+ModuleResolver::EntryKind ModuleResolver::GetEntryKind(const string& path) {
+    // the APK serves the app files unless they were overridden on disk (see ApkFileSystem)
+    if (ApkFileSystem::IsFile(path)) {
+        return EntryKind::File;
+    }
+    if (ApkFileSystem::IsDirectory(path)) {
+        return EntryKind::Directory;
+    }
+
+    auto slash = path.find_last_of('/');
+    if (!s_isDebuggable && slash != string::npos && IsInAppRoot(path)) {
+        return GetListedEntryKind(path.substr(0, slash), path.substr(slash + 1));
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return EntryKind::None;
+    }
+    return S_ISDIR(st.st_mode) ? EntryKind::Directory : (S_ISREG(st.st_mode) ? EntryKind::File : EntryKind::None);
+}
+
+ModuleResolver::EntryKind ModuleResolver::GetListedEntryKind(const string& dir, const string& name) {
+    unique_lock<mutex> lock(s_mutex);
+    auto it = s_listings.find(dir);
+    if (it == s_listings.end()) {
+        lock.unlock();
+
+        // list the whole directory once, subsequent probes for its siblings are lookups
+        unordered_map<string, EntryKind> listing;
+        auto handle = opendir(dir.c_str());
+        if (handle != nullptr) {
+            while (auto entry = readdir(handle)) {
+                string entryName(entry->d_name);
+                if (entryName == "." || entryName == "..") {
+                    continue;
+                }
+
+                auto kind = EntryKind::None;
+                if (entry->d_type == DT_DIR) {
+                    kind = EntryKind::Directory;
+                } else if (entry->d_type == DT_REG) {
+                    kind = EntryKind::File;
+                } else {
+                    struct stat st;
+                    if (stat((dir + "/" + entryName).c_str(), &st) == 0) {
+                        kind = S_ISDIR(st.st_mode) ? EntryKind::Directory : (S_ISREG(st.st_mode) ? EntryKind::File : EntryKind::None);
+                    }
+                }
+                listing.emplace(std::move(entryName), kind);
+            }
+            closedir(handle);
+        }
+
+        lock.lock();
+        it = s_listings.emplace(dir, std::move(listing)).first;
+    }
+
+    auto entry = it->second.find(name);
+    return entry == it->second.end() ? EntryKind::None : entry->second;
+}
+
+bool ModuleResolver::IsInAppRoot(const string& path) {
+    return path.compare(0, s_appRoot.length(), s_appRoot) == 0 &&
+           (path.length() == s_appRoot.length() || path[s_appRoot.length()] == '/');
+}
+
+string ModuleResolver::Normalize(const string& path) {
+    vector<string> parts;
+    size_t start = 0;
+    while (start <= path.length()) {
+        auto end = path.find('/', start);
+        if (end == string::npos) {
+            end = path.length();
+        }
+
+        auto part = path.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty()) {
+                parts.pop_back();
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(std::move(part));
+        }
+
+        start = end + 1;
+    }
+
+    string normalized;
+    normalized.reserve(path.length());
+    for (auto& part: parts) {
+        normalized += '/';
+        normalized += part;
+    }
+
+    return normalized.empty() ? string("/") : normalized;
+}
+
+string ModuleResolver::Canonicalize(const string& path) {
+    // the paths of the APK are canonical and not on disk
+    if (ApkFileSystem::IsFile(path)) {
+        return path;
+    }
+
+    char resolved[PATH_MAX];
+    return realpath(path.c_str(), resolved) != nullptr ? string(resolved) : path;
+}
+
+string ModuleResolver::GetNotFoundMessage(const string& request, const string& baseDir) {
+    auto relativeDir = baseDir.length() > s_canonicalFilesRoot.length() ? baseDir.substr(s_canonicalFilesRoot.length() + 1) : baseDir;
+    return NOT_FOUND_PREFIX + request + "\", relative to: " + relativeDir + "/";
+}
+
+// keeps the message the Java resolver produced, apps and tests match on it
+const string ModuleResolver::NOT_FOUND_PREFIX = "com.tns.NativeScriptException: Failed to find module: \"";
+bool ModuleResolver::s_isDebuggable = false;
+string ModuleResolver::s_filesRoot;
+string ModuleResolver::s_canonicalFilesRoot;
+string ModuleResolver::s_appRoot;
+string ModuleResolver::s_coreModulesRoot;
+mutex ModuleResolver::s_mutex;
+unordered_map<string, unordered_map<string, ModuleResolver::Resolution>> ModuleResolver::s_resolutions;
+unordered_map<string, ModuleResolver::PackageInfo> ModuleResolver::s_packages;
+unordered_map<string, unordered_map<string, ModuleResolver::EntryKind>> ModuleResolver::s_listings;
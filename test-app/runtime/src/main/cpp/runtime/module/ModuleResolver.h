@@ -0,0 +1,108 @@
+#ifndef MODULERESOLVER_H_
+#define MODULERESOLVER_H_
+
+#include "js_native_api.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tns {
+/*
+ * Resolves `require()` requests to canonical file paths without leaving native code.
+ *
+ * Follows the rules of the former Java resolver (com.tns.Module): relative, absolute and `~/`
+ * requests, `tns_modules/tns-core-modules`, `node_modules` lookup up to the app folder, files with
+ * an implicit `.js` extension and folders with a package.json `main` or an index.js. In addition
+ * package.json `exports` (string, subpath and `require`/`node`/`default` conditions) is honoured
+ * for packages found through `node_modules`.
+ *
+ * Every `(baseDir, request)` pair is resolved once and directories of the app folder are listed
+ * once instead of probing each candidate with stat(). Failures are cached for requests made from
+ * within the app folder, which does not change while the app runs. In debuggable apps files can
+ * be added by LiveSync at any time, so failures and directory listings are not cached there.
+ *
+ * The caches are shared by all runtimes (workers included) and guarded by a mutex, which is not
+ * held while a request is resolved, as reading a package.json calls into JS.
+ */
+class ModuleResolver {
+    public:
+        static void Init(const std::string& filesRoot, bool isDebuggable);
+
+        /*
+         * Returns the canonical path of the module or throws NativeScriptException. The returned
+         * reference stays valid for the lifetime of the process.
+         */
+        static const std::string& Resolve(napi_env env, const std::string& request, const std::string& baseDir);
+
+        /*
+         * The canonical path of the app directory, without a trailing slash
+         */
+        static const std::string& GetAppRoot() {
+            return s_appRoot;
+        }
+
+    private:
+        enum class EntryKind {
+            None,
+            File,
+            Directory
+        };
+
+        struct Resolution {
+            bool found;
+            // the canonical path or the error message
+            std::string value;
+        };
+
+        struct PackageInfo {
+            std::string main;
+            bool hasExports;
+            std::vector<std::pair<std::string, std::string>> exports;
+        };
+
+        static std::string ResolveUncached(napi_env env, const std::string& request, const std::string& baseDir, std::string& error);
+
+        static std::string ResolvePackageExports(napi_env env, const std::string& nodeModulesDir, const std::string& request);
+
+        static std::string ResolveFileOrDirectory(napi_env env, const std::string& path);
+
+        static const PackageInfo& GetPackage(napi_env env, const std::string& dir);
+
+        static void ReadExports(napi_env env, napi_value value, PackageInfo& package);
+
+        static std::string GetConditionalTarget(napi_env env, napi_value value);
+
+        static std::vector<std::string> GetNodeModulesPaths(const std::string& baseDir);
+
+        static EntryKind GetEntryKind(const std::string& path);
+
+        static EntryKind GetListedEntryKind(const std::string& dir, const std::string& name);
+
+        static bool IsInAppRoot(const std::string& path);
+
+        static bool IsFile(const std::string& path) {
+            return GetEntryKind(path) == EntryKind::File;
+        }
+
+        static std::string Normalize(const std::string& path);
+
+        static std::string Canonicalize(const std::string& path);
+
+        static std::string GetNotFoundMessage(const std::string& request, const std::string& baseDir);
+
+        static const std::string NOT_FOUND_PREFIX;
+        static bool s_isDebuggable;
+        static std::string s_filesRoot;
+        static std::string s_canonicalFilesRoot;
+        static std::string s_appRoot;
+        static std::string s_coreModulesRoot;
+        static std::mutex s_mutex;
+        static std::unordered_map<std::string, std::unordered_map<std::string, Resolution>> s_resolutions;
+        static std::unordered_map<std::string, PackageInfo> s_packages;
+        static std::unordered_map<std::string, std::unordered_map<std::string, EntryKind>> s_listings;
+};
+}
+
+#endif /* MODULERESOLVER_H_ */
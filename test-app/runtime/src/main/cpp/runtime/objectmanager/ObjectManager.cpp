@@ -5,6 +5,7 @@
 #include "Util.h"
 #include "NativeScriptException.h"
 #include "Runtime.h"
+#include "Tracing.h"
 #include <algorithm>
 #include <sstream>
 
@@ -15,6 +16,8 @@ ObjectManager::ObjectManager(jobject javaRuntimeObject) :
         m_javaRuntimeObject(javaRuntimeObject),
         m_cache(NewWeakGlobalRefCallback, DeleteWeakGlobalRefCallback, 1000, this),
         m_currentObjectId(0),
+        m_weakFlushes(0),
+        m_weakFlushedInstances(0),
         m_jsObjectProxyCreator(nullptr),
         m_jsObjectCtor(nullptr),
         m_env(nullptr) {
@@ -62,6 +65,27 @@ void ObjectManager::Init(napi_env env) {
     napi_set_named_property(env, napi_util::get_prototype(env, jsObjectCtor), PRIVATE_IS_NAPI,
                             napi_util::get_true(env));
     m_jsObjectCtor = napi_util::make_ref(env, jsObjectCtor, 1);
+
+    napi_value global;
+    napi_get_global(env, &global);
+    napi_util::napi_set_function(env, global, "__getObjectManagerStats", GetStatsCallback, this);
+}
+
+napi_value ObjectManager::GetStatsCallback(napi_env env, napi_callback_info info) {
+    void *data;
+    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+    auto thiz = static_cast<ObjectManager *>(data);
+
+    napi_value result;
+    napi_create_object(env, &result);
+
+    napi_value value;
+    napi_create_double(env, (double) thiz->m_weakFlushes, &value);
+    napi_set_named_property(env, result, "weakFlushes", value);
+    napi_create_double(env, (double) thiz->m_weakFlushedInstances, &value);
+    napi_set_named_property(env, result, "weakFlushedInstances", value);
+
+    return result;
 }
 
 
@@ -189,6 +213,8 @@ napi_value ObjectManager::GetOrCreateProxy(jint javaObjectID, napi_value instanc
     auto javaObjectIdFound = m_weakObjectIds.find(javaObjectID);
     if (javaObjectIdFound != m_weakObjectIds.end()) {
         m_weakObjectIds.erase(javaObjectID);
+        // the instance may still be waiting to be made weak
+        FlushWeakInstances();
         JEnv jenv;
         jenv.CallVoidMethod(m_javaRuntimeObject,
                             MAKE_INSTANCE_STRONG_METHOD_ID,
@@ -470,22 +496,44 @@ void ObjectManager::JSObjectProxyFinalizerCallback(napi_env env, void *finalizeD
     auto rt = Runtime::GetRuntimeUnchecked(env);
     if (rt && !rt->is_destroying) {
 
-        auto objManager = rt->GetObjectManager();
-        auto itFound = objManager->m_weakObjectIds.find(state->JavaObjectID);
-
         DEBUG_WRITE("JS Proxy finalizer called for object id: %d", state->JavaObjectID);
-        if (itFound == objManager->m_weakObjectIds.end()) {
-            objManager->m_weakObjectIds.emplace(state->JavaObjectID);
-            JEnv jEnv;
-            jEnv.CallVoidMethod(objManager->m_javaRuntimeObject,
-                                objManager->MAKE_INSTANCE_WEAK_METHOD_ID,
-                                state->JavaObjectID);
-
-        }
+        rt->GetObjectManager()->MakeInstanceWeakLater(state->JavaObjectID);
     }
     delete state;
 }
 
+/*
+ * The proxies of a torn down screen are finalized together, their instances are made weak in a
+ * single call once the batch is over rather than with a JNI call each
+ */
+void ObjectManager::MakeInstanceWeakLater(int javaObjectID) {
+    if (!m_weakObjectIds.emplace(javaObjectID).second) {
+        return;
+    }
+
+    if (m_buff.Size() == m_buff.Length()) {
+        FlushWeakInstances();
+    }
+    if (m_buff.Size() == 0) {
+        Runtime::GetRuntime(m_env)->ScheduleLoopTick();
+    }
+    m_buff.Write(javaObjectID);
+}
+
+void ObjectManager::FlushWeakInstances() {
+    int length = m_buff.Size();
+    if (length == 0) {
+        return;
+    }
+
+    m_buff.Reset();
+    m_weakFlushes++;
+    m_weakFlushedInstances += length;
+    JEnv jEnv;
+    jEnv.CallVoidMethod(m_javaRuntimeObject, MAKE_INSTANCE_WEAK_BATCH_METHOD_ID, (jobject) m_buff,
+                        length, JNI_TRUE);
+}
+
 int ObjectManager::GenerateNewObjectID() {
     const int one = 1;
     int oldValue = __sync_fetch_and_add(&m_currentObjectId, one);
@@ -585,8 +633,12 @@ void ObjectManager::ReleaseNativeObject(napi_env env, napi_value object) {
 }
 
 void ObjectManager::OnGarbageCollected(JNIEnv *jEnv, jintArray object_ids) {
+    instrumentation::TraceScope trace("OnGarbageCollected");
     JEnv jenv(jEnv);
     jsize length = jenv.GetArrayLength(object_ids);
+    if (instrumentation::Tracing::IsEnabled()) {
+        instrumentation::Tracing::Counter("CollectedJavaObjects", length);
+    }
     int *cppArray = jenv.GetIntArrayElements(object_ids, nullptr);
     for (jsize i = 0; i < length; i++) {
         auto rt = Runtime::GetRuntimeUnchecked(m_env);
@@ -77,6 +77,12 @@ namespace tns {
 
         void OnGarbageCollected(JNIEnv *jEnv, jintArray object_ids);
 
+        /*
+         * Makes the Java instances of the proxies finalized since the last call weak, in a single
+         * call to Java
+         */
+        void FlushWeakInstances();
+
         void ReleaseNativeObject(napi_env env, napi_value object);
 
         inline static void ReleaseObjectNow(napi_env env, int javaObjectId);
@@ -88,6 +94,8 @@ namespace tns {
     private:
         static napi_value JSObjectConstructorCallback(napi_env env, napi_callback_info info);
 
+        static napi_value GetStatsCallback(napi_env env, napi_callback_info info);
+
         struct JSInstanceInfo {
         public:
             JSInstanceInfo(uint32_t javaObjectID, jclass claz)
@@ -119,6 +127,8 @@ namespace tns {
 
         static void DeleteWeakGlobalRefCallback(const jweak &object, void *state);
 
+        void MakeInstanceWeakLater(int javaObjectID);
+
         jobject m_javaRuntimeObject;
 
         napi_env m_env;
@@ -133,8 +143,13 @@ namespace tns {
 
         volatile int m_currentObjectId;
 
+        // the ids of the instances to make weak on the next FlushWeakInstances
         DirectBuffer m_buff;
 
+        // the FlushWeakInstances calls to Java and the instances they made weak
+        int64_t m_weakFlushes;
+        int64_t m_weakFlushedInstances;
+
         DirectBuffer m_outBuff;
 
         jclass JAVA_LANG_CLASS;
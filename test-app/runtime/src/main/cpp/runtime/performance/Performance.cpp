@@ -0,0 +1,728 @@
+#include "Performance.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/eventfd.h>
+#include <android/log.h>
+#include "ArgConverter.h"
+#include "NativeScriptException.h"
+#include "jsr.h"
+#include "native_api_util.h"
+
+using namespace tns;
+
+static int64_t MonotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+Performance::Performance()
+        : m_env(nullptr), m_originNs(MonotonicNow()), m_entries(BUFFER_SIZE), m_next(0), m_count(0),
+          m_deliveryScheduled(false), m_disposed(false), m_entryListConstructor(nullptr),
+          m_looper(nullptr), m_fd(-1) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    m_timeOriginMs = ts.tv_sec * 1000.0 + (ts.tv_nsec / 1000) / 1000.0;
+}
+
+void Performance::Init(napi_env env, napi_value global) {
+    m_env = env;
+
+    // replaces the engine's own object, QuickJS defines a read-only `now` on it
+    napi_value performance;
+    napi_create_object(env, &performance);
+    napi_set_named_property(env, global, "performance", performance);
+
+    napi_value timeOrigin;
+    napi_create_double(env, m_timeOriginMs, &timeOrigin);
+    napi_set_named_property(env, performance, "timeOrigin", timeOrigin);
+
+    napi_util::napi_set_function(env, performance, "now", NowCallback, this);
+    napi_util::napi_set_function(env, performance, "mark", MarkCallback, this);
+    napi_util::napi_set_function(env, performance, "measure", MeasureCallback, this);
+    napi_util::napi_set_function(env, performance, "getEntries", GetEntriesCallback, this);
+    napi_util::napi_set_function(env, performance, "getEntriesByName", GetEntriesByNameCallback, this);
+    napi_util::napi_set_function(env, performance, "getEntriesByType", GetEntriesByTypeCallback, this);
+    napi_util::napi_set_function(env, performance, "clearMarks", ClearMarksCallback, this);
+    napi_util::napi_set_function(env, performance, "clearMeasures", ClearMeasuresCallback, this);
+
+    napi_value supportedEntryTypes;
+    napi_create_array_with_length(env, 3, &supportedEntryTypes);
+    const char *types[] = {"mark", "measure", "runtime"};
+    for (uint32_t i = 0; i < 3; i++) {
+        napi_set_element(env, supportedEntryTypes, i, ArgConverter::convertToJsString(env, types[i], strlen(types[i])));
+    }
+
+    napi_property_descriptor observerProperties[] = {
+            {"observe", nullptr, ObserveCallback, nullptr, nullptr, nullptr, napi_default, this},
+            {"disconnect", nullptr, DisconnectCallback, nullptr, nullptr, nullptr, napi_default, this},
+            {"takeRecords", nullptr, TakeRecordsCallback, nullptr, nullptr, nullptr, napi_default, this},
+            {"supportedEntryTypes", nullptr, nullptr, nullptr, nullptr, supportedEntryTypes, napi_static, nullptr}
+    };
+    napi_value observerConstructor;
+    napi_define_class(env, "PerformanceObserver", NAPI_AUTO_LENGTH, ObserverConstructorCallback, this,
+                      4, observerProperties, &observerConstructor);
+    napi_set_named_property(env, global, "PerformanceObserver", observerConstructor);
+
+    napi_property_descriptor entryListProperties[] = {
+            {"getEntries", nullptr, EntryListGetEntriesCallback, nullptr, nullptr, nullptr, napi_default, nullptr},
+            {"getEntriesByName", nullptr, EntryListGetEntriesByNameCallback, nullptr, nullptr, nullptr, napi_default, nullptr},
+            {"getEntriesByType", nullptr, EntryListGetEntriesByTypeCallback, nullptr, nullptr, nullptr, napi_default, nullptr}
+    };
+    napi_value entryListConstructor;
+    napi_define_class(env, "PerformanceObserverEntryList", NAPI_AUTO_LENGTH,
+                      [](napi_env env, napi_callback_info info) -> napi_value {
+                          napi_value jsThis;
+                          napi_get_cb_info(env, info, nullptr, nullptr, &jsThis, nullptr);
+                          return jsThis;
+                      }, nullptr, 3, entryListProperties, &entryListConstructor);
+    napi_set_named_property(env, global, "PerformanceObserverEntryList", entryListConstructor);
+    m_entryListConstructor = napi_util::make_ref(env, entryListConstructor);
+
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_fd == -1) {
+        __android_log_print(ANDROID_LOG_ERROR, "TNS.Performance",
+                            "Unable to create an eventfd, PerformanceObserver is disabled: %s", strerror(errno));
+        return;
+    }
+
+    m_looper = ALooper_prepare(0);
+    ALooper_acquire(m_looper);
+    ALooper_addFd(m_looper, m_fd, ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT, DeliverCallback, this);
+}
+
+void Performance::Destroy() {
+    if (m_env == nullptr) {
+        return;
+    }
+
+    std::vector<Observer *> observers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_disposed = true;
+        observers.swap(m_observers);
+    }
+
+    // the observers themselves are freed by their finalizers when the env goes away
+    for (auto observer: observers) {
+        observer->pending.clear();
+        napi_delete_reference(m_env, observer->self);
+        observer->self = nullptr;
+    }
+
+    napi_delete_reference(m_env, m_entryListConstructor);
+    m_entryListConstructor = nullptr;
+
+    if (m_looper != nullptr) {
+        ALooper_removeFd(m_looper, m_fd);
+        ALooper_release(m_looper);
+        m_looper = nullptr;
+    }
+
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+int64_t Performance::Now() const {
+    return MonotonicNow() - m_originNs;
+}
+
+int64_t Performance::FromMonotonic(int64_t monotonicNs) const {
+    return monotonicNs - m_originNs;
+}
+
+void Performance::Record(EntryType type, const std::string &name, int64_t startNs, int64_t endNs,
+                         const std::string &detail) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // reuses the storage of the overwritten entry's strings
+    auto &entry = m_entries[m_next];
+    entry.type = type;
+    entry.cleared = false;
+    entry.name.assign(name);
+    entry.detail.assign(detail);
+    entry.startNs = startNs;
+    entry.durationNs = endNs - startNs;
+
+    m_next = (m_next + 1) % BUFFER_SIZE;
+    if (m_count < BUFFER_SIZE) {
+        m_count++;
+    }
+
+    bool observed = false;
+    for (auto observer: m_observers) {
+        if (observer->types & type) {
+            // without a delivery (no eventfd, or takeRecords is never called) the oldest entries
+            // are dropped, like the ones of the timeline
+            if (observer->pending.size() >= BUFFER_SIZE) {
+                observer->pending.erase(observer->pending.begin());
+            }
+            observer->pending.push_back(entry);
+            observed = true;
+        }
+    }
+
+    if (observed) {
+        ScheduleDelivery();
+    }
+}
+
+void Performance::ScheduleDelivery() {
+    if (m_deliveryScheduled || m_fd == -1 || m_disposed) {
+        return;
+    }
+
+    m_deliveryScheduled = true;
+    uint64_t value = 1;
+    write(m_fd, &value, sizeof(value));
+}
+
+bool Performance::FindMark(const std::string &name, int64_t &startNs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t i = 1; i <= m_count; i++) {
+        auto &entry = m_entries[(m_next + BUFFER_SIZE - i) % BUFFER_SIZE];
+        if (entry.type == MARK && !entry.cleared && entry.name == name) {
+            startNs = entry.startNs;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<Performance::Entry> Performance::CopyEntries(const std::string *name, int types) {
+    std::vector<Entry> entries;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = m_count; i > 0; i--) {
+        auto &entry = m_entries[(m_next + BUFFER_SIZE - i) % BUFFER_SIZE];
+        if (!entry.cleared && (entry.type & types) && (name == nullptr || entry.name == *name)) {
+            entries.push_back(entry);
+        }
+    }
+
+    return entries;
+}
+
+void Performance::Unregister(Observer *observer) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_observers.begin(), m_observers.end(), observer);
+        if (it != m_observers.end()) {
+            m_observers.erase(it);
+        }
+        observer->pending.clear();
+        observer->types = 0;
+    }
+
+    if (observer->self != nullptr) {
+        napi_delete_reference(m_env, observer->self);
+        observer->self = nullptr;
+    }
+}
+
+int Performance::ParseEntryType(napi_env env, napi_value value) {
+    if (!napi_util::is_of_type(env, value, napi_string)) {
+        return 0;
+    }
+
+    auto type = ArgConverter::ConvertToString(env, value);
+    if (type == "mark") {
+        return MARK;
+    } else if (type == "measure") {
+        return MEASURE;
+    } else if (type == "runtime") {
+        return RUNTIME;
+    }
+
+    return 0;
+}
+
+napi_value Performance::CreateEntry(napi_env env, const Entry &entry) {
+    napi_value result;
+    napi_create_object(env, &result);
+
+    const char *type = entry.type == MARK ? "mark" : (entry.type == MEASURE ? "measure" : "runtime");
+
+    napi_value value;
+    napi_set_named_property(env, result, "name", ArgConverter::convertToJsString(env, entry.name));
+    napi_set_named_property(env, result, "entryType", ArgConverter::convertToJsString(env, type, strlen(type)));
+    napi_create_double(env, ToMs(entry.startNs), &value);
+    napi_set_named_property(env, result, "startTime", value);
+    napi_create_double(env, ToMs(entry.durationNs), &value);
+    napi_set_named_property(env, result, "duration", value);
+    if (entry.detail.empty()) {
+        napi_get_null(env, &value);
+    } else {
+        value = ArgConverter::convertToJsString(env, entry.detail);
+    }
+    napi_set_named_property(env, result, "detail", value);
+
+    return result;
+}
+
+napi_value Performance::CreateEntries(napi_env env, std::vector<Entry> &entries) {
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.startNs < b.startNs;
+    });
+
+    napi_value result;
+    napi_create_array_with_length(env, entries.size(), &result);
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        napi_set_element(env, result, i, CreateEntry(env, entries[i]));
+    }
+
+    return result;
+}
+
+bool Performance::GetFilter(napi_env env, size_t argc, napi_value *argv, std::string &name, int &types) {
+    if (argc < 1 || napi_util::is_null_or_undefined(env, argv[0])) {
+        return false;
+    }
+
+    name = ArgConverter::ConvertToString(env, argv[0]);
+    types = MARK | MEASURE | RUNTIME;
+    if (argc > 1 && !napi_util::is_undefined(env, argv[1])) {
+        types = ParseEntryType(env, argv[1]);
+    }
+
+    return true;
+}
+
+int64_t Performance::ToNs(double ms) {
+    return (int64_t) (ms * 1e6);
+}
+
+double Performance::ToMs(int64_t ns) {
+    // microsecond resolution
+    return (double) (ns / 1000) / 1000.0;
+}
+
+int Performance::DeliverCallback(int fd, int events, void *data) {
+    uint64_t value;
+    read(fd, &value, sizeof(value));
+
+    auto self = static_cast<Performance *>(data);
+
+    std::vector<std::pair<Observer *, std::vector<Entry>>> batches;
+    {
+        std::lock_guard<std::mutex> lock(self->m_mutex);
+        self->m_deliveryScheduled = false;
+        for (auto observer: self->m_observers) {
+            if (!observer->pending.empty()) {
+                batches.emplace_back(observer, std::move(observer->pending));
+                observer->pending.clear();
+            }
+        }
+    }
+
+    if (batches.empty()) {
+        return 1;
+    }
+
+    auto env = self->m_env;
+    NapiScope scope(env);
+
+    // the handles keep every observer alive until its batch has been delivered, even if an
+    // earlier callback disconnects it
+    std::vector<napi_value> observers;
+    std::vector<napi_value> callbacks;
+    for (auto &batch: batches) {
+        observers.push_back(napi_util::get_ref_value(env, batch.first->self));
+        callbacks.push_back(napi_util::get_ref_value(env, batch.first->callback));
+    }
+
+    napi_value entryListConstructor = napi_util::get_ref_value(env, self->m_entryListConstructor);
+
+    for (size_t i = 0; i < batches.size(); i++) {
+        napi_handle_scope handleScope;
+        napi_open_handle_scope(env, &handleScope);
+
+        napi_value list;
+        napi_new_instance(env, entryListConstructor, 0, nullptr, &list);
+        auto entries = new std::vector<Entry>(std::move(batches[i].second));
+        napi_wrap(env, list, entries, [](napi_env env, void *data, void *hint) {
+            delete static_cast<std::vector<Entry> *>(data);
+        }, nullptr, nullptr);
+
+        napi_value args[2] = {list, observers[i]};
+        napi_value result;
+        napi_call_function(env, observers[i], callbacks[i], 2, args, &result);
+
+        bool pendingException;
+        napi_is_exception_pending(env, &pendingException);
+        if (pendingException) {
+            napi_value error;
+            napi_get_and_clear_last_exception(env, &error);
+            NativeScriptException::OnUncaughtError(env, error);
+        }
+
+        napi_close_handle_scope(env, handleScope);
+    }
+
+    return 1;
+}
+
+napi_value Performance::NowCallback(napi_env env, napi_callback_info info) {
+    void *data;
+    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    napi_value result;
+    napi_create_double(env, ToMs(self->Now()), &result);
+    return result;
+}
+
+napi_value Performance::MarkCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    void *data;
+    napi_get_cb_info(env, info, &argc, argv, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    if (argc < 1 || napi_util::is_undefined(env, argv[0])) {
+        napi_throw_type_error(env, nullptr, "performance.mark requires a name");
+        return nullptr;
+    }
+
+    Entry entry{MARK, false, ArgConverter::ConvertToString(env, argv[0]), std::string(), self->Now(), 0};
+
+    if (argc > 1 && napi_util::is_of_type(env, argv[1], napi_object)) {
+        napi_value startTime;
+        napi_get_named_property(env, argv[1], "startTime", &startTime);
+        if (napi_util::is_of_type(env, startTime, napi_number)) {
+            auto ms = napi_util::get_number(env, startTime);
+            if (ms < 0) {
+                napi_throw_type_error(env, nullptr, "performance.mark startTime cannot be negative");
+                return nullptr;
+            }
+            entry.startNs = ToNs(ms);
+        }
+    }
+
+    self->Record(MARK, entry.name, entry.startNs, entry.startNs);
+
+    return CreateEntry(env, entry);
+}
+
+napi_value Performance::MeasureCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    void *data;
+    napi_get_cb_info(env, info, &argc, argv, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    if (argc < 1 || napi_util::is_undefined(env, argv[0])) {
+        napi_throw_type_error(env, nullptr, "performance.measure requires a name");
+        return nullptr;
+    }
+
+    // a number is a timestamp, a string the name of the latest mark with that name
+    auto resolve = [env, self](napi_value value, int64_t &result) -> bool {
+        if (napi_util::is_of_type(env, value, napi_number)) {
+            result = ToNs(napi_util::get_number(env, value));
+            return true;
+        }
+
+        auto markName = ArgConverter::ConvertToString(env, value);
+        if (!self->FindMark(markName, result)) {
+            napi_throw_error(env, "SyntaxError", ("The mark '" + markName + "' does not exist.").c_str());
+            return false;
+        }
+        return true;
+    };
+
+    Entry entry{MEASURE, false, ArgConverter::ConvertToString(env, argv[0]), std::string(), 0, 0};
+    int64_t endNs = self->Now();
+
+    if (argc > 1 && napi_util::is_of_type(env, argv[1], napi_object)) {
+        napi_value start, end, duration;
+        napi_get_named_property(env, argv[1], "start", &start);
+        napi_get_named_property(env, argv[1], "end", &end);
+        napi_get_named_property(env, argv[1], "duration", &duration);
+
+        bool hasStart = !napi_util::is_undefined(env, start);
+        bool hasEnd = !napi_util::is_undefined(env, end);
+        bool hasDuration = napi_util::is_of_type(env, duration, napi_number);
+
+        if (hasStart && hasEnd && hasDuration) {
+            napi_throw_type_error(env, nullptr, "performance.measure cannot have start, end and duration together");
+            return nullptr;
+        }
+
+        if ((hasStart && !resolve(start, entry.startNs)) || (hasEnd && !resolve(end, endNs))) {
+            return nullptr;
+        }
+
+        if (hasDuration) {
+            auto durationNs = ToNs(napi_util::get_number(env, duration));
+            if (hasStart) {
+                endNs = entry.startNs + durationNs;
+            } else {
+                entry.startNs = endNs - durationNs;
+            }
+        }
+    } else {
+        if (argc > 1 && !napi_util::is_undefined(env, argv[1]) && !resolve(argv[1], entry.startNs)) {
+            return nullptr;
+        }
+        if (argc > 2 && !napi_util::is_undefined(env, argv[2]) && !resolve(argv[2], endNs)) {
+            return nullptr;
+        }
+    }
+
+    entry.durationNs = endNs - entry.startNs;
+    self->Record(MEASURE, entry.name, entry.startNs, endNs);
+
+    return CreateEntry(env, entry);
+}
+
+napi_value Performance::GetEntriesCallback(napi_env env, napi_callback_info info) {
+    void *data;
+    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    auto entries = self->CopyEntries(nullptr, MARK | MEASURE | RUNTIME);
+    return CreateEntries(env, entries);
+}
+
+napi_value Performance::GetEntriesByNameCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    void *data;
+    napi_get_cb_info(env, info, &argc, argv, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    std::string name;
+    int types;
+    if (!GetFilter(env, argc, argv, name, types)) {
+        napi_throw_type_error(env, nullptr, "performance.getEntriesByName requires a name");
+        return nullptr;
+    }
+
+    auto entries = self->CopyEntries(&name, types);
+    return CreateEntries(env, entries);
+}
+
+napi_value Performance::GetEntriesByTypeCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    void *data;
+    napi_get_cb_info(env, info, &argc, argv, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    int types = argc > 0 ? ParseEntryType(env, argv[0]) : 0;
+    auto entries = self->CopyEntries(nullptr, types);
+    return CreateEntries(env, entries);
+}
+
+napi_value Performance::ClearEntries(napi_env env, napi_callback_info info, EntryType type) {
+    size_t argc = 1;
+    napi_value argv[1];
+    void *data;
+    napi_get_cb_info(env, info, &argc, argv, nullptr, &data);
+    auto self = static_cast<Performance *>(data);
+
+    bool all = argc < 1 || napi_util::is_undefined(env, argv[0]);
+    auto name = all ? std::string() : ArgConverter::ConvertToString(env, argv[0]);
+
+    std::lock_guard<std::mutex> lock(self->m_mutex);
+    for (auto &entry: self->m_entries) {
+        if (entry.type == type && (all || entry.name == name)) {
+            entry.cleared = true;
+        }
+    }
+
+    return nullptr;
+}
+
+napi_value Performance::ClearMarksCallback(napi_env env, napi_callback_info info) {
+    return ClearEntries(env, info, MARK);
+}
+
+napi_value Performance::ClearMeasuresCallback(napi_env env, napi_callback_info info) {
+    return ClearEntries(env, info, MEASURE);
+}
+
+napi_value Performance::ObserverConstructorCallback(napi_env env, napi_callback_info info) {
+    napi_value target;
+    napi_get_new_target(env, info, &target);
+    if (target == nullptr) {
+        napi_throw_type_error(env, nullptr, "PerformanceObserver must be called as a constructor");
+        return nullptr;
+    }
+
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_value jsThis;
+    void *data;
+    napi_get_cb_info(env, info, &argc, argv, &jsThis, &data);
+
+    if (argc < 1 || !napi_util::is_of_type(env, argv[0], napi_function)) {
+        napi_throw_type_error(env, nullptr, "PerformanceObserver expects a callback function");
+        return nullptr;
+    }
+
+    auto observer = new Observer{static_cast<Performance *>(data), napi_util::make_ref(env, argv[0]), nullptr, 0, {}};
+    napi_wrap(env, jsThis, observer, [](napi_env env, void *data, void *hint) {
+        auto observer = static_cast<Observer *>(data);
+        if (!observer->performance->m_disposed) {
+            napi_delete_reference(env, observer->callback);
+        }
+        delete observer;
+    }, nullptr, nullptr);
+
+    return jsThis;
+}
+
+napi_value Performance::ObserveCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_value jsThis;
+    napi_get_cb_info(env, info, &argc, argv, &jsThis, nullptr);
+
+    Observer *observer = nullptr;
+    napi_unwrap(env, jsThis, reinterpret_cast<void **>(&observer));
+    if (observer == nullptr || argc < 1 || !napi_util::is_of_type(env, argv[0], napi_object)) {
+        napi_throw_type_error(env, nullptr, "observe expects an options object");
+        return nullptr;
+    }
+    auto self = observer->performance;
+
+    napi_value entryTypes, type, buffered;
+    napi_get_named_property(env, argv[0], "entryTypes", &entryTypes);
+    napi_get_named_property(env, argv[0], "type", &type);
+    napi_get_named_property(env, argv[0], "buffered", &buffered);
+
+    bool hasEntryTypes = !napi_util::is_undefined(env, entryTypes);
+    bool hasType = !napi_util::is_undefined(env, type);
+    if (hasEntryTypes == hasType) {
+        napi_throw_type_error(env, nullptr, "observe expects either entryTypes or type");
+        return nullptr;
+    }
+
+    int types = 0;
+    if (hasEntryTypes) {
+        uint32_t length = 0;
+        napi_get_array_length(env, entryTypes, &length);
+        for (uint32_t i = 0; i < length; i++) {
+            napi_value element;
+            napi_get_element(env, entryTypes, i, &element);
+            types |= ParseEntryType(env, element);
+        }
+    } else {
+        types = ParseEntryType(env, type);
+    }
+
+    if (types == 0) {
+        // unsupported entry types are ignored, as in the spec
+        return nullptr;
+    }
+
+    if (observer->self == nullptr) {
+        observer->self = napi_util::make_ref(env, jsThis);
+    }
+
+    std::vector<Entry> existing;
+    if (hasType && napi_util::is_of_type(env, buffered, napi_boolean) && napi_util::get_bool(env, buffered)) {
+        existing = self->CopyEntries(nullptr, types);
+    }
+
+    std::lock_guard<std::mutex> lock(self->m_mutex);
+    observer->types = hasEntryTypes ? types : (observer->types | types);
+    if (std::find(self->m_observers.begin(), self->m_observers.end(), observer) == self->m_observers.end()) {
+        self->m_observers.push_back(observer);
+    }
+    if (!existing.empty()) {
+        observer->pending.insert(observer->pending.end(), existing.begin(), existing.end());
+        if (observer->pending.size() > BUFFER_SIZE) {
+            observer->pending.erase(observer->pending.begin(),
+                                    observer->pending.end() - BUFFER_SIZE);
+        }
+        self->ScheduleDelivery();
+    }
+
+    return nullptr;
+}
+
+napi_value Performance::DisconnectCallback(napi_env env, napi_callback_info info) {
+    napi_value jsThis;
+    napi_get_cb_info(env, info, nullptr, nullptr, &jsThis, nullptr);
+
+    Observer *observer = nullptr;
+    napi_unwrap(env, jsThis, reinterpret_cast<void **>(&observer));
+    if (observer != nullptr) {
+        observer->performance->Unregister(observer);
+    }
+
+    return nullptr;
+}
+
+napi_value Performance::TakeRecordsCallback(napi_env env, napi_callback_info info) {
+    napi_value jsThis;
+    napi_get_cb_info(env, info, nullptr, nullptr, &jsThis, nullptr);
+
+    std::vector<Entry> entries;
+    Observer *observer = nullptr;
+    napi_unwrap(env, jsThis, reinterpret_cast<void **>(&observer));
+    if (observer != nullptr) {
+        std::lock_guard<std::mutex> lock(observer->performance->m_mutex);
+        entries.swap(observer->pending);
+    }
+
+    return CreateEntries(env, entries);
+}
+
+std::vector<Performance::Entry> Performance::GetListEntries(napi_env env, napi_callback_info info,
+                                                            size_t *argc, napi_value *argv) {
+    napi_value jsThis;
+    napi_get_cb_info(env, info, argc, argv, &jsThis, nullptr);
+
+    void *entries = nullptr;
+    napi_unwrap(env, jsThis, &entries);
+    if (entries == nullptr) {
+        return {};
+    }
+    return *static_cast<std::vector<Entry> *>(entries);
+}
+
+napi_value Performance::EntryListGetEntriesCallback(napi_env env, napi_callback_info info) {
+    auto entries = GetListEntries(env, info, nullptr, nullptr);
+    return CreateEntries(env, entries);
+}
+
+napi_value Performance::EntryListGetEntriesByNameCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    auto entries = GetListEntries(env, info, &argc, argv);
+
+    std::string name;
+    int types;
+    if (!GetFilter(env, argc, argv, name, types)) {
+        napi_throw_type_error(env, nullptr, "getEntriesByName requires a name");
+        return nullptr;
+    }
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry &entry) {
+        return entry.name != name || !(entry.type & types);
+    }), entries.end());
+    return CreateEntries(env, entries);
+}
+
+napi_value Performance::EntryListGetEntriesByTypeCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    auto entries = GetListEntries(env, info, &argc, argv);
+
+    int types = argc > 0 ? ParseEntryType(env, argv[0]) : 0;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [types](const Entry &entry) {
+        return !(entry.type & types);
+    }), entries.end());
+    return CreateEntries(env, entries);
+}
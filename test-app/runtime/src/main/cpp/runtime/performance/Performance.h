@@ -4,33 +4,150 @@
 
 #ifndef TESTAPPNAPI_PERFORMANCE_H
 #define TESTAPPNAPI_PERFORMANCE_H
-#include <chrono>
-#include "js_native_api.h"
-
-napi_value Now(napi_env env, napi_callback_info info) {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 
-    napi_value result;
-    napi_create_double(env, static_cast<double>(ms), &result);
-    return result;
-}
+#include <android/looper.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "js_native_api.h"
 
 namespace tns {
 
+    /*
+     * The performance timeline of a runtime: `performance.now()`/`timeOrigin`, User Timing
+     * (`mark`, `measure`, `getEntries*`, `clearMarks`/`clearMeasures`) and `PerformanceObserver`.
+     *
+     * Times are kept in nanoseconds of the monotonic clock relative to the creation of the
+     * runtime and exposed to JS in milliseconds with microsecond resolution. Entries live in a
+     * preallocated ring buffer, once it is full the oldest entries are overwritten.
+     *
+     * The runtime records its own phases (metadata, module compilation, first frame) as entries
+     * of type "runtime". Record is thread safe, observers are notified in batches from a looper
+     * callback on the runtime thread.
+     */
     class Performance {
     public:
-        static void createPerformance(napi_env env, napi_value global) {
-            bool isInstalled = false;
-            napi_has_named_property(env, global, "performance", &isInstalled);
-            if (!isInstalled) {
-                napi_value performance;
-                napi_create_object(env, &performance);
-                napi_util::napi_set_function(env, performance, "now", Now);
-                napi_set_named_property(env, global, "performance", performance);
-            }
-
-        }
+        enum EntryType {
+            MARK = 1,
+            MEASURE = 2,
+            RUNTIME = 4
+        };
+
+        Performance();
+
+        void Init(napi_env env, napi_value global);
+
+        /*
+         * Releases the observers, must be called while the env is still alive
+         */
+        void Destroy();
+
+        /*
+         * Nanoseconds since the time origin
+         */
+        int64_t Now() const;
+
+        /*
+         * Converts a CLOCK_MONOTONIC timestamp, e.g. a Choreographer frame time, to Now() time
+         */
+        int64_t FromMonotonic(int64_t monotonicNs) const;
+
+        void Record(EntryType type, const std::string &name, int64_t startNs, int64_t endNs,
+                    const std::string &detail = std::string());
+
+        static const size_t BUFFER_SIZE = 1024;
+
+    private:
+        struct Entry {
+            EntryType type;
+            bool cleared;
+            std::string name;
+            std::string detail;
+            int64_t startNs;
+            int64_t durationNs;
+        };
+
+        struct Observer {
+            Performance *performance;
+            napi_ref callback;
+            // strong while observing, registered observers are kept alive by the timeline
+            napi_ref self;
+            int types;
+            std::vector<Entry> pending;
+        };
+
+        bool FindMark(const std::string &name, int64_t &startNs);
+
+        std::vector<Entry> CopyEntries(const std::string *name, int types);
+
+        void ScheduleDelivery();
+
+        void Unregister(Observer *observer);
+
+        static int ParseEntryType(napi_env env, napi_value value);
+
+        static napi_value CreateEntry(napi_env env, const Entry &entry);
+
+        static napi_value CreateEntries(napi_env env, std::vector<Entry> &entries);
+
+        static bool GetFilter(napi_env env, size_t argc, napi_value *argv, std::string &name, int &types);
+
+        static int64_t ToNs(double ms);
+
+        static double ToMs(int64_t ns);
+
+        static int DeliverCallback(int fd, int events, void *data);
+
+        static napi_value NowCallback(napi_env env, napi_callback_info info);
+
+        static napi_value MarkCallback(napi_env env, napi_callback_info info);
+
+        static napi_value MeasureCallback(napi_env env, napi_callback_info info);
+
+        static napi_value GetEntriesCallback(napi_env env, napi_callback_info info);
+
+        static napi_value GetEntriesByNameCallback(napi_env env, napi_callback_info info);
+
+        static napi_value GetEntriesByTypeCallback(napi_env env, napi_callback_info info);
+
+        static napi_value ClearEntries(napi_env env, napi_callback_info info, EntryType type);
+
+        static std::vector<Entry> GetListEntries(napi_env env, napi_callback_info info, size_t *argc, napi_value *argv);
+
+        static napi_value ClearMarksCallback(napi_env env, napi_callback_info info);
+
+        static napi_value ClearMeasuresCallback(napi_env env, napi_callback_info info);
+
+        static napi_value ObserverConstructorCallback(napi_env env, napi_callback_info info);
+
+        static napi_value ObserveCallback(napi_env env, napi_callback_info info);
+
+        static napi_value DisconnectCallback(napi_env env, napi_callback_info info);
+
+        static napi_value TakeRecordsCallback(napi_env env, napi_callback_info info);
+
+        static napi_value EntryListGetEntriesCallback(napi_env env, napi_callback_info info);
+
+        static napi_value EntryListGetEntriesByNameCallback(napi_env env, napi_callback_info info);
+
+        static napi_value EntryListGetEntriesByTypeCallback(napi_env env, napi_callback_info info);
+
+        napi_env m_env;
+        int64_t m_originNs;
+        double m_timeOriginMs;
+
+        std::mutex m_mutex;
+        std::vector<Entry> m_entries;
+        size_t m_next;
+        size_t m_count;
+        std::vector<Observer *> m_observers;
+        bool m_deliveryScheduled;
+        bool m_disposed;
+
+        napi_ref m_entryListConstructor;
+        ALooper *m_looper;
+        int m_fd;
     };
 
 } // tns
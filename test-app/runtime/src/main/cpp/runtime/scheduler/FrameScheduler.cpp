@@ -0,0 +1,378 @@
+#include "FrameScheduler.h"
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/eventfd.h>
+#include <android/log.h>
+#include "ArgConverter.h"
+#include "CallbackHandlers.h"
+#include "NativeScriptAssert.h"
+#include "NativeScriptException.h"
+#include "Runtime.h"
+
+using namespace tns;
+
+static int64_t MonotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void FrameScheduler::InitStatic(napi_env env, napi_value global) {
+    auto scheduler = new FrameScheduler(env);
+    scheduler->Init(global);
+}
+
+FrameScheduler::FrameScheduler(napi_env env)
+    : m_env(env), m_id(0), m_scheduler(this), m_looper(nullptr), m_fd(-1), m_hasChoreographer(true),
+      m_framePending(false), m_runPending(false), m_disposing(false), m_currentDeadline(0) {
+}
+
+void FrameScheduler::Init(napi_value global) {
+    auto env = m_env;
+
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_fd == -1) {
+        __android_log_print(ANDROID_LOG_ERROR, "TNS.FrameScheduler", "Unable to create an eventfd: %s", strerror(errno));
+        delete this;
+        return;
+    }
+
+    m_looper = ALooper_prepare(0);
+    ALooper_acquire(m_looper);
+    ALooper_addFd(m_looper, m_fd, ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT, RunCallback, this);
+
+    {
+        std::lock_guard<std::mutex> lock(s_instancesMutex);
+        m_id = ++s_nextId;
+        s_instances.emplace(m_id, this);
+    }
+
+    napi_util::napi_set_function(env, global, "requestIdleCallback", RequestIdleCallbackCallback, this);
+    napi_util::napi_set_function(env, global, "cancelIdleCallback", CancelIdleCallbackCallback, this);
+    napi_util::napi_set_function(env, global, "__getSchedulerStats", GetStatsCallback, this);
+
+    napi_value scheduler;
+    napi_create_object(env, &scheduler);
+    napi_util::napi_set_function(env, scheduler, "postTask", PostTaskCallback, this);
+    napi_set_named_property(env, global, "scheduler", scheduler);
+
+    napi_add_finalizer(env, global, this, [](napi_env env, void *finalizeData, void *finalizeHint) {
+        auto thiz = reinterpret_cast<FrameScheduler *>(finalizeData);
+        delete thiz;
+    }, nullptr, nullptr);
+}
+
+FrameScheduler::~FrameScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(s_instancesMutex);
+        s_instances.erase(m_id);
+    }
+
+    // the promises of the tasks that will not run are rejected, which also releases the deferreds
+    if (!m_pendingTasks.empty()) {
+        auto env = m_env;
+        napi_handle_scope handleScope;
+        napi_open_handle_scope(env, &handleScope);
+
+        napi_value message;
+        napi_create_string_utf8(env, "The scheduler was disposed before the task ran", NAPI_AUTO_LENGTH, &message);
+        for (auto task : m_pendingTasks) {
+            napi_value error;
+            napi_create_error(env, nullptr, message, &error);
+            napi_reject_deferred(env, task->deferred, error);
+            task->deferred = nullptr;
+        }
+        m_pendingTasks.clear();
+
+        napi_close_handle_scope(env, handleScope);
+    }
+
+    // the env is going away, the queued tasks must not touch their references
+    m_disposing = true;
+    m_scheduler.Clear();
+
+    if (m_looper != nullptr) {
+        ALooper_removeFd(m_looper, m_fd);
+        ALooper_release(m_looper);
+    }
+
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+int64_t FrameScheduler::Now() {
+    return MonotonicNow();
+}
+
+void FrameScheduler::RequestFrame() {
+    if (m_hasChoreographer) {
+        m_hasChoreographer = CallbackHandlers::PostNativeFrameCallback(FrameCallback64, FrameCallback,
+                                                                         reinterpret_cast<void*>((intptr_t) m_id));
+        if (m_hasChoreographer) {
+            return;
+        }
+    }
+
+    m_framePending = true;
+    uint64_t value = 1;
+    write(m_fd, &value, sizeof(value));
+}
+
+void FrameScheduler::RequestRun() {
+    m_runPending = true;
+    uint64_t value = 1;
+    write(m_fd, &value, sizeof(value));
+}
+
+void FrameScheduler::FrameCallback64(int64_t frameTimeNanos, void* data) {
+    OnFrame((uint32_t) (intptr_t) data, frameTimeNanos);
+}
+
+void FrameScheduler::FrameCallback(long frameTimeNanos, void* data) {
+    // `long` truncates the frame time on 32-bit devices
+    int64_t frameTime = sizeof(long) < sizeof(int64_t) ? MonotonicNow() : (int64_t) frameTimeNanos;
+    OnFrame((uint32_t) (intptr_t) data, frameTime);
+}
+
+void FrameScheduler::OnFrame(uint32_t id, int64_t frameTimeNanos) {
+    FrameScheduler* scheduler;
+    {
+        std::lock_guard<std::mutex> lock(s_instancesMutex);
+        auto it = s_instances.find(id);
+        if (it == s_instances.end()) {
+            return;
+        }
+        scheduler = it->second;
+    }
+
+    // frames are delivered on the looper of the runtime thread, which is also the thread that
+    // destroys the instance, so it cannot go away from here on
+    scheduler->m_scheduler.OnFrame(frameTimeNanos);
+}
+
+int FrameScheduler::RunCallback(int fd, int events, void* data) {
+    uint64_t value;
+    read(fd, &value, sizeof(value));
+
+    auto self = static_cast<FrameScheduler*>(data);
+
+    if (self->m_framePending) {
+        self->m_framePending = false;
+        self->m_scheduler.OnFrame(self->Now());
+    }
+
+    if (self->m_runPending) {
+        self->m_runPending = false;
+        NapiScope scope(self->m_env);
+        self->m_scheduler.Run();
+    }
+
+    return 1;
+}
+
+FrameScheduler::JsTask::JsTask(FrameScheduler* scheduler, napi_value callback, napi_deferred deferred)
+    : scheduler(scheduler), deferred(deferred) {
+    napi_create_reference(scheduler->m_env, callback, 1, &this->callback);
+    if (deferred != nullptr) {
+        scheduler->m_pendingTasks.insert(this);
+    }
+}
+
+FrameScheduler::JsTask::~JsTask() {
+    if (deferred != nullptr) {
+        scheduler->m_pendingTasks.erase(this);
+    }
+    if (!scheduler->m_disposing) {
+        napi_delete_reference(scheduler->m_env, callback);
+    }
+}
+
+void FrameScheduler::RunTask(const std::shared_ptr<JsTask>& task, const TaskScheduler::Deadline& deadline) {
+    auto env = m_env;
+
+    napi_handle_scope handleScope;
+    napi_open_handle_scope(env, &handleScope);
+
+    napi_value cb = napi_util::get_ref_value(env, task->callback);
+    napi_value global;
+    napi_get_global(env, &global);
+
+    // the deferred is settled below in any case
+    auto deferred = task->deferred;
+    if (deferred != nullptr) {
+        m_pendingTasks.erase(task.get());
+        task->deferred = nullptr;
+    }
+
+    napi_value result = nullptr;
+    if (deferred != nullptr) {
+        napi_call_function(env, global, cb, 0, nullptr, &result);
+    } else {
+        m_currentDeadline = deadline.deadlineNs;
+
+        napi_value idleDeadline;
+        napi_create_object(env, &idleDeadline);
+        napi_value didTimeout;
+        napi_get_boolean(env, deadline.didTimeout, &didTimeout);
+        napi_set_named_property(env, idleDeadline, "didTimeout", didTimeout);
+        napi_util::napi_set_function(env, idleDeadline, "timeRemaining", TimeRemainingCallback, this);
+
+        napi_call_function(env, global, cb, 1, &idleDeadline, &result);
+    }
+
+    bool pendingException;
+    napi_is_exception_pending(env, &pendingException);
+    if (pendingException) {
+        napi_value error;
+        napi_get_and_clear_last_exception(env, &error);
+        if (deferred != nullptr) {
+            napi_reject_deferred(env, deferred, error);
+        } else {
+            NativeScriptException::OnUncaughtError(env, error);
+        }
+    } else if (deferred != nullptr) {
+        if (result == nullptr) {
+            napi_get_undefined(env, &result);
+        }
+        napi_resolve_deferred(env, deferred, result);
+    }
+
+    napi_close_handle_scope(env, handleScope);
+}
+
+napi_value FrameScheduler::RequestIdleCallbackCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    void* data;
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto self = static_cast<FrameScheduler*>(data);
+
+    if (argc < 1 || !napi_util::is_of_type(env, args[0], napi_function)) {
+        napi_throw_type_error(env, nullptr, "requestIdleCallback expects a function");
+        return nullptr;
+    }
+
+    int64_t timeoutNs = 0;
+    if (argc > 1 && napi_util::is_of_type(env, args[1], napi_object)) {
+        napi_value timeout;
+        napi_get_named_property(env, args[1], "timeout", &timeout);
+        if (napi_util::is_of_type(env, timeout, napi_number)) {
+            double timeoutMs;
+            napi_get_value_double(env, timeout, &timeoutMs);
+            if (timeoutMs > 0) {
+                timeoutNs = (int64_t) (timeoutMs * 1e6);
+            }
+        }
+    }
+
+    auto task = std::make_shared<JsTask>(self, args[0], nullptr);
+    auto id = self->m_scheduler.RequestIdleCallback([self, task](const TaskScheduler::Deadline& deadline) {
+        self->RunTask(task, deadline);
+    }, timeoutNs);
+
+    napi_value result;
+    napi_create_uint32(env, id, &result);
+    return result;
+}
+
+napi_value FrameScheduler::CancelIdleCallbackCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    void* data;
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto self = static_cast<FrameScheduler*>(data);
+
+    if (argc > 0 && napi_util::is_of_type(env, args[0], napi_number)) {
+        uint32_t id;
+        napi_get_value_uint32(env, args[0], &id);
+        self->m_scheduler.Cancel(id);
+    }
+
+    return nullptr;
+}
+
+napi_value FrameScheduler::PostTaskCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    void* data;
+    napi_get_cb_info(env, info, &argc, args, nullptr, &data);
+    auto self = static_cast<FrameScheduler*>(data);
+
+    if (argc < 1 || !napi_util::is_of_type(env, args[0], napi_function)) {
+        napi_throw_type_error(env, nullptr, "postTask expects a function");
+        return nullptr;
+    }
+
+    auto priority = TaskScheduler::USER_VISIBLE;
+    if (argc > 1 && napi_util::is_of_type(env, args[1], napi_object)) {
+        napi_value value;
+        napi_get_named_property(env, args[1], "priority", &value);
+        if (!napi_util::is_null_or_undefined(env, value)) {
+            auto name = ArgConverter::ConvertToString(env, value);
+            if (name == "user-blocking") {
+                priority = TaskScheduler::USER_BLOCKING;
+            } else if (name == "background") {
+                priority = TaskScheduler::BACKGROUND;
+            } else if (name != "user-visible") {
+                napi_throw_type_error(env, nullptr, ("Invalid task priority: " + name).c_str());
+                return nullptr;
+            }
+        }
+    }
+
+    napi_deferred deferred;
+    napi_value promise;
+    napi_create_promise(env, &deferred, &promise);
+
+    auto task = std::make_shared<JsTask>(self, args[0], deferred);
+    self->m_scheduler.PostTask(priority, [self, task](const TaskScheduler::Deadline& deadline) {
+        self->RunTask(task, deadline);
+    });
+
+    return promise;
+}
+
+napi_value FrameScheduler::TimeRemainingCallback(napi_env env, napi_callback_info info) {
+    void* data;
+    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+    auto self = static_cast<FrameScheduler*>(data);
+
+    auto remaining = self->m_currentDeadline - self->Now();
+
+    napi_value result;
+    napi_create_double(env, remaining > 0 ? remaining / 1e6 : 0, &result);
+    return result;
+}
+
+napi_value FrameScheduler::GetStatsCallback(napi_env env, napi_callback_info info) {
+    void* data;
+    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+    auto stats = static_cast<FrameScheduler*>(data)->m_scheduler.GetStats();
+
+    napi_value result;
+    napi_create_object(env, &result);
+
+    auto set = [env, result](const char* name, double value) {
+        napi_value jsValue;
+        napi_create_double(env, value, &jsValue);
+        napi_set_named_property(env, result, name, jsValue);
+    };
+
+    set("frames", (double) stats.frames);
+    set("droppedFrames", (double) stats.droppedFrames);
+    set("deadlineOverruns", (double) stats.deadlineOverruns);
+    set("tasksRun", (double) stats.tasksRun);
+    set("idleCallbacksRun", (double) stats.idleCallbacksRun);
+    set("idleTimeouts", (double) stats.idleTimeouts);
+    set("pending", (double) stats.pending);
+    set("frameIntervalMs", stats.frameIntervalNs / 1e6);
+
+    return result;
+}
+
+std::mutex FrameScheduler::s_instancesMutex;
+std::unordered_map<uint32_t, FrameScheduler*> FrameScheduler::s_instances;
+uint32_t FrameScheduler::s_nextId = 0;
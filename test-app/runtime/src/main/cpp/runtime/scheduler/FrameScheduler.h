@@ -0,0 +1,90 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include "TaskScheduler.h"
+#include "js_native_api.h"
+#include <android/looper.h>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tns {
+/*
+ * Exposes TaskScheduler to JS as `requestIdleCallback`/`cancelIdleCallback`, `scheduler.postTask`
+ * (the `priority` option only) and `__getSchedulerStats`, one instance per runtime thread.
+ *
+ * Frames come from AChoreographer on the thread's looper. The tasks of a frame run from an eventfd
+ * callback posted by the frame callback, i.e. after the frame has been rendered. Devices without
+ * AChoreographer (API < 24) get a frame per wakeup, with the default frame interval as budget.
+ */
+class FrameScheduler : public TaskScheduler::Host {
+    public:
+        static void InitStatic(napi_env env, napi_value global);
+
+        ~FrameScheduler();
+
+        int64_t Now() override;
+
+        void RequestFrame() override;
+
+        void RequestRun() override;
+
+    private:
+        struct JsTask {
+            JsTask(FrameScheduler* scheduler, napi_value callback, napi_deferred deferred);
+
+            ~JsTask();
+
+            FrameScheduler* scheduler;
+            napi_ref callback;
+            napi_deferred deferred;
+        };
+
+        explicit FrameScheduler(napi_env env);
+
+        void Init(napi_value global);
+
+        void RunTask(const std::shared_ptr<JsTask>& task, const TaskScheduler::Deadline& deadline);
+
+        static napi_value RequestIdleCallbackCallback(napi_env env, napi_callback_info info);
+
+        static napi_value CancelIdleCallbackCallback(napi_env env, napi_callback_info info);
+
+        static napi_value PostTaskCallback(napi_env env, napi_callback_info info);
+
+        static napi_value TimeRemainingCallback(napi_env env, napi_callback_info info);
+
+        static napi_value GetStatsCallback(napi_env env, napi_callback_info info);
+
+        static void FrameCallback64(int64_t frameTimeNanos, void* data);
+
+        static void FrameCallback(long frameTimeNanos, void* data);
+
+        static void OnFrame(uint32_t id, int64_t frameTimeNanos);
+
+        static int RunCallback(int fd, int events, void* data);
+
+        napi_env m_env;
+        uint32_t m_id;
+        TaskScheduler m_scheduler;
+        ALooper* m_looper;
+        int m_fd;
+        bool m_hasChoreographer;
+        bool m_framePending;
+        bool m_runPending;
+        bool m_disposing;
+        int64_t m_currentDeadline;
+        // the postTask tasks whose promise is not settled yet
+        std::unordered_set<JsTask*> m_pendingTasks;
+
+        // AChoreographer callbacks cannot be cancelled, they get the id of the instance and look
+        // it up, so that a new instance allocated at the same address does not get its frames
+        static std::mutex s_instancesMutex;
+        static std::unordered_map<uint32_t, FrameScheduler*> s_instances;
+        static uint32_t s_nextId;
+};
+}
+
+#endif //FRAMESCHEDULER_H
@@ -0,0 +1,207 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+
+using namespace tns;
+
+TaskScheduler::TaskScheduler(Host* host)
+    : m_host(host), m_nextId(0), m_frameRequested(false), m_runRequested(false), m_inFrame(false), m_consecutiveFrame(false),
+      m_lastFrameTime(0), m_frameInterval(DEFAULT_FRAME_INTERVAL_NS), m_deadline(0),
+      m_frames(0), m_droppedFrames(0), m_deadlineOverruns(0), m_tasksRun(0), m_idleCallbacksRun(0), m_idleTimeouts(0) {
+}
+
+uint32_t TaskScheduler::PostTask(Priority priority, Callback callback) {
+    if (priority < USER_BLOCKING || priority >= IDLE) {
+        priority = USER_VISIBLE;
+    }
+
+    uint32_t id = ++m_nextId == 0 ? ++m_nextId : m_nextId;
+    m_queues[priority].push_back({id, std::move(callback), 0});
+    m_pending.emplace(id, priority);
+
+    ScheduleFrame();
+
+    return id;
+}
+
+uint32_t TaskScheduler::RequestIdleCallback(Callback callback, int64_t timeoutNs) {
+    uint32_t id = ++m_nextId == 0 ? ++m_nextId : m_nextId;
+    int64_t timeoutAt = timeoutNs > 0 ? m_host->Now() + timeoutNs : 0;
+    m_queues[IDLE].push_back({id, std::move(callback), timeoutAt});
+    m_pending.emplace(id, IDLE);
+
+    ScheduleFrame();
+
+    return id;
+}
+
+bool TaskScheduler::Cancel(uint32_t id) {
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        return false;
+    }
+
+    auto& queue = m_queues[it->second];
+    m_pending.erase(it);
+
+    // release the callback right away, it may hold on to JS objects
+    auto task = std::find_if(queue.begin(), queue.end(), [id](const Task& t) {
+        return t.id == id;
+    });
+    if (task != queue.end()) {
+        queue.erase(task);
+    }
+
+    return true;
+}
+
+void TaskScheduler::ScheduleFrame() {
+    if (m_frameRequested) {
+        return;
+    }
+
+    m_frameRequested = true;
+    m_consecutiveFrame = m_inFrame || (m_lastFrameTime > 0 && m_host->Now() - m_lastFrameTime < m_frameInterval);
+    m_host->RequestFrame();
+}
+
+void TaskScheduler::OnFrame(int64_t frameTimeNs) {
+    m_frameRequested = false;
+    m_frames++;
+
+    if (m_consecutiveFrame && frameTimeNs > m_lastFrameTime) {
+        int64_t gap = frameTimeNs - m_lastFrameTime;
+        if (gap < m_frameInterval * 3 / 4) {
+            // gaps are multiples of the refresh period, a short one means the estimate was too long
+            // and a too long estimate hides itself by filling the extra budget with work
+            m_frameInterval = gap;
+        } else if (gap < m_frameInterval * 3 / 2) {
+            // follows refresh rate changes (60/90/120Hz) within a few frames
+            m_frameInterval += (gap - m_frameInterval) / 8;
+        } else {
+            m_droppedFrames += (gap + m_frameInterval / 2) / m_frameInterval - 1;
+        }
+    }
+    m_lastFrameTime = frameTimeNs;
+
+    int64_t now = m_host->Now();
+    m_deadline = std::min(frameTimeNs + m_frameInterval - FRAME_RESERVE_NS, now + MAX_IDLE_PERIOD_NS);
+
+    if (!m_pending.empty() && !m_runRequested) {
+        m_runRequested = true;
+        m_inFrame = true;
+        m_host->RequestRun();
+    }
+}
+
+void TaskScheduler::Run() {
+    m_runRequested = false;
+
+    int64_t now = m_host->Now();
+    int ran = 0;
+    Task task;
+
+    while (true) {
+        bool hasTime = now < m_deadline;
+        bool didTimeout = false;
+
+        if (hasTime || ran == 0) {
+            if (!PopNext(hasTime, task)) {
+                if (hasTime || !PopExpiredIdleCallback(now, task)) {
+                    break;
+                }
+                didTimeout = true;
+            }
+        } else if (PopExpiredIdleCallback(now, task)) {
+            didTimeout = true;
+        } else {
+            break;
+        }
+
+        Deadline deadline{m_deadline, std::max<int64_t>(m_deadline - now, 0), didTimeout};
+        task.callback(deadline);
+        task.callback = nullptr;
+
+        ran++;
+        if (didTimeout) {
+            m_idleTimeouts++;
+        }
+
+        int64_t end = m_host->Now();
+        if (now < m_deadline && end > m_deadline) {
+            m_deadlineOverruns++;
+        }
+        now = end;
+    }
+
+    if (!m_pending.empty()) {
+        ScheduleFrame();
+    }
+    m_inFrame = false;
+}
+
+bool TaskScheduler::PopNext(bool hasTime, Task& task) {
+    for (int priority = USER_BLOCKING; priority < IDLE; priority++) {
+        if (PopFront(m_queues[priority], task)) {
+            m_tasksRun++;
+            return true;
+        }
+    }
+
+    if (hasTime && PopFront(m_queues[IDLE], task)) {
+        m_idleCallbacksRun++;
+        return true;
+    }
+
+    return false;
+}
+
+bool TaskScheduler::PopFront(std::deque<Task>& queue, Task& task) {
+    if (queue.empty()) {
+        return false;
+    }
+
+    task = std::move(queue.front());
+    queue.pop_front();
+    m_pending.erase(task.id);
+
+    return true;
+}
+
+bool TaskScheduler::PopExpiredIdleCallback(int64_t now, Task& task) {
+    auto& queue = m_queues[IDLE];
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (it->timeoutAt != 0 && it->timeoutAt <= now) {
+            task = std::move(*it);
+            queue.erase(it);
+            m_pending.erase(task.id);
+            m_idleCallbacksRun++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TaskScheduler::HasPendingWork() const {
+    return !m_pending.empty();
+}
+
+void TaskScheduler::Clear() {
+    for (auto& queue: m_queues) {
+        queue.clear();
+    }
+    m_pending.clear();
+}
+
+TaskScheduler::Stats TaskScheduler::GetStats() const {
+    Stats stats;
+    stats.frames = m_frames;
+    stats.droppedFrames = m_droppedFrames;
+    stats.deadlineOverruns = m_deadlineOverruns;
+    stats.tasksRun = m_tasksRun;
+    stats.idleCallbacksRun = m_idleCallbacksRun;
+    stats.idleTimeouts = m_idleTimeouts;
+    stats.pending = (int64_t) m_pending.size();
+    stats.frameIntervalNs = m_frameInterval;
+    return stats;
+}
@@ -0,0 +1,147 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+
+namespace tns {
+/*
+ * Cooperative scheduler that runs queued work in the part of a frame the UI does not need.
+ *
+ * Every frame the host reports the vsync timestamp through OnFrame. The deadline of the frame is
+ * the next expected vsync minus FRAME_RESERVE_NS and the host is asked to call Run once the
+ * frame has been rendered. Run executes tasks by priority while the deadline has not passed:
+ * `postTask` tasks first (user-blocking, user-visible, background), idle callbacks last. At least
+ * one task runs per frame so that work never starves, and idle callbacks whose timeout expired run
+ * regardless of the deadline, as the spec requires. Remaining work requests another frame.
+ *
+ * The scheduler knows nothing about the platform or the engine: time, frames and wakeups come
+ * from the Host, which makes it possible to drive it with a synthetic frame clock.
+ *
+ * Not thread safe, all calls must be made on the thread of the host.
+ */
+class TaskScheduler {
+    public:
+        enum Priority {
+            USER_BLOCKING,
+            USER_VISIBLE,
+            BACKGROUND,
+            IDLE,
+            PRIORITY_COUNT
+        };
+
+        struct Deadline {
+            // the end of the idle period, in Host::Now() time
+            int64_t deadlineNs;
+            // time left until the deadline when the callback was invoked, never negative
+            int64_t timeRemainingNs;
+            // true for an idle callback run because its timeout expired
+            bool didTimeout;
+        };
+
+        typedef std::function<void(const Deadline&)> Callback;
+
+        class Host {
+            public:
+                virtual ~Host() = default;
+
+                // monotonic time in nanoseconds, in the same clock as the frame times
+                virtual int64_t Now() = 0;
+
+                // OnFrame should be called on the next frame
+                virtual void RequestFrame() = 0;
+
+                // Run should be called once the current frame has been rendered
+                virtual void RequestRun() = 0;
+        };
+
+        struct Stats {
+            int64_t frames;
+            int64_t droppedFrames;
+            int64_t deadlineOverruns;
+            int64_t tasksRun;
+            int64_t idleCallbacksRun;
+            int64_t idleTimeouts;
+            int64_t pending;
+            int64_t frameIntervalNs;
+        };
+
+        explicit TaskScheduler(Host* host);
+
+        /*
+         * Queues `callback` with the given priority and returns its id, which is never 0
+         */
+        uint32_t PostTask(Priority priority, Callback callback);
+
+        /*
+         * Queues an idle callback, `timeoutNs` <= 0 means no timeout
+         */
+        uint32_t RequestIdleCallback(Callback callback, int64_t timeoutNs);
+
+        /*
+         * Removes a queued task or idle callback, returns false if it already ran or never existed
+         */
+        bool Cancel(uint32_t id);
+
+        void OnFrame(int64_t frameTimeNs);
+
+        void Run();
+
+        bool HasPendingWork() const;
+
+        /*
+         * Drops all queued tasks and idle callbacks without running them
+         */
+        void Clear();
+
+        Stats GetStats() const;
+
+        static const int64_t DEFAULT_FRAME_INTERVAL_NS = 16666667;
+        // left to the UI thread for input handling and the next frame's callbacks
+        static const int64_t FRAME_RESERVE_NS = 1000000;
+        // upper bound of an idle period, as in the requestIdleCallback spec
+        static const int64_t MAX_IDLE_PERIOD_NS = 50000000;
+
+    private:
+        struct Task {
+            uint32_t id;
+            Callback callback;
+            int64_t timeoutAt;
+        };
+
+        void ScheduleFrame();
+
+        bool PopNext(bool hasTime, Task& task);
+
+        bool PopFront(std::deque<Task>& queue, Task& task);
+
+        bool PopExpiredIdleCallback(int64_t now, Task& task);
+
+        Host* m_host;
+        std::deque<Task> m_queues[PRIORITY_COUNT];
+        // id -> priority of every queued task
+        std::unordered_map<uint32_t, int> m_pending;
+        uint32_t m_nextId;
+
+        bool m_frameRequested;
+        bool m_runRequested;
+        // between OnFrame and the end of the Run it requested
+        bool m_inFrame;
+        // whether the requested frame directly follows the last one, only then gaps are drops
+        bool m_consecutiveFrame;
+        int64_t m_lastFrameTime;
+        int64_t m_frameInterval;
+        int64_t m_deadline;
+
+        int64_t m_frames;
+        int64_t m_droppedFrames;
+        int64_t m_deadlineOverruns;
+        int64_t m_tasksRun;
+        int64_t m_idleCallbacksRun;
+        int64_t m_idleTimeouts;
+};
+}
+
+#endif //TASKSCHEDULER_H
@@ -5,8 +5,10 @@
 #include <android/looper.h>
 #include <unistd.h>
 #include <thread>
+#include <cmath>
 #include "Util.h"
 #include "NativeScriptAssert.h"
+#include "Tracing.h"
 
 /**
  * Overall rules when modifying this file:
@@ -27,7 +29,7 @@ inline static double ToMaybePositiveValue(napi_env env, napi_value v) {
     napi_status status = napi_coerce_to_number(env, v, &numberValue);
     if (status == napi_ok) {
         status = napi_get_value_double(env, numberValue, &value);
-        if (status != napi_ok || isnan(value)) {
+        if (status != napi_ok || std::isnan(value)) {
             value = -1;
         }
     }
@@ -40,6 +42,13 @@ static double now_ms() {
     return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
 }
 
+// the references of a timer live until it fired or was cleared
+inline static napi_ref MakeStrongRef(napi_env env, napi_value value) {
+    napi_ref ref;
+    js_create_strong_reference(env, value, &ref);
+    return ref;
+}
+
 using namespace tns;
 
 void Timers::Init(napi_env env, napi_value global) {
@@ -186,6 +195,13 @@ void Timers::Destroy() {
     auto mainLooper = Runtime::GetMainLooper();
     ALooper_removeFd(mainLooper, fd_[0]);
     close(fd_[0]);
+#ifdef __V8__
+    // called while the env is being freed, V8 leaves the strong references of the pending timers
+    // to them, the other engines free them with the env
+    for (auto &entry: timerMap_) {
+        entry.second->Unschedule();
+    }
+#endif
     timerMap_.clear();
     ALooper_release(looper_);
 }
@@ -223,6 +239,7 @@ napi_value Timers::ClearTimer(napi_env env, napi_callback_info info) {
 
 napi_value Timers::SetTimer(napi_env env, napi_callback_info info, bool repeatable) {
     NAPI_CALLBACK_BEGIN_VARGS()
+    instrumentation::TraceScope trace("SetTimer");
 
     auto thiz = reinterpret_cast<Timers *>(data);
 
@@ -249,14 +266,18 @@ napi_value Timers::SetTimer(napi_env env, napi_callback_info info, bool repeatab
             auto otherArgLength = argc - 2;
             argArray = std::make_shared<std::vector<napi_ref>>(otherArgLength);
             for (size_t i = 0; i < otherArgLength; i++) {
-                (*argArray)[i] = napi_util::make_ref(env, argv[i + 2]);
+                (*argArray)[i] = MakeStrongRef(env, argv[i + 2]);
             }
         }
 
-        auto task = std::make_shared<TimerTask>(env, napi_util::make_ref(env, handler), timeout,
+        auto task = std::make_shared<TimerTask>(env, MakeStrongRef(env, handler), timeout,
                                                 repeatable, argArray,
-                                                napi_util::make_ref(env, jsThis), id, now_ms());
+                                                MakeStrongRef(env, jsThis), id, now_ms());
         thiz->addTask(task);
+        if (instrumentation::Tracing::IsEnabled()) {
+            task->flowId_ = instrumentation::Tracing::NewFlowId();
+            instrumentation::Tracing::FlowStart("Timer", task->flowId_);
+        }
     }
     napi_value result;
     napi_create_int32(env, id, &result);
@@ -281,6 +302,18 @@ int Timers::PumpTimerLoopCallback(int fd, int events, void *data) {
     if (it != thiz->timerMap_.end()) {
         NapiScope scope(env);
         auto task = it->second;
+        instrumentation::TraceScope trace("Timer");
+        if (instrumentation::Tracing::IsEnabled()) {
+            if (task->flowId_ != 0) {
+                instrumentation::Tracing::FlowEnd("Timer", task->flowId_);
+            }
+            task->flowId_ = 0;
+            if (task->repeats_) {
+                // chain the next run of the interval to this one
+                task->flowId_ = instrumentation::Tracing::NewFlowId();
+                instrumentation::Tracing::FlowStart("Timer", task->flowId_);
+            }
+        }
         // task is no longer in queue to be executed
         task->queued_ = false;
         thiz->nesting = task->nestingLevel_;
@@ -309,15 +342,9 @@ int Timers::PumpTimerLoopCallback(int fd, int events, void *data) {
         }
 
         // task is not queued, so it's either a setTimeout or a cleared setInterval
-        // ensure we remove it
+        // ensure we remove it, which releases its references
         if (!task->queued_) {
             thiz->removeTask(task);
-            if (argc > 0) {
-                for (size_t i = 0; i < argc; i++) {
-                    napi_delete_reference(env, task->args_->at(i));
-                }
-            }
-            napi_delete_reference(env, task->thisArg);
         }
 
 
@@ -2,6 +2,8 @@
 #define TEST_APP_TIMERS_H
 
 #include <android/looper.h>
+#include <atomic>
+#include <cmath>
 #include "js_native_api.h"
 #include "ObjectManager.h"
 #include "condition_variable"
@@ -12,7 +14,8 @@ namespace tns {
     /**
      * A Timer Task
      * this class is used to store the persistent values and context
-     * once Unschedule is called everything is released
+     * once Unschedule is called everything is released, the references are strong references
+     * (see js_create_strong_reference) that must not outlive the env
      */
     class TimerTask {
     public:
@@ -37,8 +40,18 @@ namespace tns {
         }
 
         inline void Unschedule() {
+            if (env_ != nullptr) {
+                napi_delete_reference(env_, callback_);
+                if (args_ != nullptr) {
+                    for (auto arg: *args_) {
+                        napi_delete_reference(env_, arg);
+                    }
+                }
+                napi_delete_reference(env_, thisArg);
+            }
             callback_ = nullptr;
             args_.reset();
+            thisArg = nullptr;
             env_ = nullptr;
             queued_ = false;
         }
@@ -60,6 +73,8 @@ namespace tns {
         double dueTime_ = -1;
         double startTime_ = -1;
         int id_;
+        // id of the trace flow to the next run, 0 when it was scheduled while not tracing
+        int64_t flowId_ = 0;
     };
 
     struct TimerReference {
@@ -1,7 +1,9 @@
 #include "Util.h"
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <codecvt>
+#include <locale>
 
 using namespace std;
 namespace tns {
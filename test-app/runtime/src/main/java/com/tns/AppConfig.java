@@ -20,7 +20,8 @@ class AppConfig {
         ForceLog("forceLog", false),
         DiscardUncaughtJsExceptions("discardUncaughtJsExceptions", false),
         EnableLineBreakpoins("enableLineBreakpoints", false),
-        EnableMultithreadedJavascript("enableMultithreadedJavascript", false);
+        EnableMultithreadedJavascript("enableMultithreadedJavascript", false),
+        MainThreadDrainBudget("mainThreadDrainBudget", 8);
 
         private final String name;
         private final Object defaultValue;
@@ -107,6 +108,9 @@ class AppConfig {
                     if (androidObject.has(KnownKeys.EnableMultithreadedJavascript.getName())) {
                         values[KnownKeys.EnableMultithreadedJavascript.ordinal()] = androidObject.getBoolean(KnownKeys.EnableMultithreadedJavascript.getName());
                     }
+                    if (androidObject.has(KnownKeys.MainThreadDrainBudget.getName())) {
+                        values[KnownKeys.MainThreadDrainBudget.ordinal()] = androidObject.getInt(KnownKeys.MainThreadDrainBudget.getName());
+                    }
                 }
             }
         } catch (Exception e) {
@@ -171,4 +175,8 @@ class AppConfig {
     public boolean getEnableMultithreadedJavascript() {
         return (boolean)values[KnownKeys.EnableMultithreadedJavascript.ordinal()];
     }
+
+    public int getMainThreadDrainBudget() {
+        return (int)values[KnownKeys.MainThreadDrainBudget.ordinal()];
+    }
 }
@@ -4,10 +4,13 @@ import java.io.File;
 import java.io.IOException;
 
 import android.content.Context;
+import android.content.pm.ApplicationInfo;
 import android.util.Log;
 
 public class AssetExtractor {
     private native void extractAssets(String apkPath, String input, String outputDir, boolean checkForNewerFiles);
+    private static native boolean mountApk(String apkPath, String outputDir);
+    private static boolean apkMounted = false;
     private final Logger logger;
 
     public AssetExtractor(File libPath, Logger logger) {
@@ -21,7 +24,12 @@ public class AssetExtractor {
             if (logger.isEnabled()) {
                 logger.write("extract returned " + success);
             }
-        } else if (extractPolicy.shouldExtract(context)) {
+            return;
+        }
+
+        mountApk(context, outputPath);
+
+        if (extractPolicy.shouldExtract(context)) {
             if (shouldCleanUpPreviousAssets) {
                 try {
                     delete(new File(outputPath + inputPath));
@@ -43,6 +51,23 @@ public class AssetExtractor {
         }
     }
 
+    /**
+     * Lets the runtime read scripts missing from the files directory straight from the APK.
+     * Not done for debuggable apps, which LiveSync updates in place, nor with a custom
+     * FileExtractor, whose files may have nothing to do with the assets of the APK.
+     */
+    private void mountApk(Context context, String outputPath) {
+        if (apkMounted || (context.getApplicationInfo().flags & ApplicationInfo.FLAG_DEBUGGABLE) != 0) {
+            return;
+        }
+
+        apkMounted = true;
+        boolean success = mountApk(context.getPackageCodePath(), outputPath);
+        if (logger.isEnabled()) {
+            logger.write("mountApk returned " + success);
+        }
+    }
+
     /**
      * Delete a file or a directory and its children.
      * @param file The directory to delete.
@@ -47,6 +47,10 @@ public class Runtime {
 
     private native Object runScript(int runtimeId, String filePath) throws NativeScriptException;
 
+    private native String resolveMainModule(int runtimeId) throws NativeScriptException;
+
+    private static native boolean fileExists(String filePath);
+
     private native Object callJSMethodNative(int runtimeId, int javaObjectID, Class<?> claz, String methodName, int retType, boolean isConstructor, Object... packagedArgs) throws NativeScriptException;
 
     private native void createJSInstanceNative(int runtimeId, Object javaObject, int javaObjectID, String canonicalName);
@@ -680,7 +684,7 @@ public class Runtime {
     public void run() {
         ManualInstrumentation.Frame frame = ManualInstrumentation.start("Runtime.run");
         try {
-            String mainModule = Module.bootstrapApp();
+            String mainModule = Module.bootstrapApp(this);
             runModule(new File(mainModule));
         } catch (NativeScriptException e){
             passExceptionToJS(e, false, false);
@@ -698,6 +702,10 @@ public class Runtime {
         }
     }
 
+    String resolveMainModule() throws NativeScriptException {
+        return resolveMainModule(getRuntimeId());
+    }
+
     public Object runScript(File jsFile) {
         try {
             return this.runScript(jsFile, true);
@@ -710,7 +718,8 @@ public class Runtime {
     public Object runScript(File jsFile, final boolean waitForResultOnMainThread) {
         Object result = null;
         try {
-            if (jsFile.exists() && jsFile.isFile()) {
+            // the file may only exist in the APK
+            if (fileExists(jsFile.getAbsolutePath())) {
                 final String filePath = jsFile.getAbsolutePath();
 
                 boolean isWorkThread = threadScheduler.getThread().equals(Thread.currentThread());
@@ -0,0 +1,795 @@
+// Benchmarks of the JS <-> Java bridge: the runtime, with the QuickJS backend, running on the
+// fake Java VM of FakeJni.h, so that CallbackHandlers, the argument converters, ObjectManager and
+// MethodCache can be measured and profiled on a workstation.
+//
+//   bridge_benchmark_quickjs [--iterations N] [--filter name] [--output results.json]
+//                            [--call-latency ns] [--lookup-latency ns] [--string-latency ns]
+//                            [--reference-latency ns] [--check-allocations] [--verbose]
+//
+// The Java side is emulated here: com/tns/Runtime keeps the objects passed to JS by id, describes
+// the benchmark classes through getTypeMetadata and picks their overloads in
+// resolveMethodOverload, the way Runtime.java does. The metadata tree only has java/lang/Object,
+// so the classes are the ones an app creates at run time. With --verbose the Java members that
+// the runtime used but that aren't emulated are listed on stderr.
+//
+// The C++ heap allocations of a call are counted after the benchmark ran, once the caches are
+// warm. With --check-allocations the process exits with 1 when a call that the fake VM serves
+// without allocating, JS -> Java with numbers or objects, allocates in C++ in the runtime (the
+// engine allocates through its own malloc, which is not counted).
+//
+// pending_jobs_wakeup is the latency of a job that the engine queued outside of any JS call, a
+// FinalizationRegistry cleanup after a collection, until the looper of the runtime ran it.
+
+#include "FakeJni.h"
+#include "Runtime.h"
+#include "JType.h"
+#include "js_native_api.h"
+#include "jsr_common.h"
+#include <android/looper.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <atomic>
+#include <csignal>
+#include <new>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace tns;
+
+namespace {
+    std::atomic<uint64_t> s_allocations{0};
+}
+
+// new[] and the nothrow forms go through this one
+void *operator new(size_t size) {
+    s_allocations++;
+    auto memory = malloc(size > 0 ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+extern "C" {
+void Java_com_tns_Runtime_initNativeScript(JNIEnv *env, jobject obj, jint runtimeId,
+                                           jstring filesPath, jstring nativeLibDir,
+                                           jboolean verboseLoggingEnabled, jboolean isDebuggable,
+                                           jstring packageName, jobjectArray args,
+                                           jstring callingDir, jint maxLogcatObjectSize,
+                                           jboolean forceLog);
+
+jobject Java_com_tns_Runtime_callJSMethodNative(JNIEnv *env, jobject obj, jint runtimeId,
+                                                jint javaObjectID, jclass claz,
+                                                jstring methodName, jint retType,
+                                                jboolean isConstructor, jobjectArray packagedArgs);
+
+jobject Java_com_tns_Runtime_runScript(JNIEnv *env, jobject obj, jint runtimeId, jstring scriptFile);
+
+jint Java_com_tns_Runtime_generateNewObjectId(JNIEnv *env, jobject obj, jint runtimeId);
+}
+
+namespace {
+    const size_t BATCH_SIZE = 256;
+    // the calls whose allocations are counted
+    const size_t ALLOCATION_CALLS = 100;
+    const int RUNTIME_ID = 0;
+
+    void Fail(const char *expression, const char *file, int line) {
+        fprintf(stderr, "%s:%d: %s failed\n", file, line, expression);
+        exit(1);
+    }
+
+#define CHECK(expr) \
+    if ((expr) != napi_ok) Fail(#expr, __FILE__, __LINE__)
+
+#define EXPECT(cond) \
+    if (!(cond)) Fail(#cond, __FILE__, __LINE__)
+
+    struct JavaMethod {
+        const char *name;
+        const char *signature;
+        fakejni::MethodImpl impl;
+    };
+
+    struct JavaType {
+        const char *name;
+        std::vector<JavaMethod> methods;
+    };
+
+    /*
+     * The Java half of the bridge
+     */
+    class JavaSide {
+    public:
+        explicit JavaSide(fakejni::Vm &vm) : m_vm(vm) {
+        }
+
+        void DefineType(const JavaType &type) {
+            auto clazz = m_vm.DefineClass(type.name);
+            for (auto &method: type.methods) {
+                m_vm.DefineMethod(clazz, method.name, method.signature, method.impl);
+            }
+            m_types.emplace(type.name, type);
+        }
+
+        /*
+         * Runtime.getTypeMetadata, the packages are "P", the class lists its instance methods
+         */
+        jobjectArray GetTypeMetadata(JNIEnv *env, jstring className, jint index) {
+            auto name = ToString(env, className);
+            std::replace(name.begin(), name.end(), '.', '/');
+
+            std::vector<std::string> parts;
+            size_t start = 0;
+            for (size_t i = 0; i <= name.length(); i++) {
+                if (i == name.length() || name[i] == '/') {
+                    parts.push_back(name.substr(start, i - start));
+                    start = i + 1;
+                }
+            }
+
+            auto length = (jsize) parts.size() - index;
+            auto result = env->NewObjectArray(length, env->FindClass("java/lang/String"), nullptr);
+            for (jsize i = 0; i < length; i++) {
+                std::string part = "P";
+                if (index + i == (jint) parts.size() - 1) {
+                    part = ClassMetadata(name);
+                }
+                auto s = env->NewStringUTF(part.c_str());
+                env->SetObjectArrayElement(result, i, s);
+                env->DeleteLocalRef(s);
+            }
+            return result;
+        }
+
+        /*
+         * Runtime.resolveMethodOverload, by the name and the number of arguments only
+         */
+        jstring ResolveMethodOverload(JNIEnv *env, jstring className, jstring methodName, jobjectArray args) {
+            auto name = ToString(env, className);
+            std::replace(name.begin(), name.end(), '.', '/');
+            auto method = ToString(env, methodName);
+            auto argc = args != nullptr ? env->GetArrayLength(args) : 0;
+
+            auto it = m_types.find(name);
+            if (it != m_types.end()) {
+                for (auto &m: it->second.methods) {
+                    if (method == m.name && ParamCount(m.signature) == argc) {
+                        return env->NewStringUTF(m.signature);
+                    }
+                }
+            }
+            return env->NewStringUTF("");
+        }
+
+        /*
+         * Runtime.getOrCreateJavaObjectID, the objects stay strongly held. The fake VM's handles
+         * are the objects themselves, so they can be the keys.
+         */
+        jint GetOrCreateJavaObjectID(JNIEnv *env, jobject object) {
+            auto it = m_objectToId.find(object);
+            if (it != m_objectToId.end()) {
+                return it->second;
+            }
+            auto id = Java_com_tns_Runtime_generateNewObjectId(env, m_runtime, RUNTIME_ID);
+            auto global = env->NewGlobalRef(object);
+            m_objectToId.emplace(global, id);
+            m_idToObject.emplace(id, global);
+            return id;
+        }
+
+        jobject GetJavaObjectByID(JNIEnv *env, jint id) {
+            auto it = m_idToObject.find(id);
+            if (it == m_idToObject.end()) {
+                env->ThrowNew(env->FindClass("com/tns/NativeScriptException"),
+                              "Attempt to use cleared object reference");
+                return nullptr;
+            }
+            return env->NewLocalRef(it->second);
+        }
+
+        /*
+         * Runtime.packageArgs for a single argument: the type id, the value and the class name
+         */
+        jobjectArray PackageArg(JNIEnv *env, Type type, jobject value) {
+            auto args = env->NewObjectArray(3, m_objectClass, nullptr);
+            auto typeId = env->NewObject(m_integerClass, m_integerCtor, (jint) type);
+            env->SetObjectArrayElement(args, 0, typeId);
+            env->DeleteLocalRef(typeId);
+            if (type == Type::JsObject) {
+                auto clazz = env->GetObjectClass(value);
+                auto className = env->CallObjectMethod(clazz, m_getName);
+                auto id = env->NewObject(m_integerClass, m_integerCtor, GetOrCreateJavaObjectID(env, value));
+                env->SetObjectArrayElement(args, 1, id);
+                env->SetObjectArrayElement(args, 2, className);
+                env->DeleteLocalRef(id);
+                env->DeleteLocalRef(className);
+                env->DeleteLocalRef(clazz);
+            } else {
+                env->SetObjectArrayElement(args, 1, value);
+            }
+            return args;
+        }
+
+        /*
+         * Runtime.callJSMethod on an object that JS holds
+         */
+        jobject CallJSMethod(JNIEnv *env, jobject object, const char *method, Type returnType,
+                             jobjectArray packagedArgs) {
+            auto id = GetOrCreateJavaObjectID(env, object);
+            auto clazz = env->GetObjectClass(object);
+            auto name = env->NewStringUTF(method);
+            auto result = Java_com_tns_Runtime_callJSMethodNative(env, m_runtime, RUNTIME_ID, id,
+                                                                  clazz, name, (jint) returnType,
+                                                                  JNI_FALSE, packagedArgs);
+            env->DeleteLocalRef(name);
+            env->DeleteLocalRef(clazz);
+            if (env->ExceptionCheck()) {
+                env->ExceptionDescribe();
+                Fail(method, __FILE__, __LINE__);
+            }
+            return result;
+        }
+
+        void Init(JNIEnv *env, jobject runtime) {
+            m_runtime = env->NewGlobalRef(runtime);
+            m_objectClass = (jclass) env->NewGlobalRef(env->FindClass("java/lang/Object"));
+            m_integerClass = (jclass) env->NewGlobalRef(env->FindClass("java/lang/Integer"));
+            m_integerCtor = env->GetMethodID(m_integerClass, "<init>", "(I)V");
+            m_getName = env->GetMethodID(env->FindClass("java/lang/Class"), "getName", "()Ljava/lang/String;");
+        }
+
+    private:
+        static std::string ToString(JNIEnv *env, jstring s) {
+            auto chars = env->GetStringUTFChars(s, nullptr);
+            std::string result(chars);
+            env->ReleaseStringUTFChars(s, chars);
+            return result;
+        }
+
+        static int ParamCount(const char *signature) {
+            auto count = 0;
+            for (auto p = signature + 1; *p != ')'; p++, count++) {
+                while (*p == '[') p++;
+                if (*p == 'L') p = strchr(p, ';');
+            }
+            return count;
+        }
+
+        std::string ClassMetadata(const std::string &name) {
+            std::string metadata = "C I\nB java/lang/Object\n";
+            auto it = m_types.find(name);
+            if (it == m_types.end()) {
+                return metadata;
+            }
+            for (auto &method: it->second.methods) {
+                if (strcmp(method.name, "<init>") == 0) {
+                    continue;
+                }
+                metadata += std::string("M ") + method.name + " " + method.signature + " " +
+                            std::to_string(ParamCount(method.signature)) + "\n";
+            }
+            return metadata;
+        }
+
+        fakejni::Vm &m_vm;
+        std::unordered_map<std::string, JavaType> m_types;
+        std::unordered_map<jobject, jint> m_objectToId;
+        std::unordered_map<jint, jobject> m_idToObject;
+        jobject m_runtime = nullptr;
+        jclass m_objectClass = nullptr;
+        jclass m_integerClass = nullptr;
+        jmethodID m_integerCtor = nullptr;
+        jmethodID m_getName = nullptr;
+    };
+
+    JavaSide *s_java = nullptr;
+
+    jvalue Int(jint value) {
+        jvalue v;
+        v.i = value;
+        return v;
+    }
+
+    jvalue Ref(jobject value) {
+        jvalue v;
+        v.l = value;
+        return v;
+    }
+
+    void DefineJavaSide(fakejni::Vm &vm, JavaSide &java) {
+        auto runtime = vm.DefineClass("com/tns/Runtime");
+        vm.DefineStaticMethod(runtime, "getTypeMetadata", "(Ljava/lang/String;I)[Ljava/lang/String;",
+                              [&java](JNIEnv *env, jobject, const jvalue *args) {
+                                  return Ref(java.GetTypeMetadata(env, (jstring) args[0].l, args[1].i));
+                              });
+        vm.DefineMethod(runtime, "resolveMethodOverload", "(Ljava/lang/String;Ljava/lang/String;[Ljava/lang/Object;)Ljava/lang/String;",
+                        [&java](JNIEnv *env, jobject, const jvalue *args) {
+                            return Ref(java.ResolveMethodOverload(env, (jstring) args[0].l, (jstring) args[1].l,
+                                                                  (jobjectArray) args[2].l));
+                        });
+        vm.DefineMethod(runtime, "getOrCreateJavaObjectID", "(Ljava/lang/Object;)I",
+                        [&java](JNIEnv *env, jobject, const jvalue *args) {
+                            return Int(java.GetOrCreateJavaObjectID(env, args[0].l));
+                        });
+        vm.DefineMethod(runtime, "getJavaObjectByID", "(I)Ljava/lang/Object;",
+                        [&java](JNIEnv *env, jobject, const jvalue *args) {
+                            return Ref(java.GetJavaObjectByID(env, args[0].i));
+                        });
+
+        // the message of the errors that reach Java, for ExceptionDescribe
+        auto exception = vm.DefineClass("com/tns/NativeScriptException", "java/lang/RuntimeException");
+        auto setMessage = [](JNIEnv *env, jobject thiz, const jvalue *args) {
+            auto throwable = env->FindClass("java/lang/Throwable");
+            auto detailMessage = env->GetFieldID(throwable, "detailMessage", "Ljava/lang/String;");
+            env->SetObjectField(thiz, detailMessage, args[0].l);
+            return jvalue{};
+        };
+        vm.DefineMethod(exception, "<init>", "(Ljava/lang/String;Ljava/lang/String;J)V", setMessage);
+        vm.DefineMethod(exception, "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;)V", setMessage);
+
+        auto valueField = vm.DefineField(vm.DefineClass("com/tns/bench/Item"), "value", "I");
+        java.DefineType({"com/tns/bench/Item", {
+                {"<init>", "(I)V", [valueField](JNIEnv *env, jobject thiz, const jvalue *args) {
+                    env->SetIntField(thiz, reinterpret_cast<jfieldID>(valueField), args[0].i);
+                    return jvalue{};
+                }},
+                {"getValue", "()I", [valueField](JNIEnv *env, jobject thiz, const jvalue *) {
+                    return Int(env->GetIntField(thiz, reinterpret_cast<jfieldID>(valueField)));
+                }},
+        }});
+
+        java.DefineType({"com/tns/bench/Target", {
+                {"add", "(II)I", [](JNIEnv *, jobject, const jvalue *args) {
+                    return Int(args[0].i + args[1].i);
+                }},
+                {"echo", "(Ljava/lang/String;)Ljava/lang/String;", [](JNIEnv *env, jobject, const jvalue *args) {
+                    return Ref(env->NewLocalRef(args[0].l));
+                }},
+                {"self", "()Lcom/tns/bench/Target;", [](JNIEnv *env, jobject thiz, const jvalue *) {
+                    return Ref(env->NewLocalRef(thiz));
+                }},
+        }});
+
+        // the JS implementations of these are set from the benchmarks
+        java.DefineType({"com/tns/bench/Listener", {
+                {"onInt", "(I)I", nullptr},
+                {"onString", "(Ljava/lang/String;)Ljava/lang/String;", nullptr},
+                {"onItem", "(Lcom/tns/bench/Item;)I", nullptr},
+        }});
+    }
+
+    void WriteFile(const std::string &path, const void *data, size_t length) {
+        auto f = fopen(path.c_str(), "wb");
+        EXPECT(f != nullptr);
+        fwrite(data, 1, length, f);
+        fclose(f);
+    }
+
+    /*
+     * An app files dir whose metadata tree only has java/lang/Object, a class without members
+     * that is its own base. The other classes are added as getTypeMetadata describes them.
+     */
+    std::string CreateFilesDir() {
+        char dir[] = "/tmp/ns-bridge-benchmark-XXXXXX";
+        EXPECT(mkdtemp(dir) != nullptr);
+        std::string filesDir(dir);
+        EXPECT(mkdir((filesDir + "/metadata").c_str(), 0700) == 0);
+        EXPECT(mkdir((filesDir + "/app").c_str(), 0700) == 0);
+
+        // a node is its own first child when it has none, and its own next sibling when last,
+        // value offset 0 stands for packages
+        struct {
+            uint16_t firstChildId;
+            uint16_t nextSiblingId;
+            uint32_t offsetName;
+            uint32_t offsetValue;
+        } nodes[] = {{1, 0, 0,  0},
+                     {2, 1, 2,  0},
+                     {3, 2, 8,  0},
+                     {3, 3, 14, 1}};
+        const char names[] = "\0\0" "\4\0java" "\4\0lang" "\6\0Object";
+        // the type and the base class id, then the counts of the extension functions, instance
+        // methods and fields, Kotlin properties and static methods and fields
+        uint8_t values[] = {0, 1, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        WriteFile(filesDir + "/metadata/treeNodeStream.dat", nodes, sizeof(nodes));
+        WriteFile(filesDir + "/metadata/treeStringsStream.dat", names, sizeof(names) - 1);
+        WriteFile(filesDir + "/metadata/treeValueStream.dat", values, sizeof(values));
+        return filesDir;
+    }
+
+    void RemoveFilesDir(const std::string &filesDir) {
+        unlink((filesDir + "/metadata/treeNodeStream.dat").c_str());
+        unlink((filesDir + "/metadata/treeStringsStream.dat").c_str());
+        unlink((filesDir + "/metadata/treeValueStream.dat").c_str());
+        rmdir((filesDir + "/metadata").c_str());
+        rmdir((filesDir + "/app").c_str());
+        rmdir(filesDir.c_str());
+    }
+
+    void InitRuntime(JNIEnv *env, const std::string &filesDir) {
+        auto runtimeClass = env->FindClass("com/tns/Runtime");
+        auto runtime = env->AllocObject(runtimeClass);
+        s_java->Init(env, runtime);
+
+        // AppConfig.getAsArray, with the defaults of the values that the runtime reads
+        auto args = env->NewObjectArray(15, env->FindClass("java/lang/Object"), nullptr);
+        auto booleanClass = env->FindClass("java/lang/Boolean");
+        auto integerClass = env->FindClass("java/lang/Integer");
+        env->SetObjectArrayElement(args, 0, env->NewStringUTF(""));
+        env->SetObjectArrayElement(args, 1, env->NewObject(booleanClass, env->GetMethodID(booleanClass, "<init>", "(Z)V"), JNI_FALSE));
+        env->SetObjectArrayElement(args, 2, env->NewStringUTF(""));
+        env->SetObjectArrayElement(args, 14, env->NewObject(integerClass, env->GetMethodID(integerClass, "<init>", "(I)V"), 8));
+
+        auto files = env->NewStringUTF(filesDir.c_str());
+        auto empty = env->NewStringUTF("");
+        auto packageName = env->NewStringUTF("com.tns.bench");
+        Java_com_tns_Runtime_initNativeScript(env, runtime, RUNTIME_ID, files, empty, JNI_FALSE,
+                                              JNI_FALSE, packageName, args, files, 1024, JNI_FALSE);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            Fail("initNativeScript", __FILE__, __LINE__);
+        }
+
+        // the proxies of the Java objects come from the app's helpers, as Runtime.java runs them
+        auto helpers = env->NewStringUTF(TS_HELPERS_JS);
+        Java_com_tns_Runtime_runScript(env, runtime, RUNTIME_ID, helpers);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            Fail(TS_HELPERS_JS, __FILE__, __LINE__);
+        }
+    }
+
+    napi_value RunScript(napi_env env, const char *code) {
+        napi_value source, result;
+        CHECK(napi_create_string_utf8(env, code, strlen(code), &source));
+        if (js_execute_script(env, source, "benchmark.js", &result) != napi_ok) {
+            napi_value error;
+            napi_get_and_clear_last_exception(env, &error);
+            napi_value message;
+            char buffer[1024];
+            size_t length = 0;
+            if (napi_coerce_to_string(env, error, &message) == napi_ok) {
+                napi_get_value_string_utf8(env, message, buffer, sizeof(buffer), &length);
+            }
+            fprintf(stderr, "%.*s\n", (int) length, buffer);
+            Fail(code, __FILE__, __LINE__);
+        }
+        return result;
+    }
+
+    /*
+     * Creates a Java object and hands it to JS as the global `name`
+     */
+    jobject Expose(JNIEnv *env, napi_env napiEnv, const char *className, const char *name) {
+        auto clazz = env->FindClass(className);
+        auto object = env->NewGlobalRef(env->AllocObject(clazz));
+        auto id = s_java->GetOrCreateJavaObjectID(env, object);
+        auto runtime = Runtime::GetRuntime(RUNTIME_ID);
+        auto wrapper = runtime->GetObjectManager()->CreateJSWrapper(id, className);
+        EXPECT(wrapper != nullptr);
+        napi_value global;
+        CHECK(napi_get_global(napiEnv, &global));
+        CHECK(napi_set_named_property(napiEnv, global, name, wrapper));
+        return object;
+    }
+
+    /*
+     * Calls fn(i) for i in [0, iterations), in local frames of BATCH_SIZE calls
+     */
+    template<typename Fn>
+    void Loop(JNIEnv *env, napi_env napiEnv, size_t iterations, Fn fn) {
+        for (size_t i = 0; i < iterations;) {
+            napi_handle_scope scope;
+            CHECK(napi_open_handle_scope(napiEnv, &scope));
+            env->PushLocalFrame((jint) BATCH_SIZE);
+            auto end = std::min(iterations, i + BATCH_SIZE);
+            for (; i < end; i++) {
+                fn(i);
+            }
+            env->PopLocalFrame(nullptr);
+            CHECK(napi_close_handle_scope(napiEnv, scope));
+        }
+    }
+
+    struct Context {
+        JNIEnv *env;
+        napi_env napiEnv;
+        jobject listener;
+        // set by the benchmarks that time the operations themselves
+        double nsPerOp;
+    };
+
+    double RunJsLoop(napi_env env, const char *body, size_t iterations) {
+        char code[512];
+        snprintf(code, sizeof(code), "(function () { var r = 0; for (var i = 0; i < %zu; i++) { %s } return r; })()",
+                 iterations, body);
+        double result;
+        CHECK(napi_get_value_double(env, RunScript(env, code), &result));
+        return result;
+    }
+
+    void JsToJavaInt(Context &c, size_t iterations) {
+        auto r = RunJsLoop(c.napiEnv, "r += target.add(i, 1);", iterations);
+        EXPECT(r == (double) iterations * (iterations + 1) / 2);
+    }
+
+    void JsToJavaString(Context &c, size_t iterations) {
+        auto r = RunJsLoop(c.napiEnv, "r += target.echo('hello').length;", iterations);
+        EXPECT(r == 5.0 * iterations);
+    }
+
+    void JsToJavaObject(Context &c, size_t iterations) {
+        auto r = RunJsLoop(c.napiEnv, "if (target.self() === target) r++;", iterations);
+        EXPECT(r == (double) iterations);
+    }
+
+    void JavaToJsInt(Context &c, size_t iterations) {
+        auto env = c.env;
+        auto integerClass = env->FindClass("java/lang/Integer");
+        auto ctor = env->GetMethodID(integerClass, "<init>", "(I)V");
+        auto intValue = env->GetMethodID(integerClass, "intValue", "()I");
+        Loop(env, c.napiEnv, iterations, [&](size_t i) {
+            auto value = env->NewObject(integerClass, ctor, (jint) i);
+            auto args = s_java->PackageArg(env, Type::Int, value);
+            auto result = s_java->CallJSMethod(env, c.listener, "onInt", Type::Int, args);
+            EXPECT(env->CallIntMethod(result, intValue) == (jint) i + 1);
+        });
+    }
+
+    void JavaToJsString(Context &c, size_t iterations) {
+        auto env = c.env;
+        Loop(env, c.napiEnv, iterations, [&](size_t) {
+            auto value = env->NewStringUTF("hello");
+            auto args = s_java->PackageArg(env, Type::String, value);
+            auto result = s_java->CallJSMethod(env, c.listener, "onString", Type::String, args);
+            EXPECT(env->GetStringLength((jstring) result) == 11);
+        });
+    }
+
+    void WrapperChurn(Context &c, size_t iterations) {
+        auto env = c.env;
+        auto itemClass = env->FindClass("com/tns/bench/Item");
+        auto ctor = env->GetMethodID(itemClass, "<init>", "(I)V");
+        auto integerClass = env->FindClass("java/lang/Integer");
+        auto intValue = env->GetMethodID(integerClass, "intValue", "()I");
+        Loop(env, c.napiEnv, iterations, [&](size_t i) {
+            auto item = env->NewObject(itemClass, ctor, (jint) i);
+            auto args = s_java->PackageArg(env, Type::JsObject, item);
+            auto result = s_java->CallJSMethod(env, c.listener, "onItem", Type::Int, args);
+            EXPECT(env->CallIntMethod(result, intValue) == (jint) i);
+        });
+    }
+
+    size_t s_cleanups = 0;
+    std::chrono::steady_clock::time_point s_cleanedAt;
+
+    napi_value OnCleanup(napi_env env, napi_callback_info info) {
+        s_cleanedAt = std::chrono::steady_clock::now();
+        s_cleanups++;
+        return nullptr;
+    }
+
+    void PendingJobsWakeup(Context &c, size_t iterations) {
+        auto env = c.napiEnv;
+        napi_value global, onCleanup;
+        CHECK(napi_get_global(env, &global));
+        CHECK(napi_create_function(env, "__onCleanup", NAPI_AUTO_LENGTH, OnCleanup, nullptr, &onCleanup));
+        CHECK(napi_set_named_property(env, global, "__onCleanup", onCleanup));
+        RunScript(env, "globalThis.__registry = new FinalizationRegistry(function () { __onCleanup(); });");
+
+        int64_t totalNs = 0;
+        size_t measured = 0;
+        for (size_t i = 0; i < iterations; i++) {
+            napi_handle_scope scope;
+            CHECK(napi_open_handle_scope(env, &scope));
+
+            auto cleanups = s_cleanups;
+            // a cycle, which only a collection frees, reference counting would free a plain object at once
+            RunScript(env, "(function () { var o = {}; o.self = o; __registry.register(o, 0); })();");
+            // a collection while the script ran, its cleanup was drained when the script returned
+            if (s_cleanups != cleanups) {
+                CHECK(napi_close_handle_scope(env, scope));
+                continue;
+            }
+
+            // the next allocation, outside of JS, collects the registered object and queues the cleanup
+            int64_t threshold;
+            CHECK(napi_adjust_external_memory(env, INT64_MAX / 2, &threshold));
+            napi_value object;
+            CHECK(napi_create_object(env, &object));
+            auto queuedAt = std::chrono::steady_clock::now();
+
+            while (s_cleanups == cleanups) {
+                EXPECT(ALooper_pollOnce(1000, nullptr, nullptr, nullptr) != ALOOPER_POLL_TIMEOUT);
+            }
+            totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(s_cleanedAt - queuedAt).count();
+            measured++;
+
+            CHECK(napi_close_handle_scope(env, scope));
+        }
+
+        EXPECT(measured > 0);
+        c.nsPerOp = (double) totalNs / measured;
+    }
+
+    typedef void (*BenchmarkFn)(Context &c, size_t iterations);
+
+    struct Benchmark {
+        const char *name;
+        BenchmarkFn run;
+        // iterations / divisor are run, for the slow ones
+        size_t divisor;
+        // for --check-allocations, the fake VM allocates its strings and objects
+        bool allocationFree;
+    };
+
+    const Benchmark BENCHMARKS[] = {
+            {"js_to_java_int",    JsToJavaInt,    1, true},
+            {"js_to_java_string", JsToJavaString, 1, false},
+            {"js_to_java_object", JsToJavaObject, 1, true},
+            {"java_to_js_int",    JavaToJsInt,    1, false},
+            {"java_to_js_string", JavaToJsString, 1, false},
+            {"wrapper_churn",     WrapperChurn,   4, false},
+            {"pending_jobs_wakeup", PendingJobsWakeup, 1000, false},
+    };
+
+    struct Result {
+        const char *name;
+        size_t iterations;
+        double nsPerOp;
+        uint64_t jniCalls;
+        double allocationsPerOp;
+    };
+
+    void WriteJson(FILE *out, const std::vector<Result> &results, const fakejni::Latency &latency) {
+        fprintf(out, "{\n  \"engine\": \"quickjs\",\n  \"latency_ns\": {\"call\": %u, \"lookup\": %u, \"string\": %u, \"reference\": %u},\n  \"results\": [",
+                latency.call, latency.lookup, latency.string, latency.reference);
+        for (size_t i = 0; i < results.size(); i++) {
+            auto &r = results[i];
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"java_calls_per_op\": %.2f, \"allocations_per_op\": %.2f}",
+                    i > 0 ? "," : "", r.name, r.iterations, r.nsPerOp, r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0.0,
+                    (double) r.jniCalls / r.iterations, r.allocationsPerOp);
+        }
+        fprintf(out, "\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = 100000;
+    const char *filter = nullptr;
+    const char *output = nullptr;
+    bool verbose = false;
+    bool checkAllocations = false;
+    fakejni::Latency latency;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--call-latency") == 0 && i + 1 < argc) {
+            latency.call = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--lookup-latency") == 0 && i + 1 < argc) {
+            latency.lookup = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--string-latency") == 0 && i + 1 < argc) {
+            latency.string = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--reference-latency") == 0 && i + 1 < argc) {
+            latency.reference = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--check-allocations") == 0) {
+            checkAllocations = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--filter name] [--output file] [--call-latency ns]"
+                            " [--lookup-latency ns] [--string-latency ns] [--reference-latency ns] [--check-allocations] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    fakejni::Vm vm;
+    JavaSide java(vm);
+    s_java = &java;
+    DefineJavaSide(vm, java);
+
+    auto env = vm.GetEnv();
+    JNI_OnLoad(vm.GetJavaVM(), nullptr);
+    // crash instead of throwing from the runtime's signal handlers, so that a crash shows where
+    signal(SIGABRT, SIG_DFL);
+    signal(SIGSEGV, SIG_DFL);
+
+    auto filesDir = CreateFilesDir();
+    InitRuntime(env, filesDir);
+
+    auto runtime = Runtime::GetRuntime(RUNTIME_ID);
+    auto napiEnv = runtime->GetNapiEnv();
+    napi_handle_scope scope;
+    CHECK(napi_open_handle_scope(napiEnv, &scope));
+
+    Expose(env, napiEnv, "com/tns/bench/Target", "target");
+    auto listener = Expose(env, napiEnv, "com/tns/bench/Listener", "listener");
+    RunScript(napiEnv, "listener.onInt = function (i) { return i + 1; };"
+                       "listener.onString = function (s) { return s + ' world'; };"
+                       "listener.onItem = function (item) { return item.getValue(); };");
+
+    Context context{env, napiEnv, listener, 0};
+    // the latency applies to the measured calls, not to the runtime's start
+    vm.latency = latency;
+
+    std::vector<Result> results;
+    for (auto &benchmark: BENCHMARKS) {
+        if (filter != nullptr && strstr(benchmark.name, filter) == nullptr) {
+            continue;
+        }
+
+        auto count = std::max<size_t>(1, iterations / benchmark.divisor);
+        context.nsPerOp = 0;
+        auto calls = vm.counters.calls.load();
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(context, count);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        auto nsPerOp = context.nsPerOp > 0 ? context.nsPerOp : (double) ns / count;
+        calls = vm.counters.calls.load() - calls;
+
+        auto allocations = s_allocations.load();
+        benchmark.run(context, ALLOCATION_CALLS);
+        allocations = s_allocations.load() - allocations;
+        if (checkAllocations && benchmark.allocationFree && allocations > 0) {
+            fprintf(stderr, "%s: %llu C++ heap allocations in %zu calls\n", benchmark.name,
+                    (unsigned long long) allocations, ALLOCATION_CALLS);
+            return 1;
+        }
+
+        results.push_back({benchmark.name, count, nsPerOp, calls,
+                           (double) allocations / ALLOCATION_CALLS});
+    }
+
+    CHECK(napi_close_handle_scope(napiEnv, scope));
+    RemoveFilesDir(filesDir);
+
+    if (verbose) {
+        fprintf(stderr, "Java members used by the runtime but not emulated:\n");
+        for (auto &member: vm.AutoDefined()) {
+            fprintf(stderr, "  %s\n", member.c_str());
+        }
+        fprintf(stderr, "live objects: %llu, live global refs: %llu, invalid deletes: %llu\n",
+                (unsigned long long) vm.counters.liveObjects.load(),
+                (unsigned long long) vm.counters.liveGlobalRefs.load(),
+                (unsigned long long) vm.counters.invalidDeletes.load());
+    }
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output);
+            return 1;
+        }
+    }
+    WriteJson(out, results, latency);
+    if (out != stdout) {
+        fclose(out);
+    } else {
+        fflush(out);
+    }
+
+    // the runtime isn't torn down, as with an app process it lives until the exit
+    _exit(0);
+}
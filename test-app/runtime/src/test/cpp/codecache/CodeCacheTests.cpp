@@ -0,0 +1,304 @@
+// Runs modules through the QuickJS code bundle and code cache of jsr.cpp. The bundle is built by
+// qjs_code_bundle from codecache/app for the device directory /device/app.
+//
+//   code_cache_tests_quickjs <bundle> <app dir>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "jsr.h"
+#include "quickjs.h"
+
+static int s_failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static const char *const MODULE_PARAMS[] = {"module", "exports", "require", "__filename", "__dirname"};
+static const size_t MODULE_PARAM_COUNT = sizeof(MODULE_PARAMS) / sizeof(MODULE_PARAMS[0]);
+
+static std::string s_bundle;
+static std::string s_appDir;
+static std::string s_tempDir;
+
+static std::string ReadFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+static bool WaitForFile(const std::string &path) {
+    for (int i = 0; i < 100; i++) {
+        if (access(path.c_str(), F_OK) == 0) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+/*
+ * An env with the code bundle and cache of the given paths, empty paths leave them out
+ */
+class Env {
+    public:
+        Env(const std::string &root, const std::string &bundle, const std::string &cache) {
+            js_create_runtime(&runtime);
+            js_create_napi_env(&env, runtime);
+            js_set_code_bundle(env, bundle.c_str(), root.c_str());
+            if (!cache.empty()) {
+                js_set_code_cache_path(env, cache.c_str());
+            }
+            napi_open_handle_scope(env, &scope);
+        }
+
+        ~Env() {
+            napi_close_handle_scope(env, scope);
+            js_free_napi_env(env);
+            js_free_runtime(runtime);
+        }
+
+        /*
+         * Compiles `source` as a module of `file`, runs it and returns its exports
+         */
+        napi_value Require(const std::string &file, const std::string &source) {
+            auto copy = new char[source.size() + 1];
+            memcpy(copy, source.c_str(), source.size() + 1);
+            napi_value function;
+            auto status = js_compile_function(env, copy, source.size(), ("file://" + file).c_str(),
+                                              MODULE_PARAMS, MODULE_PARAM_COUNT,
+                                              [](napi_env, void *data, void *) {
+                                                  delete[] static_cast<char *>(data);
+                                              }, nullptr, &function);
+            EXPECT(status == napi_ok);
+            if (status != napi_ok) {
+                return nullptr;
+            }
+
+            napi_value module, exports, undefined;
+            napi_create_object(env, &module);
+            napi_create_object(env, &exports);
+            napi_set_named_property(env, module, "exports", exports);
+            napi_get_undefined(env, &undefined);
+            napi_value args[] = {module, exports, RequireStub(), undefined, undefined};
+            napi_value result;
+            status = napi_call_function(env, undefined, function, 5, args, &result);
+            EXPECT(status == napi_ok);
+            return exports;
+        }
+
+        std::string Where(napi_value exports) {
+            napi_value where, undefined, stack;
+            napi_get_named_property(env, exports, "where", &where);
+            napi_get_undefined(env, &undefined);
+            if (napi_call_function(env, undefined, where, 0, nullptr, &stack) != napi_ok) {
+                return "";
+            }
+            size_t length;
+            napi_get_value_string_utf8(env, stack, nullptr, 0, &length);
+            std::string result(length, '\0');
+            napi_get_value_string_utf8(env, stack, &result[0], length + 1, &length);
+            return result;
+        }
+
+        int32_t Int(napi_value exports, const char *name) {
+            napi_value value;
+            int32_t result = -1;
+            napi_get_named_property(env, exports, name, &value);
+            napi_get_value_int32(env, value, &result);
+            return result;
+        }
+
+        napi_env env;
+
+    private:
+        // require("./lib/util") of main.js, with a twice that works without util.js
+        napi_value RequireStub() {
+            const char *script = "(function () { return { twice: function (x) { return x * 2; } }; })";
+            napi_value source, require;
+            napi_create_string_utf8(env, script, NAPI_AUTO_LENGTH, &source);
+            js_execute_script(env, source, "require.js", &require);
+            return require;
+        }
+
+        napi_runtime runtime;
+        napi_handle_scope scope;
+};
+
+static bool Contains(const std::string &text, const std::string &part) {
+    return text.find(part) != std::string::npos;
+}
+
+// the file names in stack traces show where the bytecode came from
+static void RunsModulesFromTheBundle() {
+    auto main = ReadFile(s_appDir + "/main.js");
+    auto util = ReadFile(s_appDir + "/lib/util.js");
+
+    Env env("/host/app/", s_bundle, "");
+    auto mainExports = env.Require("/host/app/main.js", main);
+    EXPECT(env.Int(mainExports, "answer") == 42);
+    EXPECT(Contains(env.Where(mainExports), "/device/app/main.js"));
+
+    auto utilExports = env.Require("/host/app/lib/util.js", util);
+    EXPECT(Contains(env.Where(utilExports), "/device/app/lib/util.js"));
+}
+
+static void CompilesChangedModules() {
+    auto main = ReadFile(s_appDir + "/main.js") + "\nexports.changed = true;\n";
+
+    Env env("/host/app/", s_bundle, "");
+    auto exports = env.Require("/host/app/main.js", main);
+    EXPECT(env.Int(exports, "answer") == 42);
+    EXPECT(Contains(env.Where(exports), "/host/app/main.js"));
+}
+
+static void CompilesModulesOutsideTheApp() {
+    auto main = ReadFile(s_appDir + "/main.js");
+
+    Env env("/host/app/", s_bundle, "");
+    auto exports = env.Require("/elsewhere/main.js", main);
+    EXPECT(Contains(env.Where(exports), "/elsewhere/main.js"));
+}
+
+static void CachesCompiledModules() {
+    auto cache = s_tempDir + "/cache";
+    auto source = std::string("exports.where = function () { return new Error('where').stack; };\n");
+    {
+        Env env("/first/", "", cache);
+        auto exports = env.Require("/first/module.js", source);
+        EXPECT(Contains(env.Where(exports), "/first/module.js"));
+    }
+    EXPECT(WaitForFile(cache));
+
+    Env env("/second/", "", cache);
+    auto exports = env.Require("/second/module.js", source);
+    EXPECT(Contains(env.Where(exports), "/first/module.js"));
+}
+
+static void CompilesWhenTheBytecodeCannotBeLoaded() {
+    auto cache = s_tempDir + "/stale";
+    auto source = std::string("exports.where = function () { return new Error('where').stack; };\n");
+    auto wrapped = js_wrap_function_source(source.data(), source.size(), MODULE_PARAMS, MODULE_PARAM_COUNT);
+    {
+        JsrCodeCache keys(JS_GetVersion());
+        keys.SetBundle("", "/app/");
+        CacheBlob blob(cache);
+        auto garbage = new uint8_t[16]();
+        blob.insert(keys.Key("file:///app/module.js", wrapped.data(), wrapped.size()), garbage, 16);
+        blob.output();
+    }
+
+    Env env("/app/", "", cache);
+    auto exports = env.Require("/app/module.js", source);
+    EXPECT(Contains(env.Where(exports), "/app/module.js"));
+}
+
+// runtimes that share a cache file don't overwrite each other's writes, the first one writes it
+static void WritesTheCacheFromOneRuntime() {
+    auto cache = s_tempDir + "/shared";
+    auto first = std::string("exports.where = function () { return new Error('first').stack; };\n");
+    auto second = std::string("exports.where = function () { return new Error('second').stack; };\n");
+    {
+        Env writer("/writer/", "", cache);
+        Env reader("/reader/", "", cache);
+        writer.Require("/writer/first.js", first);
+        reader.Require("/reader/second.js", second);
+    }
+    EXPECT(WaitForFile(cache));
+
+    Env env("/app/", "", cache);
+    EXPECT(Contains(env.Where(env.Require("/app/first.js", first)), "/writer/first.js"));
+    EXPECT(Contains(env.Where(env.Require("/app/second.js", second)), "/app/second.js"));
+}
+
+static void DropsCorruptedUnits() {
+    auto path = s_tempDir + "/corrupted";
+    {
+        CacheBlob blob(path);
+        auto data = new uint8_t[64];
+        memset(data, 7, 64);
+        blob.insert("unit", data, 64);
+        blob.output();
+    }
+
+    // the data of the unit ends the file
+    auto file = fopen(path.c_str(), "r+b");
+    fseek(file, -1, SEEK_END);
+    fputc(8, file);
+    fclose(file);
+
+    CacheBlob blob(path);
+    EXPECT(blob.input());
+    int length = -1;
+    EXPECT(blob.find("unit", &length) == nullptr);
+    EXPECT(length == 0);
+}
+
+static double Milliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// not an expectation, the numbers show what the cache saves
+static void ReportsColdAndWarmStarts() {
+    std::string source;
+    for (int i = 0; i < 2000; i++) {
+        source += "exports.f" + std::to_string(i) + " = function (a, b) { var s = 0; for (var i = 0; i < a; i++) { s += i * b + " + std::to_string(i) + "; } return { s: s, t: [a, b, 'f" + std::to_string(i) + "'] }; };\n";
+    }
+
+    auto cache = s_tempDir + "/timing";
+    auto time = [&](const char *root, const std::string &cachePath) {
+        Env env(root, "", cachePath);
+        auto start = std::chrono::steady_clock::now();
+        env.Require(std::string(root) + "big.js", source);
+        return Milliseconds(std::chrono::steady_clock::now() - start);
+    };
+    auto uncached = time("/uncached/", "");
+    auto cold = time("/cold/", cache);
+    WaitForFile(cache);
+    auto warm = time("/warm/", cache);
+    printf("%zu KB module: without cache %.2f ms, cold %.2f ms, warm %.2f ms\n",
+           source.size() / 1024, uncached, cold, warm);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <bundle> <app dir>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    s_bundle = argv[1];
+    s_appDir = argv[2];
+    char tempDir[] = "/tmp/code-cache-tests-XXXXXX";
+    s_tempDir = mkdtemp(tempDir);
+
+    RunsModulesFromTheBundle();
+    CompilesChangedModules();
+    CompilesModulesOutsideTheApp();
+    CachesCompiledModules();
+    CompilesWhenTheBytecodeCannotBeLoaded();
+    WritesTheCacheFromOneRuntime();
+    DropsCorruptedUnits();
+    ReportsColdAndWarmStarts();
+
+    std::string cleanup = "rm -rf " + s_tempDir;
+    system(cleanup.c_str());
+
+    if (s_failures > 0) {
+        fprintf(stderr, "%d expectations failed\n", s_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all code cache tests passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,2 @@
+// does not compile, the bundle tool skips it
+exports.broken = function ( {;
@@ -0,0 +1,7 @@
+exports.twice = function (x) {
+    return x * 2;
+};
+
+exports.where = function () {
+    return new Error("where").stack;
+};
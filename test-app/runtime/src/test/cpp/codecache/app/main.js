@@ -0,0 +1,7 @@
+var util = require("./lib/util");
+
+exports.answer = util.twice(21);
+
+exports.where = function () {
+    return new Error("where").stack;
+};
@@ -0,0 +1,178 @@
+// Host implementations of the NDK functions that the runtime calls: logging, loopers, the API
+// level and the system properties.
+
+#include <android/api-level.h>
+#include <android/log.h>
+#include <android/looper.h>
+#include <sys/system_properties.h>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    const int HOST_API_LEVEL = 23;
+
+    struct FdEntry {
+        int ident;
+        int events;
+        ALooper_callbackFunc callback;
+        void *data;
+    };
+}
+
+struct ALooper {
+    std::atomic<int> refs{1};
+    int wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    std::mutex mutex;
+    std::map<int, FdEntry> fds;
+};
+
+namespace {
+    thread_local ALooper *t_looper = nullptr;
+}
+
+extern "C" {
+
+int __android_log_write(int prio, const char *tag, const char *text) {
+    static const char levels[] = "  VDIWEFS";
+    auto level = prio >= 0 && prio < (int) sizeof(levels) - 1 ? levels[prio] : ' ';
+    return fprintf(stderr, "%c/%s: %s\n", level, tag != nullptr ? tag : "", text);
+}
+
+int __android_log_print(int prio, const char *tag, const char *fmt, ...) {
+    char buffer[4096];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    return __android_log_write(prio, tag, buffer);
+}
+
+int android_get_device_api_level() {
+    return HOST_API_LEVEL;
+}
+
+int __system_property_get(const char *name, char *value) {
+    if (strcmp(name, "ro.build.version.sdk") == 0) {
+        return snprintf(value, PROP_VALUE_MAX, "%d", HOST_API_LEVEL);
+    }
+    value[0] = '\0';
+    return 0;
+}
+
+ALooper *ALooper_forThread() {
+    return t_looper;
+}
+
+ALooper *ALooper_prepare(int) {
+    if (t_looper == nullptr) {
+        t_looper = new ALooper;
+    }
+    return t_looper;
+}
+
+void ALooper_acquire(ALooper *looper) {
+    looper->refs.fetch_add(1);
+}
+
+void ALooper_release(ALooper *looper) {
+    if (looper->refs.fetch_sub(1) == 1) {
+        if (t_looper == looper) {
+            t_looper = nullptr;
+        }
+        close(looper->wakeFd);
+        delete looper;
+    }
+}
+
+int ALooper_addFd(ALooper *looper, int fd, int ident, int events, ALooper_callbackFunc callback,
+                  void *data) {
+    std::lock_guard<std::mutex> lock(looper->mutex);
+    looper->fds[fd] = {callback != nullptr ? ALOOPER_POLL_CALLBACK : ident, events, callback, data};
+    return 1;
+}
+
+int ALooper_removeFd(ALooper *looper, int fd) {
+    std::lock_guard<std::mutex> lock(looper->mutex);
+    return looper->fds.erase(fd) > 0 ? 1 : 0;
+}
+
+void ALooper_wake(ALooper *looper) {
+    uint64_t one = 1;
+    write(looper->wakeFd, &one, sizeof(one));
+}
+
+int ALooper_pollOnce(int timeoutMillis, int *outFd, int *outEvents, void **outData) {
+    auto looper = t_looper;
+    if (looper == nullptr) {
+        return ALOOPER_POLL_ERROR;
+    }
+
+    std::vector<pollfd> pollFds;
+    pollFds.push_back({looper->wakeFd, POLLIN, 0});
+    {
+        std::lock_guard<std::mutex> lock(looper->mutex);
+        for (auto &entry: looper->fds) {
+            short events = 0;
+            if (entry.second.events & ALOOPER_EVENT_INPUT) events |= POLLIN;
+            if (entry.second.events & ALOOPER_EVENT_OUTPUT) events |= POLLOUT;
+            pollFds.push_back({entry.first, events, 0});
+        }
+    }
+
+    if (poll(pollFds.data(), pollFds.size(), timeoutMillis) < 0) {
+        return ALOOPER_POLL_ERROR;
+    }
+
+    int result = ALOOPER_POLL_TIMEOUT;
+    if (pollFds[0].revents & POLLIN) {
+        uint64_t count;
+        read(looper->wakeFd, &count, sizeof(count));
+        result = ALOOPER_POLL_WAKE;
+    }
+
+    for (size_t i = 1; i < pollFds.size(); i++) {
+        auto revents = pollFds[i].revents;
+        if (revents == 0) {
+            continue;
+        }
+        int events = 0;
+        if (revents & POLLIN) events |= ALOOPER_EVENT_INPUT;
+        if (revents & POLLOUT) events |= ALOOPER_EVENT_OUTPUT;
+        if (revents & POLLERR) events |= ALOOPER_EVENT_ERROR;
+        if (revents & POLLHUP) events |= ALOOPER_EVENT_HANGUP;
+
+        FdEntry entry;
+        {
+            std::lock_guard<std::mutex> lock(looper->mutex);
+            auto it = looper->fds.find(pollFds[i].fd);
+            if (it == looper->fds.end()) {
+                continue;
+            }
+            entry = it->second;
+        }
+
+        if (entry.callback == nullptr) {
+            if (outFd != nullptr) *outFd = pollFds[i].fd;
+            if (outEvents != nullptr) *outEvents = events;
+            if (outData != nullptr) *outData = entry.data;
+            return entry.ident;
+        }
+
+        if (entry.callback(pollFds[i].fd, events, entry.data) == 0) {
+            ALooper_removeFd(looper, pollFds[i].fd);
+        }
+        result = ALOOPER_POLL_CALLBACK;
+    }
+
+    return result;
+}
+
+}
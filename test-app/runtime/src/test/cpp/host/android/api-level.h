@@ -0,0 +1,16 @@
+#ifndef HOST_ANDROID_API_LEVEL_H
+#define HOST_ANDROID_API_LEVEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The host reports API 23, the last level without AChoreographer, so that nothing is looked up
+// in libandroid.so
+int android_get_device_api_level();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //HOST_ANDROID_API_LEVEL_H
@@ -0,0 +1,55 @@
+#ifndef HOST_ANDROID_LOOPER_H
+#define HOST_ANDROID_LOOPER_H
+
+// The parts of the NDK's <android/looper.h> that the runtime uses, for the host builds. A looper
+// polls the file descriptors added to it when ALooper_pollOnce is called on its thread.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ALooper ALooper;
+
+typedef int (*ALooper_callbackFunc)(int fd, int events, void *data);
+
+enum {
+    ALOOPER_PREPARE_ALLOW_NON_CALLBACKS = 1 << 0,
+};
+
+enum {
+    ALOOPER_POLL_WAKE = -1,
+    ALOOPER_POLL_CALLBACK = -2,
+    ALOOPER_POLL_TIMEOUT = -3,
+    ALOOPER_POLL_ERROR = -4,
+};
+
+enum {
+    ALOOPER_EVENT_INPUT = 1 << 0,
+    ALOOPER_EVENT_OUTPUT = 1 << 1,
+    ALOOPER_EVENT_ERROR = 1 << 2,
+    ALOOPER_EVENT_HANGUP = 1 << 3,
+    ALOOPER_EVENT_INVALID = 1 << 4,
+};
+
+ALooper *ALooper_forThread();
+
+ALooper *ALooper_prepare(int opts);
+
+void ALooper_acquire(ALooper *looper);
+
+void ALooper_release(ALooper *looper);
+
+int ALooper_pollOnce(int timeoutMillis, int *outFd, int *outEvents, void **outData);
+
+void ALooper_wake(ALooper *looper);
+
+int ALooper_addFd(ALooper *looper, int fd, int ident, int events, ALooper_callbackFunc callback,
+                  void *data);
+
+int ALooper_removeFd(ALooper *looper, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //HOST_ANDROID_LOOPER_H
@@ -0,0 +1,17 @@
+#ifndef HOST_SYS_SYSTEM_PROPERTIES_H
+#define HOST_SYS_SYSTEM_PROPERTIES_H
+
+#define PROP_VALUE_MAX 92
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Only ro.build.version.sdk is known, the others are empty
+int __system_property_get(const char *name, char *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //HOST_SYS_SYSTEM_PROPERTIES_H
@@ -0,0 +1,1566 @@
+#include "FakeJni.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+namespace tns {
+namespace fakejni {
+
+struct WeakRef;
+
+struct Object {
+    explicit Object(Class *klass) : klass(klass) {
+    }
+
+    virtual ~Object() = default;
+
+    Class *klass;
+    std::atomic<int> refs{0};
+    // instance fields, objects hold a reference
+    std::vector<std::pair<Field *, jvalue>> fields;
+    std::vector<WeakRef *> weakRefs;
+};
+
+struct Class : Object {
+    Class(Vm *vm, Class *klass, const std::string &name, Class *super, bool isInterface)
+            : Object(klass), vm(vm), name(name), super(super), isInterface(isInterface) {
+        // classes are never unloaded
+        refs = 1 << 30;
+    }
+
+    Vm *vm;
+    std::string name;
+    Class *super;
+    bool isInterface;
+    bool autoDefined = false;
+    std::unordered_map<std::string, std::unique_ptr<Method>> methods;
+    std::unordered_map<std::string, std::unique_ptr<Field>> fields;
+    // overrides of the virtual methods declared by the super classes
+    std::unordered_map<Method *, Method *> dispatch;
+};
+
+struct String : Object {
+    String(Class *klass, std::u16string chars) : Object(klass), chars(std::move(chars)) {
+    }
+
+    std::u16string chars;
+};
+
+struct Array : Object {
+    Array(Class *klass, char elementType, jsize length, size_t elementSize)
+            : Object(klass), elementType(elementType), length(length) {
+        if (elementType == 'L') {
+            elements.resize(length, nullptr);
+        } else {
+            data.resize(length * elementSize);
+        }
+    }
+
+    char elementType;
+    jsize length;
+    std::vector<uint8_t> data;
+    std::vector<Object *> elements;
+};
+
+struct DirectBuffer : Object {
+    DirectBuffer(Class *klass, void *address, jlong capacity)
+            : Object(klass), address(address), capacity(capacity) {
+    }
+
+    void *address;
+    jlong capacity;
+};
+
+struct WeakRef {
+    Object *target;
+};
+
+struct Vm::VmImpl : JavaVM {
+    Vm *vm;
+    std::mutex refMutex;
+    std::unordered_map<Object *, int> globals;
+};
+
+struct Vm::EnvImpl : JNIEnv {
+    Vm *vm;
+    std::vector<Object *> locals;
+    std::vector<size_t> frames;
+    Object *exception = nullptr;
+};
+
+namespace {
+    thread_local Vm *t_vm = nullptr;
+    thread_local JNIEnv *t_env = nullptr;
+
+    inline void Spin(uint32_t ns) {
+        if (ns == 0) {
+            return;
+        }
+        auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+        while (std::chrono::steady_clock::now() < end) {
+        }
+    }
+
+    inline Object *Resolve(jobject handle) {
+        auto bits = reinterpret_cast<uintptr_t>(handle);
+        if (bits & 1) {
+            return reinterpret_cast<WeakRef *>(bits & ~(uintptr_t) 1)->target;
+        }
+        return reinterpret_cast<Object *>(handle);
+    }
+
+    inline Class *ResolveClass(jclass handle) {
+        return static_cast<Class *>(Resolve(handle));
+    }
+
+    inline jobject Handle(Object *object) {
+        return reinterpret_cast<jobject>(object);
+    }
+
+    inline bool IsReference(const std::string &signature) {
+        return signature[0] == 'L' || signature[0] == '[';
+    }
+
+    std::vector<char> ParseArgTypes(const std::string &signature, char &returnType) {
+        std::vector<char> types;
+        size_t i = 1;
+        while (i < signature.length() && signature[i] != ')') {
+            auto c = signature[i];
+            while (signature[i] == '[') {
+                i++;
+            }
+            if (signature[i] == 'L') {
+                i = signature.find(';', i);
+            }
+            i++;
+            types.push_back(c == '[' ? 'L' : c);
+        }
+        returnType = i + 1 < signature.length() ? signature[i + 1] : 'V';
+        if (returnType == '[') {
+            returnType = 'L';
+        }
+        return types;
+    }
+
+    std::u16string DecodeModifiedUtf8(const char *utf) {
+        std::u16string result;
+        auto p = reinterpret_cast<const uint8_t *>(utf);
+        while (*p != 0) {
+            uint32_t c = *p++;
+            if (c >= 0xF0 && p[0] != 0 && p[1] != 0 && p[2] != 0) {
+                // standard UTF-8 is accepted as well, as ART does
+                uint32_t cp = ((c & 0x07) << 18) | ((p[0] & 0x3F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+                p += 3;
+                cp -= 0x10000;
+                result.push_back((char16_t) (0xD800 + (cp >> 10)));
+                result.push_back((char16_t) (0xDC00 + (cp & 0x3FF)));
+            } else if (c >= 0xE0 && p[0] != 0 && p[1] != 0) {
+                result.push_back((char16_t) (((c & 0x0F) << 12) | ((p[0] & 0x3F) << 6) | (p[1] & 0x3F)));
+                p += 2;
+            } else if (c >= 0xC0 && p[0] != 0) {
+                result.push_back((char16_t) (((c & 0x1F) << 6) | (p[0] & 0x3F)));
+                p += 1;
+            } else {
+                result.push_back((char16_t) c);
+            }
+        }
+        return result;
+    }
+
+    size_t ModifiedUtf8Length(const char16_t *chars, size_t length) {
+        size_t size = 0;
+        for (size_t i = 0; i < length; i++) {
+            auto c = chars[i];
+            size += (c != 0 && c < 0x80) ? 1 : (c < 0x800 ? 2 : 3);
+        }
+        return size;
+    }
+
+    char *EncodeModifiedUtf8(const char16_t *chars, size_t length, char *out) {
+        for (size_t i = 0; i < length; i++) {
+            auto c = chars[i];
+            if (c != 0 && c < 0x80) {
+                *out++ = (char) c;
+            } else if (c < 0x800) {
+                *out++ = (char) (0xC0 | (c >> 6));
+                *out++ = (char) (0x80 | (c & 0x3F));
+            } else {
+                *out++ = (char) (0xE0 | (c >> 12));
+                *out++ = (char) (0x80 | ((c >> 6) & 0x3F));
+                *out++ = (char) (0x80 | (c & 0x3F));
+            }
+        }
+        *out = '\0';
+        return out;
+    }
+
+    template<typename T>
+    T From(const jvalue &value);
+
+    template<>
+    jboolean From(const jvalue &value) { return value.z; }
+
+    template<>
+    jbyte From(const jvalue &value) { return value.b; }
+
+    template<>
+    jchar From(const jvalue &value) { return value.c; }
+
+    template<>
+    jshort From(const jvalue &value) { return value.s; }
+
+    template<>
+    jint From(const jvalue &value) { return value.i; }
+
+    template<>
+    jlong From(const jvalue &value) { return value.j; }
+
+    template<>
+    jfloat From(const jvalue &value) { return value.f; }
+
+    template<>
+    jdouble From(const jvalue &value) { return value.d; }
+
+    template<>
+    jobject From(const jvalue &value) { return value.l; }
+
+    template<>
+    void From(const jvalue &) {}
+
+    void Assign(jvalue &value, jboolean v) { value.z = v; }
+
+    void Assign(jvalue &value, jbyte v) { value.b = v; }
+
+    void Assign(jvalue &value, jchar v) { value.c = v; }
+
+    void Assign(jvalue &value, jshort v) { value.s = v; }
+
+    void Assign(jvalue &value, jint v) { value.i = v; }
+
+    void Assign(jvalue &value, jlong v) { value.j = v; }
+
+    void Assign(jvalue &value, jfloat v) { value.f = v; }
+
+    void Assign(jvalue &value, jdouble v) { value.d = v; }
+}
+
+/*
+ * The JNI functions, as static members so that they can reach the private parts of Vm
+ */
+struct Jni {
+    using Functions = std::remove_const_t<std::remove_pointer_t<decltype(JNIEnv::functions)>>;
+    using InvokeFunctions = std::remove_const_t<std::remove_pointer_t<decltype(JavaVM::functions)>>;
+
+    static Vm::EnvImpl *Env(JNIEnv *env) {
+        return static_cast<Vm::EnvImpl *>(env);
+    }
+
+    static Vm *VmOf(JNIEnv *env) {
+        return Env(env)->vm;
+    }
+
+    static void Retain(Object *object) {
+        if (object != nullptr) {
+            object->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void Release(Object *object) {
+        if (object != nullptr && object->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Destroy(object);
+        }
+    }
+
+    static void Destroy(Object *object) {
+        auto vm = object->klass->vm;
+        {
+            std::lock_guard<std::mutex> lock(vm->m_vm->refMutex);
+            for (auto weakRef: object->weakRefs) {
+                weakRef->target = nullptr;
+            }
+        }
+        for (auto &field: object->fields) {
+            if (IsReference(field.first->signature)) {
+                Release(Resolve(field.second.l));
+            }
+        }
+        if (auto array = dynamic_cast<Array *>(object)) {
+            for (auto element: array->elements) {
+                Release(element);
+            }
+        }
+        vm->counters.liveObjects.fetch_sub(1, std::memory_order_relaxed);
+        delete object;
+    }
+
+    template<typename T, typename... Args>
+    static T *Allocate(Vm *vm, Args &&... args) {
+        vm->counters.objects.fetch_add(1, std::memory_order_relaxed);
+        vm->counters.liveObjects.fetch_add(1, std::memory_order_relaxed);
+        return new T(std::forward<Args>(args)...);
+    }
+
+    static jobject NewLocal(JNIEnv *env, Object *object) {
+        if (object == nullptr) {
+            return nullptr;
+        }
+        auto e = Env(env);
+        Retain(object);
+        e->locals.push_back(object);
+        e->vm->counters.localRefs.fetch_add(1, std::memory_order_relaxed);
+        return Handle(object);
+    }
+
+    static void Throw(JNIEnv *env, Object *throwable) {
+        auto e = Env(env);
+        Retain(throwable);
+        Release(e->exception);
+        e->exception = throwable;
+        e->vm->counters.exceptions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void ThrowNew(JNIEnv *env, const char *className, const std::string &message) {
+        auto vm = VmOf(env);
+        auto clazz = vm->FindClass(className);
+        jclass handle = static_cast<jclass>(Handle(clazz));
+        ThrowNew(env, handle, message.c_str());
+    }
+
+    static Class *ArrayClass(Vm *vm, const std::string &elementName) {
+        auto name = (elementName.length() == 1 || elementName[0] == '[')
+                    ? "[" + elementName
+                    : "[L" + elementName + ";";
+        std::lock_guard<std::recursive_mutex> lock(vm->m_mutex);
+        auto it = vm->m_classes.find(name);
+        if (it != vm->m_classes.end()) {
+            return it->second.get();
+        }
+        return vm->DefineClass(name);
+    }
+
+    static Method *FindMethod(Class *clazz, const std::string &key, bool isStatic) {
+        for (auto c = clazz; c != nullptr; c = c->super) {
+            auto it = c->methods.find(key);
+            if (it != c->methods.end() && it->second->isStatic == isStatic) {
+                return it->second.get();
+            }
+        }
+        return nullptr;
+    }
+
+    static Field *FindField(Class *clazz, const std::string &name, bool isStatic) {
+        for (auto c = clazz; c != nullptr; c = c->super) {
+            auto it = c->fields.find(name);
+            if (it != c->fields.end() && it->second->isStatic == isStatic) {
+                return it->second.get();
+            }
+        }
+        return nullptr;
+    }
+
+    static Method *Dispatch(Object *object, Method *method) {
+        auto clazz = object->klass;
+        if (clazz == method->owner || method->name == "<init>") {
+            return method;
+        }
+        auto vm = clazz->vm;
+        std::lock_guard<std::recursive_mutex> lock(vm->m_mutex);
+        auto it = clazz->dispatch.find(method);
+        if (it != clazz->dispatch.end()) {
+            return it->second;
+        }
+        auto target = FindMethod(clazz, method->name + method->signature, false);
+        if (target == nullptr) {
+            target = method;
+        }
+        clazz->dispatch.emplace(method, target);
+        return target;
+    }
+
+    static jvalue Invoke(JNIEnv *env, Object *thiz, Method *method, const jvalue *args, bool isVirtual) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.call);
+        vm->counters.calls.fetch_add(1, std::memory_order_relaxed);
+
+        if (method == nullptr) {
+            ThrowNew(env, "java/lang/NoSuchMethodError", "null method id");
+            return jvalue{};
+        }
+        if (!method->isStatic && thiz == nullptr) {
+            ThrowNew(env, "java/lang/NullPointerException", "calling " + method->name + " on null");
+            return jvalue{};
+        }
+        if (isVirtual) {
+            method = Dispatch(thiz, method);
+        }
+        method->calls.fetch_add(1, std::memory_order_relaxed);
+        if (!method->impl) {
+            return jvalue{};
+        }
+        return method->impl(env, Handle(thiz), args);
+    }
+
+    static jvalue Invoke(JNIEnv *env, Object *thiz, Method *method, va_list list, bool isVirtual) {
+        const size_t INLINE_ARGS = 16;
+        jvalue inlineArgs[INLINE_ARGS];
+        std::vector<jvalue> heapArgs;
+        jvalue *args = inlineArgs;
+
+        if (method != nullptr) {
+            auto count = method->argTypes.size();
+            if (count > INLINE_ARGS) {
+                heapArgs.resize(count);
+                args = heapArgs.data();
+            }
+            for (size_t i = 0; i < count; i++) {
+                switch (method->argTypes[i]) {
+                    case 'Z':
+                        args[i].z = (jboolean) va_arg(list, int);
+                        break;
+                    case 'B':
+                        args[i].b = (jbyte) va_arg(list, int);
+                        break;
+                    case 'C':
+                        args[i].c = (jchar) va_arg(list, int);
+                        break;
+                    case 'S':
+                        args[i].s = (jshort) va_arg(list, int);
+                        break;
+                    case 'I':
+                        args[i].i = va_arg(list, jint);
+                        break;
+                    case 'J':
+                        args[i].j = va_arg(list, jlong);
+                        break;
+                    case 'F':
+                        args[i].f = (jfloat) va_arg(list, double);
+                        break;
+                    case 'D':
+                        args[i].d = va_arg(list, double);
+                        break;
+                    default:
+                        args[i].l = va_arg(list, jobject);
+                        break;
+                }
+            }
+        }
+
+        return Invoke(env, thiz, method, args, isVirtual);
+    }
+
+    template<typename T>
+    struct Calls {
+        static T Virtual(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
+            va_list list;
+            va_start(list, methodID);
+            auto result = Invoke(env, Resolve(obj), reinterpret_cast<Method *>(methodID), list, true);
+            va_end(list);
+            return From<T>(result);
+        }
+
+        static T VirtualV(JNIEnv *env, jobject obj, jmethodID methodID, va_list list) {
+            return From<T>(Invoke(env, Resolve(obj), reinterpret_cast<Method *>(methodID), list, true));
+        }
+
+        static T VirtualA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
+            return From<T>(Invoke(env, Resolve(obj), reinterpret_cast<Method *>(methodID), args, true));
+        }
+
+        static T Nonvirtual(JNIEnv *env, jobject obj, jclass, jmethodID methodID, ...) {
+            va_list list;
+            va_start(list, methodID);
+            auto result = Invoke(env, Resolve(obj), reinterpret_cast<Method *>(methodID), list, false);
+            va_end(list);
+            return From<T>(result);
+        }
+
+        static T NonvirtualV(JNIEnv *env, jobject obj, jclass, jmethodID methodID, va_list list) {
+            return From<T>(Invoke(env, Resolve(obj), reinterpret_cast<Method *>(methodID), list, false));
+        }
+
+        static T NonvirtualA(JNIEnv *env, jobject obj, jclass, jmethodID methodID, const jvalue *args) {
+            return From<T>(Invoke(env, Resolve(obj), reinterpret_cast<Method *>(methodID), args, false));
+        }
+
+        static T Static(JNIEnv *env, jclass, jmethodID methodID, ...) {
+            va_list list;
+            va_start(list, methodID);
+            auto result = Invoke(env, nullptr, reinterpret_cast<Method *>(methodID), list, false);
+            va_end(list);
+            return From<T>(result);
+        }
+
+        static T StaticV(JNIEnv *env, jclass, jmethodID methodID, va_list list) {
+            return From<T>(Invoke(env, nullptr, reinterpret_cast<Method *>(methodID), list, false));
+        }
+
+        static T StaticA(JNIEnv *env, jclass, jmethodID methodID, const jvalue *args) {
+            return From<T>(Invoke(env, nullptr, reinterpret_cast<Method *>(methodID), args, false));
+        }
+    };
+
+    static jvalue &Slot(Object *object, Field *field) {
+        for (auto &slot: object->fields) {
+            if (slot.first == field) {
+                return slot.second;
+            }
+        }
+        object->fields.emplace_back(field, jvalue{});
+        return object->fields.back().second;
+    }
+
+    template<typename T>
+    struct Fields {
+        static T Read(JNIEnv *env, jvalue &slot) {
+            if constexpr (std::is_same<T, jobject>::value) {
+                return NewLocal(env, Resolve(slot.l));
+            } else {
+                return From<T>(slot);
+            }
+        }
+
+        static void Write(jvalue &slot, T value) {
+            if constexpr (std::is_same<T, jobject>::value) {
+                auto object = Resolve(value);
+                Retain(object);
+                Release(Resolve(slot.l));
+                slot.l = Handle(object);
+            } else {
+                Assign(slot, value);
+            }
+        }
+
+        static void Count(JNIEnv *env) {
+            auto vm = VmOf(env);
+            Spin(vm->latency.field);
+            vm->counters.fieldAccesses.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static T Get(JNIEnv *env, jobject obj, jfieldID fieldID) {
+            Count(env);
+            return Read(env, Slot(Resolve(obj), reinterpret_cast<Field *>(fieldID)));
+        }
+
+        static void Set(JNIEnv *env, jobject obj, jfieldID fieldID, T value) {
+            Count(env);
+            Write(Slot(Resolve(obj), reinterpret_cast<Field *>(fieldID)), value);
+        }
+
+        static T GetStatic(JNIEnv *env, jclass, jfieldID fieldID) {
+            Count(env);
+            return Read(env, reinterpret_cast<Field *>(fieldID)->staticValue);
+        }
+
+        static void SetStatic(JNIEnv *env, jclass, jfieldID fieldID, T value) {
+            Count(env);
+            Write(reinterpret_cast<Field *>(fieldID)->staticValue, value);
+        }
+    };
+
+    template<typename T, typename ArrayType, char Type>
+    struct Arrays {
+        static Array *Check(JNIEnv *env, ArrayType array, jsize start, jsize length) {
+            auto a = static_cast<Array *>(Resolve(array));
+            if (start < 0 || length < 0 || start + length > a->length) {
+                ThrowNew(env, "java/lang/ArrayIndexOutOfBoundsException", "region out of bounds");
+                return nullptr;
+            }
+            return a;
+        }
+
+        static ArrayType New(JNIEnv *env, jsize length) {
+            auto vm = VmOf(env);
+            Spin(vm->latency.array);
+            vm->counters.arrays.fetch_add(1, std::memory_order_relaxed);
+            auto array = Allocate<Array>(vm, ArrayClass(vm, std::string(1, Type)), Type, length, sizeof(T));
+            return static_cast<ArrayType>(NewLocal(env, array));
+        }
+
+        static T *GetElements(JNIEnv *env, ArrayType array, jboolean *isCopy) {
+            Spin(VmOf(env)->latency.array);
+            if (isCopy != nullptr) {
+                *isCopy = JNI_FALSE;
+            }
+            return reinterpret_cast<T *>(static_cast<Array *>(Resolve(array))->data.data());
+        }
+
+        static void ReleaseElements(JNIEnv *, ArrayType, T *, jint) {
+        }
+
+        static void GetRegion(JNIEnv *env, ArrayType array, jsize start, jsize length, T *buffer) {
+            Spin(VmOf(env)->latency.array);
+            if (auto a = Check(env, array, start, length)) {
+                memcpy(buffer, a->data.data() + start * sizeof(T), length * sizeof(T));
+            }
+        }
+
+        static void SetRegion(JNIEnv *env, ArrayType array, jsize start, jsize length, const T *buffer) {
+            Spin(VmOf(env)->latency.array);
+            if (auto a = Check(env, array, start, length)) {
+                memcpy(a->data.data() + start * sizeof(T), buffer, length * sizeof(T));
+            }
+        }
+    };
+
+    static jint GetVersion(JNIEnv *) {
+        return JNI_VERSION_1_6;
+    }
+
+    static jclass DefineClass(JNIEnv *env, const char *, jobject, const jbyte *, jsize) {
+        ThrowNew(env, "java/lang/UnsupportedOperationException", "DefineClass");
+        return nullptr;
+    }
+
+    static jclass FindClass(JNIEnv *env, const char *name) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.lookup);
+        vm->counters.lookups.fetch_add(1, std::memory_order_relaxed);
+        auto clazz = vm->FindClass(name);
+        if (clazz == nullptr) {
+            ThrowNew(env, "java/lang/NoClassDefFoundError", name);
+            return nullptr;
+        }
+        return static_cast<jclass>(NewLocal(env, clazz));
+    }
+
+    static jmethodID FromReflectedMethod(JNIEnv *, jobject) {
+        return nullptr;
+    }
+
+    static jfieldID FromReflectedField(JNIEnv *, jobject) {
+        return nullptr;
+    }
+
+    static jobject ToReflectedMethod(JNIEnv *, jclass, jmethodID, jboolean) {
+        return nullptr;
+    }
+
+    static jclass GetSuperclass(JNIEnv *env, jclass clazz) {
+        auto c = ResolveClass(clazz);
+        return static_cast<jclass>(NewLocal(env, c->isInterface ? nullptr : c->super));
+    }
+
+    static bool IsSubclass(Class *clazz, Class *super) {
+        if (super->super == nullptr && !super->isInterface) {
+            // java/lang/Object
+            return true;
+        }
+        for (auto c = clazz; c != nullptr; c = c->super) {
+            if (c == super) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static jboolean IsAssignableFrom(JNIEnv *, jclass clazz1, jclass clazz2) {
+        return IsSubclass(ResolveClass(clazz1), ResolveClass(clazz2)) ? JNI_TRUE : JNI_FALSE;
+    }
+
+    static jobject ToReflectedField(JNIEnv *, jclass, jfieldID, jboolean) {
+        return nullptr;
+    }
+
+    static jint Throw(JNIEnv *env, jthrowable obj) {
+        Throw(env, Resolve(obj));
+        return JNI_OK;
+    }
+
+    static jint ThrowNew(JNIEnv *env, jclass clazz, const char *message) {
+        auto vm = VmOf(env);
+        auto throwable = Allocate<Object>(vm, ResolveClass(clazz));
+        auto field = FindField(vm->FindClass("java/lang/Throwable"), "detailMessage", false);
+        if (message != nullptr) {
+            auto string = Allocate<String>(vm, vm->FindClass("java/lang/String"), DecodeModifiedUtf8(message));
+            Retain(string);
+            Slot(throwable, field).l = Handle(string);
+        }
+        Retain(throwable);
+        Throw(env, throwable);
+        Release(throwable);
+        return JNI_OK;
+    }
+
+    static jthrowable ExceptionOccurred(JNIEnv *env) {
+        return static_cast<jthrowable>(NewLocal(env, Env(env)->exception));
+    }
+
+    static void ExceptionDescribe(JNIEnv *env) {
+        auto e = Env(env);
+        if (e->exception == nullptr) {
+            return;
+        }
+        std::string message;
+        auto field = FindField(e->vm->FindClass("java/lang/Throwable"), "detailMessage", false);
+        for (auto &slot: e->exception->fields) {
+            if (slot.first == field && slot.second.l != nullptr) {
+                auto &chars = static_cast<String *>(Resolve(slot.second.l))->chars;
+                message.resize(ModifiedUtf8Length(chars.data(), chars.length()) + 1);
+                EncodeModifiedUtf8(chars.data(), chars.length(), &message[0]);
+                message.pop_back();
+            }
+        }
+        fprintf(stderr, "Exception %s: %s\n", e->exception->klass->name.c_str(), message.c_str());
+        ExceptionClear(env);
+    }
+
+    static void ExceptionClear(JNIEnv *env) {
+        auto e = Env(env);
+        Release(e->exception);
+        e->exception = nullptr;
+    }
+
+    static void FatalError(JNIEnv *, const char *message) {
+        fprintf(stderr, "JNI FatalError: %s\n", message);
+        abort();
+    }
+
+    static jint PushLocalFrame(JNIEnv *env, jint) {
+        auto e = Env(env);
+        e->frames.push_back(e->locals.size());
+        return JNI_OK;
+    }
+
+    static jobject PopLocalFrame(JNIEnv *env, jobject result) {
+        auto e = Env(env);
+        auto object = Resolve(result);
+        Retain(object);
+        auto start = e->frames.empty() ? 0 : e->frames.back();
+        if (!e->frames.empty()) {
+            e->frames.pop_back();
+        }
+        for (auto i = start; i < e->locals.size(); i++) {
+            Release(e->locals[i]);
+        }
+        e->locals.resize(start);
+        auto local = NewLocal(env, object);
+        Release(object);
+        return local;
+    }
+
+    static jobject NewGlobalRef(JNIEnv *env, jobject obj) {
+        auto object = Resolve(obj);
+        if (object == nullptr) {
+            return nullptr;
+        }
+        auto vm = VmOf(env);
+        Spin(vm->latency.reference);
+        Retain(object);
+        {
+            std::lock_guard<std::mutex> lock(vm->m_vm->refMutex);
+            vm->m_vm->globals[object]++;
+        }
+        vm->counters.globalRefs.fetch_add(1, std::memory_order_relaxed);
+        vm->counters.liveGlobalRefs.fetch_add(1, std::memory_order_relaxed);
+        return Handle(object);
+    }
+
+    static void DeleteGlobalRef(JNIEnv *env, jobject globalRef) {
+        if (globalRef == nullptr) {
+            return;
+        }
+        auto vm = VmOf(env);
+        Spin(vm->latency.reference);
+        auto object = Resolve(globalRef);
+        {
+            std::lock_guard<std::mutex> lock(vm->m_vm->refMutex);
+            auto it = vm->m_vm->globals.find(object);
+            if (it == vm->m_vm->globals.end()) {
+                vm->counters.invalidDeletes.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (--it->second == 0) {
+                vm->m_vm->globals.erase(it);
+            }
+        }
+        vm->counters.liveGlobalRefs.fetch_sub(1, std::memory_order_relaxed);
+        Release(object);
+    }
+
+    static void DeleteLocalRef(JNIEnv *env, jobject localRef) {
+        if (localRef == nullptr) {
+            return;
+        }
+        auto e = Env(env);
+        auto object = reinterpret_cast<Object *>(localRef);
+        for (auto i = e->locals.size(); i-- > 0;) {
+            if (e->locals[i] == object) {
+                e->locals.erase(e->locals.begin() + i);
+                for (auto &frame: e->frames) {
+                    if (frame > i) {
+                        frame--;
+                    }
+                }
+                Release(object);
+                return;
+            }
+        }
+        e->vm->counters.invalidDeletes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static jboolean IsSameObject(JNIEnv *, jobject ref1, jobject ref2) {
+        return Resolve(ref1) == Resolve(ref2) ? JNI_TRUE : JNI_FALSE;
+    }
+
+    static jobject NewLocalRef(JNIEnv *env, jobject ref) {
+        return NewLocal(env, Resolve(ref));
+    }
+
+    static jint EnsureLocalCapacity(JNIEnv *, jint) {
+        return JNI_OK;
+    }
+
+    static jobject AllocObject(JNIEnv *env, jclass clazz) {
+        return NewLocal(env, Allocate<Object>(VmOf(env), ResolveClass(clazz)));
+    }
+
+    static jobject NewObjectA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+        auto object = Allocate<Object>(VmOf(env), ResolveClass(clazz));
+        auto result = NewLocal(env, object);
+        Invoke(env, object, reinterpret_cast<Method *>(methodID), args, false);
+        return result;
+    }
+
+    static jobject NewObjectV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list list) {
+        auto object = Allocate<Object>(VmOf(env), ResolveClass(clazz));
+        auto result = NewLocal(env, object);
+        Invoke(env, object, reinterpret_cast<Method *>(methodID), list, false);
+        return result;
+    }
+
+    static jobject NewObject(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+        va_list list;
+        va_start(list, methodID);
+        auto result = NewObjectV(env, clazz, methodID, list);
+        va_end(list);
+        return result;
+    }
+
+    static jclass GetObjectClass(JNIEnv *env, jobject obj) {
+        auto object = Resolve(obj);
+        return static_cast<jclass>(NewLocal(env, object != nullptr ? object->klass : nullptr));
+    }
+
+    static jboolean IsInstanceOf(JNIEnv *, jobject obj, jclass clazz) {
+        auto object = Resolve(obj);
+        return object == nullptr || IsSubclass(object->klass, ResolveClass(clazz)) ? JNI_TRUE : JNI_FALSE;
+    }
+
+    static jmethodID GetMethod(JNIEnv *env, jclass clazz, const char *name, const char *sig, bool isStatic) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.lookup);
+        vm->counters.lookups.fetch_add(1, std::memory_order_relaxed);
+        auto c = ResolveClass(clazz);
+        std::lock_guard<std::recursive_mutex> lock(vm->m_mutex);
+        auto method = FindMethod(c, std::string(name) + sig, isStatic);
+        if (method == nullptr) {
+            if (!vm->m_lenient) {
+                ThrowNew(env, "java/lang/NoSuchMethodError", c->name + "." + name + sig);
+                return nullptr;
+            }
+            method = vm->AddMethod(c, name, sig, isStatic, nullptr, true);
+        }
+        return reinterpret_cast<jmethodID>(method);
+    }
+
+    static jmethodID GetMethodID(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
+        return GetMethod(env, clazz, name, sig, false);
+    }
+
+    static jmethodID GetStaticMethodID(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
+        return GetMethod(env, clazz, name, sig, true);
+    }
+
+    static jfieldID GetField(JNIEnv *env, jclass clazz, const char *name, const char *sig, bool isStatic) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.lookup);
+        vm->counters.lookups.fetch_add(1, std::memory_order_relaxed);
+        auto c = ResolveClass(clazz);
+        std::lock_guard<std::recursive_mutex> lock(vm->m_mutex);
+        auto field = FindField(c, name, isStatic);
+        if (field == nullptr) {
+            if (!vm->m_lenient) {
+                ThrowNew(env, "java/lang/NoSuchFieldError", c->name + "." + name);
+                return nullptr;
+            }
+            field = vm->AddField(c, name, sig, isStatic, true);
+        }
+        return reinterpret_cast<jfieldID>(field);
+    }
+
+    static jfieldID GetFieldID(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
+        return GetField(env, clazz, name, sig, false);
+    }
+
+    static jfieldID GetStaticFieldID(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
+        return GetField(env, clazz, name, sig, true);
+    }
+
+    static jstring NewStringObject(JNIEnv *env, std::u16string chars) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.string);
+        vm->counters.strings.fetch_add(1, std::memory_order_relaxed);
+        auto string = Allocate<String>(vm, vm->FindClass("java/lang/String"), std::move(chars));
+        return static_cast<jstring>(NewLocal(env, string));
+    }
+
+    static jstring NewString(JNIEnv *env, const jchar *unicodeChars, jsize len) {
+        return NewStringObject(env, std::u16string(reinterpret_cast<const char16_t *>(unicodeChars), len));
+    }
+
+    static jsize GetStringLength(JNIEnv *, jstring string) {
+        return (jsize) static_cast<String *>(Resolve(string))->chars.length();
+    }
+
+    static const jchar *GetStringChars(JNIEnv *env, jstring string, jboolean *isCopy) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.string);
+        vm->counters.stringConversions.fetch_add(1, std::memory_order_relaxed);
+        if (isCopy != nullptr) {
+            *isCopy = JNI_FALSE;
+        }
+        return reinterpret_cast<const jchar *>(static_cast<String *>(Resolve(string))->chars.c_str());
+    }
+
+    static void ReleaseStringChars(JNIEnv *, jstring, const jchar *) {
+    }
+
+    static jstring NewStringUTF(JNIEnv *env, const char *bytes) {
+        if (bytes == nullptr) {
+            return nullptr;
+        }
+        return NewStringObject(env, DecodeModifiedUtf8(bytes));
+    }
+
+    static jsize GetStringUTFLength(JNIEnv *, jstring string) {
+        auto &chars = static_cast<String *>(Resolve(string))->chars;
+        return (jsize) ModifiedUtf8Length(chars.data(), chars.length());
+    }
+
+    static const char *GetStringUTFChars(JNIEnv *env, jstring string, jboolean *isCopy) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.string);
+        vm->counters.stringConversions.fetch_add(1, std::memory_order_relaxed);
+        auto &chars = static_cast<String *>(Resolve(string))->chars;
+        auto utf = new char[ModifiedUtf8Length(chars.data(), chars.length()) + 1];
+        EncodeModifiedUtf8(chars.data(), chars.length(), utf);
+        if (isCopy != nullptr) {
+            *isCopy = JNI_TRUE;
+        }
+        return utf;
+    }
+
+    static void ReleaseStringUTFChars(JNIEnv *, jstring, const char *utf) {
+        delete[] utf;
+    }
+
+    static jsize GetArrayLength(JNIEnv *, jarray array) {
+        return static_cast<Array *>(Resolve(array))->length;
+    }
+
+    static jobjectArray NewObjectArray(JNIEnv *env, jsize length, jclass elementClass, jobject initialElement) {
+        auto vm = VmOf(env);
+        Spin(vm->latency.array);
+        vm->counters.arrays.fetch_add(1, std::memory_order_relaxed);
+        auto array = Allocate<Array>(vm, ArrayClass(vm, ResolveClass(elementClass)->name), 'L', length, sizeof(Object *));
+        auto initial = Resolve(initialElement);
+        if (initial != nullptr) {
+            for (auto &element: array->elements) {
+                Retain(initial);
+                element = initial;
+            }
+        }
+        return static_cast<jobjectArray>(NewLocal(env, array));
+    }
+
+    static jobject GetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index) {
+        Spin(VmOf(env)->latency.array);
+        auto a = static_cast<Array *>(Resolve(array));
+        if (index < 0 || index >= a->length) {
+            ThrowNew(env, "java/lang/ArrayIndexOutOfBoundsException", std::to_string(index));
+            return nullptr;
+        }
+        return NewLocal(env, a->elements[index]);
+    }
+
+    static void SetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index, jobject value) {
+        Spin(VmOf(env)->latency.array);
+        auto a = static_cast<Array *>(Resolve(array));
+        if (index < 0 || index >= a->length) {
+            ThrowNew(env, "java/lang/ArrayIndexOutOfBoundsException", std::to_string(index));
+            return;
+        }
+        auto object = Resolve(value);
+        Retain(object);
+        Release(a->elements[index]);
+        a->elements[index] = object;
+    }
+
+    static jint RegisterNatives(JNIEnv *, jclass, const JNINativeMethod *, jint) {
+        return JNI_OK;
+    }
+
+    static jint UnregisterNatives(JNIEnv *, jclass) {
+        return JNI_OK;
+    }
+
+    static jint MonitorEnter(JNIEnv *, jobject) {
+        return JNI_OK;
+    }
+
+    static jint MonitorExit(JNIEnv *, jobject) {
+        return JNI_OK;
+    }
+
+    static jint GetJavaVM(JNIEnv *env, JavaVM **vm) {
+        *vm = VmOf(env)->GetJavaVM();
+        return JNI_OK;
+    }
+
+    static void GetStringRegion(JNIEnv *env, jstring str, jsize start, jsize len, jchar *buf) {
+        auto &chars = static_cast<String *>(Resolve(str))->chars;
+        if (start < 0 || len < 0 || (size_t) (start + len) > chars.length()) {
+            ThrowNew(env, "java/lang/StringIndexOutOfBoundsException", "region out of bounds");
+            return;
+        }
+        memcpy(buf, chars.data() + start, len * sizeof(jchar));
+    }
+
+    static void GetStringUTFRegion(JNIEnv *env, jstring str, jsize start, jsize len, char *buf) {
+        auto &chars = static_cast<String *>(Resolve(str))->chars;
+        if (start < 0 || len < 0 || (size_t) (start + len) > chars.length()) {
+            ThrowNew(env, "java/lang/StringIndexOutOfBoundsException", "region out of bounds");
+            return;
+        }
+        EncodeModifiedUtf8(chars.data() + start, len, buf);
+    }
+
+    static void *GetPrimitiveArrayCritical(JNIEnv *, jarray array, jboolean *isCopy) {
+        if (isCopy != nullptr) {
+            *isCopy = JNI_FALSE;
+        }
+        return static_cast<Array *>(Resolve(array))->data.data();
+    }
+
+    static void ReleasePrimitiveArrayCritical(JNIEnv *, jarray, void *, jint) {
+    }
+
+    static const jchar *GetStringCritical(JNIEnv *env, jstring string, jboolean *isCopy) {
+        return GetStringChars(env, string, isCopy);
+    }
+
+    static void ReleaseStringCritical(JNIEnv *, jstring, const jchar *) {
+    }
+
+    static jweak NewWeakGlobalRef(JNIEnv *env, jobject obj) {
+        auto object = Resolve(obj);
+        if (object == nullptr) {
+            return nullptr;
+        }
+        auto vm = VmOf(env);
+        Spin(vm->latency.reference);
+        vm->counters.weakRefs.fetch_add(1, std::memory_order_relaxed);
+        auto weakRef = new WeakRef{object};
+        {
+            std::lock_guard<std::mutex> lock(vm->m_vm->refMutex);
+            object->weakRefs.push_back(weakRef);
+        }
+        return reinterpret_cast<jweak>(reinterpret_cast<uintptr_t>(weakRef) | 1);
+    }
+
+    static void DeleteWeakGlobalRef(JNIEnv *env, jweak obj) {
+        auto bits = reinterpret_cast<uintptr_t>(obj);
+        auto vm = VmOf(env);
+        if ((bits & 1) == 0) {
+            if (obj != nullptr) {
+                vm->counters.invalidDeletes.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        Spin(vm->latency.reference);
+        auto weakRef = reinterpret_cast<WeakRef *>(bits & ~(uintptr_t) 1);
+        {
+            std::lock_guard<std::mutex> lock(vm->m_vm->refMutex);
+            if (weakRef->target != nullptr) {
+                auto &weakRefs = weakRef->target->weakRefs;
+                weakRefs.erase(std::find(weakRefs.begin(), weakRefs.end(), weakRef));
+            }
+        }
+        delete weakRef;
+    }
+
+    static jboolean ExceptionCheck(JNIEnv *env) {
+        return Env(env)->exception != nullptr ? JNI_TRUE : JNI_FALSE;
+    }
+
+    static jobject NewDirectByteBuffer(JNIEnv *env, void *address, jlong capacity) {
+        auto vm = VmOf(env);
+        return NewLocal(env, Allocate<DirectBuffer>(vm, vm->FindClass("java/nio/DirectByteBuffer"), address, capacity));
+    }
+
+    static void *GetDirectBufferAddress(JNIEnv *, jobject buf) {
+        auto buffer = dynamic_cast<DirectBuffer *>(Resolve(buf));
+        return buffer != nullptr ? buffer->address : nullptr;
+    }
+
+    static jlong GetDirectBufferCapacity(JNIEnv *, jobject buf) {
+        auto buffer = dynamic_cast<DirectBuffer *>(Resolve(buf));
+        return buffer != nullptr ? buffer->capacity : -1;
+    }
+
+    static jobjectRefType GetObjectRefType(JNIEnv *env, jobject obj) {
+        auto bits = reinterpret_cast<uintptr_t>(obj);
+        if (obj == nullptr) {
+            return JNIInvalidRefType;
+        }
+        if (bits & 1) {
+            return JNIWeakGlobalRefType;
+        }
+        auto e = Env(env);
+        auto object = reinterpret_cast<Object *>(obj);
+        if (std::find(e->locals.begin(), e->locals.end(), object) != e->locals.end()) {
+            return JNILocalRefType;
+        }
+        std::lock_guard<std::mutex> lock(e->vm->m_vm->refMutex);
+        return e->vm->m_vm->globals.count(object) ? JNIGlobalRefType : JNIInvalidRefType;
+    }
+
+    static const Functions *Table() {
+        static Functions table = [] {
+            Functions t{};
+            t.GetVersion = GetVersion;
+            t.DefineClass = DefineClass;
+            t.FindClass = FindClass;
+            t.FromReflectedMethod = FromReflectedMethod;
+            t.FromReflectedField = FromReflectedField;
+            t.ToReflectedMethod = ToReflectedMethod;
+            t.GetSuperclass = GetSuperclass;
+            t.IsAssignableFrom = IsAssignableFrom;
+            t.ToReflectedField = ToReflectedField;
+            t.Throw = Throw;
+            t.ThrowNew = ThrowNew;
+            t.ExceptionOccurred = ExceptionOccurred;
+            t.ExceptionDescribe = ExceptionDescribe;
+            t.ExceptionClear = ExceptionClear;
+            t.FatalError = FatalError;
+            t.PushLocalFrame = PushLocalFrame;
+            t.PopLocalFrame = PopLocalFrame;
+            t.NewGlobalRef = NewGlobalRef;
+            t.DeleteGlobalRef = DeleteGlobalRef;
+            t.DeleteLocalRef = DeleteLocalRef;
+            t.IsSameObject = IsSameObject;
+            t.NewLocalRef = NewLocalRef;
+            t.EnsureLocalCapacity = EnsureLocalCapacity;
+            t.AllocObject = AllocObject;
+            t.NewObject = NewObject;
+            t.NewObjectV = NewObjectV;
+            t.NewObjectA = NewObjectA;
+            t.GetObjectClass = GetObjectClass;
+            t.IsInstanceOf = IsInstanceOf;
+            t.GetMethodID = GetMethodID;
+            t.GetFieldID = GetFieldID;
+            t.GetStaticMethodID = GetStaticMethodID;
+            t.GetStaticFieldID = GetStaticFieldID;
+
+#define FAKEJNI_TYPE(Name, T) \
+            t.Call##Name##Method = Calls<T>::Virtual; \
+            t.Call##Name##MethodV = Calls<T>::VirtualV; \
+            t.Call##Name##MethodA = Calls<T>::VirtualA; \
+            t.CallNonvirtual##Name##Method = Calls<T>::Nonvirtual; \
+            t.CallNonvirtual##Name##MethodV = Calls<T>::NonvirtualV; \
+            t.CallNonvirtual##Name##MethodA = Calls<T>::NonvirtualA; \
+            t.CallStatic##Name##Method = Calls<T>::Static; \
+            t.CallStatic##Name##MethodV = Calls<T>::StaticV; \
+            t.CallStatic##Name##MethodA = Calls<T>::StaticA; \
+            t.Get##Name##Field = Fields<T>::Get; \
+            t.Set##Name##Field = Fields<T>::Set; \
+            t.GetStatic##Name##Field = Fields<T>::GetStatic; \
+            t.SetStatic##Name##Field = Fields<T>::SetStatic;
+
+#define FAKEJNI_ARRAY(Name, T, Type) \
+            t.New##Name##Array = Arrays<T, T##Array, Type>::New; \
+            t.Get##Name##ArrayElements = Arrays<T, T##Array, Type>::GetElements; \
+            t.Release##Name##ArrayElements = Arrays<T, T##Array, Type>::ReleaseElements; \
+            t.Get##Name##ArrayRegion = Arrays<T, T##Array, Type>::GetRegion; \
+            t.Set##Name##ArrayRegion = Arrays<T, T##Array, Type>::SetRegion;
+
+            FAKEJNI_TYPE(Object, jobject)
+            FAKEJNI_TYPE(Boolean, jboolean)
+            FAKEJNI_TYPE(Byte, jbyte)
+            FAKEJNI_TYPE(Char, jchar)
+            FAKEJNI_TYPE(Short, jshort)
+            FAKEJNI_TYPE(Int, jint)
+            FAKEJNI_TYPE(Long, jlong)
+            FAKEJNI_TYPE(Float, jfloat)
+            FAKEJNI_TYPE(Double, jdouble)
+
+            t.CallVoidMethod = Calls<void>::Virtual;
+            t.CallVoidMethodV = Calls<void>::VirtualV;
+            t.CallVoidMethodA = Calls<void>::VirtualA;
+            t.CallNonvirtualVoidMethod = Calls<void>::Nonvirtual;
+            t.CallNonvirtualVoidMethodV = Calls<void>::NonvirtualV;
+            t.CallNonvirtualVoidMethodA = Calls<void>::NonvirtualA;
+            t.CallStaticVoidMethod = Calls<void>::Static;
+            t.CallStaticVoidMethodV = Calls<void>::StaticV;
+            t.CallStaticVoidMethodA = Calls<void>::StaticA;
+
+            FAKEJNI_ARRAY(Boolean, jboolean, 'Z')
+            FAKEJNI_ARRAY(Byte, jbyte, 'B')
+            FAKEJNI_ARRAY(Char, jchar, 'C')
+            FAKEJNI_ARRAY(Short, jshort, 'S')
+            FAKEJNI_ARRAY(Int, jint, 'I')
+            FAKEJNI_ARRAY(Long, jlong, 'J')
+            FAKEJNI_ARRAY(Float, jfloat, 'F')
+            FAKEJNI_ARRAY(Double, jdouble, 'D')
+
+#undef FAKEJNI_TYPE
+#undef FAKEJNI_ARRAY
+
+            t.NewString = NewString;
+            t.GetStringLength = GetStringLength;
+            t.GetStringChars = GetStringChars;
+            t.ReleaseStringChars = ReleaseStringChars;
+            t.NewStringUTF = NewStringUTF;
+            t.GetStringUTFLength = GetStringUTFLength;
+            t.GetStringUTFChars = GetStringUTFChars;
+            t.ReleaseStringUTFChars = ReleaseStringUTFChars;
+            t.GetArrayLength = GetArrayLength;
+            t.NewObjectArray = NewObjectArray;
+            t.GetObjectArrayElement = GetObjectArrayElement;
+            t.SetObjectArrayElement = SetObjectArrayElement;
+            t.RegisterNatives = RegisterNatives;
+            t.UnregisterNatives = UnregisterNatives;
+            t.MonitorEnter = MonitorEnter;
+            t.MonitorExit = MonitorExit;
+            t.GetJavaVM = GetJavaVM;
+            t.GetStringRegion = GetStringRegion;
+            t.GetStringUTFRegion = GetStringUTFRegion;
+            t.GetPrimitiveArrayCritical = GetPrimitiveArrayCritical;
+            t.ReleasePrimitiveArrayCritical = ReleasePrimitiveArrayCritical;
+            t.GetStringCritical = GetStringCritical;
+            t.ReleaseStringCritical = ReleaseStringCritical;
+            t.NewWeakGlobalRef = NewWeakGlobalRef;
+            t.DeleteWeakGlobalRef = DeleteWeakGlobalRef;
+            t.ExceptionCheck = ExceptionCheck;
+            t.NewDirectByteBuffer = NewDirectByteBuffer;
+            t.GetDirectBufferAddress = GetDirectBufferAddress;
+            t.GetDirectBufferCapacity = GetDirectBufferCapacity;
+            t.GetObjectRefType = GetObjectRefType;
+            return t;
+        }();
+        return &table;
+    }
+
+    static const InvokeFunctions *InvokeTable() {
+        static InvokeFunctions table = [] {
+            InvokeFunctions t{};
+            t.DestroyJavaVM = [](JavaVM *) -> jint {
+                return JNI_OK;
+            };
+            // JNIEnv** in the NDK, void** in the JDK
+            t.AttachCurrentThread = [](JavaVM *vm, auto penv, void *) -> jint {
+                *reinterpret_cast<JNIEnv **>(penv) = static_cast<Vm::VmImpl *>(vm)->vm->GetEnv();
+                return JNI_OK;
+            };
+            t.AttachCurrentThreadAsDaemon = [](JavaVM *vm, auto penv, void *) -> jint {
+                *reinterpret_cast<JNIEnv **>(penv) = static_cast<Vm::VmImpl *>(vm)->vm->GetEnv();
+                return JNI_OK;
+            };
+            t.DetachCurrentThread = [](JavaVM *) -> jint {
+                return JNI_OK;
+            };
+            t.GetEnv = [](JavaVM *vm, void **penv, jint) -> jint {
+                if (t_vm != static_cast<Vm::VmImpl *>(vm)->vm) {
+                    *penv = nullptr;
+                    return JNI_EDETACHED;
+                }
+                *penv = t_env;
+                return JNI_OK;
+            };
+            return t;
+        }();
+        return &table;
+    }
+};
+
+Vm::Vm(bool lenient)
+        : m_lenient(lenient), m_vm(new VmImpl) {
+    m_vm->functions = Jni::InvokeTable();
+    m_vm->vm = this;
+    DefineBuiltins();
+}
+
+Vm::~Vm() {
+    if (t_vm == this) {
+        t_vm = nullptr;
+        t_env = nullptr;
+    }
+}
+
+JavaVM *Vm::GetJavaVM() {
+    return m_vm.get();
+}
+
+JNIEnv *Vm::GetEnv() {
+    if (t_vm == this) {
+        return t_env;
+    }
+    auto env = new EnvImpl;
+    env->functions = Jni::Table();
+    env->vm = this;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_envs.emplace_back(env);
+    }
+    t_vm = this;
+    t_env = env;
+    return env;
+}
+
+Vm *Vm::FromEnv(JNIEnv *env) {
+    return Jni::VmOf(env);
+}
+
+Class *Vm::DefineClass(const std::string &name, const std::string &super, bool isInterface) {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto it = m_classes.find(name);
+    if (it != m_classes.end()) {
+        return it->second.get();
+    }
+    Class *superClass = nullptr;
+    if (!super.empty() && super != name) {
+        superClass = FindClass(super);
+    }
+    auto classClass = m_classes.find("java/lang/Class");
+    auto clazz = new Class(this, classClass != m_classes.end() ? classClass->second.get() : nullptr,
+                           name, superClass, isInterface);
+    m_classes.emplace(name, std::unique_ptr<Class>(clazz));
+    return clazz;
+}
+
+Class *Vm::FindClass(const std::string &name) {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto it = m_classes.find(name);
+    if (it != m_classes.end()) {
+        return it->second.get();
+    }
+    if (!m_lenient && name[0] != '[') {
+        return nullptr;
+    }
+    auto clazz = DefineClass(name);
+    clazz->autoDefined = name[0] != '[';
+    return clazz;
+}
+
+Method *Vm::AddMethod(Class *clazz, const std::string &name, const std::string &signature,
+                      bool isStatic, MethodImpl impl, bool autoDefined) {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto method = new Method;
+    method->owner = clazz;
+    method->name = name;
+    method->signature = signature;
+    method->isStatic = isStatic;
+    method->argTypes = ParseArgTypes(signature, method->returnType);
+    method->impl = std::move(impl);
+    method->autoDefined = autoDefined;
+    clazz->methods[name + signature].reset(method);
+    // the overrides may change
+    for (auto &c: m_classes) {
+        c.second->dispatch.clear();
+    }
+    return method;
+}
+
+Field *Vm::AddField(Class *clazz, const std::string &name, const std::string &signature,
+                    bool isStatic, bool autoDefined) {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto field = new Field{clazz, name, signature, isStatic, autoDefined, jvalue{}};
+    clazz->fields[name].reset(field);
+    return field;
+}
+
+Method *Vm::DefineMethod(Class *clazz, const std::string &name, const std::string &signature,
+                         MethodImpl impl) {
+    return AddMethod(clazz, name, signature, false, std::move(impl), false);
+}
+
+Method *Vm::DefineStaticMethod(Class *clazz, const std::string &name, const std::string &signature,
+                               MethodImpl impl) {
+    return AddMethod(clazz, name, signature, true, std::move(impl), false);
+}
+
+Field *Vm::DefineField(Class *clazz, const std::string &name, const std::string &signature) {
+    return AddField(clazz, name, signature, false, false);
+}
+
+Field *Vm::DefineStaticField(Class *clazz, const std::string &name, const std::string &signature) {
+    return AddField(clazz, name, signature, true, false);
+}
+
+const std::string &Vm::GetClassName(Class *clazz) const {
+    return clazz->name;
+}
+
+Class *Vm::GetClass(jobject object) {
+    auto o = Resolve(object);
+    return o != nullptr ? o->klass : nullptr;
+}
+
+std::vector<std::string> Vm::AutoDefined() const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::vector<std::string> result;
+    for (auto &c: m_classes) {
+        if (c.second->autoDefined) {
+            result.push_back(c.first);
+        }
+        for (auto &m: c.second->methods) {
+            if (m.second->autoDefined) {
+                result.push_back(c.first + "." + m.first + " calls=" + std::to_string(m.second->calls.load()));
+            }
+        }
+        for (auto &f: c.second->fields) {
+            if (f.second->autoDefined) {
+                result.push_back(c.first + "." + f.first + ":" + f.second->signature);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void Vm::DefineBuiltins() {
+    auto object = DefineClass("java/lang/Object", "");
+    auto classClass = DefineClass("java/lang/Class");
+    object->klass = classClass;
+    classClass->klass = classClass;
+    auto stringClass = DefineClass("java/lang/String");
+
+    auto newString = [](JNIEnv *env, const std::string &s) {
+        jvalue result;
+        result.l = env->NewStringUTF(s.c_str());
+        return result;
+    };
+
+    DefineMethod(object, "<init>", "()V", nullptr);
+    DefineMethod(object, "getClass", "()Ljava/lang/Class;", [](JNIEnv *env, jobject thiz, const jvalue *) {
+        jvalue result;
+        result.l = env->GetObjectClass(thiz);
+        return result;
+    });
+    DefineMethod(object, "hashCode", "()I", [](JNIEnv *, jobject thiz, const jvalue *) {
+        jvalue result;
+        result.i = (jint) (reinterpret_cast<uintptr_t>(Resolve(thiz)) >> 3);
+        return result;
+    });
+    DefineMethod(object, "equals", "(Ljava/lang/Object;)Z", [](JNIEnv *, jobject thiz, const jvalue *args) {
+        jvalue result;
+        result.z = Resolve(thiz) == Resolve(args[0].l) ? JNI_TRUE : JNI_FALSE;
+        return result;
+    });
+    DefineMethod(object, "toString", "()Ljava/lang/String;", [newString](JNIEnv *env, jobject thiz, const jvalue *) {
+        auto o = Resolve(thiz);
+        char hash[32];
+        snprintf(hash, sizeof(hash), "@%x", (unsigned) (reinterpret_cast<uintptr_t>(o) >> 3));
+        auto name = o->klass->name;
+        std::replace(name.begin(), name.end(), '/', '.');
+        return newString(env, name + hash);
+    });
+
+    DefineMethod(classClass, "getName", "()Ljava/lang/String;", [newString](JNIEnv *env, jobject thiz, const jvalue *) {
+        auto name = static_cast<Class *>(Resolve(thiz))->name;
+        std::replace(name.begin(), name.end(), '/', '.');
+        return newString(env, name);
+    });
+
+    DefineMethod(stringClass, "toString", "()Ljava/lang/String;", [](JNIEnv *env, jobject thiz, const jvalue *) {
+        jvalue result;
+        result.l = env->NewLocalRef(thiz);
+        return result;
+    });
+    DefineMethod(stringClass, "length", "()I", [](JNIEnv *env, jobject thiz, const jvalue *) {
+        jvalue result;
+        result.i = env->GetStringLength(static_cast<jstring>(thiz));
+        return result;
+    });
+    DefineMethod(stringClass, "equals", "(Ljava/lang/Object;)Z", [](JNIEnv *, jobject thiz, const jvalue *args) {
+        auto other = dynamic_cast<String *>(Resolve(args[0].l));
+        jvalue result;
+        result.z = other != nullptr && other->chars == static_cast<String *>(Resolve(thiz))->chars;
+        return result;
+    });
+
+    // the boxes hold their value in a field, as the real ones do
+    DefineClass("java/lang/Number");
+    struct Box {
+        const char *name;
+        const char *super;
+        const char *type;
+        const char *valueMethod;
+    };
+    const Box boxes[] = {
+            {"java/lang/Boolean",   "java/lang/Object", "Z", "booleanValue"},
+            {"java/lang/Character", "java/lang/Object", "C", "charValue"},
+            {"java/lang/Byte",      "java/lang/Number", "B", "byteValue"},
+            {"java/lang/Short",     "java/lang/Number", "S", "shortValue"},
+            {"java/lang/Integer",   "java/lang/Number", "I", "intValue"},
+            {"java/lang/Long",      "java/lang/Number", "J", "longValue"},
+            {"java/lang/Float",     "java/lang/Number", "F", "floatValue"},
+            {"java/lang/Double",    "java/lang/Number", "D", "doubleValue"},
+    };
+    for (auto &box: boxes) {
+        auto clazz = DefineClass(box.name, box.super);
+        auto value = DefineField(clazz, "value", box.type);
+        DefineMethod(clazz, "<init>", std::string("(") + box.type + ")V", [value](JNIEnv *, jobject thiz, const jvalue *args) {
+            Jni::Slot(Resolve(thiz), value) = args[0];
+            return jvalue{};
+        });
+        DefineMethod(clazz, box.valueMethod, std::string("()") + box.type, [value](JNIEnv *, jobject thiz, const jvalue *) {
+            return Jni::Slot(Resolve(thiz), value);
+        });
+        DefineStaticMethod(clazz, "valueOf", std::string("(") + box.type + ")L" + box.name + ";",
+                           [this, clazz, value](JNIEnv *env, jobject, const jvalue *args) {
+                               auto boxed = Jni::Allocate<Object>(this, clazz);
+                               Jni::Slot(boxed, value) = args[0];
+                               jvalue result;
+                               result.l = Jni::NewLocal(env, boxed);
+                               return result;
+                           });
+    }
+
+    auto throwable = DefineClass("java/lang/Throwable");
+    auto message = DefineField(throwable, "detailMessage", "Ljava/lang/String;");
+    DefineMethod(throwable, "<init>", "()V", nullptr);
+    DefineMethod(throwable, "<init>", "(Ljava/lang/String;)V", [message](JNIEnv *env, jobject thiz, const jvalue *args) {
+        env->SetObjectField(thiz, reinterpret_cast<jfieldID>(message), args[0].l);
+        return jvalue{};
+    });
+    DefineMethod(throwable, "getMessage", "()Ljava/lang/String;", [message](JNIEnv *env, jobject thiz, const jvalue *) {
+        jvalue result;
+        result.l = env->GetObjectField(thiz, reinterpret_cast<jfieldID>(message));
+        return result;
+    });
+    DefineClass("java/lang/Exception", "java/lang/Throwable");
+    DefineClass("java/lang/RuntimeException", "java/lang/Exception");
+    DefineClass("java/lang/Error", "java/lang/Throwable");
+    DefineClass("java/lang/NullPointerException", "java/lang/RuntimeException");
+    DefineClass("java/lang/UnsupportedOperationException", "java/lang/RuntimeException");
+    DefineClass("java/lang/IndexOutOfBoundsException", "java/lang/RuntimeException");
+    DefineClass("java/lang/ArrayIndexOutOfBoundsException", "java/lang/IndexOutOfBoundsException");
+    DefineClass("java/lang/StringIndexOutOfBoundsException", "java/lang/IndexOutOfBoundsException");
+    DefineClass("java/lang/LinkageError", "java/lang/Error");
+    DefineClass("java/lang/NoClassDefFoundError", "java/lang/LinkageError");
+    DefineClass("java/lang/IncompatibleClassChangeError", "java/lang/LinkageError");
+    DefineClass("java/lang/NoSuchMethodError", "java/lang/IncompatibleClassChangeError");
+    DefineClass("java/lang/NoSuchFieldError", "java/lang/IncompatibleClassChangeError");
+
+    DefineClass("java/nio/Buffer");
+    DefineClass("java/nio/ByteBuffer", "java/nio/Buffer");
+    DefineClass("java/nio/DirectByteBuffer", "java/nio/ByteBuffer");
+}
+
+}
+}
@@ -0,0 +1,173 @@
+#ifndef FAKEJNI_H
+#define FAKEJNI_H
+
+#include <jni.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tns {
+namespace fakejni {
+
+/*
+ * An in-memory stand-in for the Java VM, so that the code that talks to Java through JNIEnv can
+ * run, be profiled and be benchmarked on a Linux host.
+ *
+ * Classes, methods and fields are defined from C++, methods are implemented by C++ functions. The
+ * JNI functions work on a small object heap: instances, strings (UTF-16, converted from and to
+ * modified UTF-8), primitive and object arrays and direct byte buffers. Objects are reference
+ * counted by their local, global and field references, local references live in the local frames
+ * of the calling thread's JNIEnv, so PushLocalFrame/PopLocalFrame free what a native method would
+ * leave behind. Java exceptions are pending per thread as with a real VM.
+ *
+ * In lenient mode the classes, methods and fields that were not defined are created on first
+ * lookup, calling such a method returns zero or null. Everything the runtime needs from Java but
+ * a benchmark doesn't care about works this way, AutoDefined lists what was used.
+ *
+ * The latency knobs add busy waiting to the JNI calls, to model the cost of the real transitions
+ * when comparing changes in the code around them.
+ */
+
+struct Class;
+struct Object;
+
+/*
+ * The implementation of a Java method, `thiz` is null for static methods. The result is a local
+ * reference for methods returning objects.
+ */
+using MethodImpl = std::function<jvalue(JNIEnv *env, jobject thiz, const jvalue *args)>;
+
+struct Method {
+    Class *owner;
+    std::string name;
+    std::string signature;
+    bool isStatic;
+    // 'L' for objects and arrays
+    std::vector<char> argTypes;
+    char returnType;
+    MethodImpl impl;
+    bool autoDefined;
+    std::atomic<uint64_t> calls{0};
+};
+
+struct Field {
+    Class *owner;
+    std::string name;
+    std::string signature;
+    bool isStatic;
+    bool autoDefined;
+    jvalue staticValue;
+};
+
+/*
+ * The nanoseconds of busy waiting added to each JNI call of a category
+ */
+struct Latency {
+    uint32_t call = 0;
+    uint32_t lookup = 0;
+    uint32_t field = 0;
+    uint32_t string = 0;
+    uint32_t array = 0;
+    uint32_t reference = 0;
+};
+
+struct Counters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> lookups{0};
+    std::atomic<uint64_t> fieldAccesses{0};
+    std::atomic<uint64_t> objects{0};
+    std::atomic<uint64_t> liveObjects{0};
+    std::atomic<uint64_t> strings{0};
+    std::atomic<uint64_t> stringConversions{0};
+    std::atomic<uint64_t> arrays{0};
+    std::atomic<uint64_t> localRefs{0};
+    std::atomic<uint64_t> globalRefs{0};
+    std::atomic<uint64_t> liveGlobalRefs{0};
+    std::atomic<uint64_t> weakRefs{0};
+    std::atomic<uint64_t> exceptions{0};
+    // references that were deleted with the wrong function, or twice
+    std::atomic<uint64_t> invalidDeletes{0};
+};
+
+class Vm {
+public:
+    explicit Vm(bool lenient = true);
+
+    ~Vm();
+
+    JavaVM *GetJavaVM();
+
+    /*
+     * The JNIEnv of the calling thread, attaching the thread on first use
+     */
+    JNIEnv *GetEnv();
+
+    static Vm *FromEnv(JNIEnv *env);
+
+    /*
+     * Defines a class, `name` and `super` use the JNI form (java/lang/Object). The fields and
+     * methods of a class are inherited by the classes defined after them.
+     */
+    Class *DefineClass(const std::string &name, const std::string &super = "java/lang/Object",
+                       bool isInterface = false);
+
+    /*
+     * Returns the class, or null when it isn't defined and the VM isn't lenient
+     */
+    Class *FindClass(const std::string &name);
+
+    Method *DefineMethod(Class *clazz, const std::string &name, const std::string &signature,
+                         MethodImpl impl);
+
+    Method *DefineStaticMethod(Class *clazz, const std::string &name, const std::string &signature,
+                               MethodImpl impl);
+
+    Field *DefineField(Class *clazz, const std::string &name, const std::string &signature);
+
+    Field *DefineStaticField(Class *clazz, const std::string &name, const std::string &signature);
+
+    const std::string &GetClassName(Class *clazz) const;
+
+    /*
+     * The class of an object handle, for method implementations
+     */
+    Class *GetClass(jobject object);
+
+    /*
+     * The methods and fields that were created by lenient lookups
+     */
+    std::vector<std::string> AutoDefined() const;
+
+    Latency latency;
+
+    Counters counters;
+
+private:
+    Method *AddMethod(Class *clazz, const std::string &name, const std::string &signature,
+                      bool isStatic, MethodImpl impl, bool autoDefined);
+
+    Field *AddField(Class *clazz, const std::string &name, const std::string &signature,
+                    bool isStatic, bool autoDefined);
+
+    void DefineBuiltins();
+
+    struct VmImpl;
+    struct EnvImpl;
+    friend struct Jni;
+
+    bool m_lenient;
+    std::unique_ptr<VmImpl> m_vm;
+    mutable std::recursive_mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<Class>> m_classes;
+    std::vector<std::unique_ptr<EnvImpl>> m_envs;
+};
+
+}
+}
+
+#endif //FAKEJNI_H
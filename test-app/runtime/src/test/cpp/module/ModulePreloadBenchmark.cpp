@@ -0,0 +1,236 @@
+// Measures the JS thread time that ModulePreloader saves at startup, with the QuickJS backend:
+// generated modules are required once read and compiled on the JS thread and once taken from
+// the preloader, which read and compiled them on its threads (see js_precompile_function).
+//
+//   module_preload_benchmark_quickjs [--modules N] [--iterations N] [--head-start ms]
+//                                    [--output results.json]
+//
+// --head-start is how long the JS thread is busy with the rest of the runtime's initialization
+// before it requires the first module. The JS thread time is the time of reading, compiling and
+// running the modules, as ModuleInternal::CompileModuleFunction and LoadModule do. The process
+// exits with 1 when a module did not run or exported the wrong value.
+
+#include "File.h"
+#include "ModulePreloader.h"
+#include "jsr.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace tns;
+
+namespace {
+    const char *const MODULE_PARAMS[] = {"module", "exports", "require", "__filename", "__dirname"};
+    const size_t MODULE_PARAM_COUNT = sizeof(MODULE_PARAMS) / sizeof(MODULE_PARAMS[0]);
+
+    int s_failures = 0;
+
+    /*
+     * A module of some helpers and classes, about 9KB, that exports its index
+     */
+    std::string GenerateModule(int index) {
+        std::string source = "'use strict';\nconst table = [";
+        for (int i = 0; i < 32; i++) {
+            source += std::to_string((index * 31 + i * 17) % 1000) + ", ";
+        }
+        source += "];\n";
+        for (int k = 0; k < 40; k++) {
+            auto name = "helper" + std::to_string(k);
+            source += "function " + name + "(a, b) {\n"
+                      "    let result = 0;\n"
+                      "    for (let j = 0; j < a; j++) {\n"
+                      "        result += (j * " + std::to_string(k + 1) + ") % (b + 1);\n"
+                      "    }\n"
+                      "    return result + table[" + std::to_string(k % 32) + "];\n"
+                      "}\n";
+        }
+        for (int k = 0; k < 10; k++) {
+            auto name = "Widget" + std::to_string(k);
+            source += "class " + name + " {\n"
+                      "    constructor(x) { this.x = x; this.children = []; }\n"
+                      "    get value() { return this.x * " + std::to_string(k + 2) + "; }\n"
+                      "    add(child) { this.children.push(child); return this; }\n"
+                      "    render() { return `<" + name + " ${this.x}>` + this.children.map(c => c.render()).join(''); }\n"
+                      "}\n"
+                      "exports." + name + " = " + name + ";\n";
+        }
+        source += "exports.sum = function () { return helper0(3, 4) + helper39(5, 6); };\n"
+                  "exports.id = " + std::to_string(index) + ";\n";
+        return source;
+    }
+
+    bool WriteFile(const std::string &path, const std::string &content) {
+        auto file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+        bool success = fwrite(content.data(), 1, content.size(), file) == content.size();
+        return fclose(file) == 0 && success;
+    }
+
+    /*
+     * Requires `path` as the runtime does and checks that it exported `index`
+     */
+    void Require(napi_env env, ModulePreloader &preloader, const std::string &path, int index) {
+        FileContent content;
+        if (!preloader.Take(path, content) && !File::ReadContent(path, content)) {
+            fprintf(stderr, "cannot read %s\n", path.c_str());
+            s_failures++;
+            return;
+        }
+        preloader.Record(path);
+
+        napi_finalize finalize = nullptr;
+        char *source = const_cast<char *>(content.data);
+        if (!content.isMapped) {
+            source = content.buffer.release();
+            finalize = [](napi_env env, void *data, void *hint) {
+                delete[] static_cast<char *>(data);
+            };
+        }
+
+        napi_handle_scope scope;
+        napi_open_handle_scope(env, &scope);
+        napi_value function;
+        auto status = js_compile_function(env, source, content.length, ("file://" + path).c_str(),
+                                          MODULE_PARAMS, MODULE_PARAM_COUNT, finalize, nullptr, &function);
+
+        napi_value module, exports, undefined, result, id;
+        napi_create_object(env, &module);
+        napi_create_object(env, &exports);
+        napi_set_named_property(env, module, "exports", exports);
+        napi_get_undefined(env, &undefined);
+        napi_value args[] = {module, exports, undefined, undefined, undefined};
+        int32_t exported = -1;
+        if (status == napi_ok &&
+            napi_call_function(env, undefined, function, MODULE_PARAM_COUNT, args, &result) == napi_ok &&
+            napi_get_named_property(env, exports, "id", &id) == napi_ok) {
+            napi_get_value_int32(env, id, &exported);
+        }
+        if (exported != index) {
+            fprintf(stderr, "%s exported %d\n", path.c_str(), exported);
+            s_failures++;
+        }
+        napi_close_handle_scope(env, scope);
+    }
+
+    /*
+     * Returns the JS thread microseconds of requiring all modules in a new runtime
+     */
+    int64_t RequireAll(const std::string &appRoot, const std::string &listPath,
+                       const std::vector<std::string> &modules, bool preload, int headStartMs) {
+        napi_runtime runtime;
+        napi_env env;
+        js_create_runtime(&runtime);
+        js_create_napi_env(&env, runtime);
+
+        int64_t micros;
+        {
+            ModulePreloader preloader;
+            if (preload) {
+                preloader.Start(listPath, appRoot, MODULE_PARAMS, MODULE_PARAM_COUNT);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(headStartMs));
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < modules.size(); i++) {
+                Require(env, preloader, modules[i], (int) i);
+            }
+            micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+
+            preloader.Finish();
+        }
+
+        js_free_napi_env(env);
+        js_free_runtime(runtime);
+        return micros;
+    }
+}
+
+int main(int argc, char **argv) {
+    int moduleCount = 300;
+    int iterations = 5;
+    int headStartMs = 50;
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--modules") == 0 && i + 1 < argc) {
+            moduleCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--head-start") == 0 && i + 1 < argc) {
+            headStartMs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--modules N] [--iterations N] [--head-start ms] [--output file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    char dir[] = "/tmp/ns-module-preload-XXXXXX";
+    if (mkdtemp(dir) == nullptr) {
+        fprintf(stderr, "cannot create a temporary directory\n");
+        return 1;
+    }
+    std::string appRoot = std::string(dir) + "/";
+    std::string listPath = appRoot + ".ns-module-list";
+
+    std::vector<std::string> modules;
+    std::string list;
+    size_t sourceBytes = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        auto path = appRoot + "module" + std::to_string(i) + ".js";
+        auto source = GenerateModule(i);
+        if (!WriteFile(path, source)) {
+            fprintf(stderr, "cannot write %s\n", path.c_str());
+            return 1;
+        }
+        sourceBytes += source.size();
+        modules.push_back(path);
+        list += path + "\n";
+    }
+    if (!WriteFile(listPath, list)) {
+        fprintf(stderr, "cannot write %s\n", listPath.c_str());
+        return 1;
+    }
+
+    int64_t coldMicros = 0;
+    int64_t preloadedMicros = 0;
+    for (int i = 0; i < iterations; i++) {
+        coldMicros += RequireAll(appRoot, listPath, modules, false, headStartMs);
+        preloadedMicros += RequireAll(appRoot, listPath, modules, true, headStartMs);
+    }
+
+    for (auto &path: modules) {
+        unlink(path.c_str());
+    }
+    unlink(listPath.c_str());
+    rmdir(dir);
+
+    double coldMs = coldMicros / 1000.0 / iterations;
+    double preloadedMs = preloadedMicros / 1000.0 / iterations;
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output);
+            return 1;
+        }
+    }
+    fprintf(out, "{\n  \"engine\": \"quickjs\",\n  \"modules\": %d,\n  \"source_bytes\": %zu,\n  \"iterations\": %d,\n"
+                 "  \"head_start_ms\": %d,\n  \"js_thread_ms\": {\"cold\": %.2f, \"preloaded\": %.2f},\n"
+                 "  \"saved_ms\": %.2f,\n  \"saved_percent\": %.1f\n}\n",
+            moduleCount, sourceBytes, iterations, headStartMs, coldMs, preloadedMs, coldMs - preloadedMs,
+            coldMs > 0 ? (coldMs - preloadedMs) * 100 / coldMs : 0.0);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return s_failures > 0 ? 1 : 0;
+}
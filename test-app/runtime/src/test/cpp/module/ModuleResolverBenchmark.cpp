@@ -0,0 +1,225 @@
+// Benchmarks ModuleResolver on a generated app with a deep node_modules tree, with the QuickJS
+// backend reading the package.json files:
+//
+//   module_resolver_benchmark_quickjs [--iterations N] [--depth N] [--packages N] [--debuggable]
+//                                     [--output results.json]
+//
+// The app has `--packages` packages in app/tns_modules (with main, index, string, subpath,
+// pattern and conditional exports) and a chain of `--depth` nested folders under app/src, every
+// other one with a node_modules folder of its own. Each iteration requires all packages, their
+// subpaths and the local ones from a new folder at the bottom of the chain, so that the lookup
+// walks up through all the node_modules folders:
+//
+//   cold       the first folder, nothing is cached yet
+//   new_base   the other folders, the package.json files (and listings of a release app) are
+//              cached but the requests are resolved for the first time from that folder
+//   cached     the requests repeated from a folder they were resolved from
+//
+// The process exits with 1 when a request does not resolve to the file it was generated for.
+
+#include "ModuleResolver.h"
+#include "NativeScriptException.h"
+#include "jsr.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace tns;
+
+namespace {
+    int s_failures = 0;
+
+    void MakeDirs(const std::string &path) {
+        for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            mkdir(path.substr(0, slash).c_str(), 0755);
+        }
+        mkdir(path.c_str(), 0755);
+    }
+
+    void Write(const std::string &path, const std::string &content = "module.exports = 1;\n") {
+        MakeDirs(path.substr(0, path.find_last_of('/')));
+        auto file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            fprintf(stderr, "cannot write %s\n", path.c_str());
+            exit(1);
+        }
+        fwrite(content.data(), 1, content.size(), file);
+        fclose(file);
+    }
+
+    /*
+     * The requests of the app and the files they resolve to
+     */
+    typedef std::vector<std::pair<std::string, std::string>> Requests;
+
+    /*
+     * Writes package `index` to `dir` and adds the requests for it, the package kinds rotate
+     */
+    void WritePackage(const std::string &dir, const std::string &name, int index, Requests &requests) {
+        auto root = dir + "/" + name;
+        switch (index % 6) {
+            case 0:
+                Write(root + "/package.json", R"({ "name": ")" + name + R"(", "main": "lib/main" })");
+                Write(root + "/lib/main.js");
+                requests.emplace_back(name, root + "/lib/main.js");
+                break;
+            case 1:
+                Write(root + "/index.js");
+                Write(root + "/helpers.js");
+                requests.emplace_back(name, root + "/index.js");
+                requests.emplace_back(name + "/helpers", root + "/helpers.js");
+                break;
+            case 2:
+                Write(root + "/package.json", R"({ "name": ")" + name + R"(", "exports": "./dist/index.js" })");
+                Write(root + "/dist/index.js");
+                requests.emplace_back(name, root + "/dist/index.js");
+                break;
+            case 3:
+                Write(root + "/package.json", R"({ "name": ")" + name + R"(", "exports": { ".": "./index.js", "./feature": "./lib/feature.js" } })");
+                Write(root + "/index.js");
+                Write(root + "/lib/feature.js");
+                requests.emplace_back(name, root + "/index.js");
+                requests.emplace_back(name + "/feature", root + "/lib/feature.js");
+                break;
+            case 4:
+                Write(root + "/package.json", R"({ "name": ")" + name + R"(", "exports": { ".": "./index.js", "./components/*": "./src/components/*.js" } })");
+                Write(root + "/index.js");
+                Write(root + "/src/components/button.js");
+                Write(root + "/src/components/list.js");
+                requests.emplace_back(name, root + "/index.js");
+                requests.emplace_back(name + "/components/button", root + "/src/components/button.js");
+                requests.emplace_back(name + "/components/list", root + "/src/components/list.js");
+                break;
+            default:
+                Write(root + "/package.json", R"({ "name": ")" + name + R"(", "exports": { ".": { "import": "./esm/index.mjs", "require": "./cjs/index.js", "default": "./esm/index.mjs" } } })");
+                Write(root + "/cjs/index.js");
+                requests.emplace_back(name, root + "/cjs/index.js");
+                break;
+        }
+    }
+
+    /*
+     * Resolves all requests from `baseDir` and returns the nanoseconds per request
+     */
+    double ResolveAll(napi_env env, const Requests &requests, const std::string &baseDir) {
+        napi_handle_scope scope;
+        napi_open_handle_scope(env, &scope);
+        auto start = std::chrono::steady_clock::now();
+        for (auto &request: requests) {
+            std::string resolved;
+            try {
+                resolved = ModuleResolver::Resolve(env, request.first, baseDir);
+            } catch (NativeScriptException &) {
+            }
+            if (resolved != request.second) {
+                fprintf(stderr, "%s from %s resolved to \"%s\" instead of %s\n", request.first.c_str(),
+                        baseDir.c_str(), resolved.c_str(), request.second.c_str());
+                s_failures++;
+            }
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        napi_close_handle_scope(env, scope);
+        return (double) ns / requests.size();
+    }
+}
+
+int main(int argc, char **argv) {
+    int iterations = 50;
+    int depth = 12;
+    int packages = 60;
+    bool debuggable = false;
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--packages") == 0 && i + 1 < argc) {
+            packages = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--debuggable") == 0) {
+            debuggable = true;
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--depth N] [--packages N] [--debuggable] [--output file]\n", argv[0]);
+            return 2;
+        }
+    }
+    iterations = std::max(iterations, 2);
+
+    char tempDir[] = "/tmp/module-resolver-benchmark-XXXXXX";
+    char resolved[PATH_MAX];
+    if (mkdtemp(tempDir) == nullptr || realpath(tempDir, resolved) == nullptr) {
+        fprintf(stderr, "cannot create a temporary directory\n");
+        return 1;
+    }
+    std::string filesRoot = resolved;
+    std::string app = filesRoot + "/app";
+
+    Requests requests;
+    for (int i = 0; i < packages; i++) {
+        WritePackage(app + "/tns_modules", "package-" + std::to_string(i), i, requests);
+    }
+    auto bottom = app + "/src";
+    for (int level = 0; level < depth; level++) {
+        bottom += "/level" + std::to_string(level);
+        if (level % 2 == 0) {
+            WritePackage(bottom + "/node_modules", "local-" + std::to_string(level), level, requests);
+        }
+    }
+    // the folders the requests are made from, all written before a release app's listing is cached
+    std::vector<std::string> baseDirs;
+    for (int i = 0; i < iterations; i++) {
+        auto baseDir = bottom + "/screen" + std::to_string(i);
+        Write(baseDir + "/view.js");
+        baseDirs.push_back(baseDir);
+    }
+
+    napi_runtime runtime;
+    napi_env env;
+    js_create_runtime(&runtime);
+    js_create_napi_env(&env, runtime);
+    ModuleResolver::Init(filesRoot, debuggable);
+
+    auto cold = ResolveAll(env, requests, baseDirs[0]);
+    double newBase = 0;
+    for (int i = 1; i < iterations; i++) {
+        newBase += ResolveAll(env, requests, baseDirs[i]);
+    }
+    newBase /= iterations - 1;
+    double cached = 0;
+    for (int i = 0; i < iterations; i++) {
+        cached += ResolveAll(env, requests, baseDirs[i]);
+    }
+    cached /= iterations;
+
+    js_free_napi_env(env);
+    js_free_runtime(runtime);
+    std::string cleanup = "rm -rf " + filesRoot;
+    system(cleanup.c_str());
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output);
+            return 1;
+        }
+    }
+    fprintf(out, "{\n  \"engine\": \"quickjs\",\n  \"debuggable\": %s,\n  \"depth\": %d,\n  \"packages\": %d,\n"
+                 "  \"requests\": %zu,\n  \"iterations\": %d,\n"
+                 "  \"ns_per_resolve\": {\"cold\": %.0f, \"new_base\": %.0f, \"cached\": %.0f}\n}\n",
+            debuggable ? "true" : "false", depth, packages, requests.size(), iterations, cold, newBase, cached);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return s_failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+// Resolves requests with ModuleResolver against an app generated in a temporary files directory,
+// with the QuickJS backend reading the package.json files. The resolver is initialized once per
+// process, so release and debuggable apps are tested by separate runs.
+//
+//   module_resolver_tests_quickjs [--debuggable]
+
+#include "ModuleResolver.h"
+#include "NativeScriptException.h"
+#include "jsr.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+using namespace tns;
+
+static int s_failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            s_failures++; \
+        } \
+    } while (0)
+
+#define EXPECT_RESOLVES(request, baseDir, expected) \
+    do { \
+        auto resolved = Resolve(request, baseDir); \
+        if (resolved != (expected)) { \
+            fprintf(stderr, "%s:%d: %s resolved to \"%s\" instead of \"%s\"\n", __FILE__, __LINE__, \
+                    std::string(request).c_str(), resolved.c_str(), std::string(expected).c_str()); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static napi_env s_env;
+static bool s_debuggable = false;
+static std::string s_filesRoot;
+static std::string s_app;
+
+static void MakeDirs(const std::string &path) {
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+/*
+ * Writes `content` to `path` relative to the app folder
+ */
+static void Write(const std::string &path, const std::string &content = "module.exports = 1;\n") {
+    auto fullPath = s_app + "/" + path;
+    MakeDirs(fullPath.substr(0, fullPath.find_last_of('/')));
+    auto file = fopen(fullPath.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "cannot write %s\n", fullPath.c_str());
+        exit(EXIT_FAILURE);
+    }
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+}
+
+/*
+ * The resolved path relative to the app folder, or an empty string when the request failed
+ */
+static std::string Resolve(const std::string &request, const std::string &baseDir) {
+    napi_handle_scope scope;
+    napi_open_handle_scope(s_env, &scope);
+    std::string resolved;
+    try {
+        resolved = ModuleResolver::Resolve(s_env, request, baseDir);
+    } catch (NativeScriptException &) {
+    }
+    napi_close_handle_scope(s_env, scope);
+
+    if (resolved.compare(0, s_app.size() + 1, s_app + "/") == 0) {
+        return resolved.substr(s_app.size() + 1);
+    }
+    return resolved;
+}
+
+/*
+ * The resolver lists the directories of a release app once, so everything is written up front
+ */
+static void WriteApp() {
+    Write("probe/plain.js");
+    Write("probe/data.json", "{}");
+    Write("probe/both.js");
+    Write("probe/both/index.js");
+    Write("probe/folder/index.js");
+    Write("probe/nested/deeper/leaf.js");
+
+    Write("tns_modules/with-main/package.json", R"({ "main": "lib/entry" })");
+    Write("tns_modules/with-main/lib/entry.js");
+    Write("tns_modules/with-main/index.js");
+    Write("tns_modules/missing-main/package.json", R"({ "main": "lib/gone.js" })");
+    Write("tns_modules/missing-main/index.js");
+    Write("tns_modules/main-folder/package.json", R"({ "main": "./dist" })");
+    Write("tns_modules/main-folder/dist/index.js");
+    Write("tns_modules/no-package/index.js");
+    Write("tns_modules/single-file.js");
+    Write("tns_modules/tns-core-modules/ui/core.js");
+
+    Write("tns_modules/exports-string/package.json", R"({ "main": "index.js", "exports": "./dist/main.js" })");
+    Write("tns_modules/exports-string/index.js");
+    Write("tns_modules/exports-string/dist/main.js");
+    Write("tns_modules/exports-subpaths/package.json",
+          R"({ "exports": { ".": "./root.js", "./feature": "./lib/feature.js", "./package.json": "./package.json" } })");
+    Write("tns_modules/exports-subpaths/root.js");
+    Write("tns_modules/exports-subpaths/lib/feature.js");
+    Write("tns_modules/exports-subpaths/unlisted.js");
+    Write("tns_modules/exports-pattern/package.json",
+          R"({ "exports": { ".": "./index.js", "./features/*": "./src/features/*.js", "./utils/*.js": "./src/utils/*.js" } })");
+    Write("tns_modules/exports-pattern/index.js");
+    Write("tns_modules/exports-pattern/src/features/camera.js");
+    Write("tns_modules/exports-pattern/src/features/deep/gps.js");
+    Write("tns_modules/exports-pattern/src/utils/strings.js");
+    Write("tns_modules/exports-require/package.json",
+          R"({ "exports": { ".": { "import": "./esm/index.mjs", "require": "./cjs/index.js" } } })");
+    Write("tns_modules/exports-require/cjs/index.js");
+    Write("tns_modules/exports-node/package.json",
+          R"({ "exports": { "browser": "./browser.js", "node": "./node.js", "default": "./default.js" } })");
+    Write("tns_modules/exports-node/node.js");
+    Write("tns_modules/exports-node/default.js");
+    Write("tns_modules/exports-default/package.json",
+          R"({ "exports": { "./sub": { "import": "./sub.mjs", "default": "./sub.js" }, ".": { "types": "./index.d.ts", "default": "./main.js" } } })");
+    Write("tns_modules/exports-default/main.js");
+    Write("tns_modules/exports-default/sub.js");
+    Write("tns_modules/exports-nested/package.json",
+          R"({ "exports": { ".": { "node": { "import": "./node.mjs", "require": "./node.cjs.js" }, "default": "./default.js" } } })");
+    Write("tns_modules/exports-nested/node.cjs.js");
+    Write("tns_modules/exports-array/package.json",
+          R"({ "exports": { ".": [{ "worker": "./worker.js" }, "./fallback.js"] } })");
+    Write("tns_modules/exports-array/fallback.js");
+    Write("tns_modules/@scope/scoped/package.json", R"({ "exports": { ".": "./main.js", "./extra": "./extra.js" } })");
+    Write("tns_modules/@scope/scoped/main.js");
+    Write("tns_modules/@scope/scoped/extra.js");
+
+    Write("feature/node_modules/local/index.js");
+    Write("feature/node_modules/with-main/package.json", R"({ "main": "local-entry.js" })");
+    Write("feature/node_modules/with-main/local-entry.js");
+    Write("feature/screens/home/view.js");
+
+    MakeDirs(s_app + "/late");
+    MakeDirs(s_filesRoot + "/outside");
+}
+
+static void ResolvesFilesWithAnImplicitExtension() {
+    EXPECT_RESOLVES("./probe/plain", "", "probe/plain.js");
+    EXPECT_RESOLVES("./probe/plain.js", s_app, "probe/plain.js");
+    EXPECT_RESOLVES("./probe/data.json", s_app, "probe/data.json");
+    EXPECT_RESOLVES("~/probe/plain", s_app + "/feature", "probe/plain.js");
+    EXPECT_RESOLVES("../plain", s_app + "/probe/folder", "probe/plain.js");
+    EXPECT_RESOLVES(s_app + "/probe/nested/deeper/leaf", "/", "probe/nested/deeper/leaf.js");
+    // a file wins over a folder of the same name
+    EXPECT_RESOLVES("./probe/both", s_app, "probe/both.js");
+    EXPECT_RESOLVES("./probe/data", s_app, "");
+    EXPECT_RESOLVES("./probe/missing", s_app, "");
+}
+
+static void ResolvesFoldersThroughTheirPackageMain() {
+    EXPECT_RESOLVES("with-main", s_app, "tns_modules/with-main/lib/entry.js");
+    EXPECT_RESOLVES("main-folder", s_app, "tns_modules/main-folder/dist/index.js");
+    EXPECT_RESOLVES("single-file", s_app, "tns_modules/single-file.js");
+    EXPECT_RESOLVES("ui/core", s_app, "tns_modules/tns-core-modules/ui/core.js");
+}
+
+static void ResolvesFoldersThroughTheirIndex() {
+    EXPECT_RESOLVES("./probe/folder", s_app, "probe/folder/index.js");
+    EXPECT_RESOLVES("no-package", s_app, "tns_modules/no-package/index.js");
+    EXPECT_RESOLVES("missing-main", s_app, "tns_modules/missing-main/index.js");
+}
+
+static void LooksUpNodeModulesTowardsTheAppFolder() {
+    auto base = s_app + "/feature/screens/home";
+    EXPECT_RESOLVES("local", base, "feature/node_modules/local/index.js");
+    // the closest package wins
+    EXPECT_RESOLVES("with-main", base, "feature/node_modules/with-main/local-entry.js");
+    EXPECT_RESOLVES("no-package", base, "tns_modules/no-package/index.js");
+    EXPECT_RESOLVES("local", s_app + "/probe", "");
+}
+
+static void ResolvesStringExports() {
+    // exports take precedence over main
+    EXPECT_RESOLVES("exports-string", s_app, "tns_modules/exports-string/dist/main.js");
+}
+
+static void ResolvesSubpathExports() {
+    EXPECT_RESOLVES("exports-subpaths", s_app, "tns_modules/exports-subpaths/root.js");
+    EXPECT_RESOLVES("exports-subpaths/feature", s_app, "tns_modules/exports-subpaths/lib/feature.js");
+    EXPECT_RESOLVES("exports-subpaths/package.json", s_app, "tns_modules/exports-subpaths/package.json");
+    // subpaths that are not exported are looked up as files, as the Java resolver did
+    EXPECT_RESOLVES("exports-subpaths/unlisted", s_app, "tns_modules/exports-subpaths/unlisted.js");
+    EXPECT_RESOLVES("@scope/scoped", s_app, "tns_modules/@scope/scoped/main.js");
+    EXPECT_RESOLVES("@scope/scoped/extra", s_app, "tns_modules/@scope/scoped/extra.js");
+}
+
+static void ResolvesPatternExports() {
+    EXPECT_RESOLVES("exports-pattern/features/camera", s_app, "tns_modules/exports-pattern/src/features/camera.js");
+    EXPECT_RESOLVES("exports-pattern/features/deep/gps", s_app, "tns_modules/exports-pattern/src/features/deep/gps.js");
+    EXPECT_RESOLVES("exports-pattern/utils/strings.js", s_app, "tns_modules/exports-pattern/src/utils/strings.js");
+    EXPECT_RESOLVES("exports-pattern/features/none", s_app, "");
+}
+
+static void ResolvesConditionalExports() {
+    EXPECT_RESOLVES("exports-require", s_app, "tns_modules/exports-require/cjs/index.js");
+    EXPECT_RESOLVES("exports-node", s_app, "tns_modules/exports-node/node.js");
+    EXPECT_RESOLVES("exports-default", s_app, "tns_modules/exports-default/main.js");
+    EXPECT_RESOLVES("exports-default/sub", s_app, "tns_modules/exports-default/sub.js");
+    EXPECT_RESOLVES("exports-nested", s_app, "tns_modules/exports-nested/node.cjs.js");
+    EXPECT_RESOLVES("exports-array", s_app, "tns_modules/exports-array/fallback.js");
+}
+
+static void CachesFailuresOnlyWhereFilesCannotAppear() {
+    EXPECT_RESOLVES("./late/module", s_app, "");
+    EXPECT_RESOLVES("./module", s_filesRoot + "/outside", "");
+    Write("late/module.js");
+    Write("../outside/module.js");
+
+    // a release app folder does not change while the app runs, LiveSync updates debuggable ones
+    EXPECT_RESOLVES("./late/module", s_app, s_debuggable ? "late/module.js" : "");
+    EXPECT(Resolve("./module", s_filesRoot + "/outside") == s_filesRoot + "/outside/module.js");
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "--debuggable") == 0) {
+        s_debuggable = true;
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [--debuggable]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char tempDir[] = "/tmp/module-resolver-tests-XXXXXX";
+    char resolved[PATH_MAX];
+    if (mkdtemp(tempDir) == nullptr || realpath(tempDir, resolved) == nullptr) {
+        fprintf(stderr, "cannot create a temporary directory\n");
+        return EXIT_FAILURE;
+    }
+    s_filesRoot = resolved;
+    s_app = s_filesRoot + "/app";
+    WriteApp();
+
+    napi_runtime runtime;
+    js_create_runtime(&runtime);
+    js_create_napi_env(&s_env, runtime);
+    ModuleResolver::Init(s_filesRoot, s_debuggable);
+
+    ResolvesFilesWithAnImplicitExtension();
+    ResolvesFoldersThroughTheirPackageMain();
+    ResolvesFoldersThroughTheirIndex();
+    LooksUpNodeModulesTowardsTheAppFolder();
+    ResolvesStringExports();
+    ResolvesSubpathExports();
+    ResolvesPatternExports();
+    ResolvesConditionalExports();
+    CachesFailuresOnlyWhereFilesCannotAppear();
+
+    js_free_napi_env(s_env);
+    js_free_runtime(runtime);
+
+    std::string cleanup = "rm -rf " + s_filesRoot;
+    system(cleanup.c_str());
+
+    if (s_failures > 0) {
+        fprintf(stderr, "%d expectations failed\n", s_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all module resolver tests passed (%s)\n", s_debuggable ? "debuggable" : "release");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+// Node-API benchmarks, written against js_native_api.h and jsr_common.h only so that the same
+// suite runs on every engine backend that can be built for the host.
+//
+//   napi_benchmark_quickjs [--iterations N] [--filter name] [--output results.json]
+//
+// Every benchmark reports the time per operation, the results are written as JSON to stdout or
+// to the output file. The process exits with 1 when a Node-API call fails or a benchmark sees a
+// wrong result.
+
+#include "js_native_api.h"
+#include "jsr_common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    const size_t BATCH_SIZE = 256;
+
+    void Fail(const char *expression, const char *file, int line) {
+        fprintf(stderr, "%s:%d: %s failed\n", file, line, expression);
+        exit(1);
+    }
+
+#define CHECK(expr) \
+    if ((expr) != napi_ok) Fail(#expr, __FILE__, __LINE__)
+
+#define EXPECT(cond) \
+    if (!(cond)) Fail(#cond, __FILE__, __LINE__)
+
+    /*
+     * Calls fn(i) for i in [0, iterations), in handle scopes of BATCH_SIZE calls so that the
+     * handles created by the benchmarks don't pile up
+     */
+    template<typename Fn>
+    void Loop(napi_env env, size_t iterations, Fn fn) {
+        for (size_t i = 0; i < iterations;) {
+            napi_handle_scope scope;
+            CHECK(napi_open_handle_scope(env, &scope));
+            auto end = std::min(iterations, i + BATCH_SIZE);
+            for (; i < end; i++) {
+                fn(i);
+            }
+            CHECK(napi_close_handle_scope(env, scope));
+        }
+    }
+
+    napi_value RunScript(napi_env env, const char *code) {
+        napi_value source, result;
+        CHECK(napi_create_string_utf8(env, code, strlen(code), &source));
+        CHECK(js_execute_script(env, source, "benchmark.js", &result));
+        return result;
+    }
+
+    napi_value NewObject(napi_env env) {
+        napi_value object;
+        CHECK(napi_create_object(env, &object));
+        return object;
+    }
+
+    void HandleScopes(napi_env env, size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+            napi_handle_scope scope;
+            CHECK(napi_open_handle_scope(env, &scope));
+            napi_value value;
+            CHECK(napi_create_int32(env, (int32_t) i, &value));
+            CHECK(napi_close_handle_scope(env, scope));
+        }
+    }
+
+    void References(napi_env env, size_t iterations) {
+        auto object = NewObject(env);
+        for (size_t i = 0; i < iterations; i++) {
+            napi_ref ref;
+            CHECK(napi_create_reference(env, object, 1, &ref));
+            uint32_t count;
+            CHECK(napi_reference_unref(env, ref, &count));
+            CHECK(napi_delete_reference(env, ref));
+        }
+    }
+
+    void Wrap(napi_env env, size_t iterations) {
+        static int native;
+        Loop(env, iterations, [env](size_t) {
+            napi_value object = NewObject(env);
+            CHECK(napi_wrap(env, object, &native, nullptr, nullptr, nullptr));
+        });
+    }
+
+    void Unwrap(napi_env env, size_t iterations) {
+        static int native;
+        auto object = NewObject(env);
+        CHECK(napi_wrap(env, object, &native, nullptr, nullptr, nullptr));
+        for (size_t i = 0; i < iterations; i++) {
+            void *result;
+            CHECK(napi_unwrap(env, object, &result));
+            EXPECT(result == &native);
+        }
+    }
+
+    void NamedProperties(napi_env env, size_t iterations) {
+        auto object = NewObject(env);
+        Loop(env, iterations, [env, object](size_t i) {
+            napi_value value, result;
+            CHECK(napi_create_int32(env, (int32_t) i, &value));
+            CHECK(napi_set_named_property(env, object, "value", value));
+            CHECK(napi_get_named_property(env, object, "value", &result));
+        });
+    }
+
+    void KeyedProperties(napi_env env, size_t iterations) {
+        auto object = NewObject(env);
+        napi_value key;
+        CHECK(napi_create_string_utf8(env, "value", 5, &key));
+        Loop(env, iterations, [env, object, key](size_t i) {
+            napi_value value, result;
+            CHECK(napi_create_int32(env, (int32_t) i, &value));
+            CHECK(napi_set_property(env, object, key, value));
+            CHECK(napi_get_property(env, object, key, &result));
+        });
+    }
+
+    void Elements(napi_env env, size_t iterations) {
+        napi_value array;
+        CHECK(napi_create_array_with_length(env, 64, &array));
+        Loop(env, iterations, [env, array](size_t i) {
+            napi_value value, result;
+            CHECK(napi_create_int32(env, (int32_t) i, &value));
+            CHECK(napi_set_element(env, array, (uint32_t) (i & 63), value));
+            CHECK(napi_get_element(env, array, (uint32_t) (i & 63), &result));
+        });
+    }
+
+    void CallJsFunction(napi_env env, size_t iterations) {
+        auto add = RunScript(env, "(function (a, b) { return a + b; })");
+        napi_value global;
+        CHECK(napi_get_global(env, &global));
+        Loop(env, iterations, [env, add, global](size_t i) {
+            napi_value argv[2], result;
+            CHECK(napi_create_int32(env, (int32_t) i, &argv[0]));
+            CHECK(napi_create_int32(env, 1, &argv[1]));
+            CHECK(napi_call_function(env, global, add, 2, argv, &result));
+        });
+    }
+
+    napi_value NativeAdd(napi_env env, napi_callback_info info) {
+        size_t argc = 2;
+        napi_value argv[2];
+        CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+        double a, b;
+        CHECK(napi_get_value_double(env, argv[0], &a));
+        CHECK(napi_get_value_double(env, argv[1], &b));
+        napi_value result;
+        CHECK(napi_create_double(env, a + b, &result));
+        return result;
+    }
+
+    void CallNativeFunction(napi_env env, size_t iterations) {
+        napi_value global, add;
+        CHECK(napi_get_global(env, &global));
+        CHECK(napi_create_function(env, "nativeAdd", NAPI_AUTO_LENGTH, NativeAdd, nullptr, &add));
+        CHECK(napi_set_named_property(env, global, "nativeAdd", add));
+
+        auto loop = RunScript(env, "(function (n) { var s = 0; for (var i = 0; i < n; i++) s = nativeAdd(s, 1); return s; })");
+        napi_value n, result;
+        CHECK(napi_create_double(env, (double) iterations, &n));
+        CHECK(napi_call_function(env, global, loop, 1, &n, &result));
+        double sum;
+        CHECK(napi_get_value_double(env, result, &sum));
+        EXPECT(sum == (double) iterations);
+    }
+
+    void ShortStrings(napi_env env, size_t iterations) {
+        const char text[] = "ShortStringValue";
+        Loop(env, iterations, [env, &text](size_t) {
+            napi_value value;
+            CHECK(napi_create_string_utf8(env, text, sizeof(text) - 1, &value));
+        });
+    }
+
+    void LongStrings(napi_env env, size_t iterations) {
+        std::string text(1024, 'x');
+        Loop(env, iterations, [env, &text](size_t) {
+            napi_value value;
+            CHECK(napi_create_string_utf8(env, text.data(), text.size(), &value));
+        });
+    }
+
+    void Utf16Strings(napi_env env, size_t iterations) {
+        std::u16string text(64, u'é');
+        Loop(env, iterations, [env, &text](size_t) {
+            napi_value value;
+            CHECK(napi_create_string_utf16(env, text.data(), text.size(), &value));
+        });
+    }
+
+    void ReadStrings(napi_env env, size_t iterations) {
+        std::string text(256, 'y');
+        napi_value value;
+        CHECK(napi_create_string_utf8(env, text.data(), text.size(), &value));
+        char buffer[512];
+        for (size_t i = 0; i < iterations; i++) {
+            size_t length;
+            CHECK(napi_get_value_string_utf8(env, value, buffer, sizeof(buffer), &length));
+            EXPECT(length == text.size());
+        }
+    }
+
+    void TypedArrays(napi_env env, size_t iterations) {
+        Loop(env, iterations, [env](size_t) {
+            napi_value buffer, array;
+            void *data;
+            CHECK(napi_create_arraybuffer(env, 64, &data, &buffer));
+            CHECK(napi_create_typedarray(env, napi_uint8_array, 64, buffer, 0, &array));
+
+            napi_typedarray_type type;
+            size_t length;
+            void *arrayData;
+            CHECK(napi_get_typedarray_info(env, array, &type, &length, &arrayData, nullptr, nullptr));
+            EXPECT(length == 64);
+        });
+    }
+
+    size_t s_finalized = 0;
+
+    void CountFinalized(napi_env env, void *data, void *hint) {
+        s_finalized++;
+    }
+
+    void Finalizers(napi_env env, size_t iterations) {
+        s_finalized = 0;
+        Loop(env, iterations, [env](size_t) {
+            napi_value object = NewObject(env);
+            CHECK(napi_add_finalizer(env, object, &s_finalized, CountFinalized, nullptr, nullptr));
+        });
+        // engines that finalize from a job, or on a later GC, are charged for what ran so far
+        CHECK(js_execute_pending_jobs(env));
+        EXPECT(s_finalized <= iterations);
+    }
+
+    struct Benchmark {
+        const char *name;
+        void (*run)(napi_env env, size_t iterations);
+        // some operations are much slower than the others, they run fewer iterations
+        size_t divisor;
+    };
+
+    const Benchmark BENCHMARKS[] = {
+            {"handle_scope",         HandleScopes,       1},
+            {"reference",            References,         1},
+            {"wrap",                 Wrap,               4},
+            {"unwrap",               Unwrap,             1},
+            {"named_property",       NamedProperties,    1},
+            {"keyed_property",       KeyedProperties,    1},
+            {"element",              Elements,           1},
+            {"call_js_function",     CallJsFunction,     4},
+            {"call_native_function", CallNativeFunction, 4},
+            {"string_short",         ShortStrings,       1},
+            {"string_long",          LongStrings,        4},
+            {"string_utf16",         Utf16Strings,       1},
+            {"string_read",          ReadStrings,        1},
+            {"typed_array",          TypedArrays,        8},
+            {"finalizer",            Finalizers,         4},
+    };
+
+    struct Result {
+        const char *name;
+        size_t iterations;
+        double nsPerOp;
+    };
+
+    std::string EngineName(napi_env env) {
+        napi_value version;
+        if (js_get_runtime_version(env, &version) != napi_ok) {
+            return "unknown";
+        }
+        char buffer[128];
+        size_t length;
+        CHECK(napi_get_value_string_utf8(env, version, buffer, sizeof(buffer), &length));
+        return std::string(buffer, length);
+    }
+
+    void WriteJson(FILE *out, const std::string &engine, const std::vector<Result> &results) {
+        fprintf(out, "{\n  \"engine\": \"%s\",\n  \"results\": [", engine.c_str());
+        for (size_t i = 0; i < results.size(); i++) {
+            auto &r = results[i];
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f}",
+                    i > 0 ? "," : "", r.name, r.iterations, r.nsPerOp, r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0.0);
+        }
+        fprintf(out, "\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = 1000000;
+    const char *filter = nullptr;
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--filter name] [--output file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    napi_runtime runtime;
+    napi_env env;
+    CHECK(js_create_runtime(&runtime));
+    CHECK(js_create_napi_env(&env, runtime));
+    js_lock_env(env);
+
+    napi_handle_scope scope;
+    CHECK(napi_open_handle_scope(env, &scope));
+    auto engine = EngineName(env);
+
+    std::vector<Result> results;
+    for (auto &benchmark: BENCHMARKS) {
+        if (filter != nullptr && strstr(benchmark.name, filter) == nullptr) {
+            continue;
+        }
+
+        auto count = std::max<size_t>(1, iterations / benchmark.divisor);
+        napi_handle_scope benchmarkScope;
+        CHECK(napi_open_handle_scope(env, &benchmarkScope));
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(env, count);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK(napi_close_handle_scope(env, benchmarkScope));
+
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        results.push_back({benchmark.name, count, (double) ns / count});
+    }
+
+    CHECK(napi_close_handle_scope(env, scope));
+    js_unlock_env(env);
+    CHECK(js_free_napi_env(env));
+    CHECK(js_free_runtime(runtime));
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output);
+            return 1;
+        }
+    }
+    WriteJson(out, engine, results);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}
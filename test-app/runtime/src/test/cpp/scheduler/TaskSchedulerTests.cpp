@@ -0,0 +1,272 @@
+// Drives TaskScheduler with a synthetic frame clock, no device needed.
+
+#include "TaskScheduler.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace tns;
+
+static int s_failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static const int64_t MS = 1000000;
+
+/*
+ * Emulates the looper: vsyncs every `interval`, the UI renders for `renderCost` after each frame
+ * callback and then the scheduler runs, as it does after the Choreographer's doFrame.
+ */
+class SyntheticFrameClock : public TaskScheduler::Host {
+    public:
+        SyntheticFrameClock(int64_t interval, int64_t renderCost)
+            : now(0), interval(interval), renderCost(renderCost), frameRequested(false), runRequested(false),
+              frameRequests(0), scheduler(this) {
+        }
+
+        int64_t Now() override {
+            return now;
+        }
+
+        void RequestFrame() override {
+            frameRequested = true;
+            frameRequests++;
+        }
+
+        void RequestRun() override {
+            runRequested = true;
+        }
+
+        void Advance(int64_t duration) {
+            now += duration;
+        }
+
+        /*
+         * Moves to the next vsync and delivers it if a frame was requested
+         */
+        bool Frame() {
+            now = (now / interval + 1) * interval;
+            if (!frameRequested) {
+                return false;
+            }
+
+            frameRequested = false;
+            scheduler.OnFrame(now);
+            now += renderCost;
+            if (runRequested) {
+                runRequested = false;
+                scheduler.Run();
+            }
+            return true;
+        }
+
+        int RunFrames(int max) {
+            int frames = 0;
+            while (frames < max && Frame()) {
+                frames++;
+            }
+            return frames;
+        }
+
+        int64_t now;
+        int64_t interval;
+        int64_t renderCost;
+        bool frameRequested;
+        bool runRequested;
+        int frameRequests;
+        TaskScheduler scheduler;
+};
+
+static void RunsTasksByPriority() {
+    SyntheticFrameClock clock(16666667, 2 * MS);
+    std::string order;
+
+    clock.scheduler.RequestIdleCallback([&](const TaskScheduler::Deadline&) { order += "i"; }, 0);
+    clock.scheduler.PostTask(TaskScheduler::BACKGROUND, [&](const TaskScheduler::Deadline&) { order += "b"; });
+    clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline&) { order += "v"; });
+    clock.scheduler.PostTask(TaskScheduler::USER_BLOCKING, [&](const TaskScheduler::Deadline&) { order += "u"; });
+    clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline&) { order += "v"; });
+
+    EXPECT(clock.frameRequests == 1);
+    EXPECT(clock.RunFrames(10) == 1);
+    EXPECT(order == "uvvbi");
+    EXPECT(!clock.scheduler.HasPendingWork());
+    EXPECT(!clock.frameRequested);
+}
+
+static void StopsAtTheFrameDeadline() {
+    SyntheticFrameClock clock(16666667, 4 * MS);
+    std::vector<int64_t> starts;
+
+    for (int i = 0; i < 12; i++) {
+        clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline& deadline) {
+            starts.push_back(clock.now);
+            EXPECT(deadline.timeRemainingNs > 0);
+            clock.Advance(3 * MS);
+        });
+    }
+
+    // 16.6ms frame - 4ms render - 1ms reserve leaves room to start four 3ms tasks
+    EXPECT(clock.Frame());
+    EXPECT(starts.size() == 4);
+    EXPECT(clock.frameRequested);
+
+    clock.RunFrames(10);
+    EXPECT(starts.size() == 12);
+
+    auto stats = clock.scheduler.GetStats();
+    EXPECT(stats.frames == 3);
+    EXPECT(stats.tasksRun == 12);
+    // only the last task of a frame may cross the deadline
+    EXPECT(stats.deadlineOverruns <= stats.frames);
+    EXPECT(stats.droppedFrames == 0);
+}
+
+static void RunsOneTaskWhenTheFrameIsOverBudget() {
+    // rendering alone takes longer than the frame
+    SyntheticFrameClock clock(16666667, 20 * MS);
+    int ran = 0;
+
+    for (int i = 0; i < 3; i++) {
+        clock.scheduler.PostTask(TaskScheduler::BACKGROUND, [&](const TaskScheduler::Deadline& deadline) {
+            EXPECT(deadline.timeRemainingNs == 0);
+            ran++;
+        });
+    }
+    clock.scheduler.RequestIdleCallback([&](const TaskScheduler::Deadline&) { ran += 100; }, 0);
+
+    EXPECT(clock.Frame());
+    EXPECT(ran == 1);
+    clock.RunFrames(2);
+    EXPECT(ran == 3);
+    // idle callbacks without a timeout wait for a frame with time left
+    EXPECT(clock.scheduler.HasPendingWork());
+
+    clock.renderCost = 2 * MS;
+    clock.RunFrames(1);
+    EXPECT(ran == 103);
+}
+
+static void IdleCallbackTimeout() {
+    SyntheticFrameClock clock(16666667, 30 * MS);
+    bool didTimeout = false;
+    int ran = 0;
+
+    clock.scheduler.RequestIdleCallback([&](const TaskScheduler::Deadline& deadline) {
+        didTimeout = deadline.didTimeout;
+        ran++;
+    }, 50 * MS);
+
+    // the first frame has no idle time and the timeout has not expired yet
+    clock.RunFrames(1);
+    EXPECT(ran == 0);
+
+    clock.RunFrames(10);
+    EXPECT(ran == 1);
+    EXPECT(didTimeout);
+    EXPECT(clock.scheduler.GetStats().idleTimeouts == 1);
+}
+
+static void CancelsQueuedWork() {
+    SyntheticFrameClock clock(16666667, 2 * MS);
+    int ran = 0;
+
+    auto idle = clock.scheduler.RequestIdleCallback([&](const TaskScheduler::Deadline&) { ran++; }, 0);
+    auto task = clock.scheduler.PostTask(TaskScheduler::USER_BLOCKING, [&](const TaskScheduler::Deadline&) { ran++; });
+
+    EXPECT(clock.scheduler.Cancel(idle));
+    EXPECT(clock.scheduler.Cancel(task));
+    EXPECT(!clock.scheduler.Cancel(task));
+    EXPECT(!clock.scheduler.HasPendingWork());
+
+    clock.RunFrames(3);
+    EXPECT(ran == 0);
+}
+
+static void CountsDroppedFramesAndOverruns() {
+    SyntheticFrameClock clock(16666667, 2 * MS);
+
+    clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline&) {
+        // a long task blocks the looper for three vsyncs
+        clock.Advance(45 * MS);
+    });
+    clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline&) {
+    });
+
+    clock.RunFrames(10);
+
+    auto stats = clock.scheduler.GetStats();
+    EXPECT(stats.deadlineOverruns == 1);
+    EXPECT(stats.droppedFrames == 2);
+    EXPECT(stats.tasksRun == 2);
+}
+
+static void AdaptsToTheRefreshRate() {
+    SyntheticFrameClock clock(8333333, 1 * MS);
+
+    // light work posted from outside every frame, e.g. by input events, reveals the 120Hz display
+    for (int i = 0; i < 10; i++) {
+        clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline&) {
+            clock.Advance(MS / 2);
+        });
+        clock.Frame();
+    }
+    EXPECT(clock.scheduler.GetStats().frameIntervalNs < 9 * MS);
+
+    // with a 16.6ms budget these would run past the next vsync
+    for (int i = 0; i < 60; i++) {
+        clock.scheduler.PostTask(TaskScheduler::USER_VISIBLE, [&](const TaskScheduler::Deadline&) {
+            clock.Advance(1 * MS);
+        });
+    }
+
+    clock.RunFrames(100);
+
+    auto stats = clock.scheduler.GetStats();
+    EXPECT(stats.tasksRun == 70);
+    EXPECT(stats.droppedFrames == 0);
+    EXPECT(stats.frameIntervalNs < 9 * MS);
+}
+
+static void PostingFromATaskSchedulesTheNextFrame() {
+    SyntheticFrameClock clock(16666667, 2 * MS);
+    int remaining = 5;
+    std::function<void(const TaskScheduler::Deadline&)> step = [&](const TaskScheduler::Deadline&) {
+        if (--remaining > 0) {
+            clock.scheduler.PostTask(TaskScheduler::BACKGROUND, step);
+        }
+        clock.Advance(20 * MS);
+    };
+
+    clock.scheduler.PostTask(TaskScheduler::BACKGROUND, step);
+    clock.RunFrames(20);
+
+    EXPECT(remaining == 0);
+    EXPECT(!clock.frameRequested);
+}
+
+int main() {
+    RunsTasksByPriority();
+    StopsAtTheFrameDeadline();
+    RunsOneTaskWhenTheFrameIsOverBudget();
+    IdleCallbackTimeout();
+    CancelsQueuedWork();
+    CountsDroppedFramesAndOverruns();
+    AdaptsToTheRefreshRate();
+    PostingFromATaskSchedulesTheNextFrame();
+
+    if (s_failures > 0) {
+        fprintf(stderr, "%d expectations failed\n", s_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all TaskScheduler tests passed\n");
+    return EXIT_SUCCESS;
+}
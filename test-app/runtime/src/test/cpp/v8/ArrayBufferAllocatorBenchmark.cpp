@@ -0,0 +1,182 @@
+// Churns through ArrayBuffer sized allocations with the allocator of the V8 backend
+// (napi/v8/SimpleAllocator.cpp) and with plain calloc/malloc/free, as V8 would without it.
+//
+//   array_buffer_allocator_benchmark [--iterations N] [--output results.json]
+//
+// Every buffer is written a byte per page, like a buffer that is filled, and the zeroed ones are
+// checked to read as zeroes. The results are written as JSON to stdout or to the output file.
+// The process exits with 1 when an allocation fails or a buffer is not zeroed.
+
+#include "SimpleAllocator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    const size_t PAGE = 4096;
+    // image tiles and crypto blocks, up to a decoded bitmap
+    const size_t SIZES[] = {4096, 16384, 24000, 65536, 100000, 262144, 1048576};
+    const size_t SIZE_COUNT = sizeof(SIZES) / sizeof(SIZES[0]);
+
+    void Fail(const char *message, size_t size) {
+        fprintf(stderr, "%s (%zu bytes)\n", message, size);
+        exit(1);
+    }
+
+    class MallocAllocator : public v8::ArrayBuffer::Allocator {
+        public:
+            void *Allocate(size_t length) override {
+                return calloc(length, 1);
+            }
+
+            void *AllocateUninitialized(size_t length) override {
+                return malloc(length);
+            }
+
+            void Free(void *data, size_t length) override {
+                free(data);
+            }
+    };
+
+    void Fill(void *data, size_t length, bool zeroed, size_t i) {
+        auto bytes = static_cast<unsigned char *>(data);
+        for (size_t offset = 0; offset < length; offset += PAGE) {
+            if (zeroed && bytes[offset] != 0) {
+                Fail("buffer not zeroed", length);
+            }
+            bytes[offset] = (unsigned char) (i + 1);
+        }
+        if (zeroed && bytes[length - 1] != 0) {
+            Fail("buffer not zeroed", length);
+        }
+        bytes[length - 1] = (unsigned char) (i + 1);
+    }
+
+    // every buffer is freed before the next one is allocated
+    void Churn(v8::ArrayBuffer::Allocator &allocator, size_t iterations, bool zeroed) {
+        for (size_t i = 0; i < iterations; i++) {
+            auto size = SIZES[i % SIZE_COUNT];
+            auto data = zeroed ? allocator.Allocate(size) : allocator.AllocateUninitialized(size);
+            if (data == nullptr) {
+                Fail("allocation failed", size);
+            }
+            Fill(data, size, zeroed, i);
+            allocator.Free(data, size);
+        }
+    }
+
+    // the last 32 buffers stay alive, as they would until the next GC
+    void Window(v8::ArrayBuffer::Allocator &allocator, size_t iterations, bool zeroed) {
+        const size_t window = 32;
+        std::vector<std::pair<void *, size_t>> live(window, {nullptr, 0});
+        for (size_t i = 0; i < iterations; i++) {
+            auto &slot = live[i % window];
+            if (slot.first != nullptr) {
+                allocator.Free(slot.first, slot.second);
+            }
+            auto size = SIZES[(i * 3) % SIZE_COUNT];
+            slot = {zeroed ? allocator.Allocate(size) : allocator.AllocateUninitialized(size), size};
+            if (slot.first == nullptr) {
+                Fail("allocation failed", size);
+            }
+            Fill(slot.first, size, zeroed, i);
+        }
+        for (auto &slot: live) {
+            allocator.Free(slot.first, slot.second);
+        }
+    }
+
+    // 32MB of 1MB buffers at a time, past what the allocator keeps on its free lists
+    void Burst(v8::ArrayBuffer::Allocator &allocator, size_t iterations, bool zeroed) {
+        const size_t burst = 32, size = 1048576;
+        std::vector<void *> live;
+        for (size_t i = 0; i < iterations; i++) {
+            auto data = zeroed ? allocator.Allocate(size) : allocator.AllocateUninitialized(size);
+            if (data == nullptr) {
+                Fail("allocation failed", size);
+            }
+            Fill(data, size, zeroed, i);
+            live.push_back(data);
+            if (live.size() == burst || i + 1 == iterations) {
+                for (auto buffer: live) {
+                    allocator.Free(buffer, size);
+                }
+                live.clear();
+            }
+        }
+    }
+
+    struct Benchmark {
+        const char *name;
+        void (*run)(v8::ArrayBuffer::Allocator &, size_t, bool);
+        bool zeroed;
+    };
+
+    const Benchmark BENCHMARKS[] = {
+            {"churn",               Churn,  true},
+            {"churn_uninitialized", Churn,  false},
+            {"window",              Window, true},
+            {"burst",               Burst,  true},
+    };
+
+    double NsPerOp(v8::ArrayBuffer::Allocator &allocator, const Benchmark &benchmark, size_t iterations) {
+        // a first round fills the pools, as the steady state of an app would
+        benchmark.run(allocator, iterations / 10 + 1, benchmark.zeroed);
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(allocator, iterations, benchmark.zeroed);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = 20000;
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--output file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output);
+            return 1;
+        }
+    }
+
+    tns::SimpleAllocator pooled;
+    MallocAllocator baseline;
+    fprintf(out, "{\n  \"results\": [");
+    for (size_t i = 0; i < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); i++) {
+        auto &benchmark = BENCHMARKS[i];
+        auto pooledNs = NsPerOp(pooled, benchmark, iterations);
+        auto baselineNs = NsPerOp(baseline, benchmark, iterations);
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"pooled_ns_per_op\": %.2f, \"malloc_ns_per_op\": %.2f}",
+                i > 0 ? "," : "", benchmark.name, iterations, pooledNs, baselineNs);
+    }
+
+    auto stats = pooled.GetStats();
+    if (stats.liveBytes != 0 || stats.allocations != stats.frees) {
+        Fail("buffers left alive", (size_t) stats.liveBytes);
+    }
+    fprintf(out, "\n  ],\n  \"stats\": {\"peak_bytes\": %lld, \"allocations\": %lld, \"reused\": %lld, "
+                 "\"pooled_bytes\": %lld}\n}\n",
+            (long long) stats.peakBytes, (long long) stats.allocations, (long long) stats.reused,
+            (long long) stats.pooledBytes);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}
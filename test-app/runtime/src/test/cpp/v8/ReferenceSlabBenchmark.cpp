@@ -0,0 +1,231 @@
+// Churns through Reference sized objects with the slab the V8 backend allocates its Node-API
+// references from (napi/v8/ReferenceSlab.cpp) and with plain new/delete, as it did without it.
+//
+//   reference_slab_benchmark [--iterations N] [--output results.json]
+//
+// The peak heap is the most the objects took at once: the chunks of the slab, and the blocks
+// malloc handed out with their headers. The results are written as JSON to stdout or to the
+// output file. The process exits with 1 when a slot is handed out twice or freed slots are not
+// reused. Under the address sanitizer it also checks that the chunks of a destroyed slab are
+// released with their last slot.
+
+#include "ReferenceSlab.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <vector>
+
+namespace {
+    // a v8impl::Reference
+    const size_t OBJECT_SIZE = v8impl::ReferenceSlab::SLOT_SIZE;
+
+    void Fail(const char *message) {
+        fprintf(stderr, "%s\n", message);
+        exit(1);
+    }
+
+    class Allocator {
+        public:
+            virtual ~Allocator() = default;
+
+            virtual void *New() = 0;
+
+            virtual void Delete(void *object) = 0;
+
+            virtual size_t PeakBytes() = 0;
+    };
+
+    class SlabAllocator : public Allocator {
+        public:
+            void *New() override {
+                return m_slab.Allocate();
+            }
+
+            void Delete(void *object) override {
+                v8impl::ReferenceSlab::Free(object);
+            }
+
+            // the chunks are kept for the next references
+            size_t PeakBytes() override {
+                return (size_t) m_slab.GetStats().chunkBytes;
+            }
+
+        private:
+            v8impl::ReferenceSlab m_slab;
+    };
+
+    class HeapAllocator : public Allocator {
+        public:
+            void *New() override {
+                auto object = ::operator new(OBJECT_SIZE);
+                m_bytes += malloc_usable_size(object) + sizeof(size_t);
+                if (m_bytes > m_peakBytes) {
+                    m_peakBytes = m_bytes;
+                }
+                return object;
+            }
+
+            void Delete(void *object) override {
+                m_bytes -= malloc_usable_size(object) + sizeof(size_t);
+                ::operator delete(object);
+            }
+
+            size_t PeakBytes() override {
+                return m_peakBytes;
+            }
+
+        private:
+            size_t m_bytes = 0;
+            size_t m_peakBytes = 0;
+    };
+
+    // marks the object as alive, a slot handed out twice still carries the mark of the first
+    void *Create(Allocator &allocator) {
+        auto object = static_cast<unsigned char *>(allocator.New());
+        if (object == nullptr) {
+            Fail("allocation failed");
+        }
+        if (object[OBJECT_SIZE - 1] == 0xA5) {
+            Fail("slot handed out twice");
+        }
+        object[OBJECT_SIZE - 1] = 0xA5;
+        return object;
+    }
+
+    void Destroy(Allocator &allocator, void *object) {
+        static_cast<unsigned char *>(object)[OBJECT_SIZE - 1] = 0;
+        allocator.Delete(object);
+    }
+
+    // a reference for a call, like the callback of a timer
+    void Churn(Allocator &allocator, size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+            Destroy(allocator, Create(allocator));
+        }
+    }
+
+    // the last 4096 references stay alive, as wrappers would until the next GC
+    void Window(Allocator &allocator, size_t iterations) {
+        const size_t window = 4096;
+        std::vector<void *> live(window, nullptr);
+        for (size_t i = 0; i < iterations; i++) {
+            auto &slot = live[(i * 7) % window];
+            if (slot != nullptr) {
+                Destroy(allocator, slot);
+            }
+            slot = Create(allocator);
+        }
+        for (auto object: live) {
+            if (object != nullptr) {
+                Destroy(allocator, object);
+            }
+        }
+    }
+
+    // all of them alive at once, like the objects of a big list marshalled to Java
+    void Burst(Allocator &allocator, size_t iterations) {
+        std::vector<void *> live;
+        live.reserve(iterations);
+        for (size_t i = 0; i < iterations; i++) {
+            live.push_back(Create(allocator));
+        }
+        for (auto object: live) {
+            Destroy(allocator, object);
+        }
+    }
+
+    struct Benchmark {
+        const char *name;
+        void (*run)(Allocator &, size_t);
+    };
+
+    const Benchmark BENCHMARKS[] = {
+            {"churn",  Churn},
+            {"window", Window},
+            {"burst",  Burst},
+    };
+
+    double NsPerOp(Allocator &allocator, const Benchmark &benchmark, size_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(allocator, iterations);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+    }
+
+    // userland references may be deleted after their env
+    void ReleasesOrphanedChunks() {
+        auto slab = new v8impl::ReferenceSlab();
+        std::vector<void *> live;
+        for (size_t i = 0; i < 3 * v8impl::ReferenceSlab::CHUNK_SIZE / v8impl::ReferenceSlab::SLOT_SIZE; i++) {
+            live.push_back(slab->Allocate());
+        }
+        auto chunkBytes = slab->GetStats().chunkBytes;
+        for (size_t i = 0; i < live.size(); i += 2) {
+            v8impl::ReferenceSlab::Free(live[i]);
+        }
+        for (size_t i = 0; i < live.size(); i += 2) {
+            live[i] = slab->Allocate();
+        }
+        if (slab->GetStats().chunkBytes != chunkBytes) {
+            Fail("freed slots were not reused");
+        }
+        for (size_t i = 0; i < live.size(); i += 2) {
+            v8impl::ReferenceSlab::Free(live[i]);
+        }
+
+        // the odd slots are still alive and keep their chunks
+        delete slab;
+        for (size_t i = 1; i < live.size(); i += 2) {
+            static_cast<unsigned char *>(live[i])[0] = 0;
+            v8impl::ReferenceSlab::Free(live[i]);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = 1000000;
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--output file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output);
+            return 1;
+        }
+    }
+
+    ReleasesOrphanedChunks();
+
+    fprintf(out, "{\n  \"results\": [");
+    for (size_t i = 0; i < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); i++) {
+        auto &benchmark = BENCHMARKS[i];
+        // a slab per benchmark, as an env would start with
+        SlabAllocator slab;
+        HeapAllocator heap;
+        auto slabNs = NsPerOp(slab, benchmark, iterations);
+        auto heapNs = NsPerOp(heap, benchmark, iterations);
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"slab_ns_per_op\": %.2f, \"new_ns_per_op\": %.2f, "
+                     "\"slab_peak_heap_bytes\": %zu, \"new_peak_heap_bytes\": %zu}",
+                i > 0 ? "," : "", benchmark.name, iterations, slabNs, heapNs, slab.PeakBytes(),
+                heap.PeakBytes());
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}